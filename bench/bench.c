@@ -0,0 +1,714 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host Benchmark Harness
+ *
+ * Runs the port's hot paths against synthetic data sized like the game's
+ * own: a 4096-symbol export table, a few hundred cached assets, a full
+ * pool of audio voices, shader- and texture-sized hash inputs and one
+ * second of WAV audio. Each benchmark is repeated and reported as min and
+ * median nanoseconds per operation in one JSON document on stdout, so runs
+ * can be diffed or fed to a regression check.
+ *
+ * Usage: fluffydiver_bench [--quick] [--filter <substring>]
+ */
+
+#define _GNU_SOURCE
+
+#include <ftw.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <so_util/so_util.h>
+#include "asset_handler.h"
+#include "audio_mixer.h"
+#include "config.h"
+#include "path_map.h"
+#include "reimpl/fast_libc.h"
+#include "reimpl/mem_pool.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+#include "bench.h"
+
+#define BENCH_MAX_RESULTS 48
+#define BENCH_SYMBOLS 4096
+#define BENCH_SYMBOL_BUCKETS 2053           // What GNU ld picks for a table this size
+#define BENCH_ASSETS 384
+#define BENCH_LIVE_ALLOCS 4096
+#define BENCH_LOG_BATCH 128                 // Half the logger ring, so nothing drops
+#define BENCH_MATH_INPUTS 1024
+#define BENCH_STRINGS 256
+
+// Not in so_util.h; so_util.c declares it the same way
+uint32_t so_hash(const uint8_t *name);
+
+// Defined in source/patch.c, which has no header
+void patch_game(void);
+void *malloc_tracked(size_t size, const char *func, int line);
+void free_tracked(void *ptr, const char *func, int line);
+
+typedef uint64_t (*bench_fn)(void *ctx, int iterations);    // Returns elapsed ns
+
+typedef struct {
+    const char *name;
+    int iterations;
+    int reps;
+    double min_ns;
+    double median_ns;
+    size_t bytes_per_op;
+} bench_result_t;
+
+typedef struct {
+    char *names[BENCH_SYMBOLS];
+    char *missing[BENCH_SYMBOLS];
+    so_module module;
+} symbol_ctx_t;
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static int result_count = 0;
+static int quick = 0;
+static const char *filter = NULL;
+static char root[256];
+static volatile uint64_t sink;
+
+// Function prototypes
+static void run(const char *name, bench_fn fn, void *ctx, int iterations, size_t bytes_per_op);
+static void print_results(void);
+static uint32_t next_random(uint32_t *state);
+static void make_symbols(symbol_ctx_t *ctx);
+static int make_assets(char names[][64]);
+static int write_wav(const char *path, int channels, int bits, int rate, int frames);
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw);
+static int check_fast_imports(void);
+
+// ===== SYMBOLS =====
+
+static uint64_t bench_so_hash(void *ctx, int iterations) {
+    symbol_ctx_t *symbols = ctx;
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += so_hash((const uint8_t *)symbols->names[i & (BENCH_SYMBOLS - 1)]);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+static uint64_t bench_so_symbol_hit(void *ctx, int iterations) {
+    symbol_ctx_t *symbols = ctx;
+    uint32_t state = 1;
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += so_symbol(&symbols->module, symbols->names[next_random(&state) & (BENCH_SYMBOLS - 1)]);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+static uint64_t bench_so_symbol_miss(void *ctx, int iterations) {
+    symbol_ctx_t *symbols = ctx;
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += so_symbol(&symbols->module, symbols->missing[i & (BENCH_SYMBOLS - 1)]);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+// ===== ASSET CACHE =====
+
+static uint64_t bench_asset_cache_hit(void *ctx, int iterations) {
+    char (*names)[64] = ctx;
+    uint32_t state = 7;
+    size_t size = 0;
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += (uintptr_t)load_asset(names[next_random(&state) % BENCH_ASSETS], &size);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc + size;
+    return elapsed;
+}
+
+// ===== PATH MAP =====
+
+// Android app-data paths, each already interned by a first open
+static uint64_t bench_path_map_hit(void *ctx, int iterations) {
+    char (*paths)[128] = ctx;
+    uint32_t state = 11;
+    char scratch[256];
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += (uintptr_t)path_map_resolve(paths[next_random(&state) % BENCH_ASSETS], scratch, sizeof(scratch));
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+// ===== AUDIO =====
+
+// Half the pool stays busy; each op starts one voice and stops another
+static uint64_t bench_audio_free_list(void *ctx, int iterations) {
+    (void)ctx;
+    int live[MAX_AUDIO_SOURCES / 2];
+    bench_audio_init_sources();
+    for (int i = 0; i < MAX_AUDIO_SOURCES / 2; i++) {
+        live[i] = bench_audio_play(i + 1, i & 7);
+    }
+
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        int slot = i % (MAX_AUDIO_SOURCES / 2);
+        bench_audio_stop(live[slot]);
+        live[slot] = bench_audio_play((i & 0xFF) + 1, i & 7);
+    }
+    return platform_now_ns() - start;
+}
+
+// Every voice busy, so each start polls the pool and steals the weakest
+static uint64_t bench_audio_steal(void *ctx, int iterations) {
+    (void)ctx;
+    bench_audio_init_sources();
+    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
+        bench_audio_play(i + 1, i & 7);
+    }
+
+    uint32_t state = 3;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        bench_audio_play((i & 0xFF) + 1, next_random(&state) & 7);
+    }
+    return platform_now_ns() - start;
+}
+
+static uint64_t bench_wav_load(void *ctx, int iterations) {
+    const char *path = ctx;
+    size_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += bench_audio_load_wav(path);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+// Every voice looping a mono 44.1 kHz second; each op is one output buffer
+static uint64_t bench_mixer_render(void *ctx, int iterations) {
+    (void)ctx;
+    static int16_t out[AUDIO_BUFFER_SIZE * 2];
+    static int16_t pcm[44100];
+    static ALuint sources[MAX_AUDIO_SOURCES], buffer;
+    static int ready = 0;
+
+    if (!ready) {
+        uint32_t state = 13;
+        for (size_t i = 0; i < ARRAY_SIZE(pcm); i++) {
+            pcm[i] = (int16_t)(next_random(&state) & 0xFFFF);
+        }
+        audio_mixer_gen_buffers(1, &buffer);
+        audio_mixer_buffer_data(buffer, AL_FORMAT_MONO16, pcm, sizeof(pcm), 44100);
+        audio_mixer_gen_sources(MAX_AUDIO_SOURCES, sources);
+        for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
+            audio_mixer_source_i(sources[i], AL_BUFFER, (ALint)buffer);
+            audio_mixer_source_i(sources[i], AL_LOOPING, AL_TRUE);
+            audio_mixer_source_f(sources[i], AL_GAIN, 0.25f);
+            // A quarter pitched, taking the interpolating path
+            audio_mixer_source_f(sources[i], AL_PITCH, (i & 3) == 0 ? 1.5f : 1.0f);
+            audio_mixer_play(sources[i]);
+        }
+        ready = 1;
+    }
+
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        audio_mixer_render(out, AUDIO_BUFFER_SIZE);
+        acc += (uint16_t)out[i & (AUDIO_BUFFER_SIZE * 2 - 1)];
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+// ===== ALLOCATORS =====
+
+typedef struct {
+    void *live[BENCH_LIVE_ALLOCS];
+    void *(*alloc)(size_t size);
+    void (*release)(void *ptr);
+} alloc_ctx_t;
+
+static void *tracked_alloc(size_t size) {
+    return malloc_tracked(size, "bench", __LINE__);
+}
+
+static void tracked_free(void *ptr) {
+    free_tracked(ptr, "bench", __LINE__);
+}
+
+// Replace one block of a live set per op; sizes skew small like the game's
+static uint64_t bench_alloc_churn(void *ctx, int iterations) {
+    alloc_ctx_t *alloc = ctx;
+    uint32_t state = 11;
+    for (int i = 0; i < BENCH_LIVE_ALLOCS; i++) {
+        alloc->live[i] = alloc->alloc(16 + (next_random(&state) % 240));
+    }
+
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        uint32_t r = next_random(&state);
+        int slot = r % BENCH_LIVE_ALLOCS;
+        size_t size = (r & 0x30000) ? 16 + ((r >> 4) & 0xFF) : 256 + ((r >> 4) & 0xFFF);
+        alloc->release(alloc->live[slot]);
+        alloc->live[slot] = alloc->alloc(size);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+
+    for (int i = 0; i < BENCH_LIVE_ALLOCS; i++) {
+        alloc->release(alloc->live[i]);
+    }
+    return elapsed;
+}
+
+// ===== LOGGING AND HASHING =====
+
+static uint64_t bench_log_print(void *ctx, int iterations) {
+    (void)ctx;
+    uint64_t elapsed = 0;
+    for (int done = 0; done < iterations; done += BENCH_LOG_BATCH) {
+        int batch = iterations - done < BENCH_LOG_BATCH ? iterations - done : BENCH_LOG_BATCH;
+        uint64_t start = platform_now_ns();
+        for (int i = 0; i < batch; i++) {
+            _log_print(LT_INFO, "Asset loaded: %s (%zu bytes)", "stage03/bg_far.hgg", (size_t)(done + i));
+        }
+        elapsed += platform_now_ns() - start;
+        // Draining is the writer thread's cost, not the caller's
+        log_flush();
+    }
+    return elapsed;
+}
+
+typedef struct {
+    const char *data;
+    size_t size;
+} sha_ctx_t;
+
+static uint64_t bench_sha1(void *ctx, int iterations) {
+    sha_ctx_t *sha = ctx;
+    uint64_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        char *hash = str_sha1sum(sha->data, sha->size);
+        acc += (uint8_t)hash[0];
+        free(hash);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+// ===== FAST IMPORTS =====
+
+typedef struct {
+    size_t (*fn)(const char *s);
+    char text[BENCH_STRINGS][96];
+} strlen_ctx_t;
+
+typedef struct {
+    float (*fn)(float x);
+    float (*fn2)(float y, float x);
+    float x[BENCH_MATH_INPUTS];
+    float y[BENCH_MATH_INPUTS];
+} math_ctx_t;
+
+static uint64_t bench_strlen(void *ctx, int iterations) {
+    strlen_ctx_t *strings = ctx;
+    size_t acc = 0;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        acc += strings->fn(strings->text[i & (BENCH_STRINGS - 1)]);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = acc;
+    return elapsed;
+}
+
+static uint64_t bench_math(void *ctx, int iterations) {
+    math_ctx_t *math = ctx;
+    float acc = 0.0f;
+    uint64_t start = platform_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        int j = i & (BENCH_MATH_INPUTS - 1);
+        acc += math->fn ? math->fn(math->x[j]) : math->fn2(math->y[j], math->x[j]);
+    }
+    uint64_t elapsed = platform_now_ns() - start;
+    sink = (uint64_t)acc;
+    return elapsed;
+}
+
+// Asset names and mangled symbols run 8-95 characters
+static void make_strings(strlen_ctx_t *ctx) {
+    uint32_t state = 17;
+    for (int i = 0; i < BENCH_STRINGS; i++) {
+        int length = 8 + next_random(&state) % 88;
+        for (int c = 0; c < length; c++) {
+            ctx->text[i][c] = (char)('a' + next_random(&state) % 26);
+        }
+        ctx->text[i][length] = '\0';
+    }
+}
+
+// Angles of a few turns either way, exponents for fades and easing
+static void make_math_inputs(math_ctx_t *ctx, float range) {
+    uint32_t state = 19;
+    for (int i = 0; i < BENCH_MATH_INPUTS; i++) {
+        ctx->x[i] = ((float)next_random(&state) / 4294967296.0f * 2.0f - 1.0f) * range;
+        ctx->y[i] = ((float)next_random(&state) / 4294967296.0f * 2.0f - 1.0f) * range;
+    }
+}
+
+// The replacements against libm in double precision; -1 if one is off its documented bound
+static int check_fast_imports(void) {
+    static char text[160];
+    double sin_error = 0.0, cos_error = 0.0, atan2_error = 0.0, exp_error = 0.0;
+    uint32_t state = 23;
+    int failed = 0;
+
+    // Every length at every alignment, with garbage after the terminator
+    for (int offset = 0; offset < 16; offset++) {
+        for (int length = 0; length < 128; length++) {
+            memset(text, 'x', sizeof(text));
+            text[offset + length] = '\0';
+            if (strlen_fast(text + offset) != (size_t)length) {
+                fprintf(stderr, "strlen_fast: wrong length %d at offset %d\n", length, offset);
+                failed = 1;
+            }
+        }
+    }
+
+    for (int i = 0; i < 200000; i++) {
+        float x = ((float)next_random(&state) / 4294967296.0f * 2.0f - 1.0f) * 8000.0f;
+        float y = ((float)next_random(&state) / 4294967296.0f * 2.0f - 1.0f) * 100.0f;
+        float e = ((float)next_random(&state) / 4294967296.0f * 2.0f - 1.0f) * 86.0f;
+        sin_error = fmax(sin_error, fabs(sinf_fast(x) - sin((double)x)));
+        cos_error = fmax(cos_error, fabs(cosf_fast(x) - cos((double)x)));
+        atan2_error = fmax(atan2_error, fabs(atan2f_fast(y, x / 80.0f) - atan2((double)y, (double)(x / 80.0f))));
+        exp_error = fmax(exp_error, fabs(expf_fast(e) - exp((double)e)) / exp((double)e));
+    }
+
+    fprintf(stderr, "fast imports: sinf %.2e, cosf %.2e, atan2f %.2e abs; expf %.2e rel\n",
+            sin_error, cos_error, atan2_error, exp_error);
+    if (sin_error > 2e-6 || cos_error > 2e-6 || atan2_error > 2e-5 || exp_error > 1e-6) {
+        failed = 1;
+    }
+    return failed ? -1 : 0;
+}
+
+// ===== MAIN =====
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            quick = 1;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--quick] [--filter <substring>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    snprintf(root, sizeof(root), "/tmp/fluffydiver_bench.XXXXXX");
+    if (!mkdtemp(root)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    platform_set_root(root);
+    platform_set_quiet(1);
+
+    static symbol_ctx_t symbols;
+    make_symbols(&symbols);
+    run("so_hash", bench_so_hash, &symbols, 200000, 0);
+    run("so_symbol_hit", bench_so_symbol_hit, &symbols, 200000, 0);
+    run("so_symbol_miss", bench_so_symbol_miss, &symbols, 2000, 0);
+
+    static char asset_names[BENCH_ASSETS][64];
+    if (make_assets(asset_names) == 0 && init_asset_system() == 0) {
+        size_t size;
+        for (int i = 0; i < BENCH_ASSETS; i++) {
+            load_asset(asset_names[i], &size);
+        }
+        run("asset_cache_hit", bench_asset_cache_hit, asset_names, 200000, 0);
+        cleanup_asset_system();
+    } else {
+        fprintf(stderr, "asset_cache_hit: asset system failed to start\n");
+    }
+
+    static char android_paths[BENCH_ASSETS][128];
+    char scratch[256];
+    path_map_init();
+    for (int i = 0; i < BENCH_ASSETS; i++) {
+        snprintf(android_paths[i], sizeof(android_paths[i]), "/data/data/com.hotdog.fluffydiver/files/%.63s",
+                 asset_names[i]);
+        path_map_resolve(android_paths[i], scratch, sizeof(scratch));
+    }
+    run("path_map_hit", bench_path_map_hit, android_paths, 200000, 0);
+
+    run("audio_source_free_list", bench_audio_free_list, NULL, 200000, 0);
+    run("audio_source_steal", bench_audio_steal, NULL, 100000, 0);
+
+    patch_game();
+    static alloc_ctx_t tracked = { .alloc = tracked_alloc, .release = tracked_free };
+    run("malloc_tracked", bench_alloc_churn, &tracked, 200000, 0);
+
+    if (mem_pool_init() == 0) {
+        static alloc_ctx_t pooled = { .alloc = malloc_pooled, .release = free_pooled };
+        run("malloc_pooled", bench_alloc_churn, &pooled, 200000, 0);
+    }
+
+    run("log_print", bench_log_print, NULL, 20 * BENCH_LOG_BATCH, 0);
+
+    static char sha_input[256 * 1024];
+    uint32_t state = 5;
+    for (size_t i = 0; i < sizeof(sha_input); i++) {
+        sha_input[i] = (char)(32 + next_random(&state) % 95);
+    }
+    sha_ctx_t shader = { sha_input, 4 * 1024 };
+    sha_ctx_t texture = { sha_input, sizeof(sha_input) };
+    run("sha1_4k", bench_sha1, &shader, 20000, shader.size);
+    run("sha1_256k", bench_sha1, &texture, 200, texture.size);
+
+    char wav_stereo[320], wav_mono[320];
+    snprintf(wav_stereo, sizeof(wav_stereo), "%s/sfx_stereo16.wav", root);
+    snprintf(wav_mono, sizeof(wav_mono), "%s/sfx_mono8.wav", root);
+    if (write_wav(wav_stereo, 2, 16, 44100, 44100) == 0 && write_wav(wav_mono, 1, 8, 22050, 22050) == 0) {
+        run("wav_load_stereo16_1s", bench_wav_load, wav_stereo, 200, 44100 * 4);
+        run("wav_load_mono8_1s", bench_wav_load, wav_mono, 500, 22050);
+    }
+    run("mixer_render_full_pool", bench_mixer_render, NULL, 2000, AUDIO_BUFFER_SIZE * 4);
+
+    static strlen_ctx_t strings;
+    make_strings(&strings);
+    strings.fn = strlen;
+    run("strlen_libc", bench_strlen, &strings, 200000, 0);
+    strings.fn = strlen_fast;
+    run("strlen_fast", bench_strlen, &strings, 200000, 0);
+
+    static math_ctx_t angles, exponents;
+    make_math_inputs(&angles, 4.0f * (float)M_PI);
+    make_math_inputs(&exponents, 10.0f);
+    angles.fn = sinf;
+    run("sinf_libm", bench_math, &angles, 200000, 0);
+    angles.fn = sinf_fast;
+    run("sinf_fast", bench_math, &angles, 200000, 0);
+    angles.fn = cosf;
+    run("cosf_libm", bench_math, &angles, 200000, 0);
+    angles.fn = cosf_fast;
+    run("cosf_fast", bench_math, &angles, 200000, 0);
+    angles.fn = NULL;
+    angles.fn2 = atan2f;
+    run("atan2f_libm", bench_math, &angles, 200000, 0);
+    angles.fn2 = atan2f_fast;
+    run("atan2f_fast", bench_math, &angles, 200000, 0);
+    exponents.fn = expf;
+    run("expf_libm", bench_math, &exponents, 200000, 0);
+    exponents.fn = expf_fast;
+    run("expf_fast", bench_math, &exponents, 200000, 0);
+    int accuracy = check_fast_imports();
+
+    nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    print_results();
+    return accuracy < 0 ? 1 : 0;
+}
+
+// ===== RUNNER =====
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run(const char *name, bench_fn fn, void *ctx, int iterations, size_t bytes_per_op) {
+    if ((filter && !strstr(name, filter)) || result_count >= BENCH_MAX_RESULTS) {
+        return;
+    }
+
+    int reps = quick ? 3 : 15;
+    if (quick) {
+        iterations = iterations / 20 > 0 ? iterations / 20 : 1;
+    }
+
+    // One untimed pass warms caches and lazily started threads
+    fn(ctx, iterations);
+
+    double samples[15];
+    for (int r = 0; r < reps; r++) {
+        samples[r] = (double)fn(ctx, iterations) / iterations;
+    }
+    qsort(samples, reps, sizeof(double), compare_doubles);
+
+    bench_result_t *result = &results[result_count++];
+    result->name = name;
+    result->iterations = iterations;
+    result->reps = reps;
+    result->min_ns = samples[0];
+    result->median_ns = samples[reps / 2];
+    result->bytes_per_op = bytes_per_op;
+}
+
+static void print_results(void) {
+    printf("{\n  \"suite\": \"fluffydiver_bench\",\n  \"quick\": %s,\n  \"results\": [\n",
+           quick ? "true" : "false");
+    for (int i = 0; i < result_count; i++) {
+        bench_result_t *r = &results[i];
+        printf("    {\"name\": \"%s\", \"iterations\": %d, \"reps\": %d, "
+               "\"ns_per_op_min\": %.1f, \"ns_per_op_median\": %.1f",
+               r->name, r->iterations, r->reps, r->min_ns, r->median_ns);
+        if (r->bytes_per_op) {
+            printf(", \"mb_per_s\": %.1f", r->bytes_per_op * 1000.0 / r->median_ns);
+        }
+        printf("}%s\n", i + 1 < result_count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+// ===== FIXTURES =====
+
+static uint32_t next_random(uint32_t *state) {
+    // xorshift32: deterministic, so runs see the same access pattern
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Mangled C++ names in the style of the game's exports, SysV hash table as ld emits it
+static void make_symbols(symbol_ctx_t *ctx) {
+    static const char *classes[] = {
+        "CGameStage", "CSprite", "CFluffy", "CParticleSystem", "CSoundManager",
+        "CTexture", "CFontRenderer", "CMenuScene", "CItemShop", "CDiveController"
+    };
+    static const char *methods[] = {
+        "Update", "Draw", "Initialize", "Release", "SetPosition", "GetState", "LoadResource", "OnTouch"
+    };
+    static const char *params[] = { "Ev", "Ei", "Eff", "EPKc", "ERK6Vector" };
+
+    static Elf32_Sym dynsym[BENCH_SYMBOLS + 1];
+    static uint32_t hash[2 + BENCH_SYMBOL_BUCKETS + BENCH_SYMBOLS + 1];
+    static char dynstr[BENCH_SYMBOLS * 64];
+    size_t str_pos = 1;
+
+    for (int i = 0; i < BENCH_SYMBOLS; i++) {
+        const char *cls = classes[i % 10];
+        const char *method = methods[(i / 10) % 8];
+        char name[64];
+        snprintf(name, sizeof(name), "_ZN%zu%s%zu%s%dE%s", strlen(cls), cls,
+                 strlen(method) + 1 + (i >= 1000) + (i >= 100) + (i >= 10), method, i, params[i % 5]);
+        ctx->names[i] = strdup(name);
+        snprintf(name, sizeof(name), "_ZN%zu%s7Missing%dE%s", strlen(cls), cls, i, params[i % 5]);
+        ctx->missing[i] = strdup(name);
+
+        Elf32_Sym *sym = &dynsym[i + 1];
+        sym->st_name = (Elf32_Word)str_pos;
+        sym->st_value = (Elf32_Addr)(0x1000 + i * 16);
+        sym->st_size = 16;
+        sym->st_info = ELF32_ST_INFO(STB_GLOBAL, STT_FUNC);
+        sym->st_shndx = 9;
+        str_pos += (size_t)sprintf(dynstr + str_pos, "%s", ctx->names[i]) + 1;
+    }
+
+    uint32_t *bucket = &hash[2];
+    uint32_t *chain = &bucket[BENCH_SYMBOL_BUCKETS];
+    hash[0] = BENCH_SYMBOL_BUCKETS;
+    hash[1] = BENCH_SYMBOLS + 1;
+    for (int i = 1; i <= BENCH_SYMBOLS; i++) {
+        uint32_t b = so_hash((const uint8_t *)(dynstr + dynsym[i].st_name)) % BENCH_SYMBOL_BUCKETS;
+        chain[i] = bucket[b];
+        bucket[b] = (uint32_t)i;
+    }
+
+    memset(&ctx->module, 0, sizeof(ctx->module));
+    ctx->module.dynsym = dynsym;
+    ctx->module.num_dynsym = BENCH_SYMBOLS + 1;
+    ctx->module.dynstr = dynstr;
+    ctx->module.hash = hash;
+    ctx->module.text_base = 0x98000000;
+}
+
+// Small level data files, 1-8 KB, under the mapped assets directory
+static int make_assets(char names[][64]) {
+    char path[512];
+    const char *dirs[] = { "ux0", "ux0/data", "ux0/data/fluffydiver", "ux0/data/fluffydiver/assets" };
+    for (int i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "%s/%s", root, dirs[i]);
+        mkdir(path, 0755);
+    }
+
+    static char data[8 * 1024];
+    memset(data, 0x5A, sizeof(data));
+    for (int i = 0; i < BENCH_ASSETS; i++) {
+        snprintf(names[i], 64, "stage%02d_object%03d.dat", i / 32, i);
+        snprintf(path, sizeof(path), "%s/ux0/data/fluffydiver/assets/%.63s", root, names[i]);
+        FILE *f = fopen(path, "wb");
+        if (!f) {
+            return -1;
+        }
+        fwrite(data, 1, 1024 * (1 + i % 8), f);
+        fclose(f);
+    }
+    return 0;
+}
+
+static void put_le(uint8_t *p, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static int write_wav(const char *path, int channels, int bits, int rate, int frames) {
+    uint32_t data_size = (uint32_t)(frames * channels * bits / 8);
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36 + data_size, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);
+    put_le(header + 20, 1, 2);                                  // PCM
+    put_le(header + 22, (uint32_t)channels, 2);
+    put_le(header + 24, (uint32_t)rate, 4);
+    put_le(header + 28, (uint32_t)(rate * channels * bits / 8), 4);
+    put_le(header + 32, (uint32_t)(channels * bits / 8), 2);
+    put_le(header + 34, (uint32_t)bits, 2);
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data_size, 4);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return -1;
+    }
+    fwrite(header, 1, sizeof(header), f);
+    uint32_t state = 9;
+    for (uint32_t i = 0; i < data_size; i++) {
+        fputc((int)(next_random(&state) & 0xFF), f);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st; (void)flag; (void)ftw;
+    return remove(path);
+}
@@ -0,0 +1,38 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host Benchmark Harness
+ *
+ * Hooks shared by the harness (bench.c), the POSIX platform layer
+ * (platform.c) and the audio wrapper (bench_audio.c).
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ===== PLATFORM =====
+
+// Host directory that "ux0:" paths are mapped under
+void platform_set_root(const char *dir);
+
+// Send sceClibPrintf output to /dev/null instead of stderr
+void platform_set_quiet(int quiet);
+
+uint64_t platform_now_ns(void);
+
+// ===== AUDIO (source/audio.c internals) =====
+
+void bench_audio_init_sources(void);
+
+// get_available_source() plus what do_play_sound() sets up; the source index, or -1
+int bench_audio_play(int sound_id, int priority);
+
+// release_source() on a source bench_audio_play() handed out
+void bench_audio_stop(int index);
+
+// load_wav_file() into a dummy buffer; bytes of PCM, or 0 on failure
+size_t bench_audio_load_wav(const char *path);
+
+#endif // BENCH_H
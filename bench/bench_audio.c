@@ -0,0 +1,50 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Audio Benchmark Wrapper
+ *
+ * The source allocator and the WAV loader are static, so audio.c is built
+ * as part of this file and wrapped instead of being linked on its own.
+ */
+
+#include "../source/audio.c"
+
+#include "bench.h"
+
+void bench_audio_init_sources(void) {
+    memset(&audio_state, 0, sizeof(audio_state));
+    setup_audio_sources();
+}
+
+int bench_audio_play(int sound_id, int priority) {
+    int index = get_available_source();
+    if (index < 0) {
+        return -1;
+    }
+
+    audio_source_t *source = &audio_state.sources[index];
+    source->sound_id = sound_id;
+    source->active = 1;
+    source->playing = 1;
+    source->looping = 0;
+    source->priority = priority;
+    source->start_time = sceKernelGetSystemTimeWide();
+    source->predicted_end = source->start_time + 500000;
+
+    audio_state.active_sources++;
+    steal_heap_push(index);
+    audio_state.voice_map[sound_id & AUDIO_HANDLE_SLOT_MASK] =
+        (audio_voice_map_t){ AUDIO_VOICE_SOURCE, index };
+
+    // Stand in for the game thread draining completions of stolen voices
+    audio_state.completions.tail = audio_state.completions.head;
+    return index;
+}
+
+void bench_audio_stop(int index) {
+    release_source(&audio_state.sources[index]);
+}
+
+size_t bench_audio_load_wav(const char *path) {
+    size_t bytes = 0;
+    return load_wav_file(path, 1, &bytes) ? bytes : 0;
+}
@@ -0,0 +1,905 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host Platform Layer
+ *
+ * POSIX implementations of the kernel, file and clib calls the benchmarked
+ * sources make, plus no-op OpenAL, vorbisfile and kubridge entry points.
+ * Kernel objects live in one handle table; "ux0:..." paths are mapped under
+ * the directory given to platform_set_root().
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <vorbis/vorbisfile.h>
+#include <kubridge.h>
+#include "sce_host.h"
+
+#include "bench.h"
+#include "reimpl/pthr.h"
+
+#define HOST_MAX_OBJECTS 256
+#define HOST_UID_BASE 0x4000
+#define HOST_ERROR 0x80010000
+
+typedef enum {
+    HOST_OBJ_FREE = 0,
+    HOST_OBJ_THREAD,
+    HOST_OBJ_SEMA,
+    HOST_OBJ_EVENT,
+    HOST_OBJ_MEMBLOCK,
+    HOST_OBJ_DIR
+} host_obj_kind_t;
+
+typedef struct {
+    host_obj_kind_t kind;
+    char name[32];
+
+    // Threads
+    pthread_t thread;
+    SceKernelThreadEntry entry;
+    void *args;
+    SceSize arg_size;
+    int started;
+    int exit_status;
+
+    // Semaphores and event flags
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;
+    unsigned int bits;
+
+    // Memory blocks and directories
+    void *base;
+    DIR *dir;
+    char path[1024];
+} host_obj_t;
+
+static host_obj_t objects[HOST_MAX_OBJECTS];
+static pthread_mutex_t objects_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread SceUID current_thread = 0;
+static char root_dir[512] = ".";
+static int quiet = 0;
+
+// Function prototypes
+static SceUID obj_alloc(host_obj_kind_t kind, const char *name);
+static host_obj_t *obj_get(SceUID uid, host_obj_kind_t kind);
+static void obj_free(SceUID uid);
+static const char *map_path(const char *path, char *out, size_t size);
+static int wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, const struct timespec *deadline);
+static void deadline_after(struct timespec *ts, SceUInt us);
+
+// ===== HARNESS HOOKS =====
+
+void platform_set_root(const char *dir) {
+    snprintf(root_dir, sizeof(root_dir), "%s", dir);
+}
+
+void platform_set_quiet(int value) {
+    quiet = value;
+}
+
+uint64_t platform_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ===== LWMUTEX =====
+
+int sceKernelCreateLwMutex(SceKernelLwMutexWork *work, const char *name, unsigned int attr,
+                           int count, const SceKernelLwMutexOptParam *opt) {
+    (void)name; (void)count; (void)opt;
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    if (attr & 2) {
+        pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    }
+    pthread_mutex_init(&work->mutex, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+    return 0;
+}
+
+int sceKernelDeleteLwMutex(SceKernelLwMutexWork *work) {
+    return pthread_mutex_destroy(&work->mutex) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceKernelLockLwMutex(SceKernelLwMutexWork *work, int count, unsigned int *timeout) {
+    (void)count; (void)timeout;
+    return pthread_mutex_lock(&work->mutex) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceKernelTryLockLwMutex(SceKernelLwMutexWork *work, int count) {
+    (void)count;
+    return pthread_mutex_trylock(&work->mutex) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceKernelUnlockLwMutex(SceKernelLwMutexWork *work, int count) {
+    (void)count;
+    return pthread_mutex_unlock(&work->mutex) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+// ===== SEMAPHORES AND EVENT FLAGS =====
+
+SceUID sceKernelCreateSema(const char *name, SceUInt attr, int init, int max, void *opt) {
+    (void)attr; (void)max; (void)opt;
+    SceUID uid = obj_alloc(HOST_OBJ_SEMA, name);
+    if (uid >= 0) {
+        obj_get(uid, HOST_OBJ_SEMA)->count = init;
+    }
+    return uid;
+}
+
+int sceKernelDeleteSema(SceUID id) {
+    if (!obj_get(id, HOST_OBJ_SEMA)) {
+        return (int)HOST_ERROR;
+    }
+    obj_free(id);
+    return 0;
+}
+
+int sceKernelSignalSema(SceUID id, int count) {
+    host_obj_t *obj = obj_get(id, HOST_OBJ_SEMA);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    pthread_mutex_lock(&obj->lock);
+    obj->count += count;
+    pthread_cond_broadcast(&obj->cond);
+    pthread_mutex_unlock(&obj->lock);
+    return 0;
+}
+
+int sceKernelWaitSema(SceUID id, int count, SceUInt *timeout) {
+    host_obj_t *obj = obj_get(id, HOST_OBJ_SEMA);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+
+    struct timespec deadline;
+    if (timeout) {
+        deadline_after(&deadline, *timeout);
+    }
+
+    int result = 0;
+    pthread_mutex_lock(&obj->lock);
+    while (obj->count < count) {
+        if (wait_until(&obj->cond, &obj->lock, timeout ? &deadline : NULL) < 0) {
+            result = (int)SCE_KERNEL_ERROR_WAIT_TIMEOUT;
+            break;
+        }
+    }
+    if (result == 0) {
+        obj->count -= count;
+    }
+    pthread_mutex_unlock(&obj->lock);
+    return result;
+}
+
+SceUID sceKernelCreateEventFlag(const char *name, int attr, int bits, void *opt) {
+    (void)attr; (void)opt;
+    SceUID uid = obj_alloc(HOST_OBJ_EVENT, name);
+    if (uid >= 0) {
+        obj_get(uid, HOST_OBJ_EVENT)->bits = (unsigned int)bits;
+    }
+    return uid;
+}
+
+int sceKernelDeleteEventFlag(SceUID id) {
+    if (!obj_get(id, HOST_OBJ_EVENT)) {
+        return (int)HOST_ERROR;
+    }
+    obj_free(id);
+    return 0;
+}
+
+int sceKernelSetEventFlag(SceUID id, unsigned int bits) {
+    host_obj_t *obj = obj_get(id, HOST_OBJ_EVENT);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    pthread_mutex_lock(&obj->lock);
+    obj->bits |= bits;
+    pthread_cond_broadcast(&obj->cond);
+    pthread_mutex_unlock(&obj->lock);
+    return 0;
+}
+
+int sceKernelClearEventFlag(SceUID id, unsigned int bits) {
+    host_obj_t *obj = obj_get(id, HOST_OBJ_EVENT);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    pthread_mutex_lock(&obj->lock);
+    obj->bits &= bits;
+    pthread_mutex_unlock(&obj->lock);
+    return 0;
+}
+
+int sceKernelWaitEventFlag(SceUID id, unsigned int bits, unsigned int wait, unsigned int *out,
+                           SceUInt *timeout) {
+    host_obj_t *obj = obj_get(id, HOST_OBJ_EVENT);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+
+    struct timespec deadline;
+    if (timeout) {
+        deadline_after(&deadline, *timeout);
+    }
+
+    int result = 0;
+    pthread_mutex_lock(&obj->lock);
+    for (;;) {
+        unsigned int hit = obj->bits & bits;
+        if ((wait & SCE_EVENT_WAITOR) ? hit != 0 : hit == bits) {
+            break;
+        }
+        if (wait_until(&obj->cond, &obj->lock, timeout ? &deadline : NULL) < 0) {
+            result = (int)SCE_KERNEL_ERROR_WAIT_TIMEOUT;
+            break;
+        }
+    }
+    if (out) {
+        *out = obj->bits;
+    }
+    if (result == 0 && (wait & SCE_EVENT_WAITCLEAR)) {
+        obj->bits = 0;
+    } else if (result == 0 && (wait & SCE_EVENT_WAITCLEAR_PAT)) {
+        obj->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&obj->lock);
+    return result;
+}
+
+// ===== THREADS =====
+
+static void *thread_trampoline(void *arg) {
+    SceUID uid = (SceUID)(intptr_t)arg;
+    host_obj_t *obj = obj_get(uid, HOST_OBJ_THREAD);
+    current_thread = uid;
+    obj->exit_status = obj->entry(obj->arg_size, obj->args);
+    return NULL;
+}
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority,
+                             SceSize stack_size, SceUInt attr, int affinity, const void *opt) {
+    (void)priority; (void)stack_size; (void)attr; (void)affinity; (void)opt;
+    SceUID uid = obj_alloc(HOST_OBJ_THREAD, name);
+    if (uid >= 0) {
+        obj_get(uid, HOST_OBJ_THREAD)->entry = entry;
+    }
+    return uid;
+}
+
+int sceKernelStartThread(SceUID thid, SceSize args, void *argp) {
+    host_obj_t *obj = obj_get(thid, HOST_OBJ_THREAD);
+    if (!obj || obj->started) {
+        return (int)HOST_ERROR;
+    }
+
+    // Like the kernel, hand the thread its own copy of the arguments
+    obj->arg_size = args;
+    obj->args = NULL;
+    if (args && argp) {
+        obj->args = malloc(args);
+        memcpy(obj->args, argp, args);
+    }
+
+    obj->started = 1;
+    if (pthread_create(&obj->thread, NULL, thread_trampoline, (void *)(intptr_t)thid) != 0) {
+        obj->started = 0;
+        return (int)HOST_ERROR;
+    }
+    return 0;
+}
+
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt *timeout) {
+    (void)timeout;
+    host_obj_t *obj = obj_get(thid, HOST_OBJ_THREAD);
+    if (!obj || !obj->started) {
+        return (int)HOST_ERROR;
+    }
+    pthread_join(obj->thread, NULL);
+    obj->started = 0;
+    if (stat) {
+        *stat = obj->exit_status;
+    }
+    return 0;
+}
+
+int sceKernelDeleteThread(SceUID thid) {
+    host_obj_t *obj = obj_get(thid, HOST_OBJ_THREAD);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    if (obj->started) {
+        pthread_detach(obj->thread);
+    }
+    free(obj->args);
+    obj_free(thid);
+    return 0;
+}
+
+int sceKernelExitThread(int status) {
+    host_obj_t *obj = obj_get(current_thread, HOST_OBJ_THREAD);
+    if (obj) {
+        obj->exit_status = status;
+    }
+    pthread_exit(NULL);
+}
+
+int sceKernelExitDeleteThread(int status) {
+    // Waiters join the pthread, so the handle stays until they are done
+    return sceKernelExitThread(status);
+}
+
+SceUID sceKernelGetThreadId(void) {
+    if (current_thread == 0) {
+        // The main thread and anything not started through the kernel
+        static int next_foreign = 1;
+        current_thread = __atomic_fetch_add(&next_foreign, 1, __ATOMIC_RELAXED);
+    }
+    return current_thread;
+}
+
+int sceKernelGetThreadInfo(SceUID thid, SceKernelThreadInfo *info) {
+    host_obj_t *obj = obj_get(thid, HOST_OBJ_THREAD);
+    memset(&info->processId, 0, sizeof(*info) - sizeof(info->size));
+    snprintf(info->name, sizeof(info->name), "%s", obj ? obj->name : "main");
+    return 0;
+}
+
+int sceKernelChangeThreadPriority(SceUID thid, int priority) {
+    (void)thid; (void)priority;
+    return 0;
+}
+
+int sceKernelChangeThreadCpuAffinityMask(SceUID thid, int mask) {
+    (void)thid; (void)mask;
+    return 0;
+}
+
+int sceKernelDelayThread(SceUInt delay) {
+    usleep(delay);
+    return 0;
+}
+
+SceUID _vshKernelSearchModuleByName(const char *name, int *unk) {
+    (void)name; (void)unk;
+    return (int)HOST_ERROR;
+}
+
+const pthr_thread_policy_t *pthr_thread_policy(const char *name) {
+    static const pthr_thread_policy_t host_default = { "", 0, 0, 0 };
+    (void)name;
+    return &host_default;
+}
+
+// ===== TIME =====
+
+SceUInt64 sceKernelGetProcessTimeWide(void) {
+    return platform_now_ns() / 1000;
+}
+
+SceUInt32 sceKernelGetProcessTimeLow(void) {
+    return (SceUInt32)sceKernelGetProcessTimeWide();
+}
+
+SceUInt64 sceKernelGetSystemTimeWide(void) {
+    return sceKernelGetProcessTimeWide();
+}
+
+// ===== MEMORY =====
+
+SceUID sceKernelAllocMemBlock(const char *name, SceKernelMemBlockType type, SceSize size, void *opt) {
+    (void)type; (void)opt;
+    void *base = aligned_alloc(4096, (size + 4095) & ~4095u);
+    if (!base) {
+        return (int)HOST_ERROR;
+    }
+    SceUID uid = obj_alloc(HOST_OBJ_MEMBLOCK, name);
+    if (uid < 0) {
+        free(base);
+        return uid;
+    }
+    obj_get(uid, HOST_OBJ_MEMBLOCK)->base = base;
+    return uid;
+}
+
+int sceKernelFreeMemBlock(SceUID uid) {
+    host_obj_t *obj = obj_get(uid, HOST_OBJ_MEMBLOCK);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    free(obj->base);
+    obj_free(uid);
+    return 0;
+}
+
+int sceKernelGetMemBlockBase(SceUID uid, void **base) {
+    host_obj_t *obj = obj_get(uid, HOST_OBJ_MEMBLOCK);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    *base = obj->base;
+    return 0;
+}
+
+SceUID kuKernelAllocMemBlock(const char *name, SceKernelMemBlockType type, SceSize size,
+                             SceKernelAllocMemBlockKernelOpt *opt) {
+    (void)opt;
+    return sceKernelAllocMemBlock(name, type, size, NULL);
+}
+
+void kuKernelFlushCaches(const void *ptr, SceSize len) {
+    (void)ptr; (void)len;
+}
+
+int kuKernelCpuUnrestrictedMemcpy(void *dst, const void *src, SceSize len) {
+    memcpy(dst, src, len);
+    return 0;
+}
+
+void *sceClibMemcpy(void *dst, const void *src, SceSize len) {
+    return memcpy(dst, src, len);
+}
+
+void *sceClibMemset(void *dst, int ch, SceSize len) {
+    return memset(dst, ch, len);
+}
+
+void *sceClibMemmove(void *dst, const void *src, SceSize len) {
+    return memmove(dst, src, len);
+}
+
+int sceClibStrcmp(const char *s1, const char *s2) {
+    return strcmp(s1, s2);
+}
+
+int sceClibPrintf(const char *fmt, ...) {
+    if (quiet) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int ret = vfprintf(stderr, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int sceClibSnprintf(char *dst, SceSize len, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int ret = vsnprintf(dst, len, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+int sceClibVsnprintf(char *dst, SceSize len, const char *fmt, va_list args) {
+    return vsnprintf(dst, len, fmt, args);
+}
+
+void fatal_error(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+    abort();
+}
+
+// ===== FILES =====
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode) {
+    char path[1024];
+    int oflags = 0;
+    switch (flags & SCE_O_RDWR) {
+        case SCE_O_WRONLY: oflags = O_WRONLY; break;
+        case SCE_O_RDWR: oflags = O_RDWR; break;
+        default: oflags = O_RDONLY; break;
+    }
+    if (flags & SCE_O_APPEND) oflags |= O_APPEND;
+    if (flags & SCE_O_CREAT) oflags |= O_CREAT;
+    if (flags & SCE_O_TRUNC) oflags |= O_TRUNC;
+    if (flags & SCE_O_EXCL) oflags |= O_EXCL;
+
+    int fd = open(map_path(file, path, sizeof(path)), oflags, mode ? mode : 0644);
+    return fd >= 0 ? fd : (int)HOST_ERROR;
+}
+
+int sceIoClose(SceUID fd) {
+    return close(fd) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceIoRead(SceUID fd, void *data, SceSize size) {
+    ssize_t n = read(fd, data, size);
+    return n >= 0 ? (int)n : (int)HOST_ERROR;
+}
+
+int sceIoWrite(SceUID fd, const void *data, SceSize size) {
+    ssize_t n = write(fd, data, size);
+    return n >= 0 ? (int)n : (int)HOST_ERROR;
+}
+
+int sceIoPread(SceUID fd, void *data, SceSize size, SceOff offset) {
+    ssize_t n = pread(fd, data, size, offset);
+    return n >= 0 ? (int)n : (int)HOST_ERROR;
+}
+
+SceOff sceIoLseek(SceUID fd, SceOff offset, int whence) {
+    off_t pos = lseek(fd, offset, whence == SCE_SEEK_END ? SEEK_END :
+                                  whence == SCE_SEEK_CUR ? SEEK_CUR : SEEK_SET);
+    return pos >= 0 ? pos : (SceOff)(int)HOST_ERROR;
+}
+
+static void fill_stat(const struct stat *st, SceIoStat *out) {
+    memset(out, 0, sizeof(*out));
+    out->st_mode = S_ISDIR(st->st_mode) ? SCE_S_IFDIR : SCE_S_IFREG;
+    out->st_size = st->st_size;
+}
+
+int sceIoGetstat(const char *file, SceIoStat *stat_out) {
+    char path[1024];
+    struct stat st;
+    if (stat(map_path(file, path, sizeof(path)), &st) != 0) {
+        return (int)HOST_ERROR;
+    }
+    fill_stat(&st, stat_out);
+    return 0;
+}
+
+int sceIoGetstatByFd(SceUID fd, SceIoStat *stat_out) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return (int)HOST_ERROR;
+    }
+    fill_stat(&st, stat_out);
+    return 0;
+}
+
+int sceIoMkdir(const char *dir, SceMode mode) {
+    char path[1024];
+    return mkdir(map_path(dir, path, sizeof(path)), mode ? mode : 0755) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceIoRemove(const char *file) {
+    char path[1024];
+    return unlink(map_path(file, path, sizeof(path))) == 0 ? 0 : (int)HOST_ERROR;
+}
+
+int sceIoRename(const char *oldname, const char *newname) {
+    char from[1024], to[1024];
+    return rename(map_path(oldname, from, sizeof(from)), map_path(newname, to, sizeof(to))) == 0
+           ? 0 : (int)HOST_ERROR;
+}
+
+SceUID sceIoDopen(const char *dirname) {
+    char path[1024];
+    DIR *dir = opendir(map_path(dirname, path, sizeof(path)));
+    if (!dir) {
+        return (int)HOST_ERROR;
+    }
+    SceUID uid = obj_alloc(HOST_OBJ_DIR, dirname);
+    if (uid < 0) {
+        closedir(dir);
+        return uid;
+    }
+    host_obj_t *obj = obj_get(uid, HOST_OBJ_DIR);
+    obj->dir = dir;
+    snprintf(obj->path, sizeof(obj->path), "%s", path);
+    return uid;
+}
+
+int sceIoDread(SceUID fd, SceIoDirent *entry) {
+    host_obj_t *obj = obj_get(fd, HOST_OBJ_DIR);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+
+    struct dirent *de;
+    do {
+        de = readdir(obj->dir);
+    } while (de && (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0));
+    if (!de) {
+        return 0;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->d_name, sizeof(entry->d_name), "%s", de->d_name);
+
+    char path[1536];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", obj->path, de->d_name);
+    if (stat(path, &st) == 0) {
+        fill_stat(&st, &entry->d_stat);
+    }
+    return 1;
+}
+
+int sceIoDclose(SceUID fd) {
+    host_obj_t *obj = obj_get(fd, HOST_OBJ_DIR);
+    if (!obj) {
+        return (int)HOST_ERROR;
+    }
+    closedir(obj->dir);
+    obj_free(fd);
+    return 0;
+}
+
+// ===== AUDIO OUT =====
+
+// No device: the mixer is benchmarked through audio_mixer_render() directly
+
+int sceAudioOutOpenPort(int type, int len, int freq, int mode) {
+    (void)type; (void)len; (void)freq; (void)mode;
+    return -1;
+}
+
+int sceAudioOutReleasePort(int port) {
+    (void)port;
+    return 0;
+}
+
+int sceAudioOutOutput(int port, const void *buf) {
+    (void)port; (void)buf;
+    return 0;
+}
+
+int sceAudioOutSetVolume(int port, int flag, int *vol) {
+    (void)port; (void)flag; (void)vol;
+    return 0;
+}
+
+// ===== VITAGL =====
+
+// No GPU: report plenty free so the memory governor never purges for VRAM
+size_t vglMemFree(vglMemType type) {
+    (void)type;
+    return 64 * 1024 * 1024;
+}
+
+// ===== OPENAL =====
+
+static ALuint next_al_name = 1;
+
+ALenum alGetError(void) {
+    return AL_NO_ERROR;
+}
+
+void alGenSources(ALsizei n, ALuint *sources) {
+    for (ALsizei i = 0; i < n; i++) sources[i] = next_al_name++;
+}
+
+void alDeleteSources(ALsizei n, const ALuint *sources) {
+    (void)n; (void)sources;
+}
+
+void alGenBuffers(ALsizei n, ALuint *buffers) {
+    for (ALsizei i = 0; i < n; i++) buffers[i] = next_al_name++;
+}
+
+void alDeleteBuffers(ALsizei n, const ALuint *buffers) {
+    (void)n; (void)buffers;
+}
+
+void alBufferData(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq) {
+    (void)buffer; (void)format; (void)data; (void)size; (void)freq;
+}
+
+void alGetBufferi(ALuint buffer, ALenum param, ALint *value) {
+    (void)buffer; (void)param;
+    *value = 0;
+}
+
+void alSourcef(ALuint source, ALenum param, ALfloat value) {
+    (void)source; (void)param; (void)value;
+}
+
+void alSource3f(ALuint source, ALenum param, ALfloat v1, ALfloat v2, ALfloat v3) {
+    (void)source; (void)param; (void)v1; (void)v2; (void)v3;
+}
+
+void alSourcei(ALuint source, ALenum param, ALint value) {
+    (void)source; (void)param; (void)value;
+}
+
+void alGetSourcei(ALuint source, ALenum param, ALint *value) {
+    (void)source;
+    // Voices never finish on their own, so a full pool always steals
+    *value = param == AL_SOURCE_STATE ? AL_PLAYING : 0;
+}
+
+void alGetSourcef(ALuint source, ALenum param, ALfloat *value) {
+    (void)source; (void)param;
+    *value = 0.0f;
+}
+
+void alSourcePlay(ALuint source) {
+    (void)source;
+}
+
+void alSourceStop(ALuint source) {
+    (void)source;
+}
+
+void alSourceQueueBuffers(ALuint source, ALsizei n, const ALuint *buffers) {
+    (void)source; (void)n; (void)buffers;
+}
+
+void alSourceUnqueueBuffers(ALuint source, ALsizei n, ALuint *buffers) {
+    (void)source; (void)n; (void)buffers;
+}
+
+void alListenerf(ALenum param, ALfloat value) {
+    (void)param; (void)value;
+}
+
+void alListener3f(ALenum param, ALfloat v1, ALfloat v2, ALfloat v3) {
+    (void)param; (void)v1; (void)v2; (void)v3;
+}
+
+void alListenerfv(ALenum param, const ALfloat *values) {
+    (void)param; (void)values;
+}
+
+ALCdevice *alcOpenDevice(const ALCchar *name) {
+    (void)name;
+    return NULL;
+}
+
+ALCboolean alcCloseDevice(ALCdevice *device) {
+    (void)device;
+    return AL_TRUE;
+}
+
+ALCcontext *alcCreateContext(ALCdevice *device, const ALCint *attrs) {
+    (void)device; (void)attrs;
+    return NULL;
+}
+
+void alcDestroyContext(ALCcontext *context) {
+    (void)context;
+}
+
+ALCboolean alcMakeContextCurrent(ALCcontext *context) {
+    (void)context;
+    return AL_FALSE;
+}
+
+const ALCchar *alcGetString(ALCdevice *device, ALCenum param) {
+    (void)device; (void)param;
+    return "host";
+}
+
+ALCboolean alcIsExtensionPresent(ALCdevice *device, const ALCchar *name) {
+    (void)device; (void)name;
+    return AL_FALSE;
+}
+
+void *alcGetProcAddress(ALCdevice *device, const ALCchar *name) {
+    (void)device; (void)name;
+    return NULL;
+}
+
+void alcSuspendContext(ALCcontext *context) {
+    (void)context;
+}
+
+void alcProcessContext(ALCcontext *context) {
+    (void)context;
+}
+
+// ===== VORBISFILE =====
+
+int ov_open_callbacks(void *datasource, OggVorbis_File *vf, const char *initial, long ibytes,
+                      ov_callbacks callbacks) {
+    (void)datasource; (void)vf; (void)initial; (void)ibytes; (void)callbacks;
+    return -1;
+}
+
+int ov_clear(OggVorbis_File *vf) {
+    (void)vf;
+    return 0;
+}
+
+vorbis_info *ov_info(OggVorbis_File *vf, int link) {
+    (void)vf; (void)link;
+    return NULL;
+}
+
+ogg_int64_t ov_pcm_total(OggVorbis_File *vf, int i) {
+    (void)vf; (void)i;
+    return 0;
+}
+
+int ov_pcm_seek(OggVorbis_File *vf, ogg_int64_t pos) {
+    (void)vf; (void)pos;
+    return -1;
+}
+
+long ov_read(OggVorbis_File *vf, char *buffer, int length, int bigendianp, int word, int sgned,
+             int *bitstream) {
+    (void)vf; (void)buffer; (void)length; (void)bigendianp; (void)word; (void)sgned; (void)bitstream;
+    return 0;
+}
+
+// ===== INTERNALS =====
+
+static SceUID obj_alloc(host_obj_kind_t kind, const char *name) {
+    pthread_mutex_lock(&objects_lock);
+    for (int i = 0; i < HOST_MAX_OBJECTS; i++) {
+        host_obj_t *obj = &objects[i];
+        if (obj->kind == HOST_OBJ_FREE) {
+            memset(obj, 0, sizeof(*obj));
+            obj->kind = kind;
+            snprintf(obj->name, sizeof(obj->name), "%s", name ? name : "");
+            pthread_mutex_init(&obj->lock, NULL);
+            pthread_cond_init(&obj->cond, NULL);
+            pthread_mutex_unlock(&objects_lock);
+            return HOST_UID_BASE + i;
+        }
+    }
+    pthread_mutex_unlock(&objects_lock);
+    return (int)HOST_ERROR;
+}
+
+static host_obj_t *obj_get(SceUID uid, host_obj_kind_t kind) {
+    int index = uid - HOST_UID_BASE;
+    if (index < 0 || index >= HOST_MAX_OBJECTS || objects[index].kind != kind) {
+        return NULL;
+    }
+    return &objects[index];
+}
+
+static void obj_free(SceUID uid) {
+    host_obj_t *obj = &objects[uid - HOST_UID_BASE];
+    pthread_mutex_destroy(&obj->lock);
+    pthread_cond_destroy(&obj->cond);
+    pthread_mutex_lock(&objects_lock);
+    obj->kind = HOST_OBJ_FREE;
+    pthread_mutex_unlock(&objects_lock);
+}
+
+// "ux0:data/x" -> "<root>/ux0/data/x"; host paths pass through
+static const char *map_path(const char *path, char *out, size_t size) {
+    const char *colon = strchr(path, ':');
+    const char *slash = strchr(path, '/');
+    if (!colon || colon - path > 8 || (slash && slash < colon)) {
+        return path;
+    }
+    snprintf(out, size, "%s/%.*s/%s", root_dir, (int)(colon - path), path, colon + 1);
+    return out;
+}
+
+static void deadline_after(struct timespec *ts, SceUInt us) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += us / 1000000;
+    ts->tv_nsec += (long)(us % 1000000) * 1000;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static int wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, const struct timespec *deadline) {
+    if (!deadline) {
+        pthread_cond_wait(cond, lock);
+        return 0;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) == ETIMEDOUT ? -1 : 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host stand-in for OpenAL: the types and enums audio.c uses. The calls are
+ * no-ops in bench/platform.c, so loaders and the source allocator run
+ * without an output device.
+ */
+
+#ifndef BENCH_AL_H
+#define BENCH_AL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef char ALboolean;
+typedef int ALint;
+typedef int ALsizei;
+typedef int ALenum;
+typedef unsigned int ALuint;
+typedef float ALfloat;
+typedef void ALvoid;
+
+#define AL_FALSE 0
+#define AL_TRUE 1
+#define AL_NO_ERROR 0
+#define AL_INVALID_NAME 0xA001
+#define AL_INVALID_ENUM 0xA002
+#define AL_INVALID_VALUE 0xA003
+#define AL_INVALID_OPERATION 0xA004
+#define AL_OUT_OF_MEMORY 0xA005
+
+#define AL_SOURCE_RELATIVE 0x202
+#define AL_PITCH 0x1003
+#define AL_POSITION 0x1004
+#define AL_VELOCITY 0x1006
+#define AL_LOOPING 0x1007
+#define AL_BUFFER 0x1009
+#define AL_GAIN 0x100A
+#define AL_ORIENTATION 0x100F
+#define AL_SOURCE_STATE 0x1010
+#define AL_PLAYING 0x1012
+#define AL_PAUSED 0x1013
+#define AL_STOPPED 0x1014
+#define AL_BUFFERS_QUEUED 0x1015
+#define AL_BUFFERS_PROCESSED 0x1016
+#define AL_SEC_OFFSET 0x1024
+#define AL_FORMAT_MONO16 0x1101
+#define AL_FORMAT_STEREO16 0x1103
+#define AL_FREQUENCY 0x2001
+#define AL_BITS 0x2002
+#define AL_CHANNELS 0x2003
+
+ALenum alGetError(void);
+void alGenSources(ALsizei n, ALuint *sources);
+void alDeleteSources(ALsizei n, const ALuint *sources);
+void alGenBuffers(ALsizei n, ALuint *buffers);
+void alDeleteBuffers(ALsizei n, const ALuint *buffers);
+void alBufferData(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+void alGetBufferi(ALuint buffer, ALenum param, ALint *value);
+void alSourcef(ALuint source, ALenum param, ALfloat value);
+void alSource3f(ALuint source, ALenum param, ALfloat v1, ALfloat v2, ALfloat v3);
+void alSourcei(ALuint source, ALenum param, ALint value);
+void alGetSourcei(ALuint source, ALenum param, ALint *value);
+void alGetSourcef(ALuint source, ALenum param, ALfloat *value);
+void alSourcePlay(ALuint source);
+void alSourceStop(ALuint source);
+void alSourceQueueBuffers(ALuint source, ALsizei n, const ALuint *buffers);
+void alSourceUnqueueBuffers(ALuint source, ALsizei n, ALuint *buffers);
+void alListenerf(ALenum param, ALfloat value);
+void alListener3f(ALenum param, ALfloat v1, ALfloat v2, ALfloat v3);
+void alListenerfv(ALenum param, const ALfloat *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_AL_H
@@ -0,0 +1,39 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host stand-in for the OpenAL context API (see AL/al.h)
+ */
+
+#ifndef BENCH_ALC_H
+#define BENCH_ALC_H
+
+#include "al.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ALCdevice ALCdevice;
+typedef struct ALCcontext ALCcontext;
+typedef char ALCboolean;
+typedef char ALCchar;
+typedef int ALCenum;
+typedef int ALCint;
+
+#define ALC_DEVICE_SPECIFIER 0x1005
+
+ALCdevice *alcOpenDevice(const ALCchar *name);
+ALCboolean alcCloseDevice(ALCdevice *device);
+ALCcontext *alcCreateContext(ALCdevice *device, const ALCint *attrs);
+void alcDestroyContext(ALCcontext *context);
+ALCboolean alcMakeContextCurrent(ALCcontext *context);
+const ALCchar *alcGetString(ALCdevice *device, ALCenum param);
+ALCboolean alcIsExtensionPresent(ALCdevice *device, const ALCchar *name);
+void *alcGetProcAddress(ALCdevice *device, const ALCchar *name);
+void alcSuspendContext(ALCcontext *context);
+void alcProcessContext(ALCcontext *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_ALC_H
@@ -0,0 +1,22 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host stand-in for the OpenAL-soft extensions audio.c uses (see AL/al.h)
+ */
+
+#ifndef BENCH_ALEXT_H
+#define BENCH_ALEXT_H
+
+#include "alc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*LPALCDEVICEPAUSESOFT)(ALCdevice *device);
+typedef void (*LPALCDEVICERESUMESOFT)(ALCdevice *device);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_ALEXT_H
@@ -0,0 +1,2 @@
+// Host build: see bench/stubs/sce_host.h
+#include "sce_host.h"
@@ -0,0 +1,217 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host Stand-ins for the VitaSDK Headers
+ *
+ * Just the types, constants and calls the benchmarked sources use. Values
+ * match the SDK where the port depends on them; the calls themselves are
+ * implemented over POSIX in bench/platform.c.
+ */
+
+#ifndef BENCH_SCE_HOST_H
+#define BENCH_SCE_HOST_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int SceUID;
+typedef unsigned int SceSize;
+typedef int SceInt;
+typedef unsigned int SceUInt;
+typedef int SceInt32;
+typedef unsigned int SceUInt32;
+typedef int64_t SceInt64;
+typedef uint64_t SceUInt64;
+typedef int64_t SceOff;
+typedef int SceMode;
+typedef int SceBool;
+typedef int SceKernelMemBlockType;
+
+// ===== THREADS =====
+
+typedef struct {
+    pthread_mutex_t mutex;
+} SceKernelLwMutexWork;
+
+typedef struct {
+    SceSize size;
+} SceKernelLwMutexOptParam;
+
+typedef int (*SceKernelThreadEntry)(SceSize args, void *argp);
+
+typedef struct {
+    SceSize size;
+    SceUID processId;
+    char name[32];
+    SceUInt attr;
+    int status;
+    SceKernelThreadEntry entry;
+    void *stack;
+    int stackSize;
+    int initPriority;
+    int currentPriority;
+    int initCpuAffinityMask;
+    int currentCpuAffinityMask;
+    int currentCpuId;
+    int lastExecutedCpuId;
+    SceUInt64 runClocks;
+} SceKernelThreadInfo;
+
+#define SCE_KERNEL_CPU_MASK_USER_0 0x10000
+#define SCE_KERNEL_CPU_MASK_USER_1 0x20000
+#define SCE_KERNEL_CPU_MASK_USER_2 0x40000
+#define SCE_KERNEL_THREAD_CPU_AFFINITY_MASK_DEFAULT 0
+
+#define SCE_EVENT_WAITAND 0x00000000
+#define SCE_EVENT_WAITOR 0x00000001
+#define SCE_EVENT_WAITCLEAR 0x00000002
+#define SCE_EVENT_WAITCLEAR_PAT 0x00000004
+
+#define SCE_KERNEL_ERROR_WAIT_TIMEOUT 0x80028005
+
+int sceKernelCreateLwMutex(SceKernelLwMutexWork *work, const char *name, unsigned int attr,
+                           int count, const SceKernelLwMutexOptParam *opt);
+int sceKernelDeleteLwMutex(SceKernelLwMutexWork *work);
+int sceKernelLockLwMutex(SceKernelLwMutexWork *work, int count, unsigned int *timeout);
+int sceKernelTryLockLwMutex(SceKernelLwMutexWork *work, int count);
+int sceKernelUnlockLwMutex(SceKernelLwMutexWork *work, int count);
+
+SceUID sceKernelCreateSema(const char *name, SceUInt attr, int init, int max, void *opt);
+int sceKernelDeleteSema(SceUID id);
+int sceKernelSignalSema(SceUID id, int count);
+int sceKernelWaitSema(SceUID id, int count, SceUInt *timeout);
+
+SceUID sceKernelCreateEventFlag(const char *name, int attr, int bits, void *opt);
+int sceKernelDeleteEventFlag(SceUID id);
+int sceKernelSetEventFlag(SceUID id, unsigned int bits);
+int sceKernelClearEventFlag(SceUID id, unsigned int bits);
+int sceKernelWaitEventFlag(SceUID id, unsigned int bits, unsigned int wait, unsigned int *out,
+                           SceUInt *timeout);
+
+SceUID sceKernelCreateThread(const char *name, SceKernelThreadEntry entry, int priority,
+                             SceSize stack_size, SceUInt attr, int affinity, const void *opt);
+int sceKernelStartThread(SceUID thid, SceSize args, void *argp);
+int sceKernelWaitThreadEnd(SceUID thid, int *stat, SceUInt *timeout);
+int sceKernelDeleteThread(SceUID thid);
+int sceKernelExitDeleteThread(int status);
+int sceKernelExitThread(int status);
+SceUID sceKernelGetThreadId(void);
+int sceKernelGetThreadInfo(SceUID thid, SceKernelThreadInfo *info);
+int sceKernelChangeThreadPriority(SceUID thid, int priority);
+int sceKernelChangeThreadCpuAffinityMask(SceUID thid, int mask);
+int sceKernelDelayThread(SceUInt delay);
+
+// ===== TIME =====
+
+SceUInt64 sceKernelGetProcessTimeWide(void);
+SceUInt32 sceKernelGetProcessTimeLow(void);
+SceUInt64 sceKernelGetSystemTimeWide(void);
+
+// ===== MEMORY =====
+
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_RW 0x0c20d060
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_RX 0x0c20d050
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_CDRAM_RW 0x09408060
+#define SCE_KERNEL_MEMBLOCK_TYPE_USER_MAIN_PHYCONT_RW 0x0c80d060
+
+SceUID sceKernelAllocMemBlock(const char *name, SceKernelMemBlockType type, SceSize size, void *opt);
+int sceKernelFreeMemBlock(SceUID uid);
+int sceKernelGetMemBlockBase(SceUID uid, void **base);
+
+void *sceClibMemcpy(void *dst, const void *src, SceSize len);
+void *sceClibMemset(void *dst, int ch, SceSize len);
+void *sceClibMemmove(void *dst, const void *src, SceSize len);
+int sceClibStrcmp(const char *s1, const char *s2);
+int sceClibPrintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+int sceClibSnprintf(char *dst, SceSize len, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+int sceClibVsnprintf(char *dst, SceSize len, const char *fmt, va_list args);
+
+// ===== FILES =====
+
+#define SCE_O_RDONLY 0x0001
+#define SCE_O_WRONLY 0x0002
+#define SCE_O_RDWR (SCE_O_RDONLY | SCE_O_WRONLY)
+#define SCE_O_NBLOCK 0x0004
+#define SCE_O_APPEND 0x0100
+#define SCE_O_CREAT 0x0200
+#define SCE_O_TRUNC 0x0400
+#define SCE_O_EXCL 0x0800
+
+#define SCE_SEEK_SET 0
+#define SCE_SEEK_CUR 1
+#define SCE_SEEK_END 2
+
+#define SCE_S_IFMT 0xF000
+#define SCE_S_IFDIR 0x1000
+#define SCE_S_IFREG 0x2000
+#define SCE_S_ISDIR(m) (((m) & SCE_S_IFMT) == SCE_S_IFDIR)
+#define SCE_S_ISREG(m) (((m) & SCE_S_IFMT) == SCE_S_IFREG)
+
+typedef struct {
+    SceMode st_mode;
+    unsigned int st_attr;
+    SceOff st_size;
+    // No timestamps: glibc defines st_ctime and friends as macros
+    unsigned int st_private[6];
+} SceIoStat;
+
+typedef struct {
+    SceIoStat d_stat;
+    char d_name[256];
+    void *d_private;
+    int dummy;
+} SceIoDirent;
+
+SceUID sceIoOpen(const char *file, int flags, SceMode mode);
+int sceIoClose(SceUID fd);
+int sceIoRead(SceUID fd, void *data, SceSize size);
+int sceIoWrite(SceUID fd, const void *data, SceSize size);
+int sceIoPread(SceUID fd, void *data, SceSize size, SceOff offset);
+SceOff sceIoLseek(SceUID fd, SceOff offset, int whence);
+int sceIoGetstat(const char *file, SceIoStat *stat);
+int sceIoGetstatByFd(SceUID fd, SceIoStat *stat);
+int sceIoMkdir(const char *dir, SceMode mode);
+int sceIoRemove(const char *file);
+int sceIoRename(const char *oldname, const char *newname);
+SceUID sceIoDopen(const char *dirname);
+int sceIoDread(SceUID fd, SceIoDirent *dir);
+int sceIoDclose(SceUID fd);
+
+// ===== AUDIO =====
+
+#define SCE_AUDIO_OUT_PORT_TYPE_MAIN 0
+#define SCE_AUDIO_OUT_PORT_TYPE_BGM 1
+#define SCE_AUDIO_OUT_MODE_MONO 0
+#define SCE_AUDIO_OUT_MODE_STEREO 1
+#define SCE_AUDIO_VOLUME_0DB 32768
+#define SCE_AUDIO_VOLUME_FLAG_L_CH 1
+#define SCE_AUDIO_VOLUME_FLAG_R_CH 2
+
+int sceAudioOutOpenPort(int type, int len, int freq, int mode);
+int sceAudioOutReleasePort(int port);
+int sceAudioOutOutput(int port, const void *buf);
+int sceAudioOutSetVolume(int port, int flag, int *vol);
+
+// ===== VITAGL =====
+
+typedef enum {
+    VGL_MEM_VRAM,
+    VGL_MEM_RAM,
+    VGL_MEM_SLOW,
+    VGL_MEM_BUDGET,
+    VGL_MEM_EXTERNAL,
+    VGL_MEM_ALL
+} vglMemType;
+
+size_t vglMemFree(vglMemType type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_SCE_HOST_H
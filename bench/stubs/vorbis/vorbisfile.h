@@ -0,0 +1,53 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Host stand-in for libvorbisfile. The OGG paths are not benchmarked;
+ * ov_open_callbacks() always fails in bench/platform.c.
+ */
+
+#ifndef BENCH_VORBISFILE_H
+#define BENCH_VORBISFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int64_t ogg_int64_t;
+
+typedef struct {
+    int version;
+    int channels;
+    long rate;
+} vorbis_info;
+
+typedef struct {
+    void *datasource;
+} OggVorbis_File;
+
+typedef struct {
+    size_t (*read_func)(void *ptr, size_t size, size_t nmemb, void *datasource);
+    int (*seek_func)(void *datasource, ogg_int64_t offset, int whence);
+    int (*close_func)(void *datasource);
+    long (*tell_func)(void *datasource);
+} ov_callbacks;
+
+#define OV_HOLE (-3)
+
+static const ov_callbacks OV_CALLBACKS_DEFAULT __attribute__((unused)) = { NULL, NULL, NULL, NULL };
+
+int ov_open_callbacks(void *datasource, OggVorbis_File *vf, const char *initial, long ibytes,
+                      ov_callbacks callbacks);
+int ov_clear(OggVorbis_File *vf);
+vorbis_info *ov_info(OggVorbis_File *vf, int link);
+ogg_int64_t ov_pcm_total(OggVorbis_File *vf, int i);
+int ov_pcm_seek(OggVorbis_File *vf, ogg_int64_t pos);
+long ov_read(OggVorbis_File *vf, char *buffer, int length, int bigendianp, int word, int sgned,
+             int *bitstream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_VORBISFILE_H
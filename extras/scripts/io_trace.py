@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+# Fluffy Diver PS Vita Port - I/O Trace Reader
+#
+# Reads the dump written by source/io_trace.c (build with IO_TRACE 1):
+#   io_trace.py <io_trace.bin> [--manifest out.txt] [--top N] [--events]
+# Prints per-file access counts and a read-size histogram, and optionally
+# writes a prefetch manifest: asset names, one per line, in the order the
+# game first asked for them.
+
+import argparse
+import collections
+import struct
+import sys
+
+MAGIC = 0x52544F49  # "IOTR"
+VERSION = 1
+
+HEADER = struct.Struct("<8I")
+EVENT = struct.Struct("<IiHHII")
+
+OPS = [
+    "open", "fopen", "asset_open", "asset_read", "asset_seek",
+    "asset_buffer", "asset_close", "cache_hit", "cache_miss", "fail",
+]
+NO_PATH = 0xFFFF
+ASSET_PREFIX = "ux0:data/fluffydiver/assets/"
+
+# Ops that mean the game wanted the file's contents
+TOUCH_OPS = {"open", "fopen", "asset_open", "cache_hit", "cache_miss"}
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        sys.exit("%s: too short for a trace header" % path)
+
+    (magic, version, record_size, count, total,
+     path_count, path_bytes, _) = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s: not an I/O trace (magic %08x, version %d)" % (path, magic, version))
+    if record_size != EVENT.size:
+        sys.exit("%s: record size %d, expected %d" % (path, record_size, EVENT.size))
+
+    pos = HEADER.size
+    pool = data[pos:pos + path_bytes]
+    pos += path_bytes
+    paths = [p.decode("utf-8", "replace") for p in pool.split(b"\0")[:path_count]]
+
+    events = []
+    for i in range(count):
+        time_us, thread, op, path_id, offset, length = EVENT.unpack_from(data, pos + i * EVENT.size)
+        name = paths[path_id] if path_id < len(paths) else None
+        op_name = OPS[op] if op < len(OPS) else "op%d" % op
+        events.append((time_us, thread, op_name, name, offset, length))
+
+    # Writers race the dump, so order by time rather than by slot
+    events.sort(key=lambda e: e[0])
+    return events, total
+
+
+def asset_name(path):
+    if path is None:
+        return None
+    if path.startswith(ASSET_PREFIX):
+        return path[len(ASSET_PREFIX):]
+    if ":" in path or path.startswith("/"):
+        return None
+    return path
+
+
+def size_bucket(length):
+    bucket = 1
+    while bucket < length:
+        bucket <<= 1
+    return bucket
+
+
+def human(n):
+    for unit in ("B", "KB", "MB"):
+        if n < 1024 or unit == "MB":
+            return "%d %s" % (n, unit) if unit == "B" else "%.1f %s" % (n, unit)
+        n /= 1024.0
+
+
+def report(events, total, top):
+    files = collections.OrderedDict()
+    reads = collections.Counter()
+    for time_us, thread, op, name, offset, length in events:
+        stats = files.setdefault(name, {
+            "first": time_us, "ops": collections.Counter(), "bytes": 0,
+            "threads": set(), "seeks": 0, "end": None,
+        })
+        stats["ops"][op] += 1
+        stats["threads"].add(thread)
+        if op in ("asset_read", "cache_miss"):
+            stats["bytes"] += length
+        if op == "asset_read":
+            reads[size_bucket(length)] += 1
+            if stats["end"] is not None and offset != stats["end"]:
+                stats["seeks"] += 1
+            stats["end"] = offset + length
+
+    print("%d events (%d recorded, %d lost to wrap), %d files"
+          % (len(events), total, total - len(events), len(files)))
+    if events:
+        print("span %.3f s" % ((events[-1][0] - events[0][0]) / 1e6))
+
+    ranked = sorted(files.items(), key=lambda kv: kv[1]["bytes"], reverse=True)
+    print("\n%-48s %7s %7s %7s %6s %6s %10s" %
+          ("file", "opens", "reads", "hits", "misses", "jumps", "bytes"))
+    for name, stats in ranked[:top]:
+        ops = stats["ops"]
+        opens = ops["open"] + ops["fopen"] + ops["asset_open"]
+        print("%-48s %7d %7d %7d %6d %6d %10s" % (
+            (name or "<unknown>")[-48:], opens, ops["asset_read"], ops["cache_hit"],
+            ops["cache_miss"], stats["seeks"], human(stats["bytes"])))
+
+    if reads:
+        print("\nAAsset_read sizes")
+        peak = max(reads.values())
+        for bucket in sorted(reads):
+            bar = "#" * max(1, reads[bucket] * 40 // peak)
+            print("  <= %-9s %7d %s" % (human(bucket), reads[bucket], bar))
+
+    failed = [name for name, stats in files.items() if stats["ops"]["fail"]]
+    if failed:
+        print("\nfailed opens: %s" % ", ".join(n or "<unknown>" for n in failed))
+
+
+def manifest(events):
+    order = []
+    seen = set()
+    for _, _, op, name, _, _ in events:
+        if op not in TOUCH_OPS:
+            continue
+        asset = asset_name(name)
+        if asset and asset not in seen:
+            seen.add(asset)
+            order.append(asset)
+    return order
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Summarise a Fluffy Diver I/O trace")
+    parser.add_argument("trace")
+    parser.add_argument("--manifest", metavar="OUT",
+                        help="write asset names in first-access order")
+    parser.add_argument("--top", type=int, default=40,
+                        help="files to list, by bytes read (default 40)")
+    parser.add_argument("--events", action="store_true",
+                        help="print every event")
+    args = parser.parse_args()
+
+    events, total = load(args.trace)
+
+    if args.events:
+        for time_us, thread, op, name, offset, length in events:
+            print("%10.3f ms  %08x  %-12s %-40s %10d %10d"
+                  % (time_us / 1000.0, thread & 0xFFFFFFFF, op, name or "-", offset, length))
+        print()
+
+    report(events, total, args.top)
+
+    if args.manifest:
+        order = manifest(events)
+        with open(args.manifest, "w") as f:
+            for name in order:
+                f.write(name + "\n")
+        print("\nWrote %d assets to %s" % (len(order), args.manifest))
+
+
+if __name__ == "__main__":
+    main()
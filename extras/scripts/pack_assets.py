@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# Fluffy Diver PS Vita Port - Asset Archive Packer
+#
+# Bundles an assets directory into a single archive for source/asset_pack.c:
+#   pack_assets.py <assets_dir> <out.fdpk> [--lz4]
+# Copy the result to ux0:data/fluffydiver/assets.fdpk. Anything still left in
+# ux0:data/fluffydiver/assets/ overrides the packed copy of the same name.
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x4B504446  # "FDPK"
+VERSION = 1
+ALIGN = 16
+FLAG_LZ4 = 0x1
+
+HEADER = struct.Struct("<8I")
+ENTRY = struct.Struct("<6I")
+
+
+def fnv1a(name):
+    h = 2166136261
+    for b in name:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def lz4_compress(data):
+    """Greedy raw LZ4 block compressor (no frame header)."""
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    # Spec: the last match must start 12 bytes before the end and the final
+    # 5 bytes are always literals
+    match_limit = n - 12
+    while i < match_limit:
+        key = data[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 0xFFFF:
+            i += 1
+            continue
+
+        length = 4
+        while i + length < n - 5 and data[cand + length] == data[i + length]:
+            length += 1
+
+        _emit_sequence(out, data[anchor:i], i - cand, length)
+        i += length
+        anchor = i
+
+    _emit_sequence(out, data[anchor:], 0, 0)
+    return bytes(out)
+
+
+def _emit_length(out, value):
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+
+
+def _emit_sequence(out, literals, offset, match_len):
+    lit_len = len(literals)
+    token = (min(lit_len, 15) << 4)
+    if match_len:
+        token |= min(match_len - 4, 15)
+    out.append(token)
+    if lit_len >= 15:
+        _emit_length(out, lit_len - 15)
+    out += literals
+    if match_len:
+        out += struct.pack("<H", offset)
+        if match_len - 4 >= 15:
+            _emit_length(out, match_len - 4 - 15)
+
+
+def collect(root):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for fn in sorted(filenames):
+            if fn.startswith("."):
+                continue
+            path = os.path.join(dirpath, fn)
+            name = os.path.relpath(path, root).replace(os.sep, "/")
+            files.append((name, path))
+    return files
+
+
+def align(value):
+    return (value + ALIGN - 1) & ~(ALIGN - 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack Fluffy Diver assets")
+    parser.add_argument("assets_dir")
+    parser.add_argument("output")
+    parser.add_argument("--lz4", action="store_true",
+                        help="LZ4-compress entries that shrink by at least 1/8")
+    args = parser.parse_args()
+
+    files = collect(args.assets_dir)
+    if not files:
+        sys.exit("no files found in %s" % args.assets_dir)
+
+    entries = []
+    for name, path in files:
+        encoded = name.encode("utf-8")
+        if len(encoded) >= 256:
+            sys.exit("asset name too long: %s" % name)
+        with open(path, "rb") as f:
+            raw = f.read()
+        payload, flags = raw, 0
+        if args.lz4 and raw:
+            packed = lz4_compress(raw)
+            if len(packed) <= len(raw) - len(raw) // 8:
+                payload, flags = packed, FLAG_LZ4
+        entries.append([fnv1a(encoded), encoded, payload, len(raw), flags])
+
+    entries.sort(key=lambda e: (e[0], e[1]))
+
+    names = bytearray()
+    name_offsets = []
+    for e in entries:
+        name_offsets.append(len(names))
+        names += e[1] + b"\0"
+
+    toc_offset = HEADER.size
+    names_offset = toc_offset + ENTRY.size * len(entries)
+    data_offset = align(names_offset + len(names))
+
+    toc = bytearray()
+    body = bytearray()
+    for e, name_offset in zip(entries, name_offsets):
+        offset = data_offset + len(body)
+        toc += ENTRY.pack(e[0], name_offset, offset, len(e[2]), e[3], e[4])
+        body += e[2]
+        body += b"\0" * (align(len(body)) - len(body))
+
+    with open(args.output, "wb") as f:
+        f.write(HEADER.pack(MAGIC, VERSION, len(entries), toc_offset,
+                            names_offset, len(names), data_offset, 0))
+        f.write(toc)
+        f.write(names)
+        f.write(b"\0" * (data_offset - names_offset - len(names)))
+        f.write(body)
+
+    raw_total = sum(e[3] for e in entries)
+    stored_total = sum(len(e[2]) for e in entries)
+    compressed = sum(1 for e in entries if e[4] & FLAG_LZ4)
+    print("Packed %d files (%d compressed): %d -> %d bytes"
+          % (len(entries), compressed, raw_total, stored_total))
+
+
+if __name__ == "__main__":
+    main()
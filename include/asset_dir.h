@@ -0,0 +1,34 @@
+/*
+ * include/asset_dir.h
+ * Asset Directory Index for Fluffy Diver PS Vita Port
+ *
+ * Built once at boot from the packed archive's table of contents and a
+ * scan of the loose assets directory. Every file name is interned into one
+ * string blob, grouped by directory and sorted, so listing a directory is a
+ * walk over a contiguous range with no allocation.
+ */
+
+#ifndef ASSET_DIR_H
+#define ASSET_DIR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int asset_dir_build(void);
+void asset_dir_free(void);
+
+// Range of files directly inside dir ("" is the asset root), 0 if found
+int asset_dir_find(const char *dir, int *first, int *count);
+
+// 1 if the asset exists, packed or loose, without touching the card
+int asset_dir_exists(const char *path);
+
+// Leaf name of file `index`, valid until asset_dir_free()
+const char *asset_dir_file_name(int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_DIR_H
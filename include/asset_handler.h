@@ -0,0 +1,59 @@
+/*
+ * include/asset_handler.h
+ * Asset System Header for Fluffy Diver PS Vita Port
+ */
+
+#ifndef ASSET_HANDLER_H
+#define ASSET_HANDLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ref-counted cache handle: (generation << ASSET_HANDLE_SLOT_BITS) | slot.
+// Stale handles are rejected, never dereferenced.
+typedef int asset_handle_t;
+#define ASSET_HANDLE_INVALID (-1)
+
+// Asset system initialization and cleanup
+int init_asset_system(void);
+void cleanup_asset_system(void);
+
+// Asset loading. The returned pointer is owned by the cache and stays valid
+// until the entry is evicted; pin it with asset_acquire() to keep it longer.
+void *load_asset(const char *filename, size_t *out_size);
+
+// 0 when load_asset() transforms the file, so cached bytes differ from disk
+int asset_cache_is_raw(const char *filename);
+
+// Async loading on the worker threads. Callbacks run on a worker (or on the
+// caller if the asset is already cached) with the data pinned for the call;
+// data is NULL on failure. Requests for a file already in flight are merged.
+typedef void (*asset_load_cb)(const char *filename, void *data, size_t size, void *user);
+int load_asset_async(const char *filename, asset_load_cb cb, void *user);
+int prefetch_group(const char **filenames, int count);
+
+// Pinned access: acquired assets are never evicted until released
+asset_handle_t asset_acquire(const char *filename);
+const void *asset_handle_data(asset_handle_t handle, size_t *out_size);
+void asset_release(asset_handle_t handle);
+
+// Cache budget (bytes of asset data kept resident)
+void asset_set_cache_budget(size_t bytes);
+size_t asset_get_cache_usage(void);
+size_t asset_get_cache_budget(void);
+
+// Lookup counters since boot; either pointer may be NULL
+void asset_get_cache_stats(uint32_t *hits, uint32_t *misses);
+
+// Debug functions
+void asset_debug_info(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_HANDLER_H
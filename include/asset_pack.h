@@ -0,0 +1,74 @@
+/*
+ * include/asset_pack.h
+ * Packed Asset Archive for Fluffy Diver PS Vita Port
+ *
+ * The archive is built offline by extras/scripts/pack_assets.py from the
+ * contents of ux0:data/fluffydiver/assets/ and opened once at boot. Every
+ * read is an offset read from that single handle, so loading an asset no
+ * longer costs a memory card open. Loose files left in the assets directory
+ * override archive entries of the same name.
+ */
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// On-disk layout, all fields little endian:
+//   header | toc[entry_count] | names | payloads (each 16-byte aligned)
+// The TOC is sorted by (hash, name) where hash is FNV-1a of the name.
+#define ASSET_PACK_MAGIC     0x4B504446  // "FDPK"
+#define ASSET_PACK_VERSION   1
+#define ASSET_PACK_ALIGN     16
+
+#define ASSET_PACK_FLAG_LZ4  0x1         // Payload is a raw LZ4 block
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t toc_offset;
+    uint32_t names_offset;
+    uint32_t names_size;
+    uint32_t data_offset;
+    uint32_t reserved;
+} asset_pack_header_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t name_offset;  // Into the names blob
+    uint32_t offset;       // Absolute payload offset in the archive
+    uint32_t size;         // Stored bytes
+    uint32_t raw_size;     // Bytes after decompression
+    uint32_t flags;
+} asset_pack_entry_t;
+
+// Opens the archive and reads its table of contents; safe to call again
+int asset_pack_open(const char *path);
+void asset_pack_close(void);
+int asset_pack_is_open(void);
+const char *asset_pack_get_path(void);
+
+// TOC iteration, in archive order
+int asset_pack_entry_count(void);
+const char *asset_pack_entry_name(int index);
+
+// NULL when the name is not packed or a loose file overrides it
+const asset_pack_entry_t *asset_pack_find(const char *name);
+
+// Offset read of an uncompressed entry; returns bytes read or -1
+int asset_pack_read(const asset_pack_entry_t *entry, void *buf, size_t offset, size_t count);
+
+// Whole entry in a malloc'd buffer, decompressed if needed
+void *asset_pack_load(const asset_pack_entry_t *entry, size_t *out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_PACK_H
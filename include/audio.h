@@ -7,6 +7,7 @@
 #define AUDIO_H
 
 // Audio initialization and cleanup
+void audio_set_source_limit(int count); // Before audio_init(); defaults to MAX_AUDIO_SOURCES
 int audio_init(void);
 void audio_cleanup(void);
 
@@ -15,6 +16,12 @@ int audio_play_sound(const char *filename, float volume, int looping, int priori
 int audio_play_music(const char *filename, float volume, int looping);
 void audio_stop_sound(int sound_id);
 void audio_stop_all_sounds(void);
+void audio_set_sound_volume(int sound_id, float volume);
+void audio_set_sound_pitch(int sound_id, float pitch);
+
+// SFX bank: decode files up front so the first play doesn't hit storage.
+// Loading happens on the audio thread; returns the number of files queued.
+int audio_preload_bank(const char **filenames, int count);
 
 // Volume control
 void audio_set_master_volume(float volume);
@@ -24,10 +31,16 @@ float audio_get_master_volume(void);
 float audio_get_music_volume(void);
 float audio_get_sfx_volume(void);
 
+// Per-frame update from the game thread (drains completion events)
+void audio_update(void);
+
 // Audio state
 int audio_is_playing(int sound_id);
 int audio_get_active_sources(void);
 
+// The mixing thread, for CPU accounting; -1 while audio is down
+int audio_get_thread_id(void);
+
 // Configuration
 void audio_enable(int enabled);
 void audio_enable_music(int enabled);
@@ -36,6 +49,12 @@ int audio_is_enabled(void);
 int audio_is_music_enabled(void);
 int audio_is_sfx_enabled(void);
 
+// Suspend: stop the audio thread, run any SFX bank trim the memory governor
+// asked for and pause the output; resume picks up where the voices were.
+// Main thread only.
+void audio_suspend(void);
+void audio_resume(void);
+
 // Debug functions
 void audio_debug_info(void);
 
@@ -0,0 +1,59 @@
+/*
+ * include/audio_mixer.h
+ * Software Mixer for Fluffy Diver PS Vita Port
+ *
+ * With AUDIO_MIXER set, audio.c plays through this instead of OpenAL-soft:
+ * one high-priority thread mixes every playing voice straight into an
+ * sceAudioOut port, AUDIO_BUFFER_SIZE frames at a time, with NEON kernels
+ * for the gain and the final clamp. PCM is converted to 48 kHz stereo when
+ * it is loaded, so only a pitched voice resamples while mixing. The calls
+ * mirror the slice of OpenAL audio.c uses (sources, buffers, and buffer
+ * queues for music), so audio.c maps its al*() calls onto them and keeps
+ * its command ring, sound bank and voice stealing unchanged.
+ */
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <AL/al.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The rate sceAudioOut's main port runs at; buffers are converted to it
+#define AUDIO_MIXER_RATE 48000
+
+// Open the output port and start the mixer thread; 0 on success
+int audio_mixer_open(void);
+
+// Stop the thread and release the port (sources and buffers are kept)
+void audio_mixer_close(void);
+
+// Mix `frames` stereo frames of every playing voice into `out`
+void audio_mixer_render(int16_t *out, int frames);
+
+// OpenAL equivalents, same arguments and semantics for what audio.c uses
+ALenum audio_mixer_get_error(void);
+void audio_mixer_gen_sources(ALsizei n, ALuint *sources);
+void audio_mixer_delete_sources(ALsizei n, const ALuint *sources);
+void audio_mixer_gen_buffers(ALsizei n, ALuint *buffers);
+void audio_mixer_delete_buffers(ALsizei n, const ALuint *buffers);
+void audio_mixer_buffer_data(ALuint buffer, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq);
+void audio_mixer_get_buffer_i(ALuint buffer, ALenum param, ALint *value);
+void audio_mixer_source_f(ALuint source, ALenum param, ALfloat value);
+void audio_mixer_source_i(ALuint source, ALenum param, ALint value);
+void audio_mixer_get_source_i(ALuint source, ALenum param, ALint *value);
+void audio_mixer_get_source_f(ALuint source, ALenum param, ALfloat *value);
+void audio_mixer_play(ALuint source);
+void audio_mixer_stop(ALuint source);
+void audio_mixer_queue_buffers(ALuint source, ALsizei n, const ALuint *buffers);
+void audio_mixer_unqueue_buffers(ALuint source, ALsizei n, ALuint *buffers);
+void audio_mixer_set_gain(ALfloat gain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_MIXER_H
@@ -0,0 +1,36 @@
+/*
+ * include/boot_graph.h
+ * Boot Task Graph for Fluffy Diver PS Vita Port
+ *
+ * Startup steps are registered as tasks with explicit dependencies and run
+ * together: tasks that need the GL context (or otherwise have to stay on
+ * the main thread) run there, everything else on two worker threads on
+ * cores 1 and 2. A task starts as soon as all of its dependencies have
+ * finished, so boot takes as long as its longest chain.
+ */
+
+#ifndef BOOT_GRAPH_H
+#define BOOT_GRAPH_H
+
+#include <stdint.h>
+
+#define BOOT_MAX_TASKS 16
+
+// Dependency mask for a task id returned by boot_graph_add()
+#define BOOT_DEP(id) (1u << (id))
+
+typedef enum {
+    BOOT_ON_WORKER = 0,
+    BOOT_ON_MAIN = 1
+} boot_thread_t;
+
+// 0 on success; a failing task skips everything that depends on it
+typedef int (*boot_task_fn)(void);
+
+// Task id, or -1; tasks may only depend on ones added before them
+int boot_graph_add(const char *name, boot_task_fn fn, boot_thread_t thread, uint32_t deps);
+
+// Run every task to completion; 0 when all succeeded
+int boot_graph_run(void);
+
+#endif // BOOT_GRAPH_H
@@ -15,32 +15,67 @@
 #define LOAD_ADDRESS        0x98000000
 #define HEAP_SIZE          (256 * 1024 * 1024)  // 256MB
 #define STACK_SIZE         (1024 * 1024)         // 1MB
+#define ASSET_CACHE_BUDGET (HEAP_SIZE / 4)      // Resident asset data before LRU eviction
+#define MEM_POOL            1                    // Serve the game's small mallocs from size-class slabs
+#define MEM_POOL_ARENA_SIZE (32 * 1024 * 1024)  // Slab arena, carved out of the heap at boot
+#define MEM_GOVERNOR        1                    // Purge caches in priority order when heap or VRAM runs low
+#define MEM_HEAP_LOW_WATER  (16 * 1024 * 1024)  // Free heap below which caches are purged
+#define MEM_VRAM_LOW_WATER  (8 * 1024 * 1024)   // Free VRAM below which caches are purged
+#define THREAD_POLICY       1                    // Pin and prioritise threads by name (reimpl/pthr.c)
+#define THREAD_DEFAULT_STACK_SIZE (512 * 1024)   // Game threads that don't ask for a size
+#define PRELINK_CACHE       1                    // Reuse the relocated .so image across boots
+#define JNI_LOOKUP_CACHE    1                    // Hashed JNI method/field IDs, indexed dispatch (jni_cache.c)
+#define FAST_LIBC           1                    // sceClib/NEON/fast-math imports picked by settings.cfg fast_imports
 
 // File paths
 #define SO_PATH            "ux0:data/fluffydiver/libFluffyDiver.so"
+#ifndef DATA_PATH
 #define DATA_PATH          "ux0:data/fluffydiver"
+#endif
 #define ASSETS_PATH        "ux0:data/fluffydiver/assets"
+#define ASSET_PACK_PATH    "ux0:data/fluffydiver/assets.fdpk"
 #define SAVE_PATH          "ux0:data/fluffydiver/save"
+#define SAVE_WRITE_BEHIND   1                    // Saves buffered in memory, written atomically off the main thread
 #define SETTINGS_PATH      "ux0:data/fluffydiver/settings.cfg"
 
 // Screen configuration
 #define SCREEN_WIDTH        960
 #define SCREEN_HEIGHT       544
 #define TARGET_FPS          60
+#define FRAME_PACE_MODE     0                    // 0 = 60 Hz, 1 = 30 Hz, 2 = 60 with eased drop to 30 (balanced profile)
+#define PERF_PROFILE_DEFAULT 1                   // 0 = battery, 1 = balanced, 2 = max; settings.cfg perf_profile overrides
+#define PERF_GOVERNOR       1                    // Raise clocks while frames miss budget; settings.cfg perf_governor overrides
+#define GAME_FIXED_TIMESTEP 0                    // Run OnGameUpdate at GAME_TICK_RATE, several per frame if behind
+#define GAME_TICK_RATE      60
+#define GAME_MAX_TICKS      4                    // Per rendered frame; older backlog is dropped
 
 // OpenGL configuration
 #define VERTEX_POOL_SIZE    (2 * 1024 * 1024)   // 2MB
 #define VERTEX_RAM_SIZE     (24 * 1024 * 1024)  // 24MB
 #define TEXTURE_CACHE_SIZE  (64 * 1024 * 1024)  // 64MB
+#define TEXTURE_TRANSCODE   1                    // Opaque -> RGB565, alpha -> RGBA4444; 0 keeps RGBA8888
+#define TEXTURE_MIPMAPS     1                    // Box-filtered mips for power-of-two textures
+#define TEXTURE_DISK_CACHE  1                    // Keep transcoded textures in DATA_PATH/textures
+#define GL_STATE_FILTER     1                    // Drop redundant GL state changes from the game
+#define GL_SPRITE_BATCH     0                    // Merge GLES1 client-array draws (needs GL_STATE_FILTER)
+#define GL_SPRITE_ATLAS     0                    // Pack small sprite textures into shared pages (needs GL_SPRITE_BATCH)
+#define GL_ATLAS_PAGE_SIZE  1024                 // Atlas page side, 1024 or 2048
+#define GL_ATLAS_MAX_SPRITE 256                  // Larger uploads keep their own texture
+#define GL_UPLOAD_FILTER    0                    // Drop re-uploads of pixels a texture already holds (needs GL_SPRITE_BATCH)
+#define GL_UPLOAD_FILTER_MAX_BYTES (64 * 1024)   // Larger uploads are never hashed
+#define DYNAMIC_RESOLUTION  0                    // Render offscreen, scaled on GPU time, and upscale to the screen
+#define DYNRES_MIN_WIDTH    720                  // Smallest render width; height keeps the aspect
 
 // Audio configuration
 #define MAX_AUDIO_SOURCES   32
 #define AUDIO_SAMPLE_RATE   44100
 #define AUDIO_BUFFER_SIZE   1024
+#define AUDIO_MIXER         0                    // Mix on our own sceAudioOut thread instead of OpenAL-soft (audio_mixer.c)
 
 // Input configuration
 #define TOUCH_DEADZONE      0.1f
 #define ANALOG_DEADZONE     0.2f
+#define INPUT_THREAD        1                    // Sample input on its own thread into an event queue
 
 // Debug configuration
 #ifdef DEBUG
@@ -58,15 +93,22 @@
 #define DEBUG_JNI           0
 #define LOG_LEVEL           LOG_INFO
 #endif
+#define PERF_HUD            1                    // Frame-time overlay, toggled with L + R + TRIANGLE
+#define IO_TRACE            0                    // Record file/asset I/O to DATA_PATH/cache/io_trace.bin
+#define REPLAY_MODE         0                    // 1 = record input to DATA_PATH/replay, 2 = replay it and report
+#define REPLAY_DELTA_MS     16                   // Fixed game step while recording or replaying
 
 // Performance configuration
-#define ENABLE_PROFILING    1
+#define ENABLE_PROFILING    1                    // Profiler zones (include/profiler.h); 0 compiles them out
+#define PROFILER_CAPTURE_FRAMES 300              // Frames per capture, started with L + R + CIRCLE
+#define PROFILER_BOOT_CAPTURE 0                  // Also capture from boot through the first frames
 #define ENABLE_THREADING    1
 #define ENABLE_VSYNC        1
 #define ENABLE_MSAA         1
 
 // Feature toggles
 #define ENABLE_SAVE_SYSTEM  1
+#define APP_LIFECYCLE       1                    // Pause, release caches and stop audio on standby (lifecycle.c)
 #define ENABLE_ACHIEVEMENTS 1
 #define ENABLE_LEADERBOARDS 0  // Disabled for offline play
 #define ENABLE_MONETIZATION 0  // Disabled for Vita port
@@ -167,6 +209,22 @@ MAKE_VERSION(VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH)
 #error "Vertex RAM size too large"
 #endif
 
+#if GL_SPRITE_BATCH && !GL_STATE_FILTER
+#error "GL_SPRITE_BATCH relies on GL_STATE_FILTER to see state changes"
+#endif
+
+#if GL_SPRITE_ATLAS && !GL_SPRITE_BATCH
+#error "GL_SPRITE_ATLAS hooks texture uploads through the GL_SPRITE_BATCH entry points"
+#endif
+
+#if GL_UPLOAD_FILTER && !GL_SPRITE_BATCH
+#error "GL_UPLOAD_FILTER hooks texture uploads through the GL_SPRITE_BATCH entry points"
+#endif
+
+#if GL_ATLAS_PAGE_SIZE != 1024 && GL_ATLAS_PAGE_SIZE != 2048
+#error "GL_ATLAS_PAGE_SIZE must be 1024 or 2048"
+#endif
+
 #if MAX_AUDIO_SOURCES > 64
 #error "Too many audio sources"
 #endif
@@ -0,0 +1,44 @@
+/*
+ * include/frame_pacer.h
+ * Frame Pacing for Fluffy Diver PS Vita Port
+ *
+ * The display vblank counter is the frame clock: each frame is held to a
+ * whole number of vblanks, and the time step handed to OnGameUpdate is the
+ * vblank-quantised frame length run through a low-pass filter, so a frame
+ * that just misses its slot does not turn into a 16/33 ms see-saw.
+ */
+
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <stdint.h>
+
+typedef enum {
+    FRAME_PACE_60 = 0,              // Every vblank
+    FRAME_PACE_30 = 1,              // Every second vblank
+    FRAME_PACE_HALF_INTERPOLATED = 2  // 60, dropping to 30 under load, step eased between rates
+} frame_pace_mode_t;
+
+int frame_pacer_init(frame_pace_mode_t mode);
+void frame_pacer_set_mode(frame_pace_mode_t mode);
+frame_pace_mode_t frame_pacer_get_mode(void);
+
+#define FRAME_PACE_MAX_SWAP_INTERVAL 4
+
+// The game's eglSwapInterval(): hold every frame for at least `vblanks`,
+// clamped to 1..FRAME_PACE_MAX_SWAP_INTERVAL, on top of the mode's own rate
+void frame_pacer_set_swap_interval(int vblanks);
+
+// Block until this frame's vblank slot; call once per frame after presenting
+void frame_pacer_wait(void);
+
+// Smoothed time step for the next game update, in milliseconds
+int frame_pacer_delta_ms(void);
+
+// Measured time between the last two frames, in microseconds
+uint64_t frame_pacer_frame_time(void);
+
+// Vblanks per frame currently targeted
+int frame_pacer_interval(void);
+
+#endif // FRAME_PACER_H
@@ -16,9 +16,13 @@ void graphics_cleanup(void);
 void graphics_frame_start(void);
 void graphics_frame_end(void);
 
-// Shader management
+// Shader management. Shaders are cached by source content and ref-counted:
+// release each graphics_load_shader() result when done with it; programs
+// hold their own references until graphics_delete_program().
 GLuint graphics_load_shader(GLenum type, const char *source);
 GLuint graphics_create_program(GLuint vertex_shader, GLuint fragment_shader);
+void graphics_release_shader(GLuint shader);
+void graphics_delete_program(GLuint program);
 
 // Texture management
 GLuint graphics_load_texture(const char *path);
@@ -26,6 +30,26 @@ GLuint graphics_load_texture(const char *path);
 // Performance monitoring
 int graphics_get_fps(void);
 
+#define GRAPHICS_STATS_FRAMES 120
+
+typedef struct {
+    float min_ms;
+    float avg_ms;
+    float p99_ms;
+} graphics_timing_t;
+
+typedef struct {
+    int frames;                 // Frames in the window, up to GRAPHICS_STATS_FRAMES
+    graphics_timing_t cpu;      // graphics_frame_start() to the swap call returning
+    graphics_timing_t gpu;      // Swap submit to the scene reaching the display queue
+} graphics_frame_stats_t;
+
+// Rolling timings over the last GRAPHICS_STATS_FRAMES frames
+void graphics_get_frame_stats(graphics_frame_stats_t *stats);
+
+// Newest GPU frame times first, in us; the number written, up to max
+int graphics_get_gpu_times(uint32_t *out, int max);
+
 // Coordinate transformation
 void graphics_screen_to_game_coords(float screen_x, float screen_y, float *game_x, float *game_y);
 void graphics_game_to_screen_coords(float game_x, float game_y, float *screen_x, float *screen_y);
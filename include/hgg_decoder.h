@@ -0,0 +1,33 @@
+/*
+ * include/hgg_decoder.h
+ * Streaming HGG Decoder for Fluffy Diver PS Vita Port
+ *
+ * Compressed .hgg files start with an 8-byte header (signature, then the
+ * uncompressed size) followed by a zlib stream. The caller's thread reads
+ * the stream in chunks while a dedicated decoder thread inflates the
+ * previous chunk into a destination buffer sized once from the header.
+ */
+
+#ifndef HGG_DECODER_H
+#define HGG_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HGG_SIGNATURE      "HGG\0"  // Compared as bytes
+#define HGG_SIGNATURE_SIZE 4
+#define HGG_HEADER_SIZE    8
+
+// Positional reader over the compressed source; returns bytes read or < 0
+typedef int (*hgg_read_fn)(void *ctx, void *buf, size_t offset, size_t count);
+
+int hgg_decoder_init(void);
+void hgg_decoder_shutdown(void);
+
+// 1 if the first HGG_HEADER_SIZE bytes carry the compressed signature
+int hgg_is_compressed(const void *header, size_t size);
+
+// Decodes `src_size` bytes of compressed HGG into a malloc'd buffer
+int hgg_decode(hgg_read_fn read, void *ctx, size_t src_size, void **out, size_t *out_size);
+
+#endif // HGG_DECODER_H
@@ -0,0 +1,48 @@
+/*
+ * include/input.h
+ * Input Sampling for Fluffy Diver PS Vita Port
+ *
+ * A dedicated thread blocks on sceCtrlReadBufferPositive, so it wakes for
+ * every controller sample, and diffs the front touch panel on each wake.
+ * Button changes and per-pointer touch DOWN/MOVE/UP events are stamped with
+ * their sample time and pushed onto a single-producer/single-consumer ring
+ * that the game loop drains right before OnGameUpdate.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+// Android MotionEvent actions as OnGameTouchEvent expects them
+#define INPUT_ACTION_DOWN 0
+#define INPUT_ACTION_UP   1
+#define INPUT_ACTION_MOVE 2
+
+typedef enum {
+    INPUT_EVENT_TOUCH = 0,
+    INPUT_EVENT_BUTTONS = 1
+} input_event_type_t;
+
+typedef struct {
+    uint64_t timestamp;     // Sample time, us
+    uint8_t type;           // input_event_type_t
+    uint8_t action;         // INPUT_ACTION_* for touches
+    uint8_t pointer;        // Touch report id
+    float x, y;             // Front panel coordinates (1920x1088)
+    uint32_t buttons;       // Held buttons after the change
+} input_event_t;
+
+int input_init(void);
+void input_shutdown(void);
+
+// 1 while the sampling thread runs; callers poll the hardware themselves otherwise
+int input_is_threaded(void);
+
+// Pop the oldest event; 0 when the queue is empty
+int input_poll(input_event_t *event);
+
+// Events lost because the game loop fell too far behind
+int input_dropped_events(void);
+
+#endif // INPUT_H
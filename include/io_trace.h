@@ -0,0 +1,55 @@
+/*
+ * include/io_trace.h
+ * I/O Trace for Fluffy Diver PS Vita Port
+ *
+ * With IO_TRACE set, every file open, AAsset call and asset-cache lookup is
+ * recorded as a fixed 20-byte event in a memory ring: no formatting, no
+ * locks on the read path. The ring is written to DATA_PATH/cache/io_trace.bin
+ * the first time it fills and again at exit, and extras/scripts/io_trace.py
+ * turns the dump into per-file histograms and a first-touch prefetch
+ * manifest. With IO_TRACE clear every call here returns immediately.
+ */
+
+#ifndef IO_TRACE_H
+#define IO_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    IO_OP_OPEN = 0,         // open(); length = newlib open flags
+    IO_OP_FOPEN,            // fopen()
+    IO_OP_ASSET_OPEN,       // AAssetManager_open(); length = asset size
+    IO_OP_ASSET_READ,       // AAsset_read() at offset
+    IO_OP_ASSET_SEEK,       // AAsset_seek(); offset = new position
+    IO_OP_ASSET_BUFFER,     // AAsset_getBuffer(): whole asset in memory
+    IO_OP_ASSET_CLOSE,
+    IO_OP_CACHE_HIT,        // load_asset() served from the cache
+    IO_OP_CACHE_MISS,       // load_asset() read the file; length = bytes loaded
+    IO_OP_FAIL              // Any of the opens failing
+} io_trace_op_t;
+
+#define IO_TRACE_NO_PATH 0xFFFF
+
+int io_trace_init(void);
+
+// Small id for `path`, stable for the session; IO_TRACE_NO_PATH when off or full
+uint16_t io_trace_path(const char *path);
+
+void io_trace_record(io_trace_op_t op, uint16_t path_id, uint32_t offset, uint32_t length);
+
+// io_trace_path() and io_trace_record() in one, for one-shot events
+void io_trace_record_path(io_trace_op_t op, const char *path, uint32_t offset, uint32_t length);
+
+// Write the ring out now; 0 on success
+int io_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IO_TRACE_H
@@ -0,0 +1,54 @@
+/*
+ * include/jni_cache.h
+ * JNI Lookup Cache for Fluffy Diver PS Vita Port
+ *
+ * FalsoJNI resolves GetMethodID/GetFieldID by comparing names down the
+ * tables in java.c and dispatches every Call*Method/Get*Field by scanning
+ * the typed arrays for the id. With JNI_LOOKUP_CACHE set, jni_cache_init()
+ * hashes the names once and flattens the typed arrays into per-id slots,
+ * then points the JNIEnv at a copy of FalsoJNI's function table with those
+ * entries replaced: an ID lookup is one hash probe and a call is an index
+ * and an indirect call. Anything the cache does not know goes to FalsoJNI
+ * unchanged, so its logging of unimplemented methods still works.
+ */
+
+#ifndef JNI_CACHE_H
+#define JNI_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The typed method and field tables java.c defines, Void aside
+#define JNI_CACHE_TYPES(X) \
+    X(Boolean, jboolean) \
+    X(Byte, jbyte) \
+    X(Char, jchar) \
+    X(Double, jdouble) \
+    X(Float, jfloat) \
+    X(Int, jint) \
+    X(Long, jlong) \
+    X(Object, jobject) \
+    X(Short, jshort)
+
+#define JNI_CACHE_METHOD_COUNT(Type, type) \
+    const int jni_cache_methods##Type##_count = sizeof(methods##Type) / sizeof(methods##Type[0]);
+#define JNI_CACHE_FIELD_COUNT(Type, type) \
+    const int jni_cache_fields##Type##_count = sizeof(fields##Type) / sizeof(fields##Type[0]);
+
+// Place in java.c after the tables, next to __FALSOJNI_IMPL_CONTAINER_SIZES
+#define JNI_CACHE_TABLE_SIZES \
+    const int jni_cache_method_names_count = sizeof(nameToMethodId) / sizeof(nameToMethodId[0]); \
+    const int jni_cache_field_names_count = sizeof(nameToFieldId) / sizeof(nameToFieldId[0]); \
+    const int jni_cache_methodsVoid_count = sizeof(methodsVoid) / sizeof(methodsVoid[0]); \
+    JNI_CACHE_TYPES(JNI_CACHE_METHOD_COUNT) \
+    JNI_CACHE_TYPES(JNI_CACHE_FIELD_COUNT)
+
+// Build the cache and install it on the JNIEnv; call after jni_init(). 0 on success
+int jni_cache_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JNI_CACHE_H
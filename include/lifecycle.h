@@ -0,0 +1,40 @@
+/*
+ * include/lifecycle.h
+ * App Suspend/Resume for Fluffy Diver PS Vita Port
+ *
+ * Going into standby left the port's OpenAL voices, decoded SFX, asset
+ * cache and atlas pages all resident, and the game only ran its pause
+ * logic if the player had pressed START first. With APP_LIFECYCLE set,
+ * the power callback and sceAppMgr's system events become a suspend and
+ * a resume on the main thread. Suspending pauses the game, writes queued
+ * saves, drops the purgeable caches through the memory governor and stops
+ * the audio thread with its output. Resuming restarts audio and the game
+ * and nothing else: the caches refill as the game touches them again.
+ */
+
+#ifndef LIFECYCLE_H
+#define LIFECYCLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Game-side halves of the transition, run on the main thread
+typedef void (*lifecycle_fn)(void);
+
+// Register the power callback; from the main thread, once the game is up. 0 on success
+int lifecycle_init(lifecycle_fn pause_game, lifecycle_fn resume_game);
+
+// Once per frame on the main thread: carries out a pending suspend or resume
+void lifecycle_poll(void);
+
+// Whether the port is between a suspend and its resume
+int lifecycle_is_suspended(void);
+
+void lifecycle_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIFECYCLE_H
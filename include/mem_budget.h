@@ -0,0 +1,54 @@
+/*
+ * include/mem_budget.h
+ * vitaGL Memory Budget for Fluffy Diver PS Vita Port
+ *
+ * Sizes vitaGL's pools from what is actually free at boot instead of fixed
+ * numbers: CDRAM for render targets and textures, user RAM (capped by the
+ * performance profile's vertex_ram) for vertex streams, physically
+ * contiguous RAM for the rest. Any pool can be pinned from settings.cfg
+ * (vgl_vram_mb, vgl_ram_mb, vgl_phycont_mb; 0 = auto), clamped to what is
+ * free. Pool use is sampled while running and the high-water marks are
+ * logged at exit.
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // Free at planning time, before vitaGL takes its share
+    int free_user;
+    int free_cdram;
+    int free_phycont;
+
+    // vglInitWithCustomSizes() arguments
+    int legacy_pool;
+    int ram_pool;
+    int cdram_pool;
+    int phycont_pool;
+    int cdlg_pool;
+
+    // Texture bytes texture_loader may keep before warning
+    int texture_budget;
+} mem_budget_t;
+
+// Plan once from free memory and settings; later calls return the same plan
+const mem_budget_t *mem_budget_plan(void);
+
+// Plan and initialise vitaGL with it; 0 on success
+int mem_budget_init_gl(int width, int height, int msaa);
+
+// Once per frame: pool use is sampled every few frames
+void mem_budget_sample(void);
+
+// Log each pool's high-water mark
+void mem_budget_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_BUDGET_H
@@ -0,0 +1,80 @@
+/*
+ * include/mem_governor.h
+ * Memory Governor for Fluffy Diver PS Vita Port
+ *
+ * The port's caches (assets, the SFX bank, cached shaders, atlas pages,
+ * the FIOS RAM cache) each keep to their own budget and know nothing of
+ * one another, so the heap or VRAM can run out with megabytes of clean,
+ * rebuildable data still resident. Each cache registers a purge callback
+ * here with a priority, cheapest to rebuild first. The governor watches
+ * free heap and free VRAM against MEM_HEAP_LOW_WATER / MEM_VRAM_LOW_WATER
+ * and, when one drops below it, calls the purges in priority order until
+ * twice the low water is free again. Allocation paths that would otherwise
+ * fail call mem_governor_reclaim() and retry, so running out of memory
+ * costs a few reloads instead of a crash.
+ */
+
+#ifndef MEM_GOVERNOR_H
+#define MEM_GOVERNOR_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MEM_KIND_HEAP = 0,
+    MEM_KIND_VRAM,
+    MEM_KIND_COUNT
+} mem_kind_t;
+
+typedef enum {
+    MEM_PRESSURE_LOW = 1,               // Below the low water
+    MEM_PRESSURE_CRITICAL               // An allocation failed, or under half the low water
+} mem_pressure_t;
+
+// Purge order, lowest first
+#define MEM_PRIORITY_ASSETS      10     // Raw asset bytes: one card read to rebuild
+#define MEM_PRIORITY_ATLAS       10     // Empty atlas pages: nothing to rebuild
+#define MEM_PRIORITY_SFX         20     // Decoded PCM: card read and decode
+#define MEM_PRIORITY_SHADERS     30     // Unreferenced shaders: recompile unless a binary is stored
+#define MEM_PRIORITY_FIOS        90     // FIOS RAM cache: only under critical pressure, not rebuilt
+
+// The purge may run on whichever thread hit the shortage; without it the
+// purge waits for the next mem_governor_poll() on the main thread
+#define MEM_PURGE_ANY_THREAD     1
+
+// Free up to `wanted` bytes of `kind`; bytes actually freed (0 if it frees later)
+typedef size_t (*mem_purge_fn)(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+
+// Call from the main thread before the caches register
+void mem_governor_init(void);
+
+// Safe from any thread, at init; 0 on success
+int mem_governor_register(const char *name, int priority, int flags, mem_purge_fn purge);
+
+// Once per frame on the main thread: free memory is checked every few frames
+void mem_governor_poll(void);
+
+// Before a large allocation: purge so that `bytes` fit and stay above the low water
+void mem_governor_reserve(mem_kind_t kind, size_t bytes);
+
+// After an allocation of `bytes` failed; 1 if anything was freed and a retry may succeed
+int mem_governor_reclaim(mem_kind_t kind, size_t bytes);
+
+// Run every purge up to `max_priority` at critical pressure, on the main
+// thread, whatever is free; bytes freed (purges that finish later count 0)
+size_t mem_governor_release(int max_priority);
+
+// malloc(), purging and retrying once if it fails
+void *mem_governor_malloc(size_t size);
+
+// Log the purges made so far
+void mem_governor_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_GOVERNOR_H
@@ -0,0 +1,40 @@
+/*
+ * include/path_map.h
+ * Path Mapping for Fluffy Diver PS Vita Port
+ *
+ * One place that turns the game's Android paths into Vita ones: app data
+ * directories (/data/data/<package>/, external storage) land in DATA_PATH,
+ * /proc entries in app0:, and asset names under DATA_PATH/assets. The rules
+ * are a prefix trie built once; every path resolved is interned with its
+ * mapping, so opening the same file again is one hash probe that returns
+ * the expanded path without building any string. Paths no rule covers come
+ * back unchanged.
+ */
+
+#ifndef PATH_MAP_H
+#define PATH_MAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asset names are mapped to this prefix plus the name
+#define PATH_MAP_ASSET_ROOT DATA_PATH "assets/"
+
+// Build the rule trie; resolving before this initialises on first use
+int path_map_init(void);
+
+// Vita path for `path`. Interned strings stay valid for the session; if the
+// table is full the result is built in `scratch` instead. NULL if it doesn't fit
+const char *path_map_resolve(const char *path, char *scratch, size_t size);
+
+// Same for an asset name, as passed to AAssetManager_open()
+const char *path_map_asset(const char *name, char *scratch, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PATH_MAP_H
@@ -0,0 +1,51 @@
+/*
+ * include/perf_hud.h
+ * Performance HUD for Fluffy Diver PS Vita Port
+ *
+ * The game loop reports how long each part of the frame took; the HUD keeps
+ * the last PERF_HUD_HISTORY frames and, while visible, draws them as a
+ * stacked frame-time graph with averages, audio thread CPU and memory
+ * occupancy on top of the game's frame, just before the swap. L + R +
+ * TRIANGLE toggles it.
+ */
+
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <stdint.h>
+#include <psp2/kernel/processmgr.h>
+
+#include "config.h"
+
+#define PERF_HUD_HISTORY 120
+
+typedef enum {
+    PERF_HUD_INPUT = 0,     // System events and input dispatch
+    PERF_HUD_UPDATE,        // OnGameUpdate, including the game's GL calls
+    PERF_HUD_GL,            // Frame start/end: texture uploads, clear, swap submit
+    PERF_HUD_WAIT,          // Frame pacer holding the vblank slot
+    PERF_HUD_SECTIONS
+} perf_hud_section_t;
+
+void perf_hud_toggle(void);
+int perf_hud_visible(void);
+
+// Add `us` to the current frame's `section`
+void perf_hud_add(perf_hud_section_t section, uint64_t us);
+
+// Charge the time since *mark to `section` and move *mark to now
+static inline void perf_hud_lap(perf_hud_section_t section, uint64_t *mark) {
+#if PERF_HUD
+    uint64_t now = sceKernelGetProcessTimeWide();
+    perf_hud_add(section, now - *mark);
+    *mark = now;
+#endif
+}
+
+// Close the current frame; call once per loop iteration
+void perf_hud_end_frame(void);
+
+// Draw over the current frame; needs the GL context, no-op while hidden
+void perf_hud_draw(void);
+
+#endif // PERF_HUD_H
@@ -0,0 +1,65 @@
+/*
+ * include/perf_profile.h
+ * Performance Profiles for Fluffy Diver PS Vita Port
+ *
+ * A profile (battery, balanced, max; "perf_profile" in settings.cfg) picks
+ * the clocks, frame rate, MSAA, vitaGL vertex RAM and audio source count.
+ * Boot always runs at full clocks; the profile's own clocks take over when
+ * the game loop starts. With the governor on ("perf_governor 1") the CPU
+ * and GPU clocks are stepped up while the frame stats show frames missing
+ * their budget, and eased back to the profile's once they have headroom.
+ */
+
+#ifndef PERF_PROFILE_H
+#define PERF_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PERF_PROFILE_BATTERY = 0,
+    PERF_PROFILE_BALANCED,
+    PERF_PROFILE_MAX,
+    PERF_PROFILE_COUNT
+} perf_profile_id_t;
+
+typedef struct {
+    const char *name;
+    int cpu_level;                      // Step on the ARM clock ladder
+    int gpu_level;                      // Step on the GPU/bus/crossbar ladder
+    int pace_mode;                      // frame_pace_mode_t
+    int msaa;                           // SceGxmMultisampleMode, if ENABLE_MSAA
+    int vertex_ram;                     // Cap on vitaGL's RAM pool, bytes
+    int audio_sources;                  // At most MAX_AUDIO_SOURCES
+} perf_profile_t;
+
+// Pick the profile from the loaded settings and go to boot clocks; 0 on success
+int perf_profile_init(void);
+
+// Full clocks, for boot and loading
+void perf_profile_boot_clocks(void);
+
+// Drop to the profile's clocks; call once before the game loop
+void perf_profile_start(void);
+
+// Once per frame: governor step, when enabled
+void perf_governor_update(void);
+
+const perf_profile_t *perf_profile_get(void);
+
+// MSAA mode to initialise vitaGL with, ENABLE_MSAA taken into account
+int perf_profile_msaa(void);
+
+// Profile by settings name, or -1
+int perf_profile_find(const char *name);
+const char *perf_profile_name(int id);
+
+// Clocks currently set, in MHz
+void perf_profile_get_clocks(int *cpu_mhz, int *gpu_mhz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERF_PROFILE_H
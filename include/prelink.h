@@ -0,0 +1,25 @@
+/*
+ * include/prelink.h
+ * Prelink Cache for Fluffy Diver PS Vita Port
+ *
+ * Relocating and resolving the game library is deterministic: the same .so
+ * at the same load address against the same import table always ends up
+ * with the same bytes in its data segments. The first boot after a change
+ * snapshots those segments, plus any relocated words that live in .text,
+ * and later boots copy the snapshot back in place of so_relocate() and
+ * resolve_imports().
+ */
+
+#ifndef PRELINK_H
+#define PRELINK_H
+
+#include <stdint.h>
+#include <so_util/so_util.h>
+
+// 0 when `mod` was brought to its relocated, resolved state from the cache
+int prelink_apply(so_module *mod, const char *so_path, uint32_t dynlib_hash);
+
+// Snapshot `mod` right after relocation and import resolution
+int prelink_store(so_module *mod, const char *so_path, uint32_t dynlib_hash);
+
+#endif // PRELINK_H
@@ -0,0 +1,81 @@
+/*
+ * include/profiler.h
+ * Hot-Path Profiler for Fluffy Diver PS Vita Port
+ *
+ * PROF_SCOPE("name") times the rest of the enclosing block; PROF_BEGIN and
+ * PROF_END bracket a region explicitly. Names must be string literals: only
+ * the pointer is stored. Zones record nothing unless a capture is running,
+ * and with ENABLE_PROFILING clear the macros compile to nothing at all.
+ *
+ * A capture (L + R + CIRCLE, or PROFILER_BOOT_CAPTURE) lasts
+ * PROFILER_CAPTURE_FRAMES frames and is written to DATA_PATH/cache/trace.json
+ * in Chrome trace format, loadable in chrome://tracing or Perfetto.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ENABLE_PROFILING
+
+typedef struct {
+    const char *name;                   // NULL when no capture was running
+    uint32_t start;
+} prof_zone_t;
+
+extern volatile int prof_active;
+
+uint32_t prof_now(void);
+void prof_record(const char *name, uint32_t start);
+
+static inline prof_zone_t prof_zone_begin(const char *name) {
+    prof_zone_t zone = { NULL, 0 };
+    if (prof_active) {
+        zone.name = name;
+        zone.start = prof_now();
+    }
+    return zone;
+}
+
+static inline void prof_zone_end(prof_zone_t *zone) {
+    if (zone->name) {
+        prof_record(zone->name, zone->start);
+    }
+}
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+#define PROF_SCOPE(name) \
+    prof_zone_t PROF_CONCAT(prof_zone_, __LINE__) __attribute__((cleanup(prof_zone_end))) = prof_zone_begin(name)
+#define PROF_BEGIN(var, name) prof_zone_t var = prof_zone_begin(name)
+#define PROF_END(var) prof_zone_end(&var)
+
+// Record the next `frames` frames; ignored while a capture is running
+void prof_capture_start(int frames);
+
+// Frame boundary, from the game loop; writes the trace when a capture ends
+void prof_frame(void);
+
+#else
+
+#define PROF_SCOPE(name)
+#define PROF_BEGIN(var, name)
+#define PROF_END(var)
+
+static inline void prof_capture_start(int frames) { (void)frames; }
+static inline void prof_frame(void) {}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILER_H
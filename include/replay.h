@@ -0,0 +1,66 @@
+/*
+ * include/replay.h
+ * Input Record/Replay for Fluffy Diver PS Vita Port
+ *
+ * With REPLAY_MODE 1 every touch and button change the game is sent is
+ * written, tagged with its frame number, to DATA_PATH/replay/input.rec.
+ * With REPLAY_MODE 2 that file is fed back instead of live input, the game
+ * is stepped by REPLAY_DELTA_MS every frame in both modes so the two runs
+ * see the same simulation, and when the recording runs out a summary row
+ * (frame-time percentiles, load spans, peak memory) is appended to
+ * DATA_PATH/replay/results.csv, with the load spans themselves in
+ * replay/spans_<run>.csv. With REPLAY_MODE 0 every call here does nothing.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    REPLAY_EVENT_TOUCH = 0,             // Game coordinates, TOUCH_ACTION_*
+    REPLAY_EVENT_BUTTONS                // New SceCtrlData.buttons
+} replay_event_type_t;
+
+// On-disk record as well, so fixed size and layout
+typedef struct {
+    uint32_t frame;
+    uint8_t type;                       // replay_event_type_t
+    uint8_t action;
+    uint16_t reserved;
+    float x;
+    float y;
+    uint32_t buttons;
+} replay_event_t;
+
+// REPLAY_MODE 1 opens the recording, 2 loads it; 0 on success
+int replay_init(int mode);
+
+// Flush a recording or write a replay's report if it hasn't been yet
+void replay_shutdown(void);
+
+int replay_is_recording(void);
+int replay_is_playing(void);
+int replay_is_active(void);
+
+void replay_record_touch(int action, float x, float y);
+void replay_record_buttons(uint32_t buttons);
+
+// Next recorded event due on the current frame; 0 when there are no more
+int replay_poll(replay_event_t *event);
+
+// Close the frame: both times in us, work being the time before the pacer wait
+void replay_end_frame(uint64_t frame_us, uint64_t work_us);
+
+// The replay has run out of input and its report is written
+int replay_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPLAY_H
@@ -0,0 +1,43 @@
+/*
+ * include/save_writer.h
+ * Write-Behind Save Writer for Fluffy Diver PS Vita Port
+ *
+ * With SAVE_WRITE_BEHIND set, files the game opens for writing under
+ * SAVE_PATH are in-memory images: fwrite and friends never touch the
+ * memory card, and fclose hands the image to a background thread that
+ * writes it aside and renames it over the save, so the frame never waits
+ * on the card and an interrupted write leaves the previous save intact.
+ * Saves to the same file queued before the thread gets to them collapse
+ * into one write, and opening a save that is still queued reads the
+ * queued image.
+ */
+
+#ifndef SAVE_WRITER_H
+#define SAVE_WRITER_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Finish any write a power loss interrupted and start the writer; 0 on success
+int save_writer_init(void);
+
+// Whether fopen() of `path` belongs to the writer
+int save_writer_owns(const char *path);
+
+// fopen() for a path the writer owns
+FILE *save_writer_fopen(const char *path, const char *mode);
+
+// Block until every queued save is on the card
+void save_writer_flush(void);
+
+// Flush and stop the writer thread
+void save_writer_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAVE_WRITER_H
@@ -0,0 +1,41 @@
+/*
+ * include/texture_loader.h
+ * Texture Loader for Fluffy Diver PS Vita Port
+ *
+ * texture_loader_load() hands back a texture name at once, bound to a 1x1
+ * white placeholder. A decoder thread pulls the file through the asset
+ * cache, decodes and transcodes it, and builds the mip chain; the GL thread
+ * only issues the final glTexImage2D / glCompressedTexImage2D calls from
+ * texture_loader_process_uploads().
+ *
+ * PNG (and .hif/.spr files carrying a PNG) is decoded to RGBA8 and, with
+ * TEXTURE_TRANSCODE, stored as RGB565 when opaque or RGBA4444 otherwise.
+ * An offline-converted sibling with the same base name and a .pvr (PVRTC,
+ * PVR v3 container) or .dds (DXT1/3/5) extension is uploaded as-is instead.
+ *
+ * With TEXTURE_DISK_CACHE, decoded results are kept on the memory card
+ * keyed by the SHA-1 of the source file, so repeat loads skip the decode.
+ */
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <stddef.h>
+#include <vitaGL.h>
+
+int texture_loader_init(void);
+void texture_loader_shutdown(void);
+
+// Asset-relative path; returns 0 only if no texture name could be created
+GLuint texture_loader_load(const char *path);
+
+// GL thread only: upload at most max_uploads finished decodes, 0 = all
+int texture_loader_process_uploads(int max_uploads);
+
+// Decodes queued or waiting for upload
+int texture_loader_pending(void);
+
+// Bytes of texture memory uploaded so far
+size_t texture_loader_get_usage(void);
+
+#endif // TEXTURE_LOADER_H
@@ -64,6 +64,18 @@ int fios_init(const char * path) {
     return 0;
 }
 
+size_t fios_drop_cache(void) {
+    if (!g_RamCacheWorkBuffer)
+        return 0;
+
+    if (sceFiosIOFilterRemove(0) < 0)
+        return 0;
+
+    free(g_RamCacheWorkBuffer);
+    g_RamCacheWorkBuffer = NULL;
+    return RAMCACHEBLOCKNUM * RAMCACHEBLOCKSIZE;
+}
+
 void fios_terminate(void) {
     sceFiosTerminate();
     free(g_RamCacheWorkBuffer);
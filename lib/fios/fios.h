@@ -79,10 +79,14 @@ int sceFiosInitialize(const SceFiosParams *params);
 void sceFiosTerminate();
 
 int sceFiosIOFilterAdd(int index, void *pFilterCallback, void *pFilterContext);
+int sceFiosIOFilterRemove(int index);
 void sceFiosIOFilterCache();
 
 int fios_init(const char * path);
 
+// Remove the RAM cache filter and free its buffer; bytes freed
+size_t fios_drop_cache(void);
+
 #ifdef __cplusplus
 };
 #endif
@@ -14,6 +14,7 @@
 #include <string.h>
 
 #include "utils/dialog.h"
+#include "profiler.h"
 #include "so_util.h"
 
 #ifndef SCE_KERNEL_MEMBLOCK_TYPE_USER_RX
@@ -426,8 +427,67 @@ __attribute__((naked)) void plt0_stub()
     reloc_err(got0);
 }
 
+uint32_t so_hash(const uint8_t *name);
+
+// Open-addressed index over a default_dynlib table, built once per resolve.
+// On duplicate names the earlier entry wins, as with the old linear scan.
+typedef struct {
+    so_default_dynlib *table;
+    int *slots;               // Table index + 1, 0 = empty
+    uint32_t mask;
+} dynlib_index;
+
+static int dynlib_index_build(dynlib_index *idx, so_default_dynlib *table, int count) {
+    uint32_t size = 16;
+    while (size < (uint32_t)count * 2)
+        size <<= 1;
+
+    idx->table = table;
+    idx->mask = size - 1;
+    idx->slots = calloc(size, sizeof(int));
+    if (!idx->slots)
+        return -1;
+
+    for (int j = 0; j < count; j++) {
+        uint32_t h = so_hash((const uint8_t *)table[j].symbol) & idx->mask;
+        while (idx->slots[h] && strcmp(table[idx->slots[h] - 1].symbol, table[j].symbol) != 0)
+            h = (h + 1) & idx->mask;
+        if (!idx->slots[h])
+            idx->slots[h] = j + 1;
+    }
+
+    return 0;
+}
+
+static so_default_dynlib *dynlib_index_find(dynlib_index *idx, const char *symbol) {
+    uint32_t h = so_hash((const uint8_t *)symbol) & idx->mask;
+    while (idx->slots[h]) {
+        so_default_dynlib *entry = &idx->table[idx->slots[h] - 1];
+        if (strcmp(entry->symbol, symbol) == 0)
+            return entry;
+        h = (h + 1) & idx->mask;
+    }
+    return NULL;
+}
+
+// What one dynsym entry resolved to; relocations share the symbol's result
+typedef struct {
+    uintptr_t link;
+    so_default_dynlib *entry;
+    int done;
+} resolve_cache;
+
 int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only) {
+    PROF_SCOPE("so_resolve");
     uintptr_t val;
+    dynlib_index idx;
+    if (dynlib_index_build(&idx, default_dynlib, size_default_dynlib / sizeof(so_default_dynlib)) < 0)
+        fatal_error("Error could not allocate the symbol index\n");
+
+    resolve_cache *cache = calloc(mod->num_dynsym, sizeof(resolve_cache));
+    if (!cache)
+        fatal_error("Error could not allocate the symbol cache\n");
+
     for (int i = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
         Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
         Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(rel->r_info)];
@@ -440,32 +500,28 @@ int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_defau
             case R_ARM_JUMP_SLOT:
             {
                 if (sym->st_shndx == SHN_UNDEF) {
-                    int resolved = 0;
-                    if (!default_dynlib_only) {
-                        uintptr_t link = so_resolve_link(mod, mod->dynstr + sym->st_name);
-                        if (link) {
-                            // debugPrintf("Resolved from dependencies: %s\n", mod->dynstr + sym->st_name);
-                            if (type == R_ARM_ABS32) {
-                                val = *ptr + link;
-                                kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-                            } else {
-                                val = link;
-                                kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-                            }
-                            resolved = 1;
-                        }
+                    resolve_cache *c = &cache[ELF32_R_SYM(rel->r_info)];
+                    if (!c->done) {
+                        if (!default_dynlib_only)
+                            c->link = so_resolve_link(mod, mod->dynstr + sym->st_name);
+                        c->entry = dynlib_index_find(&idx, mod->dynstr + sym->st_name);
+                        c->done = 1;
                     }
 
-                    for (int j = 0; j < size_default_dynlib / sizeof(so_default_dynlib); j++) {
-                        if (strcmp(mod->dynstr + sym->st_name, default_dynlib[j].symbol) == 0) {
-                            val = default_dynlib[j].func;
+                    // Our table overrides what dependencies export
+                    if (c->entry) {
+                        val = c->entry->func;
+                        kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
+                    } else if (c->link) {
+                        // debugPrintf("Resolved from dependencies: %s\n", mod->dynstr + sym->st_name);
+                        if (type == R_ARM_ABS32) {
+                            val = *ptr + c->link;
+                            kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
+                        } else {
+                            val = c->link;
                             kuKernelCpuUnrestrictedMemcpy(ptr, &val, sizeof(uintptr_t));
-                            resolved = 1;
-                            break;
                         }
-                    }
-
-                    if (!resolved) {
+                    } else {
                         if (type == R_ARM_JUMP_SLOT) {
                             printf("Unresolved import: %s\n", mod->dynstr + sym->st_name);
                             *ptr = (uintptr_t)&plt0_stub;
@@ -483,6 +539,8 @@ int so_resolve(so_module *mod, so_default_dynlib *default_dynlib, int size_defau
         }
     }
 
+    free(cache);
+    free(idx.slots);
     return 0;
 }
 
@@ -491,6 +549,10 @@ int __ret0() {
 }
 
 int so_resolve_with_dummy(so_module *mod, so_default_dynlib *default_dynlib, int size_default_dynlib, int default_dynlib_only) {
+    dynlib_index idx;
+    if (dynlib_index_build(&idx, default_dynlib, size_default_dynlib / sizeof(so_default_dynlib)) < 0)
+        fatal_error("Error could not allocate the symbol index\n");
+
     for (int i = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
         Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
         Elf32_Sym *sym = &mod->dynsym[ELF32_R_SYM(rel->r_info)];
@@ -503,12 +565,8 @@ int so_resolve_with_dummy(so_module *mod, so_default_dynlib *default_dynlib, int
             case R_ARM_JUMP_SLOT:
             {
                 if (sym->st_shndx == SHN_UNDEF) {
-                    for (int j = 0; j < size_default_dynlib / sizeof(so_default_dynlib); j++) {
-                        if (strcmp(mod->dynstr + sym->st_name, default_dynlib[j].symbol) == 0) {
-                            *ptr = (uintptr_t) &__ret0;
-                            break;
-                        }
-                    }
+                    if (dynlib_index_find(&idx, mod->dynstr + sym->st_name))
+                        *ptr = (uintptr_t) &__ret0;
                 }
 
                 break;
@@ -518,6 +576,7 @@ int so_resolve_with_dummy(so_module *mod, so_default_dynlib *default_dynlib, int
         }
     }
 
+    free(idx.slots);
     return 0;
 }
 
@@ -0,0 +1,275 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Asset Directory Index
+ *
+ * Merges the archive TOC and the loose assets directory into one sorted
+ * table. Files are ordered by (directory, leaf name), so the files of each
+ * directory are contiguous and already in the ascending ASCII order
+ * AAssetDir promises. Directory strings are not stored separately: each
+ * directory range points at the path prefix of its first file.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/io/dirent.h>
+#include <psp2/io/stat.h>
+
+#include "config.h"
+#include "asset_dir.h"
+#include "asset_pack.h"
+#include "utils/logger.h"
+
+typedef struct {
+    uint32_t path;     // Offset of the full asset path in dir_names
+    uint16_t dir_len;  // Length of the directory part, 0 at the root
+    uint16_t leaf;     // Offset of the leaf name within the path
+} dir_file_t;
+
+typedef struct {
+    uint32_t path;     // Directory string = first dir_len bytes of this path
+    uint16_t len;
+    int first;
+    int count;
+} dir_range_t;
+
+static char *dir_names = NULL;
+static size_t names_size = 0;
+static size_t names_capacity = 0;
+static dir_file_t *dir_files = NULL;
+static int file_count = 0;
+static int file_capacity = 0;
+static dir_range_t *dir_ranges = NULL;
+static int range_count = 0;
+
+// Function prototypes
+static int add_file(const char *path);
+static void scan_loose_files(const char *dir, const char *prefix);
+static int compare_dir(const char *a, size_t a_len, const char *b, size_t b_len);
+static int compare_files(const void *a, const void *b);
+
+int asset_dir_build(void) {
+    asset_dir_free();
+
+    int packed = asset_pack_entry_count();
+    for (int i = 0; i < packed; i++) {
+        const char *name = asset_pack_entry_name(i);
+        if (name && add_file(name) < 0) {
+            asset_dir_free();
+            return -1;
+        }
+    }
+    scan_loose_files(ASSETS_PATH, "");
+
+    qsort(dir_files, file_count, sizeof(dir_file_t), compare_files);
+
+    // Drop loose files that shadow archive entries, then cut directory ranges
+    int unique = 0;
+    for (int i = 0; i < file_count; i++) {
+        if (unique > 0 && compare_files(&dir_files[unique - 1], &dir_files[i]) == 0) {
+            continue;
+        }
+        dir_files[unique++] = dir_files[i];
+    }
+    file_count = unique;
+
+    dir_ranges = malloc((file_count ? file_count : 1) * sizeof(dir_range_t));
+    if (!dir_ranges) {
+        asset_dir_free();
+        return -1;
+    }
+
+    for (int i = 0; i < file_count; i++) {
+        dir_file_t *file = &dir_files[i];
+        dir_range_t *last = range_count ? &dir_ranges[range_count - 1] : NULL;
+        if (last && compare_dir(dir_names + last->path, last->len,
+                                dir_names + file->path, file->dir_len) == 0) {
+            last->count++;
+            continue;
+        }
+
+        dir_range_t *range = &dir_ranges[range_count++];
+        range->path = file->path;
+        range->len = file->dir_len;
+        range->first = i;
+        range->count = 1;
+    }
+
+    l_success("Asset directory index: %d files in %d directories (%zu bytes of names)",
+              file_count, range_count, names_size);
+    return 0;
+}
+
+void asset_dir_free(void) {
+    free(dir_names);
+    free(dir_files);
+    free(dir_ranges);
+    dir_names = NULL;
+    dir_files = NULL;
+    dir_ranges = NULL;
+    names_size = names_capacity = 0;
+    file_count = file_capacity = 0;
+    range_count = 0;
+}
+
+int asset_dir_find(const char *dir, int *first, int *count) {
+    if (!dir || !first || !count) {
+        return -1;
+    }
+
+    size_t len = strlen(dir);
+    while (len > 0 && dir[len - 1] == '/') {
+        len--;
+    }
+
+    int lo = 0;
+    int hi = range_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = compare_dir(dir_names + dir_ranges[mid].path, dir_ranges[mid].len, dir, len);
+        if (cmp == 0) {
+            *first = dir_ranges[mid].first;
+            *count = dir_ranges[mid].count;
+            return 0;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+int asset_dir_exists(const char *path) {
+    if (!path) {
+        return 0;
+    }
+
+    const char *slash = strrchr(path, '/');
+    const char *leaf = slash ? slash + 1 : path;
+    char dir[256];
+    size_t dir_len = slash ? (size_t)(slash - path) : 0;
+    if (dir_len >= sizeof(dir)) {
+        return 0;
+    }
+    memcpy(dir, path, dir_len);
+    dir[dir_len] = '\0';
+
+    int first, count;
+    if (asset_dir_find(dir, &first, &count) < 0) {
+        return 0;
+    }
+
+    // Leaves are sorted within the directory range
+    int lo = first;
+    int hi = first + count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(asset_dir_file_name(mid), leaf);
+        if (cmp == 0) return 1;
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return 0;
+}
+
+const char *asset_dir_file_name(int index) {
+    if (index < 0 || index >= file_count) {
+        return NULL;
+    }
+    return dir_names + dir_files[index].path + dir_files[index].leaf;
+}
+
+// ===== BUILD =====
+
+static int add_file(const char *path) {
+    size_t len = strlen(path);
+    if (len >= 0xFFFF) {
+        return 0;
+    }
+
+    if (names_size + len + 1 > names_capacity) {
+        size_t capacity = names_capacity ? names_capacity * 2 : 16 * 1024;
+        while (capacity < names_size + len + 1) capacity *= 2;
+        char *names = realloc(dir_names, capacity);
+        if (!names) return -1;
+        dir_names = names;
+        names_capacity = capacity;
+    }
+
+    if (file_count == file_capacity) {
+        int capacity = file_capacity ? file_capacity * 2 : 512;
+        dir_file_t *files = realloc(dir_files, capacity * sizeof(dir_file_t));
+        if (!files) return -1;
+        dir_files = files;
+        file_capacity = capacity;
+    }
+
+    const char *slash = strrchr(path, '/');
+    dir_file_t *file = &dir_files[file_count++];
+    file->path = (uint32_t)names_size;
+    file->dir_len = slash ? (uint16_t)(slash - path) : 0;
+    file->leaf = slash ? (uint16_t)(slash - path + 1) : 0;
+
+    memcpy(dir_names + names_size, path, len + 1);
+    names_size += len + 1;
+    return 0;
+}
+
+static void scan_loose_files(const char *dir, const char *prefix) {
+    SceUID dfd = sceIoDopen(dir);
+    if (dfd < 0) {
+        return;
+    }
+
+    SceIoDirent entry;
+    while (sceIoDread(dfd, &entry) > 0) {
+        if (entry.d_name[0] == '.') {
+            continue;
+        }
+
+        char name[256];
+        snprintf(name, sizeof(name), "%s%s", prefix, entry.d_name);
+
+        if (SCE_S_ISDIR(entry.d_stat.st_mode)) {
+            char path[512];
+            char sub_prefix[256];
+            snprintf(path, sizeof(path), "%s/%s", dir, entry.d_name);
+            snprintf(sub_prefix, sizeof(sub_prefix), "%s/", name);
+            scan_loose_files(path, sub_prefix);
+            continue;
+        }
+
+        if (add_file(name) < 0) {
+            l_error("Out of memory indexing %s", name);
+            break;
+        }
+    }
+
+    sceIoDclose(dfd);
+}
+
+static int compare_dir(const char *a, size_t a_len, const char *b, size_t b_len) {
+    size_t n = a_len < b_len ? a_len : b_len;
+    int cmp = memcmp(a, b, n);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a_len > b_len) - (a_len < b_len);
+}
+
+static int compare_files(const void *a, const void *b) {
+    const dir_file_t *fa = (const dir_file_t *)a;
+    const dir_file_t *fb = (const dir_file_t *)b;
+
+    int cmp = compare_dir(dir_names + fa->path, fa->dir_len, dir_names + fb->path, fb->dir_len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return strcmp(dir_names + fa->path + fa->leaf, dir_names + fb->path + fb->leaf);
+}
@@ -10,18 +10,29 @@
  * - .yfont files (font data)
  */
 
+#include <malloc.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <psp2/io/fcntl.h>
 #include <psp2/io/stat.h>
 #include <psp2/kernel/clib.h>
-
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "asset_handler.h"
+#include "asset_dir.h"
+#include "asset_pack.h"
+#include "hgg_decoder.h"
+#include "io_trace.h"
+#include "mem_governor.h"
+#include "path_map.h"
+#include "profiler.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
 // Asset format signatures
-#define HGG_SIGNATURE   0x48474700  // "HGG\0"
 #define SPR_SIGNATURE   0x53505200  // "SPR\0"
 #define HIF_SIGNATURE   0x48494600  // "HIF\0"
 #define HDM_SIGNATURE   0x48444D00  // "HDM\0"
@@ -29,15 +40,66 @@
 // Asset cache management
 typedef struct {
     char filename[256];
+    uint32_t hash;
     void *data;
     size_t size;
     int format;
     int loaded;
+    int refcount;          // Outstanding asset_acquire() handles
+    uint32_t generation;   // Bumped on eviction so stale handles fail
+    int lru_prev;          // Doubly linked LRU list, most recent at head
+    int lru_next;
 } asset_cache_entry_t;
 
 #define MAX_CACHED_ASSETS 512
+#define ASSET_INDEX_SIZE 1024 // Power of two, 2x entries keeps probe chains short
+#define ASSET_HANDLE_SLOT_BITS 10
+#define ASSET_HANDLE_SLOT_MASK ((1 << ASSET_HANDLE_SLOT_BITS) - 1)
+
 static asset_cache_entry_t asset_cache[MAX_CACHED_ASSETS];
+static int16_t asset_index[ASSET_INDEX_SIZE]; // Open addressing over asset_cache, -1 = empty
 static int cache_count = 0;
+static int lru_head = -1;
+static int lru_tail = -1;
+static size_t cache_bytes = 0;
+static size_t cache_budget = ASSET_CACHE_BUDGET;
+static uint32_t cache_hits = 0;
+static uint32_t cache_misses = 0;
+static uint32_t cache_evictions = 0;
+
+// Guards the cache, index and LRU list; file I/O always runs unlocked
+static SceKernelLwMutexWork cache_lock;
+
+// Async loading
+#define ASSET_WORKER_COUNT 2
+#define ASSET_WORKER_PRIORITY 160               // Below the game and audio threads
+#define ASSET_WORKER_AFFINITY 0x40000           // Core 2, the one the game leaves idle
+#define ASSET_WORKER_STACK_SIZE (64 * 1024)
+#define MAX_PENDING_ASSETS 64
+#define MAX_ASSET_WAITERS 4
+
+typedef struct {
+    asset_load_cb cb;
+    void *user;
+} asset_waiter_t;
+
+// One in-flight load; repeat requests for the same file attach as waiters
+typedef struct {
+    char filename[256];
+    uint32_t hash;
+    int in_use;
+    asset_waiter_t waiters[MAX_ASSET_WAITERS];
+    int waiter_count;
+} asset_request_t;
+
+static asset_request_t pending_requests[MAX_PENDING_ASSETS];
+static int request_queue[MAX_PENDING_ASSETS];  // FIFO of pending_requests indices
+static int queue_head = 0;
+static int queue_count = 0;
+static SceUID request_sema = -1;
+static SceUID asset_workers[ASSET_WORKER_COUNT];
+static volatile int workers_running = 0;
+static uint32_t async_dedups = 0;
 
 // Asset format types
 typedef enum {
@@ -60,9 +122,19 @@ static int load_hdm_file(const char *path, void **data, size_t *size);
 static int load_yfont_file(const char *path, void **data, size_t *size);
 static int load_png_file(const char *path, void **data, size_t *size);
 static int load_dat_file(const char *path, void **data, size_t *size);
-static void *get_cached_asset(const char *filename);
-static void cache_asset(const char *filename, void *data, size_t size, int format);
+static int load_packed_hgg(const asset_pack_entry_t *entry, void **data, size_t *size);
+static uint32_t hash_filename(const char *filename);
+static int find_cached_asset(const char *filename, uint32_t hash);
+static void lru_touch(int entry);
+static int cache_asset(const char *filename, void *data, size_t size, int format);
+static void evict_to_budget(size_t incoming);
+static void *load_asset_internal(const char *filename, size_t *out_size, int pin, int *out_entry);
+static void start_asset_workers(void);
+static void stop_asset_workers(void);
 static void preload_critical_assets(void); // MOVED TO FORWARD DECLARATION
+#if MEM_GOVERNOR
+static size_t purge_assets(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+#endif
 
 // Initialize asset system
 int init_asset_system(void) {
@@ -70,21 +142,38 @@ int init_asset_system(void) {
 
     // Clear asset cache
     sceClibMemset(asset_cache, 0, sizeof(asset_cache));
+    sceClibMemset(asset_index, 0xFF, sizeof(asset_index));
     cache_count = 0;
-
-    // Verify asset directory exists
-    if (!file_exists("ux0:data/fluffydiver/assets/")) {
+    lru_head = lru_tail = -1;
+    cache_bytes = 0;
+    sceKernelCreateLwMutex(&cache_lock, "asset_cache_lock", 0, 0, NULL);
+#if MEM_GOVERNOR
+    mem_governor_register("assets", MEM_PRIORITY_ASSETS, MEM_PURGE_ANY_THREAD, purge_assets);
+#endif
+
+    // Verify asset directory exists, unless everything comes from the archive
+    if (asset_pack_open(ASSET_PACK_PATH) < 0 && !file_exists("ux0:data/fluffydiver/assets/")) {
         l_error("Asset directory not found: ux0:data/fluffydiver/assets/");
         return -1;
     }
 
-    // Pre-load critical assets
+    // Directory listings are answered from memory from here on
+    asset_dir_build();
+    hgg_decoder_init();
+
+    // Start loader threads, then warm critical assets on them
+    start_asset_workers();
     preload_critical_assets();
 
     l_success("Asset system initialized");
     return 0;
 }
 
+int asset_cache_is_raw(const char *filename) {
+    // load_asset() decompresses HGG, so its cache holds different bytes
+    return detect_asset_format(filename) != ASSET_FORMAT_HGG;
+}
+
 // Main asset loading function
 void* load_asset(const char *filename, size_t *out_size) {
     if (!filename || !out_size) {
@@ -92,16 +181,42 @@ void* load_asset(const char *filename, size_t *out_size) {
         return NULL;
     }
 
+    return load_asset_internal(filename, out_size, 0, NULL);
+}
+
+// Shared by load_asset(), asset_acquire() and the workers. With `pin` set the
+// entry's refcount is taken under the same lock hold that finds or inserts it.
+static void *load_asset_internal(const char *filename, size_t *out_size, int pin, int *out_entry) {
+    PROF_SCOPE("load_asset");
+
     // Check cache first
-    void *cached_data = get_cached_asset(filename);
-    if (cached_data) {
+    uint32_t hash = hash_filename(filename);
+
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+    int cached = find_cached_asset(filename, hash);
+    if (cached >= 0) {
+        cache_hits++;
+        lru_touch(cached);
+        if (pin) asset_cache[cached].refcount++;
+        if (out_entry) *out_entry = cached;
+        *out_size = asset_cache[cached].size;
+        void *cached_data = asset_cache[cached].data;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+
+        io_trace_record_path(IO_OP_CACHE_HIT, filename, 0, (uint32_t)*out_size);
         l_debug("Asset loaded from cache: %s", filename);
         return cached_data;
     }
-
-    // Build full path
-    char full_path[512];
-    snprintf(full_path, sizeof(full_path), "ux0:data/fluffydiver/assets/%s", filename);
+    cache_misses++;
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+
+    // Full path, interned by the path map after the first load
+    char scratch[512];
+    const char *full_path = path_map_asset(filename, scratch, sizeof(scratch));
+    if (!full_path) {
+        l_error("Asset path too long: %s", filename);
+        return NULL;
+    }
 
     // Detect format
     asset_format_t format = detect_asset_format(filename);
@@ -110,8 +225,14 @@ void* load_asset(const char *filename, size_t *out_size) {
     size_t size = 0;
     int result = -1;
 
-    // Load based on format
-    switch (format) {
+    // Packed assets are one offset read from the archive handle
+    const asset_pack_entry_t *packed = asset_pack_find(filename);
+    if (packed && format == ASSET_FORMAT_HGG) {
+        result = load_packed_hgg(packed, &data, &size);
+    } else if (packed) {
+        data = asset_pack_load(packed, &size);
+        result = data ? 0 : -1;
+    } else switch (format) {
         case ASSET_FORMAT_HGG:
             result = load_hgg_file(full_path, &data, &size);
             break;
@@ -134,18 +255,37 @@ void* load_asset(const char *filename, size_t *out_size) {
             result = load_dat_file(full_path, &data, &size);
             break;
         default:
-            l_warning("Unknown asset format: %s", filename);
-            result = -1;
+            // No format handler; AAsset buffers still need the raw bytes
+            l_debug("Unknown asset format, loading raw: %s", filename);
+            result = load_dat_file(full_path, &data, &size);
             break;
     }
 
     if (result == 0 && data) {
+        io_trace_record_path(IO_OP_CACHE_MISS, filename, 0, (uint32_t)size);
+        sceKernelLockLwMutex(&cache_lock, 1, NULL);
+
+        // Another thread may have finished the same file while we were reading
+        int entry = find_cached_asset(filename, hash);
+        if (entry >= 0) {
+            free(data);
+            data = asset_cache[entry].data;
+            size = asset_cache[entry].size;
+        } else {
+            evict_to_budget(size);
+            entry = cache_asset(filename, data, size, format);
+        }
+
+        if (entry >= 0 && pin) asset_cache[entry].refcount++;
+        if (out_entry) *out_entry = entry;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+
         *out_size = size;
-        cache_asset(filename, data, size, format);
         l_debug("Asset loaded: %s (%zu bytes)", filename, size);
         return data;
     }
 
+    io_trace_record_path(IO_OP_FAIL, filename, 0, 0);
     l_error("Failed to load asset: %s", filename);
     return NULL;
 }
@@ -168,6 +308,10 @@ static asset_format_t detect_asset_format(const char *filename) {
     return ASSET_FORMAT_UNKNOWN;
 }
 
+static int read_fd_at(void *ctx, void *buf, size_t offset, size_t count) {
+    return sceIoPread(*(SceUID *)ctx, buf, count, offset);
+}
+
 // Load HGG files (compressed game data)
 static int load_hgg_file(const char *path, void **data, size_t *size) {
     l_debug("Loading HGG file: %s", path);
@@ -183,15 +327,28 @@ static int load_hgg_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
+    // Compressed files stream through the decoder thread chunk by chunk;
+    // one the decoder can't make sense of goes to the game as it is
+    uint8_t header[HGG_HEADER_SIZE];
+    if (sceIoPread(fd, header, sizeof(header), 0) == sizeof(header) &&
+        hgg_is_compressed(header, sizeof(header))) {
+        l_debug("HGG file is compressed, decompressing...");
+        if (hgg_decode(read_fd_at, &fd, *size, data, size) == 0) {
+            sceIoClose(fd);
+            return 0;
+        }
+        l_warn("Passing %s through undecoded", path);
+    }
+
     // Allocate memory
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
     }
 
     // Read file
-    int bytes_read = sceIoRead(fd, *data, *size);
+    int bytes_read = sceIoPread(fd, *data, *size, 0);
     sceIoClose(fd);
 
     if (bytes_read != *size) {
@@ -200,14 +357,61 @@ static int load_hgg_file(const char *path, void **data, size_t *size) {
         return -1;
     }
 
-    // HGG files might be compressed - check signature and decompress if needed
-    uint32_t *header = (uint32_t*)*data;
-    if (*header == HGG_SIGNATURE) {
-        // This is a compressed HGG file - implement decompression
-        l_debug("HGG file is compressed, decompressing...");
-        // TODO: Implement HGG decompression based on format analysis
+    return 0;
+}
+
+static int read_pack_at(void *ctx, void *buf, size_t offset, size_t count) {
+    return asset_pack_read((const asset_pack_entry_t *)ctx, buf, offset, count);
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+} memory_source_t;
+
+static int read_memory_at(void *ctx, void *buf, size_t offset, size_t count) {
+    memory_source_t *source = (memory_source_t *)ctx;
+    if (offset >= source->size) return 0;
+    if (count > source->size - offset) count = source->size - offset;
+    memcpy(buf, source->data + offset, count);
+    return (int)count;
+}
+
+static int load_packed_hgg(const asset_pack_entry_t *entry, void **data, size_t *size) {
+    // Stored entries stream from the archive; LZ4 ones are unpacked first.
+    // Either way, a payload the decoder rejects is returned undecoded
+    if (!(entry->flags & ASSET_PACK_FLAG_LZ4)) {
+        uint8_t header[HGG_HEADER_SIZE];
+        if (asset_pack_read(entry, header, 0, sizeof(header)) == sizeof(header) &&
+            hgg_is_compressed(header, sizeof(header))) {
+            if (hgg_decode(read_pack_at, (void *)entry, entry->size, data, size) == 0) {
+                return 0;
+            }
+            l_warn("Passing packed HGG entry through undecoded");
+        }
+        *data = asset_pack_load(entry, size);
+        return *data ? 0 : -1;
     }
 
+    size_t packed_size;
+    uint8_t *packed = asset_pack_load(entry, &packed_size);
+    if (!packed) {
+        return -1;
+    }
+    if (!hgg_is_compressed(packed, packed_size)) {
+        *data = packed;
+        *size = packed_size;
+        return 0;
+    }
+
+    memory_source_t source = { packed, packed_size };
+    if (hgg_decode(read_memory_at, &source, packed_size, data, size) == 0) {
+        free(packed);
+        return 0;
+    }
+    l_warn("Passing packed HGG entry through undecoded");
+    *data = packed;
+    *size = packed_size;
     return 0;
 }
 
@@ -227,7 +431,7 @@ static int load_spr_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -255,7 +459,7 @@ static int load_hif_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -282,7 +486,12 @@ static int load_hdm_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    // One read into a block aligned like packed payloads, so the game's
+    // parse of the map's arrays starts on a cache line either way
+    *data = memalign(ASSET_PACK_ALIGN, *size);
+    if (!*data && mem_governor_reclaim(MEM_KIND_HEAP, *size)) {
+        *data = memalign(ASSET_PACK_ALIGN, *size);
+    }
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -290,8 +499,18 @@ static int load_hdm_file(const char *path, void **data, size_t *size) {
 
     int bytes_read = sceIoRead(fd, *data, *size);
     sceIoClose(fd);
+    if (bytes_read != *size) {
+        free(*data);
+        *data = NULL;
+        return -1;
+    }
 
-    return (bytes_read == *size) ? 0 : -1;
+    // The game parses the bytes either way; an unexpected header is only
+    // noted. The tag is compared as bytes, as hgg_is_compressed() does
+    if (*size < 4 || memcmp(*data, "HDM\0", 4) != 0) {
+        l_debug("HDM file without the expected \"HDM\\0\" tag: %s", path);
+    }
+    return 0;
 }
 
 // Load YFONT files (font data)
@@ -309,7 +528,7 @@ static int load_yfont_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -336,7 +555,7 @@ static int load_png_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -363,7 +582,7 @@ static int load_dat_file(const char *path, void **data, size_t *size) {
     sceIoGetstatByFd(fd, &stat);
     *size = stat.st_size;
 
-    *data = malloc(*size);
+    *data = mem_governor_malloc(*size);
     if (!*data) {
         sceIoClose(fd);
         return -1;
@@ -375,29 +594,488 @@ static int load_dat_file(const char *path, void **data, size_t *size) {
     return (bytes_read == *size) ? 0 : -1;
 }
 
-// Get cached asset
-static void *get_cached_asset(const char *filename) {
-    for (int i = 0; i < cache_count; i++) {
-        if (strcmp(asset_cache[i].filename, filename) == 0 && asset_cache[i].loaded) {
-            return asset_cache[i].data;
+// ===== CACHE INDEX =====
+
+// FNV-1a over the asset name
+static uint32_t hash_filename(const char *filename) {
+    uint32_t hash = 2166136261u;
+    while (*filename) {
+        hash ^= (uint8_t)*filename++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int find_cached_asset(const char *filename, uint32_t hash) {
+    for (int probe = 0; probe < ASSET_INDEX_SIZE; probe++) {
+        int slot = (hash + probe) & (ASSET_INDEX_SIZE - 1);
+        int entry = asset_index[slot];
+        if (entry < 0) {
+            return -1;
+        }
+        if (asset_cache[entry].hash == hash && strcmp(asset_cache[entry].filename, filename) == 0) {
+            return entry;
         }
     }
-    return NULL;
+    return -1;
 }
 
-// Cache asset
-static void cache_asset(const char *filename, void *data, size_t size, int format) {
-    if (cache_count >= MAX_CACHED_ASSETS) {
-        l_warning("Asset cache full, not caching: %s", filename);
-        return;
+static void index_insert(int entry) {
+    uint32_t hash = asset_cache[entry].hash;
+    for (int probe = 0; probe < ASSET_INDEX_SIZE; probe++) {
+        int slot = (hash + probe) & (ASSET_INDEX_SIZE - 1);
+        if (asset_index[slot] < 0) {
+            asset_index[slot] = entry;
+            return;
+        }
+    }
+}
+
+// Linear-probing delete with backward shift, so no tombstones accumulate
+static void index_remove(int entry) {
+    int slot = asset_cache[entry].hash & (ASSET_INDEX_SIZE - 1);
+    while (asset_index[slot] != entry) {
+        if (asset_index[slot] < 0) {
+            return;
+        }
+        slot = (slot + 1) & (ASSET_INDEX_SIZE - 1);
+    }
+
+    int hole = slot;
+    asset_index[hole] = -1;
+    for (int next = (hole + 1) & (ASSET_INDEX_SIZE - 1); asset_index[next] >= 0;
+         next = (next + 1) & (ASSET_INDEX_SIZE - 1)) {
+        int home = asset_cache[asset_index[next]].hash & (ASSET_INDEX_SIZE - 1);
+        // Move the entry back only if the hole lies between its home slot and where it sits
+        int distance_hole = (hole - home) & (ASSET_INDEX_SIZE - 1);
+        int distance_next = (next - home) & (ASSET_INDEX_SIZE - 1);
+        if (distance_hole < distance_next) {
+            asset_index[hole] = asset_index[next];
+            asset_index[next] = -1;
+            hole = next;
+        }
+    }
+}
+
+// ===== LRU LIST =====
+
+static void lru_unlink(int entry) {
+    asset_cache_entry_t *e = &asset_cache[entry];
+    if (e->lru_prev >= 0) asset_cache[e->lru_prev].lru_next = e->lru_next;
+    else lru_head = e->lru_next;
+    if (e->lru_next >= 0) asset_cache[e->lru_next].lru_prev = e->lru_prev;
+    else lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = -1;
+}
+
+static void lru_push_front(int entry) {
+    asset_cache_entry_t *e = &asset_cache[entry];
+    e->lru_prev = -1;
+    e->lru_next = lru_head;
+    if (lru_head >= 0) asset_cache[lru_head].lru_prev = entry;
+    lru_head = entry;
+    if (lru_tail < 0) lru_tail = entry;
+}
+
+static void lru_touch(int entry) {
+    if (lru_head != entry) {
+        lru_unlink(entry);
+        lru_push_front(entry);
+    }
+}
+
+static void evict_entry(int entry) {
+    asset_cache_entry_t *e = &asset_cache[entry];
+
+    l_debug("Evicting asset: %s (%zu KB)", e->filename, e->size / 1024);
+
+    index_remove(entry);
+    lru_unlink(entry);
+    free(e->data);
+    cache_bytes -= e->size;
+    cache_count--;
+    cache_evictions++;
+
+    e->data = NULL;
+    e->size = 0;
+    e->loaded = 0;
+    e->filename[0] = '\0';
+    e->generation++;
+}
+
+// Drop least recently used, unpinned assets until `incoming` more bytes fit
+static void evict_to_budget(size_t incoming) {
+    int entry = lru_tail;
+    while (entry >= 0 && cache_bytes + incoming > cache_budget) {
+        int prev = asset_cache[entry].lru_prev;
+        if (asset_cache[entry].refcount == 0) {
+            evict_entry(entry);
+        }
+        entry = prev;
+    }
+
+    if (cache_bytes + incoming > cache_budget) {
+        l_warn("Asset cache over budget: %zu KB resident, all pinned", cache_bytes / 1024);
+    }
+}
+
+#if MEM_GOVERNOR
+// Governor purge: unpinned assets, least recently used first
+static size_t purge_assets(mem_kind_t kind, mem_pressure_t pressure __attribute__((unused)), size_t wanted) {
+    if (kind != MEM_KIND_HEAP) {
+        return 0;
+    }
+    // The shortage may be an allocation made under the lock itself
+    if (sceKernelTryLockLwMutex(&cache_lock, 1) < 0) {
+        return 0;
+    }
+
+    size_t freed = 0;
+    int entry = lru_tail;
+    while (entry >= 0 && freed < wanted) {
+        int prev = asset_cache[entry].lru_prev;
+        if (asset_cache[entry].refcount == 0) {
+            freed += asset_cache[entry].size;
+            evict_entry(entry);
+        }
+        entry = prev;
+    }
+
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+    return freed;
+}
+#endif
+
+// Cache asset, returns the entry index or -1
+static int cache_asset(const char *filename, void *data, size_t size, int format) {
+    int entry = -1;
+    if (cache_count < MAX_CACHED_ASSETS) {
+        for (int i = 0; i < MAX_CACHED_ASSETS; i++) {
+            if (!asset_cache[i].loaded) {
+                entry = i;
+                break;
+            }
+        }
+    }
+
+    // Out of slots: recycle the least recently used unpinned entry
+    for (int i = lru_tail; entry < 0 && i >= 0; i = asset_cache[i].lru_prev) {
+        if (asset_cache[i].refcount == 0) {
+            evict_entry(i);
+            entry = i;
+        }
+    }
+
+    if (entry < 0) {
+        l_warn("Asset cache full, not caching: %s", filename);
+        return -1;
     }
 
-    strncpy(asset_cache[cache_count].filename, filename, sizeof(asset_cache[cache_count].filename) - 1);
-    asset_cache[cache_count].data = data;
-    asset_cache[cache_count].size = size;
-    asset_cache[cache_count].format = format;
-    asset_cache[cache_count].loaded = 1;
+    asset_cache_entry_t *e = &asset_cache[entry];
+    strncpy(e->filename, filename, sizeof(e->filename) - 1);
+    e->filename[sizeof(e->filename) - 1] = '\0';
+    e->hash = hash_filename(filename);
+    e->data = data;
+    e->size = size;
+    e->format = format;
+    e->loaded = 1;
+    e->refcount = 0;
+
+    index_insert(entry);
+    lru_push_front(entry);
+    cache_bytes += size;
     cache_count++;
+
+    return entry;
+}
+
+// ===== HANDLES =====
+
+static int handle_entry(asset_handle_t handle) {
+    if (handle < 0) {
+        return -1;
+    }
+
+    int entry = handle & ASSET_HANDLE_SLOT_MASK;
+    uint32_t generation = (uint32_t)handle >> ASSET_HANDLE_SLOT_BITS;
+    if (entry >= MAX_CACHED_ASSETS || !asset_cache[entry].loaded ||
+        (asset_cache[entry].generation & 0x1FFFFF) != generation) {
+        return -1;
+    }
+    return entry;
+}
+
+asset_handle_t asset_acquire(const char *filename) {
+    if (!filename) {
+        return ASSET_HANDLE_INVALID;
+    }
+
+    size_t size;
+    int entry = -1;
+    if (!load_asset_internal(filename, &size, 1, &entry)) {
+        return ASSET_HANDLE_INVALID;
+    }
+
+    if (entry < 0) {
+        // Loaded but the cache had no room for it
+        l_error("Cannot pin uncached asset: %s", filename);
+        return ASSET_HANDLE_INVALID;
+    }
+
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+    asset_handle_t handle = (asset_handle_t)(((asset_cache[entry].generation & 0x1FFFFF) << ASSET_HANDLE_SLOT_BITS) | entry);
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+
+    return handle;
+}
+
+const void *asset_handle_data(asset_handle_t handle, size_t *out_size) {
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+    int entry = handle_entry(handle);
+    if (entry < 0) {
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+        return NULL;
+    }
+
+    if (out_size) {
+        *out_size = asset_cache[entry].size;
+    }
+    const void *data = asset_cache[entry].data;
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+
+    return data;
+}
+
+void asset_release(asset_handle_t handle) {
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+    int entry = handle_entry(handle);
+    if (entry >= 0 && asset_cache[entry].refcount > 0) {
+        asset_cache[entry].refcount--;
+    }
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+}
+
+void asset_set_cache_budget(size_t bytes) {
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+    cache_budget = bytes;
+    evict_to_budget(0);
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+    l_info("Asset cache budget set to %zu KB", bytes / 1024);
+}
+
+size_t asset_get_cache_usage(void) {
+    return cache_bytes;
+}
+
+size_t asset_get_cache_budget(void) {
+    return cache_budget;
+}
+
+void asset_get_cache_stats(uint32_t *hits, uint32_t *misses) {
+    if (hits) {
+        *hits = cache_hits;
+    }
+    if (misses) {
+        *misses = cache_misses;
+    }
+}
+
+void asset_debug_info(void) {
+    l_info("=== Asset Cache Debug Info ===");
+    l_info("  Entries: %d/%d", cache_count, MAX_CACHED_ASSETS);
+    l_info("  Resident: %zu/%zu KB", cache_bytes / 1024, cache_budget / 1024);
+    l_info("  Hits: %u, Misses: %u, Evictions: %u", cache_hits, cache_misses, cache_evictions);
+    l_info("  Async: %d queued, %u deduplicated", queue_count, async_dedups);
+
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+
+    for (int i = lru_head; i >= 0; i = asset_cache[i].lru_next) {
+        if (asset_cache[i].refcount > 0) {
+            l_info("  Pinned [%d refs]: %s (%zu KB)", asset_cache[i].refcount,
+                   asset_cache[i].filename, asset_cache[i].size / 1024);
+        }
+    }
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+}
+
+// ===== ASYNC LOADING =====
+
+static int asset_worker_thread(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    while (workers_running) {
+        sceKernelWaitSema(request_sema, 1, NULL);
+        if (!workers_running) {
+            break;
+        }
+
+        sceKernelLockLwMutex(&cache_lock, 1, NULL);
+        if (queue_count == 0) {
+            sceKernelUnlockLwMutex(&cache_lock, 1);
+            continue;
+        }
+        asset_request_t *request = &pending_requests[request_queue[queue_head]];
+        queue_head = (queue_head + 1) % MAX_PENDING_ASSETS;
+        queue_count--;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+
+        // Pinned while the callbacks run so a concurrent load can't evict it
+        size_t size = 0;
+        int entry = -1;
+        void *data = load_asset_internal(request->filename, &size, 1, &entry);
+
+        // Detach the waiters, after which no new ones can join this request
+        sceKernelLockLwMutex(&cache_lock, 1, NULL);
+        asset_waiter_t waiters[MAX_ASSET_WAITERS];
+        char filename[256];
+        int waiter_count = request->waiter_count;
+        memcpy(waiters, request->waiters, sizeof(waiters));
+        memcpy(filename, request->filename, sizeof(filename));
+        request->in_use = 0;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+
+        for (int i = 0; i < waiter_count; i++) {
+            waiters[i].cb(filename, data, data ? size : 0, waiters[i].user);
+        }
+
+        if (entry >= 0) {
+            sceKernelLockLwMutex(&cache_lock, 1, NULL);
+            asset_cache[entry].refcount--;
+            sceKernelUnlockLwMutex(&cache_lock, 1);
+        }
+    }
+
+    return sceKernelExitDeleteThread(0);
+}
+
+static void start_asset_workers(void) {
+    sceClibMemset(pending_requests, 0, sizeof(pending_requests));
+    queue_head = queue_count = 0;
+
+    request_sema = sceKernelCreateSema("asset_requests", 0, 0, MAX_PENDING_ASSETS, NULL);
+    if (request_sema < 0) {
+        l_error("Failed to create asset request semaphore: 0x%08X", request_sema);
+        return;
+    }
+
+    workers_running = 1;
+    for (int i = 0; i < ASSET_WORKER_COUNT; i++) {
+        asset_workers[i] = sceKernelCreateThread("asset_worker", asset_worker_thread, ASSET_WORKER_PRIORITY,
+                                                 ASSET_WORKER_STACK_SIZE, 0, ASSET_WORKER_AFFINITY, NULL);
+        if (asset_workers[i] >= 0) {
+            sceKernelStartThread(asset_workers[i], 0, NULL);
+        } else {
+            l_error("Failed to create asset worker %d: 0x%08X", i, asset_workers[i]);
+        }
+    }
+
+    l_info("Started %d asset workers", ASSET_WORKER_COUNT);
+}
+
+static void stop_asset_workers(void) {
+    if (request_sema < 0) {
+        return;
+    }
+
+    workers_running = 0;
+    sceKernelSignalSema(request_sema, ASSET_WORKER_COUNT);
+    for (int i = 0; i < ASSET_WORKER_COUNT; i++) {
+        if (asset_workers[i] >= 0) {
+            sceKernelWaitThreadEnd(asset_workers[i], NULL, NULL);
+        }
+    }
+
+    sceKernelDeleteSema(request_sema);
+    request_sema = -1;
+}
+
+int load_asset_async(const char *filename, asset_load_cb cb, void *user) {
+    if (!filename) {
+        return -1;
+    }
+
+    uint32_t hash = hash_filename(filename);
+    sceKernelLockLwMutex(&cache_lock, 1, NULL);
+
+    // Already resident: complete right away on the caller's thread
+    int cached = find_cached_asset(filename, hash);
+    if (cached >= 0) {
+        cache_hits++;
+        lru_touch(cached);
+        void *data = asset_cache[cached].data;
+        size_t size = asset_cache[cached].size;
+        asset_cache[cached].refcount++;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+
+        if (cb) {
+            cb(filename, data, size, user);
+        }
+
+        sceKernelLockLwMutex(&cache_lock, 1, NULL);
+        asset_cache[cached].refcount--;
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+        return 0;
+    }
+
+    // Join an in-flight load of the same file
+    int free_slot = -1;
+    for (int i = 0; i < MAX_PENDING_ASSETS; i++) {
+        asset_request_t *request = &pending_requests[i];
+        if (!request->in_use) {
+            if (free_slot < 0) free_slot = i;
+            continue;
+        }
+        if (request->hash == hash && strcmp(request->filename, filename) == 0) {
+            if (cb) {
+                if (request->waiter_count >= MAX_ASSET_WAITERS) {
+                    sceKernelUnlockLwMutex(&cache_lock, 1);
+                    l_warn("Too many waiters on asset: %s", filename);
+                    return -1;
+                }
+                request->waiters[request->waiter_count++] = (asset_waiter_t){ cb, user };
+            }
+            async_dedups++;
+            sceKernelUnlockLwMutex(&cache_lock, 1);
+            return 0;
+        }
+    }
+
+    if (free_slot < 0 || request_sema < 0) {
+        sceKernelUnlockLwMutex(&cache_lock, 1);
+        l_warn("Asset request queue full: %s", filename);
+        return -1;
+    }
+
+    asset_request_t *request = &pending_requests[free_slot];
+    strncpy(request->filename, filename, sizeof(request->filename) - 1);
+    request->filename[sizeof(request->filename) - 1] = '\0';
+    request->hash = hash;
+    request->in_use = 1;
+    request->waiter_count = 0;
+    if (cb) {
+        request->waiters[request->waiter_count++] = (asset_waiter_t){ cb, user };
+    }
+
+    request_queue[(queue_head + queue_count) % MAX_PENDING_ASSETS] = free_slot;
+    queue_count++;
+    sceKernelUnlockLwMutex(&cache_lock, 1);
+
+    sceKernelSignalSema(request_sema, 1);
+    return 0;
+}
+
+int prefetch_group(const char **filenames, int count) {
+    if (!filenames) {
+        return 0;
+    }
+
+    int queued = 0;
+    for (int i = 0; i < count && filenames[i]; i++) {
+        if (load_asset_async(filenames[i], NULL, NULL) == 0) {
+            queued++;
+        }
+    }
+
+    l_debug("Prefetching %d/%d assets", queued, count);
+    return queued;
 }
 
 // Pre-load critical assets
@@ -415,26 +1093,33 @@ static void preload_critical_assets(void) {
         NULL
     };
 
-    for (int i = 0; critical_assets[i]; i++) {
-        size_t size;
-        void *data = load_asset(critical_assets[i], &size);
-        if (data) {
-            l_debug("Pre-loaded critical asset: %s", critical_assets[i]);
-        }
-    }
+    // Loaded on the worker threads; the first load_asset() of one still in
+    // flight simply reads it itself and the worker's copy is dropped
+    prefetch_group(critical_assets, ARRAY_SIZE(critical_assets) - 1);
 }
 
 // Cleanup asset system
 void cleanup_asset_system(void) {
     l_info("Cleaning up asset system");
 
-    for (int i = 0; i < cache_count; i++) {
+    stop_asset_workers();
+    hgg_decoder_shutdown();
+    asset_dir_free();
+
+    for (int i = 0; i < MAX_CACHED_ASSETS; i++) {
         if (asset_cache[i].data) {
             free(asset_cache[i].data);
             asset_cache[i].data = NULL;
         }
+        asset_cache[i].loaded = 0;
+        asset_cache[i].refcount = 0;
+        asset_cache[i].generation++;
     }
 
+    sceClibMemset(asset_index, 0xFF, sizeof(asset_index));
+    lru_head = lru_tail = -1;
+    cache_bytes = 0;
     cache_count = 0;
+    sceKernelDeleteLwMutex(&cache_lock);
     l_success("Asset system cleaned up");
 }
@@ -0,0 +1,326 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Packed Asset Archive
+ *
+ * Opens the archive produced by extras/scripts/pack_assets.py once and
+ * serves every packed asset as an offset read from that handle. The TOC and
+ * name blob are kept in memory; lookups are a binary search on the name hash.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/dirent.h>
+#include <psp2/io/stat.h>
+
+#include "config.h"
+#include "asset_pack.h"
+#include "mem_governor.h"
+#include "utils/logger.h"
+
+static SceUID pack_fd = -1;
+static char pack_path[256];
+static asset_pack_header_t pack_header;
+static asset_pack_entry_t *pack_toc = NULL;
+static char *pack_names = NULL;
+static uint8_t *pack_overridden = NULL; // 1 = a loose file shadows this entry
+static int pack_override_count = 0;
+
+// Function prototypes
+static uint32_t pack_hash(const char *name);
+static int pack_lookup(const char *name);
+static void scan_loose_overrides(const char *dir, const char *prefix);
+static int lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+int asset_pack_open(const char *path) {
+    if (pack_fd >= 0) {
+        return 0;
+    }
+
+    SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+    if (fd < 0) {
+        l_info("No asset archive at %s, using loose files", path);
+        return -1;
+    }
+
+    if (sceIoPread(fd, &pack_header, sizeof(pack_header), 0) != sizeof(pack_header) ||
+        pack_header.magic != ASSET_PACK_MAGIC || pack_header.version != ASSET_PACK_VERSION) {
+        l_error("Invalid asset archive: %s", path);
+        sceIoClose(fd);
+        return -1;
+    }
+
+    size_t toc_bytes = pack_header.entry_count * sizeof(asset_pack_entry_t);
+    pack_toc = malloc(toc_bytes);
+    pack_names = malloc(pack_header.names_size + 1);
+    pack_overridden = calloc(pack_header.entry_count ? pack_header.entry_count : 1, 1);
+    if (!pack_toc || !pack_names || !pack_overridden ||
+        sceIoPread(fd, pack_toc, toc_bytes, pack_header.toc_offset) != (int)toc_bytes ||
+        sceIoPread(fd, pack_names, pack_header.names_size, pack_header.names_offset) != (int)pack_header.names_size) {
+        l_error("Failed to read asset archive index: %s", path);
+        free(pack_toc);
+        free(pack_names);
+        free(pack_overridden);
+        pack_toc = NULL;
+        pack_names = NULL;
+        pack_overridden = NULL;
+        sceIoClose(fd);
+        return -1;
+    }
+    pack_names[pack_header.names_size] = '\0';
+
+    pack_fd = fd;
+    strncpy(pack_path, path, sizeof(pack_path) - 1);
+    pack_path[sizeof(pack_path) - 1] = '\0';
+
+    // One directory walk here instead of a stat on every lookup
+    pack_override_count = 0;
+    scan_loose_overrides(ASSETS_PATH, "");
+
+    l_success("Asset archive opened: %u entries, %d overridden by loose files",
+              pack_header.entry_count, pack_override_count);
+    return 0;
+}
+
+void asset_pack_close(void) {
+    if (pack_fd < 0) {
+        return;
+    }
+
+    sceIoClose(pack_fd);
+    pack_fd = -1;
+
+    free(pack_toc);
+    free(pack_names);
+    free(pack_overridden);
+    pack_toc = NULL;
+    pack_names = NULL;
+    pack_overridden = NULL;
+}
+
+int asset_pack_is_open(void) {
+    return pack_fd >= 0;
+}
+
+const char *asset_pack_get_path(void) {
+    return pack_fd >= 0 ? pack_path : NULL;
+}
+
+int asset_pack_entry_count(void) {
+    return pack_fd >= 0 ? (int)pack_header.entry_count : 0;
+}
+
+const char *asset_pack_entry_name(int index) {
+    if (pack_fd < 0 || index < 0 || index >= (int)pack_header.entry_count ||
+        pack_toc[index].name_offset >= pack_header.names_size) {
+        return NULL;
+    }
+    return pack_names + pack_toc[index].name_offset;
+}
+
+const asset_pack_entry_t *asset_pack_find(const char *name) {
+    if (pack_fd < 0 || !name) {
+        return NULL;
+    }
+
+    int index = pack_lookup(name);
+    if (index < 0 || pack_overridden[index]) {
+        return NULL;
+    }
+    return &pack_toc[index];
+}
+
+int asset_pack_read(const asset_pack_entry_t *entry, void *buf, size_t offset, size_t count) {
+    if (pack_fd < 0 || !entry || (entry->flags & ASSET_PACK_FLAG_LZ4)) {
+        return -1;
+    }
+
+    if (offset >= entry->size) {
+        return 0;
+    }
+    if (count > entry->size - offset) {
+        count = entry->size - offset;
+    }
+
+    // pread keeps no file position, so any thread can share the handle
+    return sceIoPread(pack_fd, buf, count, (SceOff)entry->offset + offset);
+}
+
+void *asset_pack_load(const asset_pack_entry_t *entry, size_t *out_size) {
+    if (pack_fd < 0 || !entry || !out_size) {
+        return NULL;
+    }
+
+    // +1 keeps malloc(0) from returning NULL for empty files
+    uint8_t *data = mem_governor_malloc(entry->raw_size + 1);
+    if (!data) {
+        return NULL;
+    }
+
+    if (!(entry->flags & ASSET_PACK_FLAG_LZ4)) {
+        if (sceIoPread(pack_fd, data, entry->size, entry->offset) != (int)entry->size) {
+            free(data);
+            return NULL;
+        }
+        *out_size = entry->size;
+        return data;
+    }
+
+    uint8_t *packed = mem_governor_malloc(entry->size);
+    if (!packed) {
+        free(data);
+        return NULL;
+    }
+
+    int ok = sceIoPread(pack_fd, packed, entry->size, entry->offset) == (int)entry->size &&
+             lz4_decompress(packed, entry->size, data, entry->raw_size) == (int)entry->raw_size;
+    free(packed);
+
+    if (!ok) {
+        l_error("Corrupt archive entry at offset 0x%08X", entry->offset);
+        free(data);
+        return NULL;
+    }
+
+    *out_size = entry->raw_size;
+    return data;
+}
+
+// ===== INDEX =====
+
+// FNV-1a, matching the packer
+static uint32_t pack_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int pack_lookup(const char *name) {
+    uint32_t hash = pack_hash(name);
+
+    // Lower bound on hash, then walk the (almost always single) run of equals
+    int lo = 0;
+    int hi = (int)pack_header.entry_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (pack_toc[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (int i = lo; i < (int)pack_header.entry_count && pack_toc[i].hash == hash; i++) {
+        if (pack_toc[i].name_offset < pack_header.names_size &&
+            strcmp(pack_names + pack_toc[i].name_offset, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void scan_loose_overrides(const char *dir, const char *prefix) {
+    SceUID dfd = sceIoDopen(dir);
+    if (dfd < 0) {
+        return;
+    }
+
+    SceIoDirent entry;
+    while (sceIoDread(dfd, &entry) > 0) {
+        if (entry.d_name[0] == '.') {
+            continue;
+        }
+
+        char name[256];
+        snprintf(name, sizeof(name), "%s%s", prefix, entry.d_name);
+
+        if (SCE_S_ISDIR(entry.d_stat.st_mode)) {
+            char path[512];
+            char sub_prefix[256];
+            snprintf(path, sizeof(path), "%s/%s", dir, entry.d_name);
+            snprintf(sub_prefix, sizeof(sub_prefix), "%s/", name);
+            scan_loose_overrides(path, sub_prefix);
+            continue;
+        }
+
+        int index = pack_lookup(name);
+        if (index >= 0 && !pack_overridden[index]) {
+            pack_overridden[index] = 1;
+            pack_override_count++;
+            l_debug("Loose file overrides archive entry: %s", name);
+        }
+    }
+
+    sceIoDclose(dfd);
+}
+
+// ===== LZ4 =====
+
+// Raw LZ4 block decoder with bounds checks on every copy
+static int lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size) {
+    const uint8_t *ip = src;
+    const uint8_t *iend = src + src_size;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + dst_size;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+
+        // Literals
+        size_t length = token >> 4;
+        if (length == 15) {
+            unsigned byte;
+            do {
+                if (ip >= iend) return -1;
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+        }
+        if (length > (size_t)(iend - ip) || length > (size_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+
+        // The last sequence carries literals only
+        if (ip >= iend) {
+            break;
+        }
+
+        // Match
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return -1;
+        }
+
+        length = token & 15;
+        if (length == 15) {
+            unsigned byte;
+            do {
+                if (ip >= iend) return -1;
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+        }
+        length += 4;
+        if (length > (size_t)(oend - op)) {
+            return -1;
+        }
+
+        // Byte copy: matches may overlap their own output
+        const uint8_t *match = op - offset;
+        while (length--) {
+            *op++ = *match++;
+        }
+    }
+
+    return (int)(op - dst);
+}
@@ -8,6 +8,8 @@
 
 #include <AL/al.h>
 #include <AL/alc.h>
+#include <AL/alext.h>
+#include <vorbis/vorbisfile.h>
 #include <psp2/audioout.h>
 #include <psp2/kernel/sysmem.h>
 #include <psp2/kernel/threadmgr.h>
@@ -15,28 +17,93 @@
 #include <psp2/io/stat.h>
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "config.h"
+#include "mem_governor.h"
+#include "profiler.h"
+#include "reimpl/pthr.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
+#if AUDIO_MIXER
+#include "audio_mixer.h"
+
+// The software mixer takes the same calls, so everything below drives it unchanged
+#define alGetError audio_mixer_get_error
+#define alGenSources audio_mixer_gen_sources
+#define alDeleteSources audio_mixer_delete_sources
+#define alGenBuffers audio_mixer_gen_buffers
+#define alDeleteBuffers audio_mixer_delete_buffers
+#define alBufferData audio_mixer_buffer_data
+#define alGetBufferi audio_mixer_get_buffer_i
+#define alSourcef audio_mixer_source_f
+#define alSourcei audio_mixer_source_i
+#define alGetSourcei audio_mixer_get_source_i
+#define alGetSourcef audio_mixer_get_source_f
+#define alSourcePlay audio_mixer_play
+#define alSourceStop audio_mixer_stop
+#define alSourceQueueBuffers audio_mixer_queue_buffers
+#define alSourceUnqueueBuffers audio_mixer_unqueue_buffers
+#define alListenerf(param, value) audio_mixer_set_gain(value) // AL_GAIN is the only listener float set
+#define alSource3f(source, param, x, y, z) ((void)0)           // No positional audio
+#define alcGetString(device, param) "sceAudioOut mixer"
+#endif
+
 // Audio configuration
 #define MAX_AUDIO_SOURCES 32
 #define MAX_AUDIO_BUFFERS 64
-#define AUDIO_BUFFER_SIZE 4096
+#define MAX_VIRTUAL_VOICES 128 // Plays tracked without a source until one frees up
 #define AUDIO_SAMPLE_RATE 44100
 #define AUDIO_CHANNELS 2
 #define AUDIO_FORMAT AL_FORMAT_STEREO16
 
+// WAVE format tags understood by load_wav_file()
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_IEEE_FLOAT 0x0003
+#define WAV_FORMAT_IMA_ADPCM 0x0011
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+// Music streaming configuration
+#define MAX_AUDIO_STREAMS 4
+#define STREAM_BUFFER_COUNT 2
+#define STREAM_CHUNK_SIZE (64 * 1024) // ~370ms of 44.1kHz stereo 16-bit PCM
+
+// SFX bank configuration
+#define SOUND_BANK_HASH_SIZE 128            // Power of two, at least 2x MAX_AUDIO_BUFFERS
+#define SOUND_BANK_BUDGET (8 * 1024 * 1024) // Decoded PCM kept resident in OpenAL buffers
+
+// Game <-> audio thread queues (sizes must be powers of two)
+#define AUDIO_COMMAND_RING_SIZE 64
+#define AUDIO_COMPLETION_RING_SIZE 256     // At least every live voice: virtual + sources + streams
+
+// Sound ids are handles: (generation << AUDIO_HANDLE_SLOT_BITS) | slot
+#define AUDIO_HANDLE_SLOT_BITS 8
+#define AUDIO_HANDLE_SLOTS (1 << AUDIO_HANDLE_SLOT_BITS)
+#define AUDIO_HANDLE_SLOT_MASK (AUDIO_HANDLE_SLOTS - 1)
+#define AUDIO_HANDLE_GEN_MAX ((1u << (31 - AUDIO_HANDLE_SLOT_BITS)) - 1) // Keeps ids positive
+
+// Audio thread scheduling
+#define AUDIO_EVF_WAKE 0x1
+#define AUDIO_WAKE_MIN_US 1000       // Floor so a late source doesn't spin the thread
+#define AUDIO_WAKE_RETRY_US 2000     // Re-check a source that outlived its predicted end
+#define AUDIO_IDLE_POLL_MIN_US 16666
+#define AUDIO_IDLE_POLL_MAX_US 500000 // Idle backoff ceiling; commands still wake us instantly
+
 // Audio file format support
 typedef enum {
     AUDIO_FORMAT_UNKNOWN = 0,
-    AUDIO_FORMAT_WAV,
-    AUDIO_FORMAT_OGG,
-    AUDIO_FORMAT_MP3,
-    AUDIO_FORMAT_RAW
+    AUDIO_FORMAT_WAV_CUSTOM,
+    AUDIO_FORMAT_OGG_CUSTOM,
+    AUDIO_FORMAT_MP3_CUSTOM,
+    AUDIO_FORMAT_RAW_CUSTOM
 } audio_format_t;
 
 // Audio source management
@@ -53,23 +120,116 @@ typedef struct {
     audio_format_t format;
     int priority;
     uint64_t start_time;
+    uint64_t predicted_end; // start_time + buffer duration / pitch, 0 when looping
+    int bank_entry;        // Sound bank entry bound to this source, -1 if none
+    int next_free;         // Intrusive free list link, -1 terminates
+    int heap_pos;          // Position in the steal heap, -1 while free
 } audio_source_t;
 
+// A sound that is playing without an OpenAL source: it keeps time, holds its
+// bank buffer, and takes over a source at its current position once one frees
+typedef struct {
+    int sound_id;
+    int bank_entry;
+    int looping;
+    float volume;
+    float pitch;
+    int priority;
+    uint64_t start_time;
+    uint64_t mark;           // When offset_us was taken
+    uint64_t offset_us;      // Buffer position at mark, at pitch 1.0
+    uint64_t predicted_end;  // As for a source, 0 when looping
+} audio_virtual_t;
+
+// Game thread bookkeeping for one handle slot
+typedef struct {
+    uint32_t generation;
+    int next_free;
+    int in_use;
+} audio_handle_t;
+
+// Where a handle slot is currently playing (audio thread only)
+typedef enum {
+    AUDIO_VOICE_NONE = 0,
+    AUDIO_VOICE_SOURCE,
+    AUDIO_VOICE_STREAM,
+    AUDIO_VOICE_VIRTUAL
+} audio_voice_kind_t;
+
+typedef struct {
+    audio_voice_kind_t kind;
+    int index;
+} audio_voice_map_t;
+
+// Resident decoded SFX, one per buffer_pool slot
+typedef struct {
+    char filename[256];
+    uint32_t hash;
+    ALuint buffer;
+    size_t bytes;
+    uint64_t duration_us;  // Playback length at pitch 1.0
+    int refcount;          // Sources currently bound to the buffer
+    uint64_t last_used;
+    int loaded;
+} sound_bank_entry_t;
+
 // Audio streaming for larger files
 typedef struct {
     ALuint source;
-    ALuint buffers[2];
+    ALuint buffers[STREAM_BUFFER_COUNT];
     FILE *file;
+    OggVorbis_File vorbis;
+    char *pcm;             // Decode scratch, STREAM_CHUNK_SIZE bytes
+    ALenum al_format;
+    long sample_rate;
+    int sound_id;
     int active;
+    int pending_start;     // Opened by a command, primed by update_audio_streams()
     int playing;
     int looping;
+    int eof;
     float volume;
     audio_format_t format;
     size_t file_size;
-    size_t bytes_read;
+    size_t bytes_read;     // Decoded PCM bytes handed to OpenAL so far
     char filename[256];
 } audio_stream_t;
 
+// Commands sent from the game thread; all OpenAL work happens on the audio thread
+typedef enum {
+    AUDIO_CMD_PLAY_SOUND = 0,
+    AUDIO_CMD_PLAY_MUSIC,
+    AUDIO_CMD_STOP,
+    AUDIO_CMD_STOP_ALL,
+    AUDIO_CMD_RELEASE,
+    AUDIO_CMD_SET_VOLUME,
+    AUDIO_CMD_SET_PITCH,
+    AUDIO_CMD_APPLY_VOLUMES,
+    AUDIO_CMD_PRELOAD
+} audio_command_type_t;
+
+typedef struct {
+    audio_command_type_t type;
+    int sound_id;
+    float volume;
+    float pitch;
+    int looping;
+    int priority;
+    char filename[256];
+} audio_command_t;
+
+typedef struct {
+    audio_command_t items[AUDIO_COMMAND_RING_SIZE];
+    uint32_t head; // Advanced by the game thread only
+    uint32_t tail; // Advanced by the audio thread only
+} audio_command_ring_t;
+
+typedef struct {
+    int ids[AUDIO_COMPLETION_RING_SIZE];
+    uint32_t head; // Advanced by the audio thread only
+    uint32_t tail; // Advanced by the game thread only
+} audio_completion_ring_t;
+
 // Audio system state
 typedef struct {
     int initialized;
@@ -79,14 +239,30 @@ typedef struct {
     // Audio sources
     audio_source_t sources[MAX_AUDIO_SOURCES];
     ALuint source_pool[MAX_AUDIO_SOURCES];
-    int next_source_index;
+    int source_count; // Generated sources, at most MAX_AUDIO_SOURCES
+    int source_free_head;
+    int steal_heap[MAX_AUDIO_SOURCES]; // Min-heap of busy sources by (priority, start_time)
+    int steal_heap_size;
+    audio_voice_map_t voice_map[AUDIO_HANDLE_SLOTS];
+
+    // Virtual voices, packed at the front
+    audio_virtual_t virtuals[MAX_VIRTUAL_VOICES];
+    int virtual_count;
 
     // Audio buffers
     ALuint buffer_pool[MAX_AUDIO_BUFFERS];
-    int next_buffer_index;
+
+    // SFX bank (filename -> resident buffer)
+    sound_bank_entry_t bank[MAX_AUDIO_BUFFERS];
+    int16_t bank_index[SOUND_BANK_HASH_SIZE]; // Open addressing, -1 = empty
+    size_t bank_bytes;
+    int bank_count;
+    uint32_t bank_hits;
+    uint32_t bank_misses;
+    size_t trim_bytes;      // Bank bytes the memory governor asked back, any thread sets it
 
     // Streaming
-    audio_stream_t streams[4]; // Limited streams for memory
+    audio_stream_t streams[MAX_AUDIO_STREAMS]; // Limited streams for memory
     int next_stream_index;
 
     // Settings
@@ -98,45 +274,106 @@ typedef struct {
     int sfx_enabled;
 
     // Performance
-    int active_sources;
-    int next_sound_id;
+    volatile int active_sources; // Written by the audio thread, read by the game thread
+
+    // Thread handoff
+    audio_command_ring_t commands;
+    audio_completion_ring_t completions;
+    audio_handle_t handles[AUDIO_HANDLE_SLOTS]; // Game thread view of which ids are still playing
+    int handle_free_head;
+    int handles_in_use;
 
     // Threading
     SceUID audio_thread;
     int audio_thread_running;
+    SceUID wake_flag;       // Set by push_command() to wake the audio thread
+    SceUInt idle_poll_us;   // Adaptive backoff while nothing is playing
+    uint32_t wakeups;
+
+    // Suspend
+    int suspended;          // Audio thread stopped and output paused by audio_suspend()
+    uint64_t suspend_time;
 
 } audio_state_t;
 
 static audio_state_t audio_state = {0};
+static int source_limit = MAX_AUDIO_SOURCES;
 
 // Forward declarations
+#if !AUDIO_MIXER
 static void initialize_openal(void);
+#endif
 static void setup_audio_sources(void);
 static void setup_audio_buffers(void);
+static void setup_audio_streams(void);
+static void init_handles(void);
 static int get_available_source(void);
-static int get_available_buffer(void);
+static void steal_heap_push(int index);
+static void steal_heap_sift(int pos);
+static void release_source(audio_source_t *source);
+static int voice_loses_to(int priority, float volume, uint64_t start_time,
+                          int other_priority, float other_volume, uint64_t other_start_time);
+static void bind_source(int index, const audio_virtual_t *voice, uint64_t now);
+static void demote_source(audio_source_t *source);
+static void virtual_push(const audio_virtual_t *voice);
+static void virtual_drop(int index, int complete);
+static void virtual_remove(int index);
+static uint64_t virtual_position(const audio_virtual_t *voice, uint64_t now);
+static void promote_virtual_voices(void);
+static void process_audio_commands(void);
+static void do_play_sound(const audio_command_t *cmd);
+static void do_play_music(const audio_command_t *cmd);
+static void do_stop_sound(int sound_id);
+static void do_stop_all(void);
+static void do_set_sound_volume(int sound_id, float volume);
+static void do_set_sound_pitch(int sound_id, float pitch);
+static void do_apply_volumes(void);
+static int bank_load(const char *filename);
+static void bank_evict(int entry);
+static void bank_trim(void);
+#if MEM_GOVERNOR
+static size_t purge_sfx_bank(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+#endif
 static audio_format_t detect_audio_format(const char *filename);
-static int load_wav_file(const char *filename, ALuint buffer);
-static int load_ogg_file(const char *filename, ALuint buffer);
+static int load_wav_file(const char *filename, ALuint buffer, size_t *out_bytes);
+static int load_ogg_file(const char *filename, ALuint buffer, size_t *out_bytes);
+static int open_ogg_stream(audio_stream_t *stream, const char *filename);
+static size_t fill_stream_chunk(audio_stream_t *stream);
+static void start_stream(audio_stream_t *stream);
+static void close_stream(audio_stream_t *stream);
 static void cleanup_completed_sources(void);
 static void update_audio_streams(void);
+static SceUInt compute_wake_timeout(void);
+static void start_audio_thread(void);
+static void stop_audio_thread(void);
+static void pause_output(int paused);
+static void shift_voice_clocks(uint64_t us);
 static int audio_thread_func(SceSize args, void *argp);
 static void create_directories(void);
 
 // ===== INITIALIZATION =====
 
+void audio_set_source_limit(int count) {
+    source_limit = count < 1 ? 1 : count > MAX_AUDIO_SOURCES ? MAX_AUDIO_SOURCES : count;
+}
+
 int audio_init(void) {
     l_info("Initializing audio system for Fluffy Diver");
 
     // Create required directories
     create_directories();
 
-    // Initialize OpenAL
+    // Initialize OpenAL, or the software mixer in its place
+#if AUDIO_MIXER
+    audio_mixer_open();
+#else
     initialize_openal();
+#endif
 
     // Set up audio sources and buffers
     setup_audio_sources();
     setup_audio_buffers();
+    setup_audio_streams();
 
     // Initialize state
     audio_state.initialized = 1;
@@ -147,33 +384,33 @@ int audio_init(void) {
     audio_state.music_enabled = 1;
     audio_state.sfx_enabled = 1;
     audio_state.active_sources = 0;
-    audio_state.next_sound_id = 1;
-    audio_state.next_source_index = 0;
-    audio_state.next_buffer_index = 0;
+    init_handles();
     audio_state.next_stream_index = 0;
 
-    // Initialize streams
-    memset(audio_state.streams, 0, sizeof(audio_state.streams));
-
     // Start audio thread
-    audio_state.audio_thread_running = 1;
-    audio_state.audio_thread = sceKernelCreateThread("audio_thread", audio_thread_func,
-                                                     0x10000100, 0x10000, 0, 0, NULL);
-    if (audio_state.audio_thread >= 0) {
-        sceKernelStartThread(audio_state.audio_thread, 0, NULL);
+    audio_state.wake_flag = sceKernelCreateEventFlag("audio_wake", 0, 0, NULL);
+    if (audio_state.wake_flag < 0) {
+        l_error("Failed to create audio wake event flag: 0x%08X", audio_state.wake_flag);
     }
+    audio_state.idle_poll_us = AUDIO_IDLE_POLL_MIN_US;
+#if MEM_GOVERNOR
+    mem_governor_register("sfx_bank", MEM_PRIORITY_SFX, MEM_PURGE_ANY_THREAD, purge_sfx_bank);
+#endif
+    start_audio_thread();
 
     l_success("Audio system initialized successfully");
     l_info("  OpenAL Device: %s", alcGetString(audio_state.device, ALC_DEVICE_SPECIFIER));
     l_info("  Sample Rate: %d Hz", AUDIO_SAMPLE_RATE);
     l_info("  Channels: %d", AUDIO_CHANNELS);
-    l_info("  Audio Sources: %d", MAX_AUDIO_SOURCES);
-    l_info("  Audio Buffers: %d", MAX_AUDIO_BUFFERS);
+    l_info("  Audio Sources: %d", audio_state.source_count);
+    l_info("  Audio Buffers: %d (SFX bank budget %d KB)", MAX_AUDIO_BUFFERS, SOUND_BANK_BUDGET / 1024);
+    l_info("  Music Streams: %d x %d KB", MAX_AUDIO_STREAMS, (STREAM_BUFFER_COUNT * STREAM_CHUNK_SIZE) / 1024);
     l_info("  Master Volume: %.1f", audio_state.master_volume);
 
     return 1;
 }
 
+#if !AUDIO_MIXER
 static void initialize_openal(void) {
     l_info("Initializing OpenAL");
 
@@ -214,15 +451,17 @@ static void initialize_openal(void) {
 
     l_success("OpenAL initialized successfully");
 }
+#endif
 
 static void setup_audio_sources(void) {
     l_info("Setting up audio sources");
 
     // Generate audio sources
-    alGenSources(MAX_AUDIO_SOURCES, audio_state.source_pool);
+    audio_state.source_count = source_limit;
+    alGenSources(audio_state.source_count, audio_state.source_pool);
 
     // Initialize source structures
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
+    for (int i = 0; i < audio_state.source_count; i++) {
         audio_state.sources[i].source = audio_state.source_pool[i];
         audio_state.sources[i].buffer = 0;
         audio_state.sources[i].sound_id = 0;
@@ -234,6 +473,9 @@ static void setup_audio_sources(void) {
         audio_state.sources[i].format = AUDIO_FORMAT_UNKNOWN;
         audio_state.sources[i].priority = 0;
         audio_state.sources[i].start_time = 0;
+        audio_state.sources[i].bank_entry = -1;
+        audio_state.sources[i].next_free = (i + 1 < audio_state.source_count) ? i + 1 : -1;
+        audio_state.sources[i].heap_pos = -1;
         memset(audio_state.sources[i].filename, 0, sizeof(audio_state.sources[i].filename));
 
         // Set source properties
@@ -244,6 +486,11 @@ static void setup_audio_sources(void) {
         alSourcei(audio_state.sources[i].source, AL_LOOPING, AL_FALSE);
     }
 
+    audio_state.source_free_head = 0;
+    audio_state.steal_heap_size = 0;
+    memset(audio_state.voice_map, 0, sizeof(audio_state.voice_map));
+    audio_state.virtual_count = 0;
+
     l_success("Audio sources initialized");
 }
 
@@ -253,6 +500,15 @@ static void setup_audio_buffers(void) {
     // Generate audio buffers
     alGenBuffers(MAX_AUDIO_BUFFERS, audio_state.buffer_pool);
 
+    // Each bank entry owns one pool buffer for its whole lifetime
+    memset(audio_state.bank, 0, sizeof(audio_state.bank));
+    memset(audio_state.bank_index, 0xFF, sizeof(audio_state.bank_index));
+    for (int i = 0; i < MAX_AUDIO_BUFFERS; i++) {
+        audio_state.bank[i].buffer = audio_state.buffer_pool[i];
+    }
+    audio_state.bank_bytes = 0;
+    audio_state.bank_count = 0;
+
     ALenum error = alGetError();
     if (error != AL_NO_ERROR) {
         l_error("OpenAL error generating buffers: 0x%x", error);
@@ -261,319 +517,1674 @@ static void setup_audio_buffers(void) {
     l_success("Audio buffers initialized");
 }
 
-// ===== AUDIO PLAYBACK =====
+static void setup_audio_streams(void) {
+    l_info("Setting up music streams");
 
-int audio_play_sound(const char *filename, float volume, int looping, int priority) {
-    if (!audio_state.initialized || !audio_state.audio_enabled) {
-        return -1;
-    }
+    memset(audio_state.streams, 0, sizeof(audio_state.streams));
 
-    if (!filename || strlen(filename) == 0) {
-        l_error("Invalid filename for audio playback");
-        return -1;
+    // Each stream owns a dedicated source so music never competes with SFX
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        audio_stream_t *stream = &audio_state.streams[i];
+        alGenSources(1, &stream->source);
+        alGenBuffers(STREAM_BUFFER_COUNT, stream->buffers);
+
+        alSourcef(stream->source, AL_PITCH, 1.0f);
+        alSourcef(stream->source, AL_GAIN, 1.0f);
+        alSource3f(stream->source, AL_POSITION, 0.0f, 0.0f, 0.0f);
+        alSourcei(stream->source, AL_SOURCE_RELATIVE, AL_TRUE);
+        alSourcei(stream->source, AL_LOOPING, AL_FALSE); // Looping is done by rewinding the decoder
     }
 
-    // Get available source
-    int source_index = get_available_source();
-    if (source_index < 0) {
-        l_warn("No available audio sources for: %s", filename);
-        return -1;
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR) {
+        l_error("OpenAL error generating stream objects: 0x%x", error);
     }
 
-    // Get available buffer
-    int buffer_index = get_available_buffer();
-    if (buffer_index < 0) {
-        l_warn("No available audio buffers for: %s", filename);
-        return -1;
-    }
+    l_success("Music streams initialized");
+}
 
-    audio_source_t *source = &audio_state.sources[source_index];
-    ALuint buffer = audio_state.buffer_pool[buffer_index];
+// ===== COMMAND QUEUE =====
 
-    // Detect audio format
-    audio_format_t format = detect_audio_format(filename);
-    if (format == AUDIO_FORMAT_UNKNOWN) {
-        l_error("Unsupported audio format: %s", filename);
-        return -1;
+static void wake_audio_thread(void) {
+    if (audio_state.wake_flag >= 0) {
+        sceKernelSetEventFlag(audio_state.wake_flag, AUDIO_EVF_WAKE);
     }
+}
 
-    // Load audio file
-    int load_result = 0;
-    switch (format) {
-        case AUDIO_FORMAT_WAV_CUSTOM:
-            load_result = load_wav_file(filename, buffer);
-            break;
-        case AUDIO_FORMAT_OGG_CUSTOM:
-            load_result = load_ogg_file(filename, buffer);
-            break;
-        default:
-            l_error("Format not implemented: %d", format);
-            return -1;
+// Game thread -> audio thread. Single producer, single consumer: the game
+// thread only advances head, the audio thread only advances tail.
+static int push_command(const audio_command_t *cmd) {
+    audio_command_ring_t *ring = &audio_state.commands;
+    uint32_t head = ring->head;
+
+    // Give the audio thread a moment to drain before dropping the command
+    for (int tries = 0; head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= AUDIO_COMMAND_RING_SIZE; tries++) {
+        // Nothing drains the queue while suspended
+        if (tries >= 50 || audio_state.suspended) {
+            l_warn("Audio command queue full, dropping command %d", cmd->type);
+            return 0;
+        }
+        wake_audio_thread();
+        sceKernelDelayThread(200);
     }
 
-    if (!load_result) {
-        l_error("Failed to load audio file: %s", filename);
-        return -1;
-    }
+    ring->items[head & (AUDIO_COMMAND_RING_SIZE - 1)] = *cmd;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
 
-    // Set up source
-    source->buffer = buffer;
-    source->sound_id = audio_state.next_sound_id++;
-    source->active = 1;
-    source->playing = 1;
-    source->looping = looping;
-    source->volume = volume;
-    source->pitch = 1.0f;
-    source->format = format;
-    source->priority = priority;
-    source->start_time = sceKernelGetSystemTimeWide();
-    strncpy(source->filename, filename, sizeof(source->filename) - 1);
+    wake_audio_thread();
+    return 1;
+}
 
-    // Apply volume (consider master volume and SFX volume)
-    float final_volume = volume * audio_state.master_volume * audio_state.sfx_volume;
-    alSourcef(source->source, AL_GAIN, final_volume);
-    alSourcef(source->source, AL_PITCH, source->pitch);
-    alSourcei(source->source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+static int pop_command(audio_command_t *cmd) {
+    audio_command_ring_t *ring = &audio_state.commands;
+    uint32_t tail = ring->tail;
 
-    // Bind buffer to source
-    alSourcei(source->source, AL_BUFFER, buffer);
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
 
-    // Play sound
-    alSourcePlay(source->source);
+    *cmd = ring->items[tail & (AUDIO_COMMAND_RING_SIZE - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
 
-    audio_state.active_sources++;
+// Audio thread -> game thread, same scheme with the roles swapped
+static void push_completion(int sound_id) {
+    audio_completion_ring_t *ring = &audio_state.completions;
+    uint32_t head = ring->head;
 
-    l_debug("Playing sound: %s (ID: %d, Volume: %.2f)", filename, source->sound_id, final_volume);
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= AUDIO_COMPLETION_RING_SIZE) {
+        l_warn("Audio completion queue full, dropping ID: %d", sound_id);
+        return;
+    }
 
-    return source->sound_id;
+    ring->ids[head & (AUDIO_COMPLETION_RING_SIZE - 1)] = sound_id;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
 }
 
-int audio_play_music(const char *filename, float volume, int looping) {
-    if (!audio_state.initialized || !audio_state.music_enabled) {
+// ===== SOUND HANDLES =====
+
+static void init_handles(void) {
+    for (int i = 0; i < AUDIO_HANDLE_SLOTS; i++) {
+        audio_state.handles[i].generation = 1;
+        audio_state.handles[i].in_use = 0;
+        audio_state.handles[i].next_free = (i + 1 < AUDIO_HANDLE_SLOTS) ? i + 1 : -1;
+    }
+    audio_state.handle_free_head = 0;
+    audio_state.handles_in_use = 0;
+}
+
+// Game thread only. Returns a new sound id, or -1 when every slot is live
+static int alloc_handle(void) {
+    int slot = audio_state.handle_free_head;
+    if (slot < 0) {
+        l_warn("Out of sound handles (%d live)", audio_state.handles_in_use);
         return -1;
     }
 
-    // Music gets higher priority and uses streaming for large files
-    return audio_play_sound(filename, volume * audio_state.music_volume, looping, 100);
+    audio_handle_t *handle = &audio_state.handles[slot];
+    audio_state.handle_free_head = handle->next_free;
+    handle->in_use = 1;
+    handle->next_free = -1;
+    audio_state.handles_in_use++;
+
+    return (int)((handle->generation << AUDIO_HANDLE_SLOT_BITS) | slot);
 }
 
-void audio_stop_sound(int sound_id) {
-    if (!audio_state.initialized || sound_id <= 0) {
+static int handle_is_live(int sound_id) {
+    if (sound_id <= 0) {
+        return 0;
+    }
+
+    audio_handle_t *handle = &audio_state.handles[sound_id & AUDIO_HANDLE_SLOT_MASK];
+    return handle->in_use && handle->generation == ((uint32_t)sound_id >> AUDIO_HANDLE_SLOT_BITS);
+}
+
+// Stale or already-freed ids are ignored, so late completions are harmless
+static void free_handle(int sound_id) {
+    if (!handle_is_live(sound_id)) {
         return;
     }
 
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active && audio_state.sources[i].sound_id == sound_id) {
-            alSourceStop(audio_state.sources[i].source);
-            audio_state.sources[i].active = 0;
-            audio_state.sources[i].playing = 0;
-            audio_state.sources[i].sound_id = 0;
-            audio_state.active_sources--;
+    int slot = sound_id & AUDIO_HANDLE_SLOT_MASK;
+    audio_handle_t *handle = &audio_state.handles[slot];
+    handle->in_use = 0;
+    handle->generation = (handle->generation >= AUDIO_HANDLE_GEN_MAX) ? 1 : handle->generation + 1;
+    handle->next_free = audio_state.handle_free_head;
+    audio_state.handle_free_head = slot;
+    audio_state.handles_in_use--;
+}
 
-            l_debug("Stopped sound ID: %d", sound_id);
-            break;
+static void free_all_handles(void) {
+    for (int i = 0; i < AUDIO_HANDLE_SLOTS; i++) {
+        audio_handle_t *handle = &audio_state.handles[i];
+        if (handle->in_use) {
+            free_handle((int)((handle->generation << AUDIO_HANDLE_SLOT_BITS) | i));
         }
     }
 }
 
-void audio_stop_all_sounds(void) {
-    if (!audio_state.initialized) {
-        return;
-    }
+static void drain_completions(void) {
+    audio_completion_ring_t *ring = &audio_state.completions;
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
 
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active) {
-            alSourceStop(audio_state.sources[i].source);
-            audio_state.sources[i].active = 0;
-            audio_state.sources[i].playing = 0;
-            audio_state.sources[i].sound_id = 0;
-        }
+    while (tail != head) {
+        free_handle(ring->ids[tail & (AUDIO_COMPLETION_RING_SIZE - 1)]);
+        tail++;
     }
 
-    audio_state.active_sources = 0;
-    l_info("Stopped all sounds");
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
 }
 
-// ===== AUDIO MANAGEMENT =====
 
-static int get_available_source(void) {
-    // First, try to find a completely free source
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (!audio_state.sources[i].active) {
-            return i;
+static void process_audio_commands(void) {
+    audio_command_t cmd;
+
+    while (pop_command(&cmd)) {
+        switch (cmd.type) {
+            case AUDIO_CMD_PLAY_SOUND:
+                do_play_sound(&cmd);
+                break;
+            case AUDIO_CMD_PLAY_MUSIC:
+                do_play_music(&cmd);
+                break;
+            case AUDIO_CMD_STOP:
+            case AUDIO_CMD_RELEASE:
+                do_stop_sound(cmd.sound_id);
+                break;
+            case AUDIO_CMD_STOP_ALL:
+                do_stop_all();
+                break;
+            case AUDIO_CMD_SET_VOLUME:
+                do_set_sound_volume(cmd.sound_id, cmd.volume);
+                break;
+            case AUDIO_CMD_SET_PITCH:
+                do_set_sound_pitch(cmd.sound_id, cmd.pitch);
+                break;
+            case AUDIO_CMD_APPLY_VOLUMES:
+                do_apply_volumes();
+                break;
+            case AUDIO_CMD_PRELOAD:
+                if (bank_load(cmd.filename) < 0) {
+                    l_warn("Failed to preload SFX: %s", cmd.filename);
+                }
+                break;
         }
     }
+}
 
-    // If no free sources, find one that's finished playing
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active) {
-            ALint state;
-            alGetSourcei(audio_state.sources[i].source, AL_SOURCE_STATE, &state);
-            if (state == AL_STOPPED) {
-                // Free this source
-                audio_state.sources[i].active = 0;
-                audio_state.sources[i].playing = 0;
-                audio_state.sources[i].sound_id = 0;
-                audio_state.active_sources--;
-                return i;
-            }
-        }
-    }
+// ===== AUDIO PLAYBACK =====
 
-    // If still no free sources, steal the lowest priority one
-    int lowest_priority = 1000;
-    int lowest_index = -1;
+int audio_play_sound(const char *filename, float volume, int looping, int priority) {
+    if (!audio_state.initialized || !audio_state.audio_enabled) {
+        return -1;
+    }
 
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active && audio_state.sources[i].priority < lowest_priority) {
-            lowest_priority = audio_state.sources[i].priority;
-            lowest_index = i;
-        }
+    if (!filename || strlen(filename) == 0) {
+        l_error("Invalid filename for audio playback");
+        return -1;
     }
 
-    if (lowest_index >= 0) {
-        alSourceStop(audio_state.sources[lowest_index].source);
-        audio_state.sources[lowest_index].active = 0;
-        audio_state.sources[lowest_index].playing = 0;
-        audio_state.sources[lowest_index].sound_id = 0;
-        audio_state.active_sources--;
-        l_debug("Stole audio source %d (priority %d)", lowest_index, lowest_priority);
-        return lowest_index;
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_PLAY_SOUND;
+    cmd.sound_id = alloc_handle();
+    cmd.volume = volume;
+    cmd.looping = looping;
+    cmd.priority = priority;
+    strncpy(cmd.filename, filename, sizeof(cmd.filename) - 1);
+
+    if (cmd.sound_id < 0 || !push_command(&cmd)) {
+        free_handle(cmd.sound_id);
+        return -1;
     }
 
-    return -1;
+    return cmd.sound_id;
 }
 
-static int get_available_buffer(void) {
-    // Simple round-robin allocation
-    int buffer_index = audio_state.next_buffer_index;
-    audio_state.next_buffer_index = (audio_state.next_buffer_index + 1) % MAX_AUDIO_BUFFERS;
-    return buffer_index;
-}
+int audio_play_music(const char *filename, float volume, int looping) {
+    if (!audio_state.initialized || !audio_state.music_enabled) {
+        return -1;
+    }
 
-static void cleanup_completed_sources(void) {
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active) {
-            ALint state;
-            alGetSourcei(audio_state.sources[i].source, AL_SOURCE_STATE, &state);
+    if (!filename || strlen(filename) == 0) {
+        l_error("Invalid filename for music playback");
+        return -1;
+    }
 
-            if (state == AL_STOPPED && !audio_state.sources[i].looping) {
-                // Mark as completed
-                audio_state.sources[i].active = 0;
-                audio_state.sources[i].playing = 0;
+    // Non-Vorbis music is small enough to go through the regular SFX path
+    if (detect_audio_format(filename) != AUDIO_FORMAT_OGG_CUSTOM) {
+        return audio_play_sound(filename, volume * audio_state.music_volume, looping, 100);
+    }
 
-                // Notify game through JNI callback
-                // This will be called from the audio thread
-                extern void audio_mark_complete(int sound_id);
-                audio_mark_complete(audio_state.sources[i].sound_id);
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_PLAY_MUSIC;
+    cmd.sound_id = alloc_handle();
+    cmd.volume = volume;
+    cmd.looping = looping;
+    strncpy(cmd.filename, filename, sizeof(cmd.filename) - 1);
 
-                audio_state.sources[i].sound_id = 0;
-                audio_state.active_sources--;
-            }
-        }
+    if (cmd.sound_id < 0 || !push_command(&cmd)) {
+        free_handle(cmd.sound_id);
+        return -1;
     }
-}
-
-// ===== AUDIO FILE LOADING =====
 
-static audio_format_t detect_audio_format(const char *filename) {
-    if (!filename) return AUDIO_FORMAT_UNKNOWN;
+    return cmd.sound_id;
+}
 
-    const char *ext = strrchr(filename, '.');
-    if (!ext) return AUDIO_FORMAT_UNKNOWN;
+void audio_stop_sound(int sound_id) {
+    if (!audio_state.initialized || sound_id <= 0) {
+        return;
+    }
 
-    if (strcasecmp(ext, ".wav") == 0) return AUDIO_FORMAT_WAV_CUSTOM;
-    if (strcasecmp(ext, ".ogg") == 0) return AUDIO_FORMAT_OGG_CUSTOM;
-    if (strcasecmp(ext, ".mp3") == 0) return AUDIO_FORMAT_MP3_CUSTOM;
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_STOP;
+    cmd.sound_id = sound_id;
+    push_command(&cmd);
 
-    return AUDIO_FORMAT_UNKNOWN;
+    free_handle(sound_id);
 }
 
-static int load_wav_file(const char *filename, ALuint buffer) {
-    // Simple WAV file loader
-    // In a real implementation, this would parse the WAV header properly
-
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        l_error("Failed to open WAV file: %s", filename);
-        return 0;
+void audio_stop_all_sounds(void) {
+    if (!audio_state.initialized) {
+        return;
     }
 
-    // Skip WAV header (simplified)
-    fseek(file, 44, SEEK_SET);
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_STOP_ALL;
+    push_command(&cmd);
 
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file) - 44;
-    fseek(file, 44, SEEK_SET);
+    free_all_handles();
+    l_info("Stopped all sounds");
+}
 
-    // Allocate buffer
-    char *data = malloc(file_size);
-    if (!data) {
-        fclose(file);
-        l_error("Failed to allocate memory for WAV file");
-        return 0;
+void audio_set_sound_volume(int sound_id, float volume) {
+    if (!audio_state.initialized || sound_id <= 0) {
+        return;
     }
 
-    // Read data
-    size_t bytes_read = fread(data, 1, file_size, file);
-    fclose(file);
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_SET_VOLUME;
+    cmd.sound_id = sound_id;
+    cmd.volume = fmaxf(0.0f, fminf(1.0f, volume));
+    push_command(&cmd);
+}
 
-    if (bytes_read != (size_t)file_size) {
-        free(data);
-        l_error("Failed to read WAV file completely");
-        return 0;
+void audio_set_sound_pitch(int sound_id, float pitch) {
+    if (!audio_state.initialized || sound_id <= 0) {
+        return;
     }
 
-    // Load into OpenAL buffer
-    alBufferData(buffer, AUDIO_FORMAT, data, file_size, AUDIO_SAMPLE_RATE);
-
-    free(data);
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_SET_PITCH;
+    cmd.sound_id = sound_id;
+    cmd.pitch = fmaxf(0.5f, fminf(2.0f, pitch));
+    push_command(&cmd);
+}
 
-    ALenum error = alGetError();
-    if (error != AL_NO_ERROR) {
-        l_error("OpenAL error loading WAV: 0x%x", error);
-        return 0;
+void audio_update(void) {
+    if (!audio_state.initialized) {
+        return;
     }
 
-    l_debug("Loaded WAV file: %s (%ld bytes)", filename, file_size);
-    return 1;
-}
-
-static int load_ogg_file(const char *filename __attribute__((unused)), ALuint buffer __attribute__((unused))) {
-    // OGG file loading would require libvorbis integration
-    // For now, return failure
-    l_error("OGG format not yet implemented: %s", filename);
-    return 0;
+    drain_completions();
 }
 
-// ===== VOLUME CONTROL =====
+// ===== AUDIO THREAD COMMAND HANDLERS =====
 
-void audio_set_master_volume(float volume) {
-    if (!audio_state.initialized) return;
+static void do_play_sound(const audio_command_t *cmd) {
+    // Resolve the decoded buffer first; repeat plays never touch storage
+    int entry = bank_load(cmd->filename);
+    if (entry < 0) {
+        l_error("Failed to load audio file: %s", cmd->filename);
+        push_completion(cmd->sound_id);
+        return;
+    }
 
-    audio_state.master_volume = fmaxf(0.0f, fminf(1.0f, volume));
-    alListenerf(AL_GAIN, audio_state.master_volume);
+    uint64_t now = sceKernelGetSystemTimeWide();
+    sound_bank_entry_t *bank = &audio_state.bank[entry];
+    bank->refcount++;
+    bank->last_used = now;
+
+    audio_virtual_t voice = {0};
+    voice.sound_id = cmd->sound_id;
+    voice.bank_entry = entry;
+    voice.looping = cmd->looping;
+    voice.volume = cmd->volume;
+    voice.pitch = 1.0f;
+    voice.priority = cmd->priority;
+    voice.start_time = now;
+    voice.mark = now;
+    voice.predicted_end = voice.looping ? 0 : now + bank->duration_us;
+
+    // A full pool only gives up a source to a sound that outranks its weakest one
+    if (audio_state.source_free_head < 0) {
+        cleanup_completed_sources();
+    }
+    if (audio_state.source_free_head < 0 && audio_state.steal_heap_size > 0) {
+        audio_source_t *weakest = &audio_state.sources[audio_state.steal_heap[0]];
+        if (voice_loses_to(voice.priority, voice.volume, voice.start_time,
+                           weakest->priority, weakest->volume, weakest->start_time)) {
+            l_debug("Playing sound virtually: %s (ID: %d)", cmd->filename, cmd->sound_id);
+            virtual_push(&voice);
+            return;
+        }
+    }
 
-    l_info("Master volume set to %.2f", audio_state.master_volume);
-}
+    int source_index = get_available_source();
+    if (source_index < 0) {
+        virtual_push(&voice);
+        return;
+    }
 
-void audio_set_music_volume(float volume) {
-    if (!audio_state.initialized) return;
+    bind_source(source_index, &voice, now);
 
-    audio_state.music_volume = fmaxf(0.0f, fminf(1.0f, volume));
-    l_info("Music volume set to %.2f", audio_state.music_volume);
+    l_debug("Playing sound: %s (ID: %d, Volume: %.2f)", cmd->filename, cmd->sound_id,
+            voice.volume * audio_state.master_volume * audio_state.sfx_volume);
 }
 
-void audio_set_sfx_volume(float volume) {
-    if (!audio_state.initialized) return;
+// Start a voice on a source, from wherever it has got to
+static void bind_source(int index, const audio_virtual_t *voice, uint64_t now) {
+    audio_source_t *source = &audio_state.sources[index];
+    sound_bank_entry_t *bank = voice->bank_entry >= 0 ? &audio_state.bank[voice->bank_entry] : NULL;
+    uint64_t duration = bank ? bank->duration_us : 0;
+    uint64_t position = virtual_position(voice, now);
+
+    // Set up source; the voice's bank reference moves over with it
+    source->buffer = bank ? bank->buffer : 0;
+    source->bank_entry = voice->bank_entry;
+    source->sound_id = voice->sound_id;
+    source->active = 1;
+    source->playing = 1;
+    source->looping = voice->looping;
+    source->volume = voice->volume;
+    source->pitch = voice->pitch;
+    source->format = bank ? detect_audio_format(bank->filename) : AUDIO_FORMAT_UNKNOWN;
+    source->priority = voice->priority;
+    source->start_time = voice->start_time;
+    source->predicted_end = source->looping ? 0 :
+        now + (position < duration ? (uint64_t)((duration - position) / source->pitch) : 0);
+    if (bank) {
+        strncpy(source->filename, bank->filename, sizeof(source->filename) - 1);
+    }
 
-    audio_state.sfx_volume = fmaxf(0.0f, fminf(1.0f, volume));
-    l_info("SFX volume set to %.2f", audio_state.sfx_volume);
-}
+    // Apply volume (consider master volume and SFX volume)
+    float final_volume = source->volume * audio_state.master_volume * audio_state.sfx_volume;
+    alSourcef(source->source, AL_GAIN, final_volume);
+    alSourcef(source->source, AL_PITCH, source->pitch);
+    alSourcei(source->source, AL_LOOPING, source->looping ? AL_TRUE : AL_FALSE);
 
-float audio_get_master_volume(void) {
-    return audio_state.master_volume;
+    // Bind buffer to source, resuming where a virtual voice had got to
+    alSourcei(source->source, AL_BUFFER, source->buffer);
+    if (position > 0) {
+        alSourcef(source->source, AL_SEC_OFFSET, (float)position / 1000000.0f);
+    }
+
+    // Play sound
+    alSourcePlay(source->source);
+
+    audio_state.active_sources++;
+    steal_heap_push(index);
+    audio_state.voice_map[voice->sound_id & AUDIO_HANDLE_SLOT_MASK] =
+        (audio_voice_map_t){ AUDIO_VOICE_SOURCE, index };
+}
+
+static void do_play_music(const audio_command_t *cmd) {
+    // Find a free stream slot, recycling round-robin if all are busy
+    audio_stream_t *stream = NULL;
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        if (!audio_state.streams[i].active) {
+            stream = &audio_state.streams[i];
+            break;
+        }
+    }
+    if (!stream) {
+        stream = &audio_state.streams[audio_state.next_stream_index];
+        audio_state.next_stream_index = (audio_state.next_stream_index + 1) % MAX_AUDIO_STREAMS;
+        l_debug("Recycling music stream: %s", stream->filename);
+        push_completion(stream->sound_id);
+        close_stream(stream);
+    }
+
+    if (!open_ogg_stream(stream, cmd->filename)) {
+        l_error("Failed to open music stream: %s", cmd->filename);
+        push_completion(cmd->sound_id);
+        return;
+    }
+
+    stream->sound_id = cmd->sound_id;
+    stream->looping = cmd->looping;
+    stream->volume = cmd->volume;
+    stream->format = AUDIO_FORMAT_OGG_CUSTOM;
+    stream->eof = 0;
+    stream->playing = 0;
+    stream->bytes_read = 0;
+    strncpy(stream->filename, cmd->filename, sizeof(stream->filename) - 1);
+    stream->filename[sizeof(stream->filename) - 1] = '\0';
+
+    alSourcef(stream->source, AL_GAIN, stream->volume * audio_state.master_volume * audio_state.music_volume);
+
+    // The first chunks are decoded by update_audio_streams() after the command batch
+    stream->pending_start = 1;
+    stream->active = 1;
+    audio_state.voice_map[cmd->sound_id & AUDIO_HANDLE_SLOT_MASK] =
+        (audio_voice_map_t){ AUDIO_VOICE_STREAM, (int)(stream - audio_state.streams) };
+
+    l_debug("Streaming music: %s (ID: %d, %ld Hz)", cmd->filename, stream->sound_id, stream->sample_rate);
+}
+
+// O(1) handle -> voice lookups; a stale generation never matches
+static audio_stream_t *find_stream(int sound_id) {
+    audio_voice_map_t *voice = &audio_state.voice_map[sound_id & AUDIO_HANDLE_SLOT_MASK];
+    if (voice->kind != AUDIO_VOICE_STREAM) {
+        return NULL;
+    }
+
+    audio_stream_t *stream = &audio_state.streams[voice->index];
+    return (stream->active && stream->sound_id == sound_id) ? stream : NULL;
+}
+
+static audio_source_t *find_source(int sound_id) {
+    audio_voice_map_t *voice = &audio_state.voice_map[sound_id & AUDIO_HANDLE_SLOT_MASK];
+    if (voice->kind != AUDIO_VOICE_SOURCE) {
+        return NULL;
+    }
+
+    audio_source_t *source = &audio_state.sources[voice->index];
+    return (source->active && source->sound_id == sound_id) ? source : NULL;
+}
+
+static audio_virtual_t *find_virtual(int sound_id) {
+    audio_voice_map_t *voice = &audio_state.voice_map[sound_id & AUDIO_HANDLE_SLOT_MASK];
+    if (voice->kind != AUDIO_VOICE_VIRTUAL) {
+        return NULL;
+    }
+
+    audio_virtual_t *virt = &audio_state.virtuals[voice->index];
+    return (voice->index < audio_state.virtual_count && virt->sound_id == sound_id) ? virt : NULL;
+}
+
+static void unmap_voice(int sound_id, audio_voice_kind_t kind) {
+    if (sound_id <= 0) {
+        return;
+    }
+
+    audio_voice_map_t *voice = &audio_state.voice_map[sound_id & AUDIO_HANDLE_SLOT_MASK];
+    if (voice->kind == kind) {
+        voice->kind = AUDIO_VOICE_NONE;
+    }
+}
+
+static void do_stop_sound(int sound_id) {
+    audio_stream_t *stream = find_stream(sound_id);
+    if (stream) {
+        close_stream(stream);
+        l_debug("Stopped music stream ID: %d", sound_id);
+        return;
+    }
+
+    audio_source_t *source = find_source(sound_id);
+    if (source) {
+        release_source(source);
+        l_debug("Stopped sound ID: %d", sound_id);
+        return;
+    }
+
+    audio_virtual_t *virt = find_virtual(sound_id);
+    if (virt) {
+        virtual_drop((int)(virt - audio_state.virtuals), 0);
+        l_debug("Stopped virtual sound ID: %d", sound_id);
+    }
+}
+
+static void do_stop_all(void) {
+    for (int i = 0; i < audio_state.source_count; i++) {
+        if (audio_state.sources[i].active) {
+            release_source(&audio_state.sources[i]);
+        }
+    }
+
+    audio_state.active_sources = 0;
+
+    while (audio_state.virtual_count > 0) {
+        virtual_drop(audio_state.virtual_count - 1, 0);
+    }
+
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        if (audio_state.streams[i].active) {
+            close_stream(&audio_state.streams[i]);
+        }
+    }
+}
+
+static void do_set_sound_volume(int sound_id, float volume) {
+    audio_stream_t *stream = find_stream(sound_id);
+    if (stream) {
+        stream->volume = volume;
+        alSourcef(stream->source, AL_GAIN, volume * audio_state.master_volume * audio_state.music_volume);
+        return;
+    }
+
+    audio_source_t *source = find_source(sound_id);
+    if (source) {
+        source->volume = volume;
+        alSourcef(source->source, AL_GAIN, volume * audio_state.master_volume * audio_state.sfx_volume);
+        steal_heap_sift(source->heap_pos); // Loudness is part of the steal order
+        return;
+    }
+
+    audio_virtual_t *virt = find_virtual(sound_id);
+    if (virt) {
+        virt->volume = volume;
+    }
+}
+
+static void do_set_sound_pitch(int sound_id, float pitch) {
+    audio_stream_t *stream = find_stream(sound_id);
+    if (stream) {
+        alSourcef(stream->source, AL_PITCH, pitch);
+        return;
+    }
+
+    audio_source_t *source = find_source(sound_id);
+    if (source) {
+        // Rescale the remaining playback time to the new rate
+        uint64_t now = sceKernelGetSystemTimeWide();
+        if (source->predicted_end > now) {
+            uint64_t remaining = source->predicted_end - now;
+            source->predicted_end = now + (uint64_t)(remaining * (source->pitch / pitch));
+        }
+
+        source->pitch = pitch;
+        alSourcef(source->source, AL_PITCH, pitch);
+        return;
+    }
+
+    audio_virtual_t *virt = find_virtual(sound_id);
+    if (virt) {
+        uint64_t now = sceKernelGetSystemTimeWide();
+        virt->offset_us = virtual_position(virt, now);
+        virt->mark = now;
+        if (virt->predicted_end > now) {
+            virt->predicted_end = now + (uint64_t)((virt->predicted_end - now) * (virt->pitch / pitch));
+        }
+        virt->pitch = pitch;
+    }
+}
+
+// Re-apply gains after a master/music/sfx volume change on the game thread
+static void do_apply_volumes(void) {
+    alListenerf(AL_GAIN, audio_state.master_volume);
+
+    for (int i = 0; i < audio_state.source_count; i++) {
+        audio_source_t *source = &audio_state.sources[i];
+        if (source->active) {
+            alSourcef(source->source, AL_GAIN, source->volume * audio_state.master_volume * audio_state.sfx_volume);
+        }
+    }
+
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        audio_stream_t *stream = &audio_state.streams[i];
+        if (stream->active) {
+            alSourcef(stream->source, AL_GAIN, stream->volume * audio_state.master_volume * audio_state.music_volume);
+        }
+    }
+}
+
+// ===== AUDIO MANAGEMENT =====
+
+// Steal order: lowest priority first, then the quietest, then the oldest
+static int voice_loses_to(int priority, float volume, uint64_t start_time,
+                          int other_priority, float other_volume, uint64_t other_start_time) {
+    if (priority != other_priority) {
+        return priority < other_priority;
+    }
+    if (volume != other_volume) {
+        return volume < other_volume;
+    }
+    return start_time < other_start_time;
+}
+
+static int steal_heap_less(int a, int b) {
+    audio_source_t *sa = &audio_state.sources[a];
+    audio_source_t *sb = &audio_state.sources[b];
+    return voice_loses_to(sa->priority, sa->volume, sa->start_time, sb->priority, sb->volume, sb->start_time);
+}
+
+static void steal_heap_swap(int i, int j) {
+    int a = audio_state.steal_heap[i];
+    int b = audio_state.steal_heap[j];
+    audio_state.steal_heap[i] = b;
+    audio_state.steal_heap[j] = a;
+    audio_state.sources[b].heap_pos = i;
+    audio_state.sources[a].heap_pos = j;
+}
+
+static void steal_heap_sift(int pos) {
+    int *heap = audio_state.steal_heap;
+
+    while (pos > 0 && steal_heap_less(heap[pos], heap[(pos - 1) / 2])) {
+        steal_heap_swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+
+    for (;;) {
+        int left = pos * 2 + 1;
+        int right = left + 1;
+        int smallest = pos;
+        if (left < audio_state.steal_heap_size && steal_heap_less(heap[left], heap[smallest])) {
+            smallest = left;
+        }
+        if (right < audio_state.steal_heap_size && steal_heap_less(heap[right], heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        steal_heap_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void steal_heap_push(int index) {
+    int pos = audio_state.steal_heap_size++;
+    audio_state.steal_heap[pos] = index;
+    audio_state.sources[index].heap_pos = pos;
+    steal_heap_sift(pos);
+}
+
+static void steal_heap_remove(int index) {
+    int pos = audio_state.sources[index].heap_pos;
+    if (pos < 0) {
+        return;
+    }
+
+    int last = --audio_state.steal_heap_size;
+    if (pos != last) {
+        steal_heap_swap(pos, last);
+        audio_state.sources[index].heap_pos = -1;
+        steal_heap_sift(pos);
+    } else {
+        audio_state.sources[index].heap_pos = -1;
+    }
+}
+
+static int get_available_source(void) {
+    // First, try the free list
+    if (audio_state.source_free_head < 0) {
+        // Reclaim anything past its predicted end before stealing
+        cleanup_completed_sources();
+    }
+
+    if (audio_state.source_free_head >= 0) {
+        int index = audio_state.source_free_head;
+        audio_state.source_free_head = audio_state.sources[index].next_free;
+        audio_state.sources[index].next_free = -1;
+        return index;
+    }
+
+    // If still no free sources, steal the lowest priority one; its sound carries on virtually
+    if (audio_state.steal_heap_size > 0) {
+        int index = audio_state.steal_heap[0];
+        audio_source_t *victim = &audio_state.sources[index];
+
+        l_debug("Stole audio source %d (priority %d)", index, victim->priority);
+        demote_source(victim);
+
+        // release_source() just pushed it onto the free list
+        audio_state.source_free_head = victim->next_free;
+        victim->next_free = -1;
+        return index;
+    }
+
+    return -1;
+}
+
+// Stop a source and drop its reference on the bank buffer it was bound to
+static void release_source(audio_source_t *source) {
+    alSourceStop(source->source);
+    alSourcei(source->source, AL_BUFFER, 0);
+
+    if (source->bank_entry >= 0) {
+        audio_state.bank[source->bank_entry].refcount--;
+        source->bank_entry = -1;
+    }
+
+    if (source->active) {
+        int index = (int)(source - audio_state.sources);
+        audio_state.active_sources--;
+        steal_heap_remove(index);
+        unmap_voice(source->sound_id, AUDIO_VOICE_SOURCE);
+
+        source->next_free = audio_state.source_free_head;
+        audio_state.source_free_head = index;
+    }
+
+    source->buffer = 0;
+    source->active = 0;
+    source->playing = 0;
+    source->sound_id = 0;
+}
+
+// ===== VIRTUAL VOICES =====
+
+// Hand a source's sound over to a virtual voice and free the source
+static void demote_source(audio_source_t *source) {
+    uint64_t now = sceKernelGetSystemTimeWide();
+    ALfloat offset = 0.0f;
+    alGetSourcef(source->source, AL_SEC_OFFSET, &offset);
+
+    audio_virtual_t voice = {0};
+    voice.sound_id = source->sound_id;
+    voice.bank_entry = source->bank_entry;
+    voice.looping = source->looping;
+    voice.volume = source->volume;
+    voice.pitch = source->pitch;
+    voice.priority = source->priority;
+    voice.start_time = source->start_time;
+    voice.mark = now;
+    voice.offset_us = (uint64_t)(offset * 1000000.0f);
+    voice.predicted_end = source->predicted_end;
+
+    // The bank reference moves to the virtual voice rather than being dropped
+    source->bank_entry = -1;
+    release_source(source);
+    virtual_push(&voice);
+}
+
+// Track a voice; when full, the least important one (maybe this one) completes
+static void virtual_push(const audio_virtual_t *voice) {
+    if (audio_state.virtual_count >= MAX_VIRTUAL_VOICES) {
+        int weakest = 0;
+        for (int i = 1; i < audio_state.virtual_count; i++) {
+            audio_virtual_t *a = &audio_state.virtuals[i];
+            audio_virtual_t *b = &audio_state.virtuals[weakest];
+            if (voice_loses_to(a->priority, a->volume, a->start_time, b->priority, b->volume, b->start_time)) {
+                weakest = i;
+            }
+        }
+
+        audio_virtual_t *b = &audio_state.virtuals[weakest];
+        if (voice_loses_to(voice->priority, voice->volume, voice->start_time, b->priority, b->volume, b->start_time)) {
+            l_warn("Virtual voices full, dropping sound ID: %d", voice->sound_id);
+            push_completion(voice->sound_id);
+            if (voice->bank_entry >= 0) {
+                audio_state.bank[voice->bank_entry].refcount--;
+            }
+            return;
+        }
+        virtual_drop(weakest, 1);
+    }
+
+    int index = audio_state.virtual_count++;
+    audio_state.virtuals[index] = *voice;
+    audio_state.voice_map[voice->sound_id & AUDIO_HANDLE_SLOT_MASK] =
+        (audio_voice_map_t){ AUDIO_VOICE_VIRTUAL, index };
+}
+
+// Stop a virtual voice for good, reporting completion if asked
+static void virtual_drop(int index, int complete) {
+    audio_virtual_t *voice = &audio_state.virtuals[index];
+    if (complete) {
+        push_completion(voice->sound_id);
+    }
+    if (voice->bank_entry >= 0) {
+        audio_state.bank[voice->bank_entry].refcount--;
+    }
+    virtual_remove(index);
+}
+
+// Take a voice out of the packed array; its bank reference is the caller's
+static void virtual_remove(int index) {
+    unmap_voice(audio_state.virtuals[index].sound_id, AUDIO_VOICE_VIRTUAL);
+
+    int last = --audio_state.virtual_count;
+    if (index != last) {
+        audio_state.virtuals[index] = audio_state.virtuals[last];
+        audio_state.voice_map[audio_state.virtuals[index].sound_id & AUDIO_HANDLE_SLOT_MASK].index = index;
+    }
+}
+
+// Where in its buffer the voice would be now, wrapped for loops
+static uint64_t virtual_position(const audio_virtual_t *voice, uint64_t now) {
+    uint64_t position = voice->offset_us + (uint64_t)((now - voice->mark) * voice->pitch);
+    if (voice->looping && voice->bank_entry >= 0) {
+        uint64_t duration = audio_state.bank[voice->bank_entry].duration_us;
+        if (duration > 0) {
+            position %= duration;
+        }
+    }
+    return position;
+}
+
+// Give free sources to the most important virtual voices
+static void promote_virtual_voices(void) {
+    uint64_t now = sceKernelGetSystemTimeWide();
+
+    while (audio_state.virtual_count > 0 && audio_state.source_free_head >= 0) {
+        int best = 0;
+        for (int i = 1; i < audio_state.virtual_count; i++) {
+            audio_virtual_t *a = &audio_state.virtuals[best];
+            audio_virtual_t *b = &audio_state.virtuals[i];
+            if (voice_loses_to(a->priority, a->volume, a->start_time, b->priority, b->volume, b->start_time)) {
+                best = i;
+            }
+        }
+
+        audio_virtual_t voice = audio_state.virtuals[best];
+        virtual_remove(best);
+        bind_source(get_available_source(), &voice, now);
+        l_debug("Promoted virtual sound ID: %d", voice.sound_id);
+    }
+}
+
+// ===== SFX BANK =====
+
+static uint32_t bank_hash(const char *filename) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*filename) {
+        hash ^= (uint8_t)*filename++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int bank_find(const char *filename, uint32_t hash) {
+    for (int probe = 0; probe < SOUND_BANK_HASH_SIZE; probe++) {
+        int slot = (hash + probe) & (SOUND_BANK_HASH_SIZE - 1);
+        int entry = audio_state.bank_index[slot];
+        if (entry < 0) {
+            return -1;
+        }
+        if (audio_state.bank[entry].hash == hash && strcmp(audio_state.bank[entry].filename, filename) == 0) {
+            return entry;
+        }
+    }
+    return -1;
+}
+
+static void bank_index_insert(int entry) {
+    uint32_t hash = audio_state.bank[entry].hash;
+    for (int probe = 0; probe < SOUND_BANK_HASH_SIZE; probe++) {
+        int slot = (hash + probe) & (SOUND_BANK_HASH_SIZE - 1);
+        if (audio_state.bank_index[slot] < 0) {
+            audio_state.bank_index[slot] = entry;
+            return;
+        }
+    }
+}
+
+static void bank_index_rebuild(void) {
+    memset(audio_state.bank_index, 0xFF, sizeof(audio_state.bank_index));
+    for (int i = 0; i < MAX_AUDIO_BUFFERS; i++) {
+        if (audio_state.bank[i].loaded) {
+            bank_index_insert(i);
+        }
+    }
+}
+
+static void bank_evict(int entry) {
+    sound_bank_entry_t *bank = &audio_state.bank[entry];
+
+    l_debug("Evicting SFX from bank: %s (%zu KB)", bank->filename, bank->bytes / 1024);
+
+    // The buffer object is reused, so only an empty upload gives its PCM back
+    alBufferData(bank->buffer, AL_FORMAT_MONO16, NULL, 0, AUDIO_SAMPLE_RATE);
+
+    audio_state.bank_bytes -= bank->bytes;
+    audio_state.bank_count--;
+    bank->loaded = 0;
+    bank->bytes = 0;
+    bank->filename[0] = '\0';
+
+    // Eviction is rare next to lookups, so rebuilding the small index beats tombstones
+    bank_index_rebuild();
+}
+
+// Least recently used entry that no source is bound to, or -1
+static int bank_find_lru(int exclude) {
+    int lru = -1;
+    for (int i = 0; i < MAX_AUDIO_BUFFERS; i++) {
+        sound_bank_entry_t *bank = &audio_state.bank[i];
+        if (!bank->loaded || bank->refcount > 0 || i == exclude) {
+            continue;
+        }
+        if (lru < 0 || bank->last_used < audio_state.bank[lru].last_used) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+// Give back what the memory governor asked for, least recently used first
+static void bank_trim(void) {
+    size_t wanted = __atomic_exchange_n(&audio_state.trim_bytes, 0, __ATOMIC_ACQ_REL);
+    size_t freed = 0;
+
+    while (freed < wanted) {
+        int entry = bank_find_lru(-1);
+        if (entry < 0) {
+            break;
+        }
+        sound_bank_entry_t *bank = &audio_state.bank[entry];
+        freed += bank->bytes;
+        bank_evict(entry);
+    }
+
+    if (freed > 0) {
+        l_info("SFX bank trimmed by %zu KB for the memory governor", freed / 1024);
+    }
+}
+
+#if MEM_GOVERNOR
+// Any thread: the bank belongs to the audio thread, which trims on its next pass
+static size_t purge_sfx_bank(mem_kind_t kind, mem_pressure_t pressure __attribute__((unused)), size_t wanted) {
+    if (kind != MEM_KIND_HEAP || !audio_state.audio_thread_running) {
+        return 0;
+    }
+
+    __atomic_store_n(&audio_state.trim_bytes, wanted, __ATOMIC_RELEASE);
+    wake_audio_thread();
+    return 0;
+}
+#endif
+
+// Returns the bank entry holding the decoded file, loading it if needed
+static int bank_load(const char *filename) {
+    uint32_t hash = bank_hash(filename);
+
+    int entry = bank_find(filename, hash);
+    if (entry >= 0) {
+        audio_state.bank_hits++;
+        return entry;
+    }
+    audio_state.bank_misses++;
+
+    audio_format_t format = detect_audio_format(filename);
+    if (format == AUDIO_FORMAT_UNKNOWN) {
+        l_error("Unsupported audio format: %s", filename);
+        return -1;
+    }
+
+    // Grab an unused buffer, or recycle the LRU one nothing is playing from
+    entry = -1;
+    for (int i = 0; i < MAX_AUDIO_BUFFERS; i++) {
+        if (!audio_state.bank[i].loaded) {
+            entry = i;
+            break;
+        }
+    }
+    if (entry < 0) {
+        entry = bank_find_lru(-1);
+        if (entry < 0) {
+            l_warn("SFX bank full, every buffer is in use: %s", filename);
+            return -1;
+        }
+        bank_evict(entry);
+    }
+
+    sound_bank_entry_t *bank = &audio_state.bank[entry];
+    size_t bytes = 0;
+    int load_result = 0;
+    switch (format) {
+        case AUDIO_FORMAT_WAV_CUSTOM:
+            load_result = load_wav_file(filename, bank->buffer, &bytes);
+            break;
+        case AUDIO_FORMAT_OGG_CUSTOM:
+            load_result = load_ogg_file(filename, bank->buffer, &bytes);
+            break;
+        default:
+            l_error("Format not implemented: %d", format);
+            return -1;
+    }
+
+    if (!load_result) {
+        return -1;
+    }
+
+    // Play length, used by the audio thread to schedule its next wakeup
+    ALint frequency = 0, channels = 0, bits = 0;
+    alGetBufferi(bank->buffer, AL_FREQUENCY, &frequency);
+    alGetBufferi(bank->buffer, AL_CHANNELS, &channels);
+    alGetBufferi(bank->buffer, AL_BITS, &bits);
+    uint64_t bytes_per_second = (uint64_t)frequency * channels * (bits / 8);
+
+    strncpy(bank->filename, filename, sizeof(bank->filename) - 1);
+    bank->filename[sizeof(bank->filename) - 1] = '\0';
+    bank->hash = hash;
+    bank->bytes = bytes;
+    bank->duration_us = bytes_per_second ? (bytes * 1000000ULL) / bytes_per_second : 0;
+    bank->refcount = 0;
+    bank->last_used = sceKernelGetSystemTimeWide();
+    bank->loaded = 1;
+    bank_index_insert(entry);
+
+    audio_state.bank_bytes += bytes;
+    audio_state.bank_count++;
+
+    // Trim back under budget, never touching buffers bound to a source
+    while (audio_state.bank_bytes > SOUND_BANK_BUDGET) {
+        int lru = bank_find_lru(entry);
+        if (lru < 0) {
+            l_warn("SFX bank over budget (%zu KB), nothing evictable", audio_state.bank_bytes / 1024);
+            break;
+        }
+        bank_evict(lru);
+    }
+
+    return entry;
+}
+
+int audio_preload_bank(const char **filenames, int count) {
+    if (!audio_state.initialized || !filenames) {
+        return 0;
+    }
+
+    // Decoding happens on the audio thread like every other OpenAL call
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+        if (!filenames[i]) {
+            continue;
+        }
+
+        audio_command_t cmd = {0};
+        cmd.type = AUDIO_CMD_PRELOAD;
+        strncpy(cmd.filename, filenames[i], sizeof(cmd.filename) - 1);
+        if (push_command(&cmd)) {
+            queued++;
+        }
+    }
+
+    l_info("Queued %d/%d SFX for preload", queued, count);
+
+    return queued;
+}
+
+static void cleanup_completed_sources(void) {
+    uint64_t now = sceKernelGetSystemTimeWide();
+
+    for (int i = 0; i < audio_state.source_count; i++) {
+        // Only ask OpenAL about sources that should have finished by now
+        if (audio_state.sources[i].active && !audio_state.sources[i].looping &&
+            audio_state.sources[i].predicted_end <= now) {
+            ALint state;
+            alGetSourcei(audio_state.sources[i].source, AL_SOURCE_STATE, &state);
+
+            if (state == AL_STOPPED) {
+                // Report completion and give the buffer reference back to the bank
+                push_completion(audio_state.sources[i].sound_id);
+                release_source(&audio_state.sources[i]);
+            }
+        }
+    }
+
+    // Virtual one-shots finish on the clock alone; backwards, as dropping packs the array
+    for (int i = audio_state.virtual_count - 1; i >= 0; i--) {
+        audio_virtual_t *voice = &audio_state.virtuals[i];
+        if (!voice->looping && voice->predicted_end <= now) {
+            virtual_drop(i, 1);
+        }
+    }
+}
+
+// ===== AUDIO FILE LOADING =====
+
+static audio_format_t detect_audio_format(const char *filename) {
+    if (!filename) return AUDIO_FORMAT_UNKNOWN;
+
+    const char *ext = strrchr(filename, '.');
+    if (!ext) return AUDIO_FORMAT_UNKNOWN;
+
+    if (strcasecmp(ext, ".wav") == 0) return AUDIO_FORMAT_WAV_CUSTOM;
+    if (strcasecmp(ext, ".ogg") == 0) return AUDIO_FORMAT_OGG_CUSTOM;
+    if (strcasecmp(ext, ".mp3") == 0) return AUDIO_FORMAT_MP3_CUSTOM;
+
+    return AUDIO_FORMAT_UNKNOWN;
+}
+
+// ===== WAV DECODING =====
+
+// Parsed `fmt ` + `data` chunks of a RIFF/WAVE file
+typedef struct {
+    uint16_t format_tag;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    uint16_t samples_per_block; // IMA ADPCM only
+    const uint8_t *data;
+    uint32_t data_size;
+} wav_info_t;
+
+static uint16_t read_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static int parse_wav(const uint8_t *file, size_t size, wav_info_t *info) {
+    memset(info, 0, sizeof(*info));
+
+    if (size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0) {
+        return 0;
+    }
+
+    int have_fmt = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t *chunk = file + pos;
+        uint32_t chunk_size = read_le32(chunk + 4);
+        const uint8_t *body = chunk + 8;
+        size_t available = size - (pos + 8);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && chunk_size <= available) {
+            info->format_tag = read_le16(body);
+            info->channels = read_le16(body + 2);
+            info->sample_rate = read_le32(body + 4);
+            info->block_align = read_le16(body + 12);
+            info->bits_per_sample = read_le16(body + 14);
+
+            uint16_t extra = (chunk_size >= 18) ? read_le16(body + 16) : 0;
+            if (info->format_tag == WAV_FORMAT_IMA_ADPCM && extra >= 2) {
+                info->samples_per_block = read_le16(body + 18);
+            } else if (info->format_tag == WAV_FORMAT_EXTENSIBLE && extra >= 22 && chunk_size >= 40) {
+                // The real format code leads the SubFormat GUID
+                info->format_tag = read_le16(body + 24);
+            }
+            have_fmt = 1;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            // Some encoders write a bogus size for the final chunk; clamp to the file
+            info->data = body;
+            info->data_size = (chunk_size <= available) ? chunk_size : (uint32_t)available;
+            if (have_fmt) {
+                break;
+            }
+        }
+
+        // A size past the end is corrupt (or the clamped data above); nothing
+        // after it can be found, and stepping over it could wrap pos
+        if (chunk_size > available) {
+            break;
+        }
+
+        // Chunks are word aligned
+        pos += 8 + (size_t)chunk_size + (chunk_size & 1);
+    }
+
+    return have_fmt && info->data && info->channels >= 1 && info->channels <= 2 && info->sample_rate > 0;
+}
+
+static void convert_u8_to_s16(const uint8_t *src, int16_t *dst, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    const uint8x16_t bias = vdupq_n_u8(0x80);
+    for (; i + 16 <= count; i += 16) {
+        int8x16_t s = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), bias));
+        vst1q_s16(dst + i, vshll_n_s8(vget_low_s8(s), 8));
+        vst1q_s16(dst + i + 8, vshll_n_s8(vget_high_s8(s), 8));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = (int16_t)((src[i] - 128) << 8);
+    }
+}
+
+static void convert_f32_to_s16(const uint8_t *src, int16_t *dst, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    // vcvtq saturates out-of-range values, vqmovn narrows with saturation
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vmulq_n_f32(vld1q_f32((const float *)(const void *)(src + i * 4)), 32767.0f);
+        float32x4_t b = vmulq_n_f32(vld1q_f32((const float *)(const void *)(src + i * 4 + 16)), 32767.0f);
+        int16x4_t lo = vqmovn_s32(vcvtq_s32_f32(a));
+        int16x4_t hi = vqmovn_s32(vcvtq_s32_f32(b));
+        vst1q_s16(dst + i, vcombine_s16(lo, hi));
+    }
+#endif
+    for (; i < count; i++) {
+        float f;
+        memcpy(&f, src + i * 4, sizeof(f));
+        f *= 32767.0f;
+        dst[i] = (int16_t)(f > 32767.0f ? 32767 : (f < -32768.0f ? -32768 : f));
+    }
+}
+
+// Keep the top 16 bits of 24/32-bit integer PCM
+static void convert_wide_to_s16(const uint8_t *src, int16_t *dst, size_t count, int bytes_per_sample) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *s = src + i * bytes_per_sample + (bytes_per_sample - 2);
+        dst[i] = (int16_t)read_le16(s);
+    }
+}
+
+static const int16_t ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static int16_t ima_decode_nibble(int nibble, int *predictor, int *index) {
+    int step = ima_step_table[*index];
+    int diff = step >> 3;
+    if (nibble & 1) diff += step >> 2;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 4) diff += step;
+    if (nibble & 8) diff = -diff;
+
+    *predictor += diff;
+    if (*predictor > 32767) *predictor = 32767;
+    if (*predictor < -32768) *predictor = -32768;
+
+    *index += ima_index_table[nibble];
+    if (*index < 0) *index = 0;
+    if (*index > 88) *index = 88;
+
+    return (int16_t)*predictor;
+}
+
+// Microsoft IMA ADPCM: per-channel 4-byte block header, then 4-byte groups
+// of 8 nibbles interleaved by channel. Returns frames decoded per channel.
+static size_t decode_ima_adpcm(const wav_info_t *info, int16_t *dst) {
+    int channels = info->channels;
+    size_t block_align = info->block_align;
+    size_t frames_per_block = info->samples_per_block;
+    size_t frames = 0;
+
+    for (size_t offset = 0; offset + block_align <= info->data_size; offset += block_align) {
+        const uint8_t *block = info->data + offset;
+        int predictor[2], index[2];
+        int16_t *out = dst + frames * channels;
+
+        for (int c = 0; c < channels; c++) {
+            predictor[c] = (int16_t)read_le16(block + c * 4);
+            index[c] = block[c * 4 + 2] > 88 ? 88 : block[c * 4 + 2];
+            out[c] = (int16_t)predictor[c];
+        }
+
+        const uint8_t *nibbles = block + channels * 4;
+        size_t decoded = 1;
+        while (decoded + 8 <= frames_per_block) {
+            for (int c = 0; c < channels; c++) {
+                for (int b = 0; b < 4; b++) {
+                    uint8_t byte = nibbles[c * 4 + b];
+                    out[(decoded + b * 2) * channels + c] = ima_decode_nibble(byte & 0x0F, &predictor[c], &index[c]);
+                    out[(decoded + b * 2 + 1) * channels + c] = ima_decode_nibble(byte >> 4, &predictor[c], &index[c]);
+                }
+            }
+            nibbles += channels * 4;
+            decoded += 8;
+        }
+
+        frames += decoded;
+    }
+
+    return frames;
+}
+
+// Convert the data chunk into 16-bit PCM. Returns a malloc'd buffer (or a
+// pointer into the file for native 16-bit data, with *owned = 0).
+static const int16_t *wav_to_s16(const wav_info_t *info, size_t *out_bytes, int *owned) {
+    *owned = 0;
+
+    if (info->format_tag == WAV_FORMAT_PCM && info->bits_per_sample == 16) {
+        *out_bytes = info->data_size & ~(size_t)1;
+        return (const int16_t *)(const void *)info->data;
+    }
+
+    size_t samples = 0;
+    if (info->format_tag == WAV_FORMAT_IMA_ADPCM) {
+        if (info->bits_per_sample != 4 || info->block_align < info->channels * 4u ||
+            info->samples_per_block == 0) {
+            return NULL;
+        }
+        samples = (size_t)(info->data_size / info->block_align) * info->samples_per_block * info->channels;
+    } else if (info->bits_per_sample >= 8) {
+        samples = info->data_size / (info->bits_per_sample / 8);
+    }
+    if (samples == 0) {
+        return NULL;
+    }
+
+    int16_t *pcm = malloc(samples * sizeof(int16_t));
+    if (!pcm) {
+        return NULL;
+    }
+
+    switch (info->format_tag) {
+        case WAV_FORMAT_PCM:
+            if (info->bits_per_sample == 8) {
+                convert_u8_to_s16(info->data, pcm, samples);
+            } else if (info->bits_per_sample == 24 || info->bits_per_sample == 32) {
+                convert_wide_to_s16(info->data, pcm, samples, info->bits_per_sample / 8);
+            } else {
+                free(pcm);
+                return NULL;
+            }
+            break;
+        case WAV_FORMAT_IEEE_FLOAT:
+            if (info->bits_per_sample != 32) {
+                free(pcm);
+                return NULL;
+            }
+            convert_f32_to_s16(info->data, pcm, samples);
+            break;
+        case WAV_FORMAT_IMA_ADPCM:
+            samples = decode_ima_adpcm(info, pcm) * info->channels;
+            break;
+        default:
+            free(pcm);
+            return NULL;
+    }
+
+    *owned = 1;
+    *out_bytes = samples * sizeof(int16_t);
+    return pcm;
+}
+
+static int load_wav_file(const char *filename, ALuint buffer, size_t *out_bytes) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        l_error("Failed to open WAV file: %s", filename);
+        return 0;
+    }
+
+    // Get file size
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (file_size <= 0) {
+        fclose(file);
+        l_error("Empty WAV file: %s", filename);
+        return 0;
+    }
+
+    // Allocate buffer
+    uint8_t *data = malloc(file_size);
+    if (!data) {
+        fclose(file);
+        l_error("Failed to allocate memory for WAV file");
+        return 0;
+    }
+
+    // Read data
+    size_t bytes_read = fread(data, 1, file_size, file);
+    fclose(file);
+
+    if (bytes_read != (size_t)file_size) {
+        free(data);
+        l_error("Failed to read WAV file completely");
+        return 0;
+    }
+
+    wav_info_t info;
+    if (!parse_wav(data, file_size, &info)) {
+        free(data);
+        l_error("Invalid or unsupported WAV file: %s", filename);
+        return 0;
+    }
+
+    size_t pcm_bytes = 0;
+    int owned = 0;
+    const int16_t *pcm = wav_to_s16(&info, &pcm_bytes, &owned);
+    if (!pcm || pcm_bytes == 0) {
+        free(data);
+        l_error("Unsupported WAV encoding 0x%04x/%d-bit: %s", info.format_tag, info.bits_per_sample, filename);
+        return 0;
+    }
+
+    // Mono stays mono: half the memory and half the mixing cost
+    ALenum format = (info.channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    alBufferData(buffer, format, pcm, (ALsizei)pcm_bytes, (ALsizei)info.sample_rate);
+
+    if (owned) {
+        free((void *)pcm);
+    }
+    free(data);
+
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR) {
+        l_error("OpenAL error loading WAV: 0x%x", error);
+        return 0;
+    }
+
+    l_debug("Loaded WAV file: %s (%u Hz, %d ch, fmt 0x%04x/%d-bit, %zu bytes PCM)", filename,
+            info.sample_rate, info.channels, info.format_tag, info.bits_per_sample, pcm_bytes);
+    *out_bytes = pcm_bytes;
+    return 1;
+}
+
+static int load_ogg_file(const char *filename, ALuint buffer, size_t *out_bytes) {
+    // Short Vorbis SFX are decoded in full; music goes through the streaming path
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        l_error("Failed to open OGG file: %s", filename);
+        return 0;
+    }
+
+    OggVorbis_File vorbis;
+    if (ov_open_callbacks(file, &vorbis, NULL, 0, OV_CALLBACKS_DEFAULT) < 0) {
+        fclose(file);
+        l_error("Not a valid Vorbis file: %s", filename);
+        return 0;
+    }
+
+    vorbis_info *info = ov_info(&vorbis, -1);
+    ALenum format = (info->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    long rate = info->rate;
+
+    ogg_int64_t total_samples = ov_pcm_total(&vorbis, -1);
+    size_t data_size = (size_t)total_samples * info->channels * sizeof(int16_t);
+    if (total_samples <= 0 || data_size == 0) {
+        ov_clear(&vorbis);
+        l_error("Empty or unseekable OGG file: %s", filename);
+        return 0;
+    }
+
+    char *data = malloc(data_size);
+    if (!data) {
+        ov_clear(&vorbis);
+        l_error("Failed to allocate memory for OGG file");
+        return 0;
+    }
+
+    size_t decoded = 0;
+    int bitstream = 0;
+    while (decoded < data_size) {
+        long ret = ov_read(&vorbis, data + decoded, (int)(data_size - decoded), 0, 2, 1, &bitstream);
+        if (ret <= 0) {
+            break;
+        }
+        decoded += ret;
+    }
+    ov_clear(&vorbis);
+
+    if (decoded == 0) {
+        free(data);
+        l_error("Failed to decode OGG file: %s", filename);
+        return 0;
+    }
+
+    alBufferData(buffer, format, data, (ALsizei)decoded, (ALsizei)rate);
+    free(data);
+
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR) {
+        l_error("OpenAL error loading OGG: 0x%x", error);
+        return 0;
+    }
+
+    l_debug("Loaded OGG file: %s (%zu bytes PCM)", filename, decoded);
+    *out_bytes = decoded;
+    return 1;
+}
+
+// ===== MUSIC STREAMING =====
+
+static int open_ogg_stream(audio_stream_t *stream, const char *filename) {
+    stream->file = fopen(filename, "rb");
+    if (!stream->file) {
+        l_error("Failed to open OGG stream: %s", filename);
+        return 0;
+    }
+
+    fseek(stream->file, 0, SEEK_END);
+    stream->file_size = ftell(stream->file);
+    fseek(stream->file, 0, SEEK_SET);
+
+    // vorbisfile takes ownership of the FILE and closes it in ov_clear()
+    if (ov_open_callbacks(stream->file, &stream->vorbis, NULL, 0, OV_CALLBACKS_DEFAULT) < 0) {
+        fclose(stream->file);
+        stream->file = NULL;
+        l_error("Not a valid Vorbis stream: %s", filename);
+        return 0;
+    }
+
+    if (!stream->pcm) {
+        stream->pcm = malloc(STREAM_CHUNK_SIZE);
+        if (!stream->pcm) {
+            ov_clear(&stream->vorbis);
+            stream->file = NULL;
+            l_error("Failed to allocate stream decode buffer");
+            return 0;
+        }
+    }
+
+    vorbis_info *info = ov_info(&stream->vorbis, -1);
+    stream->al_format = (info->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    stream->sample_rate = info->rate;
+
+    return 1;
+}
+
+// Decode up to STREAM_CHUNK_SIZE bytes into the stream scratch buffer,
+// rewinding the decoder on EOF for looping tracks. Returns bytes decoded.
+static size_t fill_stream_chunk(audio_stream_t *stream) {
+    size_t filled = 0;
+    int bitstream = 0;
+    int rewound = 0;
+
+    while (filled < STREAM_CHUNK_SIZE) {
+        long ret = ov_read(&stream->vorbis, stream->pcm + filled,
+                           (int)(STREAM_CHUNK_SIZE - filled), 0, 2, 1, &bitstream);
+        if (ret > 0) {
+            filled += ret;
+            rewound = 0;
+        } else if (ret == 0) {
+            // Guard against empty files spinning forever on rewind
+            if (stream->looping && !rewound && ov_pcm_seek(&stream->vorbis, 0) == 0) {
+                rewound = 1;
+                continue;
+            }
+            stream->eof = 1;
+            break;
+        } else if (ret != OV_HOLE) {
+            l_error("Vorbis decode error %ld in stream: %s", ret, stream->filename);
+            stream->eof = 1;
+            break;
+        }
+    }
+
+    stream->bytes_read += filled;
+    return filled;
+}
+
+static void start_stream(audio_stream_t *stream) {
+    alSourceStop(stream->source);
+    alSourcei(stream->source, AL_BUFFER, 0);
+
+    int queued = 0;
+    for (int i = 0; i < STREAM_BUFFER_COUNT && !stream->eof; i++) {
+        size_t bytes = fill_stream_chunk(stream);
+        if (bytes == 0) {
+            break;
+        }
+        alBufferData(stream->buffers[i], stream->al_format, stream->pcm, (ALsizei)bytes, (ALsizei)stream->sample_rate);
+        alSourceQueueBuffers(stream->source, 1, &stream->buffers[i]);
+        queued++;
+    }
+
+    stream->pending_start = 0;
+
+    if (queued == 0) {
+        l_error("Music stream produced no audio: %s", stream->filename);
+        close_stream(stream);
+        return;
+    }
+
+    alSourcePlay(stream->source);
+    stream->playing = 1;
+}
+
+static void close_stream(audio_stream_t *stream) {
+    alSourceStop(stream->source);
+    alSourcei(stream->source, AL_BUFFER, 0); // Detaches every queued buffer
+
+    if (stream->file) {
+        ov_clear(&stream->vorbis);
+        stream->file = NULL;
+    }
+
+    free(stream->pcm);
+    stream->pcm = NULL;
+
+    unmap_voice(stream->sound_id, AUDIO_VOICE_STREAM);
+    stream->active = 0;
+    stream->pending_start = 0;
+    stream->playing = 0;
+    stream->sound_id = 0;
+    stream->eof = 0;
+}
+
+// ===== VOLUME CONTROL =====
+
+void audio_set_master_volume(float volume) {
+    if (!audio_state.initialized) return;
+
+    audio_state.master_volume = fmaxf(0.0f, fminf(1.0f, volume));
+
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_APPLY_VOLUMES;
+    push_command(&cmd);
+
+    l_info("Master volume set to %.2f", audio_state.master_volume);
+}
+
+void audio_set_music_volume(float volume) {
+    if (!audio_state.initialized) return;
+
+    audio_state.music_volume = fmaxf(0.0f, fminf(1.0f, volume));
+
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_APPLY_VOLUMES;
+    push_command(&cmd);
+
+    l_info("Music volume set to %.2f", audio_state.music_volume);
+}
+
+void audio_set_sfx_volume(float volume) {
+    if (!audio_state.initialized) return;
+
+    audio_state.sfx_volume = fmaxf(0.0f, fminf(1.0f, volume));
+
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_APPLY_VOLUMES;
+    push_command(&cmd);
+    l_info("SFX volume set to %.2f", audio_state.sfx_volume);
+}
+
+float audio_get_master_volume(void) {
+    return audio_state.master_volume;
 }
 
 float audio_get_music_volume(void) {
@@ -591,27 +2202,164 @@ static int audio_thread_func(SceSize args __attribute__((unused)), void *argp __
 
     while (audio_state.audio_thread_running) {
         if (audio_state.initialized) {
-            // Clean up completed sources
+            PROF_SCOPE("audio_pass");
+
+            // Apply everything the game thread queued since the last pass
+            process_audio_commands();
+            bank_trim();
+
+            // Clean up completed sources, then hand them to waiting virtual voices
             cleanup_completed_sources();
+            promote_virtual_voices();
 
             // Update audio streams
             update_audio_streams();
         }
 
-        // Sleep for 16ms (60 FPS)
-        sceKernelDelayThread(16666);
+        // Sleep until a command arrives or the next sound is due to end
+        SceUInt timeout = compute_wake_timeout();
+        if (audio_state.wake_flag >= 0) {
+            sceKernelWaitEventFlag(audio_state.wake_flag, AUDIO_EVF_WAKE,
+                                   SCE_EVENT_WAITOR | SCE_EVENT_WAITCLEAR, NULL, &timeout);
+        } else {
+            sceKernelDelayThread(timeout < AUDIO_IDLE_POLL_MIN_US ? timeout : AUDIO_IDLE_POLL_MIN_US);
+        }
+        audio_state.wakeups++;
     }
 
     l_info("Audio thread stopped");
     return 0;
 }
 
+static void start_audio_thread(void) {
+    audio_state.audio_thread_running = 1;
+    const pthr_thread_policy_t *policy = pthr_thread_policy("audio_thread");
+    audio_state.audio_thread = sceKernelCreateThread("audio_thread", audio_thread_func,
+                                                     policy->priority ? policy->priority : 0x10000100,
+                                                     policy->stack_size ? policy->stack_size : 0x10000,
+                                                     0, policy->affinity, NULL);
+    if (audio_state.audio_thread >= 0) {
+        sceKernelStartThread(audio_state.audio_thread, 0, NULL);
+    } else {
+        audio_state.audio_thread_running = 0;
+    }
+}
+
+static void stop_audio_thread(void) {
+    audio_state.audio_thread_running = 0;
+    wake_audio_thread();
+    if (audio_state.audio_thread >= 0) {
+        sceKernelWaitThreadEnd(audio_state.audio_thread, NULL, NULL);
+        sceKernelDeleteThread(audio_state.audio_thread);
+        audio_state.audio_thread = -1;
+    }
+}
+
+// Time until the audio thread next has work, absent new commands
+static SceUInt compute_wake_timeout(void) {
+    uint64_t now = sceKernelGetSystemTimeWide();
+    uint64_t timeout = UINT64_MAX;
+
+    // Earliest predicted end of a one-shot source
+    for (int i = 0; i < audio_state.source_count; i++) {
+        audio_source_t *source = &audio_state.sources[i];
+        if (!source->active || source->looping) {
+            continue;
+        }
+
+        uint64_t until = (source->predicted_end > now) ? source->predicted_end - now : AUDIO_WAKE_RETRY_US;
+        if (until < timeout) {
+            timeout = until;
+        }
+    }
+
+    // Virtual one-shots complete on their own schedule too
+    for (int i = 0; i < audio_state.virtual_count; i++) {
+        audio_virtual_t *voice = &audio_state.virtuals[i];
+        if (voice->looping) {
+            continue;
+        }
+
+        uint64_t until = (voice->predicted_end > now) ? voice->predicted_end - now : 0;
+        if (until < timeout) {
+            timeout = until;
+        }
+    }
+
+    // Streams must refill before their queued chunks run dry: wake at half a chunk
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        audio_stream_t *stream = &audio_state.streams[i];
+        if (!stream->active) {
+            continue;
+        }
+
+        uint64_t until = AUDIO_WAKE_MIN_US;
+        if (!stream->pending_start && stream->sample_rate > 0) {
+            int channels = (stream->al_format == AL_FORMAT_MONO16) ? 1 : 2;
+            until = (STREAM_CHUNK_SIZE * 1000000ULL) / ((uint64_t)stream->sample_rate * channels * 2) / 2;
+        }
+        if (until < timeout) {
+            timeout = until;
+        }
+    }
+
+    if (timeout == UINT64_MAX) {
+        // Nothing scheduled (silence or only loops): back off, commands still wake us instantly
+        timeout = audio_state.idle_poll_us;
+        audio_state.idle_poll_us *= 2;
+        if (audio_state.idle_poll_us > AUDIO_IDLE_POLL_MAX_US) {
+            audio_state.idle_poll_us = AUDIO_IDLE_POLL_MAX_US;
+        }
+    } else {
+        audio_state.idle_poll_us = AUDIO_IDLE_POLL_MIN_US;
+    }
+
+    return (SceUInt)(timeout > AUDIO_WAKE_MIN_US ? timeout : AUDIO_WAKE_MIN_US);
+}
+
 static void update_audio_streams(void) {
-    // Update streaming audio sources
-    for (int i = 0; i < 4; i++) {
-        if (audio_state.streams[i].active) {
-            // TODO: Implement streaming audio update
-            // This would handle buffering of large audio files
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        audio_stream_t *stream = &audio_state.streams[i];
+        if (!stream->active) {
+            continue;
+        }
+
+        if (stream->pending_start) {
+            start_stream(stream);
+            continue;
+        }
+
+        // Refill every buffer OpenAL has finished with and put it back in the queue
+        ALint processed = 0;
+        alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &processed);
+        while (processed-- > 0) {
+            ALuint buffer;
+            alSourceUnqueueBuffers(stream->source, 1, &buffer);
+
+            if (stream->eof) {
+                continue;
+            }
+
+            size_t bytes = fill_stream_chunk(stream);
+            if (bytes > 0) {
+                alBufferData(buffer, stream->al_format, stream->pcm, (ALsizei)bytes, (ALsizei)stream->sample_rate);
+                alSourceQueueBuffers(stream->source, 1, &buffer);
+            }
+        }
+
+        ALint queued = 0, state = 0;
+        alGetSourcei(stream->source, AL_BUFFERS_QUEUED, &queued);
+        alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
+
+        if (queued == 0) {
+            // Drained after EOF: the track is over
+            l_debug("Music stream finished: %s (ID: %d)", stream->filename, stream->sound_id);
+            push_completion(stream->sound_id);
+            close_stream(stream);
+        } else if (state != AL_PLAYING && state != AL_PAUSED) {
+            // Underrun (the thread was starved): resume with what is queued
+            l_debug("Music stream underrun, restarting: %s", stream->filename);
+            alSourcePlay(stream->source);
         }
     }
 }
@@ -630,21 +2378,19 @@ int audio_is_playing(int sound_id) {
         return 0;
     }
 
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].active && audio_state.sources[i].sound_id == sound_id) {
-            ALint state;
-            alGetSourcei(audio_state.sources[i].source, AL_SOURCE_STATE, &state);
-            return (state == AL_PLAYING);
-        }
-    }
-
-    return 0;
+    // Answered from the game thread's own view, no OpenAL query involved
+    drain_completions();
+    return handle_is_live(sound_id);
 }
 
 int audio_get_active_sources(void) {
     return audio_state.active_sources;
 }
 
+int audio_get_thread_id(void) {
+    return audio_state.audio_thread_running ? audio_state.audio_thread : -1;
+}
+
 // ===== CONFIGURATION =====
 
 void audio_enable(int enabled) {
@@ -677,6 +2423,94 @@ int audio_is_sfx_enabled(void) {
     return audio_state.sfx_enabled;
 }
 
+// ===== SUSPEND / RESUME =====
+
+void audio_suspend(void) {
+    if (!audio_state.initialized || audio_state.suspended) {
+        return;
+    }
+
+    // The audio thread is gone after this, so OpenAL is ours as in audio_cleanup()
+    stop_audio_thread();
+
+    // A bank trim the memory governor asked for was left to the thread
+    bank_trim();
+
+    pause_output(1);
+    audio_state.suspended = 1;
+    audio_state.suspend_time = sceKernelGetSystemTimeWide();
+    l_info("Audio suspended (%zu KB SFX bank resident)", audio_state.bank_bytes / 1024);
+}
+
+void audio_resume(void) {
+    if (!audio_state.suspended) {
+        return;
+    }
+
+    // Paused voices resume where they were, so their clocks skip the time away
+    uint64_t away = sceKernelGetSystemTimeWide() - audio_state.suspend_time;
+    shift_voice_clocks(away);
+
+    pause_output(0);
+    audio_state.suspended = 0;
+    start_audio_thread();
+    l_info("Audio resumed after %llu ms", (unsigned long long)(away / 1000));
+}
+
+static void pause_output(int paused) {
+#if AUDIO_MIXER
+    // Closing keeps the mixer's sources and buffers; only the port and thread go
+    if (paused) {
+        audio_mixer_close();
+    } else if (audio_mixer_open() < 0) {
+        l_error("Failed to reopen the audio mixer");
+    }
+#else
+    if (!audio_state.device) {
+        return;
+    }
+
+    if (!alcIsExtensionPresent(audio_state.device, "ALC_SOFT_pause_device")) {
+        // Sources keep playing under a suspended context, but it stops mixing them
+        if (paused) {
+            alcSuspendContext(audio_state.context);
+        } else {
+            alcProcessContext(audio_state.context);
+        }
+        return;
+    }
+
+    if (paused) {
+        LPALCDEVICEPAUSESOFT device_pause = (LPALCDEVICEPAUSESOFT)alcGetProcAddress(audio_state.device, "alcDevicePauseSOFT");
+        device_pause(audio_state.device);
+    } else {
+        LPALCDEVICERESUMESOFT device_resume = (LPALCDEVICERESUMESOFT)alcGetProcAddress(audio_state.device, "alcDeviceResumeSOFT");
+        device_resume(audio_state.device);
+    }
+#endif
+}
+
+static void shift_voice_clocks(uint64_t us) {
+    for (int i = 0; i < audio_state.source_count; i++) {
+        audio_source_t *source = &audio_state.sources[i];
+        if (source->active) {
+            source->start_time += us;
+            if (source->predicted_end) {
+                source->predicted_end += us;
+            }
+        }
+    }
+
+    for (int i = 0; i < audio_state.virtual_count; i++) {
+        audio_virtual_t *voice = &audio_state.virtuals[i];
+        voice->start_time += us;
+        voice->mark += us;
+        if (voice->predicted_end) {
+            voice->predicted_end += us;
+        }
+    }
+}
+
 // ===== CLEANUP =====
 
 void audio_cleanup(void) {
@@ -687,22 +2521,38 @@ void audio_cleanup(void) {
     l_info("Cleaning up audio system");
 
     // Stop audio thread
-    audio_state.audio_thread_running = 0;
-    if (audio_state.audio_thread >= 0) {
-        sceKernelWaitThreadEnd(audio_state.audio_thread, NULL, NULL);
-        sceKernelDeleteThread(audio_state.audio_thread);
+    stop_audio_thread();
+    if (audio_state.suspended) {
+        pause_output(0);
+        audio_state.suspended = 0;
+    }
+    if (audio_state.wake_flag >= 0) {
+        sceKernelDeleteEventFlag(audio_state.wake_flag);
+        audio_state.wake_flag = -1;
     }
 
-    // Stop all sounds
-    audio_stop_all_sounds();
+    // The audio thread is gone, so it is safe to touch OpenAL from here
+    do_stop_all();
 
     // Clean up sources
-    alDeleteSources(MAX_AUDIO_SOURCES, audio_state.source_pool);
+    alDeleteSources(audio_state.source_count, audio_state.source_pool);
 
-    // Clean up buffers
+    // Clean up buffers (drops the whole SFX bank)
     alDeleteBuffers(MAX_AUDIO_BUFFERS, audio_state.buffer_pool);
+    memset(audio_state.bank, 0, sizeof(audio_state.bank));
+    audio_state.bank_bytes = 0;
+    audio_state.bank_count = 0;
+
+    // Clean up music streams
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        alDeleteSources(1, &audio_state.streams[i].source);
+        alDeleteBuffers(STREAM_BUFFER_COUNT, audio_state.streams[i].buffers);
+    }
 
     // Clean up OpenAL context
+#if AUDIO_MIXER
+    audio_mixer_close();
+#else
     alcMakeContextCurrent(NULL);
     if (audio_state.context) {
         alcDestroyContext(audio_state.context);
@@ -710,6 +2560,7 @@ void audio_cleanup(void) {
     if (audio_state.device) {
         alcCloseDevice(audio_state.device);
     }
+#endif
 
     audio_state.initialized = 0;
 
@@ -733,13 +2584,27 @@ void audio_debug_info(void) {
     l_info("  Audio Enabled: %s", audio_state.audio_enabled ? "Yes" : "No");
     l_info("  Music Enabled: %s", audio_state.music_enabled ? "Yes" : "No");
     l_info("  SFX Enabled: %s", audio_state.sfx_enabled ? "Yes" : "No");
-    l_info("  Active Sources: %d/%d", audio_state.active_sources, MAX_AUDIO_SOURCES);
-    l_info("  Next Sound ID: %d", audio_state.next_sound_id);
+    l_info("  Active Sources: %d/%d", audio_state.active_sources, audio_state.source_count);
+    l_info("  Virtual Voices: %d/%d", audio_state.virtual_count, MAX_VIRTUAL_VOICES);
+    l_info("  Sound Handles: %d/%d live", audio_state.handles_in_use, AUDIO_HANDLE_SLOTS);
+    l_info("  Audio Thread Wakeups: %u (idle poll %u us)", audio_state.wakeups, audio_state.idle_poll_us);
+    l_info("  SFX Bank: %d/%d entries, %zu/%d KB, %u hits / %u misses", audio_state.bank_count,
+           MAX_AUDIO_BUFFERS, audio_state.bank_bytes / 1024, SOUND_BANK_BUDGET / 1024,
+           audio_state.bank_hits, audio_state.bank_misses);
+
+    for (int i = 0; i < MAX_AUDIO_STREAMS; i++) {
+        audio_stream_t *stream = &audio_state.streams[i];
+        if (stream->active) {
+            l_info("  Stream [%d] ID:%d %s %ld Hz, %zu/%zu KB decoded/file %s", i, stream->sound_id,
+                   stream->playing ? "Playing" : "Starting", stream->sample_rate,
+                   stream->bytes_read / 1024, stream->file_size / 1024, stream->filename);
+        }
+    }
 
     // Show active sources
     if (audio_state.active_sources > 0) {
         l_info("  Active Sources:");
-        for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
+        for (int i = 0; i < audio_state.source_count; i++) {
             if (audio_state.sources[i].active) {
                 ALint state;
                 alGetSourcei(audio_state.sources[i].source, AL_SOURCE_STATE, &state);
@@ -758,14 +2623,15 @@ void audio_debug_info(void) {
 void audio_mark_complete(int sound_id) {
     l_debug("Audio complete callback for sound ID: %d", sound_id);
 
-    // Find the source and mark it as completed
-    for (int i = 0; i < MAX_AUDIO_SOURCES; i++) {
-        if (audio_state.sources[i].sound_id == sound_id) {
-            audio_state.sources[i].active = 0;
-            audio_state.sources[i].playing = 0;
-            audio_state.sources[i].sound_id = 0;
-            audio_state.active_sources--;
-            break;
-        }
+    if (!audio_state.initialized || sound_id <= 0) {
+        return;
     }
+
+    // Release the source on the audio thread; the JNI caller never waits on OpenAL
+    audio_command_t cmd = {0};
+    cmd.type = AUDIO_CMD_RELEASE;
+    cmd.sound_id = sound_id;
+    push_command(&cmd);
+
+    free_handle(sound_id);
 }
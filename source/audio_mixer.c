@@ -0,0 +1,591 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Software Mixer
+ *
+ * Buffers hold interleaved stereo s16 at AUDIO_MIXER_RATE, converted once
+ * in audio_mixer_buffer_data(). A voice walks its buffer queue with a 16.16
+ * position: at unit pitch the samples are scaled with a rounding Q15
+ * multiply and widened into an int32 accumulator eight at a time, and a
+ * pitched voice steps through with linear interpolation instead. The
+ * accumulator is narrowed back to s16 with saturation. Gains are capped at
+ * 1.0 as OpenAL-soft does, so AUDIO_MIXER_VOICES full-scale voices still fit
+ * the accumulator. Render and the OpenAL-style calls share one lock; the
+ * audio thread's calls are short and the mixer holds it for one buffer.
+ */
+
+#include <psp2/audioout.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "config.h"
+#include "audio_mixer.h"
+#include "reimpl/pthr.h"
+#include "utils/logger.h"
+
+#define AUDIO_MIXER_VOICES (MAX_AUDIO_SOURCES + 8)  // SFX pool plus the music streams
+#define AUDIO_MIXER_BUFFERS 96                      // SFX bank plus two per music stream
+#define AUDIO_MIXER_QUEUE 4                         // Buffers queued on one voice
+#define AUDIO_MIXER_UNITY (1 << 16)                 // 16.16 step at pitch 1.0
+#define AUDIO_MIXER_MAX_STEP (8 << 16)
+
+typedef struct {
+    int used;
+    int16_t *pcm;                       // Interleaved stereo at AUDIO_MIXER_RATE
+    uint32_t frames;
+    ALint frequency;                    // As loaded, for duration queries
+    ALint channels;
+} mixer_buffer_t;
+
+typedef struct {
+    int used;
+    ALint state;                        // AL_PLAYING or AL_STOPPED
+    int looping;
+    float gain;
+    uint32_t step;                      // 16.16 input frames per output frame
+    ALuint queue[AUDIO_MIXER_QUEUE];
+    int queued;
+    int current;                        // Playing entry; the ones before it are processed
+    uint64_t position;                  // 16.16 frame within the current buffer
+    uint64_t start_offset;              // Where the next play starts (AL_SEC_OFFSET while stopped)
+} mixer_voice_t;
+
+static mixer_voice_t voices[AUDIO_MIXER_VOICES];
+static mixer_buffer_t buffers[AUDIO_MIXER_BUFFERS];
+static int32_t accumulator[AUDIO_BUFFER_SIZE * 2];
+static int16_t output[2][AUDIO_BUFFER_SIZE * 2];
+static float master_gain = 1.0f;
+static ALenum last_error = AL_NO_ERROR;
+
+static SceKernelLwMutexWork mixer_lock;
+static int lock_ready = 0;
+static int port = -1;
+static SceUID mixer_thread = -1;
+static volatile int mixer_running = 0;
+
+// Function prototypes
+static int mixer_thread_func(SceSize args, void *argp);
+static void ensure_lock(void);
+static mixer_voice_t *get_voice(ALuint source);
+static mixer_buffer_t *get_buffer(ALuint buffer);
+static uint64_t clamp_position(const mixer_voice_t *voice, uint64_t position);
+static void mix_voice(mixer_voice_t *voice, int frames);
+static void mix_unity(int32_t *acc, const int16_t *src, int samples, int16_t gain);
+static void mix_pitched(int32_t *acc, const mixer_buffer_t *buffer, uint64_t position, uint32_t step,
+                        int frames, int16_t gain);
+static int16_t *convert_pcm(const int16_t *src, uint32_t frames, int channels, int freq, uint32_t *out_frames);
+
+// ===== OUTPUT =====
+
+int audio_mixer_open(void) {
+    ensure_lock();
+
+    port = sceAudioOutOpenPort(SCE_AUDIO_OUT_PORT_TYPE_MAIN, AUDIO_BUFFER_SIZE, AUDIO_MIXER_RATE,
+                               SCE_AUDIO_OUT_MODE_STEREO);
+    if (port < 0) {
+        l_error("Mixer: failed to open audio port: 0x%08X", port);
+        return -1;
+    }
+
+    int volume[2] = { SCE_AUDIO_VOLUME_0DB, SCE_AUDIO_VOLUME_0DB };
+    sceAudioOutSetVolume(port, SCE_AUDIO_VOLUME_FLAG_L_CH | SCE_AUDIO_VOLUME_FLAG_R_CH, volume);
+
+    mixer_running = 1;
+    const pthr_thread_policy_t *policy = pthr_thread_policy("audio_mixer");
+    mixer_thread = sceKernelCreateThread("audio_mixer", mixer_thread_func,
+                                         policy->priority ? policy->priority : 0x10000100,
+                                         policy->stack_size ? policy->stack_size : 0x4000,
+                                         0, policy->affinity, NULL);
+    if (mixer_thread < 0) {
+        l_error("Mixer: failed to create thread: 0x%08X", mixer_thread);
+        mixer_running = 0;
+        sceAudioOutReleasePort(port);
+        port = -1;
+        return -1;
+    }
+    sceKernelStartThread(mixer_thread, 0, NULL);
+
+    l_success("Mixer: %d voices, %d frames at %d Hz", AUDIO_MIXER_VOICES, AUDIO_BUFFER_SIZE, AUDIO_MIXER_RATE);
+    return 0;
+}
+
+void audio_mixer_close(void) {
+    if (mixer_thread >= 0) {
+        mixer_running = 0;
+        sceKernelWaitThreadEnd(mixer_thread, NULL, NULL);
+        sceKernelDeleteThread(mixer_thread);
+        mixer_thread = -1;
+    }
+
+    if (port >= 0) {
+        sceAudioOutOutput(port, NULL); // Wait for the last buffer to play out
+        sceAudioOutReleasePort(port);
+        port = -1;
+    }
+}
+
+static int mixer_thread_func(SceSize args, void *argp) {
+    (void)args;
+    (void)argp;
+
+    // sceAudioOutOutput blocks until the previous buffer is consumed, so two alternate
+    int current = 0;
+    while (mixer_running) {
+        audio_mixer_render(output[current], AUDIO_BUFFER_SIZE);
+        sceAudioOutOutput(port, output[current]);
+        current ^= 1;
+    }
+
+    return 0;
+}
+
+void audio_mixer_render(int16_t *out, int frames) {
+    if (frames > AUDIO_BUFFER_SIZE) {
+        frames = AUDIO_BUFFER_SIZE;
+    }
+    int samples = frames * 2;
+
+    memset(accumulator, 0, (size_t)samples * sizeof(int32_t));
+
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    for (int i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        if (voices[i].used && voices[i].state == AL_PLAYING) {
+            mix_voice(&voices[i], frames);
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x4_t low = vqmovn_s32(vld1q_s32(accumulator + i));
+        int16x4_t high = vqmovn_s32(vld1q_s32(accumulator + i + 4));
+        vst1q_s16(out + i, vcombine_s16(low, high));
+    }
+#endif
+    for (; i < samples; i++) {
+        int32_t sample = accumulator[i];
+        out[i] = (int16_t)(sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample);
+    }
+}
+
+// ===== MIXING =====
+
+static void mix_voice(mixer_voice_t *voice, int frames) {
+    float gain = voice->gain * master_gain;
+    int16_t gain_q15 = (int16_t)(gain >= 1.0f ? 32767 : gain <= 0.0f ? 0 : gain * 32767.0f + 0.5f);
+
+    int done = 0;
+    while (done < frames) {
+        mixer_buffer_t *buffer = voice->current < voice->queued ? get_buffer(voice->queue[voice->current]) : NULL;
+        if (!buffer || buffer->frames == 0) {
+            voice->state = AL_STOPPED;
+            voice->current = voice->queued;
+            voice->position = 0;
+            return;
+        }
+
+        // Output frames left before this buffer runs out
+        uint64_t end = (uint64_t)buffer->frames << 16;
+        uint64_t available = (end - voice->position + voice->step - 1) / voice->step;
+        int count = (uint64_t)(frames - done) < available ? frames - done : (int)available;
+
+        if (gain_q15 == 0) {
+            // Silent voices keep time without touching the samples
+        } else if (voice->step == AUDIO_MIXER_UNITY) {
+            uint32_t frame = (uint32_t)(voice->position >> 16);
+            mix_unity(accumulator + done * 2, buffer->pcm + frame * 2, count * 2, gain_q15);
+        } else {
+            mix_pitched(accumulator + done * 2, buffer, voice->position, voice->step, count, gain_q15);
+        }
+
+        voice->position += (uint64_t)voice->step * (uint32_t)count;
+        done += count;
+
+        if (voice->position >= end) {
+            voice->position -= end;
+            voice->current++;
+            if (voice->current >= voice->queued) {
+                if (!voice->looping) {
+                    voice->state = AL_STOPPED;
+                    voice->position = 0;
+                    return;
+                }
+                voice->current = 0;
+            }
+        }
+    }
+}
+
+static void mix_unity(int32_t *acc, const int16_t *src, int samples, int16_t gain) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t scaled = vqrdmulhq_n_s16(vld1q_s16(src + i), gain);
+        vst1q_s32(acc + i, vaddw_s16(vld1q_s32(acc + i), vget_low_s16(scaled)));
+        vst1q_s32(acc + i + 4, vaddw_s16(vld1q_s32(acc + i + 4), vget_high_s16(scaled)));
+    }
+#endif
+    for (; i < samples; i++) {
+        acc[i] += (src[i] * gain + 0x4000) >> 15;
+    }
+}
+
+static void mix_pitched(int32_t *acc, const mixer_buffer_t *buffer, uint64_t position, uint32_t step,
+                        int frames, int16_t gain) {
+    const int16_t *pcm = buffer->pcm;
+    uint32_t last = buffer->frames - 1;
+
+    for (int i = 0; i < frames; i++, position += step) {
+        uint32_t frame = (uint32_t)(position >> 16);
+        int32_t frac = (int32_t)(position & 0xFFFF);
+        uint32_t next = frame < last ? frame + 1 : last;
+
+        for (int c = 0; c < 2; c++) {
+            int32_t a = pcm[frame * 2 + c];
+            int32_t b = pcm[next * 2 + c];
+            int32_t sample = a + (((b - a) * frac) >> 16);
+            acc[i * 2 + c] += (sample * gain + 0x4000) >> 15;
+        }
+    }
+}
+
+// ===== BUFFERS =====
+
+static int16_t *convert_pcm(const int16_t *src, uint32_t frames, int channels, int freq, uint32_t *out_frames) {
+    uint32_t count = (uint32_t)(((uint64_t)frames * AUDIO_MIXER_RATE + freq - 1) / freq);
+    int16_t *pcm = malloc((size_t)count * 2 * sizeof(int16_t));
+    if (!pcm) {
+        return NULL;
+    }
+
+    if (freq == AUDIO_MIXER_RATE) {
+        if (channels == 2) {
+            memcpy(pcm, src, (size_t)frames * 2 * sizeof(int16_t));
+        } else {
+            for (uint32_t i = 0; i < frames; i++) {
+                pcm[i * 2] = pcm[i * 2 + 1] = src[i];
+            }
+        }
+    } else {
+        // Linear interpolation, done here so mixing never has to
+        uint64_t step = ((uint64_t)freq << 16) / AUDIO_MIXER_RATE;
+        uint64_t position = 0;
+        for (uint32_t i = 0; i < count; i++, position += step) {
+            uint32_t frame = (uint32_t)(position >> 16);
+            int32_t frac = (int32_t)(position & 0xFFFF);
+            if (frame >= frames) {
+                frame = frames - 1;
+                frac = 0;
+            }
+            uint32_t next = frame + 1 < frames ? frame + 1 : frame;
+
+            for (int c = 0; c < 2; c++) {
+                int ch = channels == 2 ? c : 0;
+                int32_t a = src[frame * channels + ch];
+                int32_t b = src[next * channels + ch];
+                pcm[i * 2 + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+            }
+        }
+    }
+
+    *out_frames = count;
+    return pcm;
+}
+
+void audio_mixer_gen_buffers(ALsizei n, ALuint *ids) {
+    ensure_lock();
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    for (ALsizei i = 0; i < n; i++) {
+        ids[i] = 0;
+        for (int b = 0; b < AUDIO_MIXER_BUFFERS; b++) {
+            if (!buffers[b].used) {
+                memset(&buffers[b], 0, sizeof(buffers[b]));
+                buffers[b].used = 1;
+                ids[i] = (ALuint)b + 1;
+                break;
+            }
+        }
+        if (!ids[i]) {
+            l_error("Mixer: out of buffers (%d)", AUDIO_MIXER_BUFFERS);
+            last_error = AL_OUT_OF_MEMORY;
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_delete_buffers(ALsizei n, const ALuint *ids) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    for (ALsizei i = 0; i < n; i++) {
+        mixer_buffer_t *buffer = get_buffer(ids[i]);
+        if (buffer) {
+            free(buffer->pcm);
+            memset(buffer, 0, sizeof(*buffer));
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_buffer_data(ALuint id, ALenum format, const ALvoid *data, ALsizei size, ALsizei freq) {
+    if (format != AL_FORMAT_MONO16 && format != AL_FORMAT_STEREO16) {
+        l_error("Mixer: unsupported buffer format 0x%x", format);
+        last_error = AL_INVALID_ENUM;
+        return;
+    }
+
+    int channels = format == AL_FORMAT_STEREO16 ? 2 : 1;
+    uint32_t frames = (uint32_t)size / (uint32_t)(channels * sizeof(int16_t));
+    uint32_t out_frames = 0;
+    int16_t *pcm = NULL;
+    if (frames > 0 && freq > 0) {
+        pcm = convert_pcm(data, frames, channels, freq, &out_frames);
+        if (!pcm) {
+            last_error = AL_OUT_OF_MEMORY;
+            return;
+        }
+    }
+
+    // Conversion happens outside the lock; only the swap holds up mixing
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_buffer_t *buffer = get_buffer(id);
+    int16_t *old = NULL;
+    if (buffer) {
+        old = buffer->pcm;
+        buffer->pcm = pcm;
+        buffer->frames = out_frames;
+        buffer->frequency = freq;
+        buffer->channels = channels;
+    } else {
+        old = pcm;
+        last_error = AL_INVALID_NAME;
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+
+    free(old);
+}
+
+void audio_mixer_get_buffer_i(ALuint id, ALenum param, ALint *value) {
+    mixer_buffer_t *buffer = get_buffer(id);
+    *value = 0;
+    if (!buffer) {
+        return;
+    }
+
+    switch (param) {
+        case AL_FREQUENCY: *value = buffer->frequency; break;
+        case AL_CHANNELS:  *value = buffer->channels; break;
+        case AL_BITS:      *value = 16; break;
+        default: break;
+    }
+}
+
+// ===== SOURCES =====
+
+void audio_mixer_gen_sources(ALsizei n, ALuint *ids) {
+    ensure_lock();
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    for (ALsizei i = 0; i < n; i++) {
+        ids[i] = 0;
+        for (int v = 0; v < AUDIO_MIXER_VOICES; v++) {
+            if (!voices[v].used) {
+                memset(&voices[v], 0, sizeof(voices[v]));
+                voices[v].used = 1;
+                voices[v].state = AL_STOPPED;
+                voices[v].gain = 1.0f;
+                voices[v].step = AUDIO_MIXER_UNITY;
+                ids[i] = (ALuint)v + 1;
+                break;
+            }
+        }
+        if (!ids[i]) {
+            l_error("Mixer: out of voices (%d)", AUDIO_MIXER_VOICES);
+            last_error = AL_OUT_OF_MEMORY;
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_delete_sources(ALsizei n, const ALuint *ids) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    for (ALsizei i = 0; i < n; i++) {
+        mixer_voice_t *voice = get_voice(ids[i]);
+        if (voice) {
+            memset(voice, 0, sizeof(*voice));
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_source_f(ALuint id, ALenum param, ALfloat value) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    if (voice) {
+        if (param == AL_GAIN) {
+            voice->gain = value;
+        } else if (param == AL_PITCH) {
+            float step = value * AUDIO_MIXER_UNITY;
+            voice->step = step < 1.0f ? 1 : step > AUDIO_MIXER_MAX_STEP ? AUDIO_MIXER_MAX_STEP : (uint32_t)(step + 0.5f);
+        } else if (param == AL_SEC_OFFSET) {
+            // Within the first buffer, which is all audio.c seeks in
+            uint64_t position = (uint64_t)(value > 0.0f ? value * AUDIO_MIXER_RATE * AUDIO_MIXER_UNITY : 0.0f);
+            if (voice->state == AL_PLAYING) {
+                voice->position = clamp_position(voice, position);
+            } else {
+                voice->start_offset = position;
+            }
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_get_source_f(ALuint id, ALenum param, ALfloat *value) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    *value = 0.0f;
+    if (voice && param == AL_SEC_OFFSET && voice->state == AL_PLAYING) {
+        *value = (float)voice->position / AUDIO_MIXER_UNITY / AUDIO_MIXER_RATE;
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_source_i(ALuint id, ALenum param, ALint value) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    if (voice) {
+        if (param == AL_LOOPING) {
+            voice->looping = value == AL_TRUE;
+        } else if (param == AL_BUFFER) {
+            // Replaces the whole queue, as in OpenAL
+            voice->state = AL_STOPPED;
+            voice->queue[0] = (ALuint)value;
+            voice->queued = value ? 1 : 0;
+            voice->current = 0;
+            voice->position = 0;
+            voice->start_offset = 0;
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_get_source_i(ALuint id, ALenum param, ALint *value) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    *value = 0;
+    if (voice) {
+        switch (param) {
+            case AL_SOURCE_STATE:      *value = voice->state; break;
+            case AL_BUFFERS_QUEUED:    *value = voice->queued; break;
+            case AL_BUFFERS_PROCESSED: *value = voice->current; break;
+            default: break;
+        }
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_play(ALuint id) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    if (voice) {
+        // Plays from the start of the queue (or a set offset), also when already playing
+        voice->current = 0;
+        voice->position = clamp_position(voice, voice->start_offset);
+        voice->start_offset = 0;
+        voice->state = voice->queued > 0 ? AL_PLAYING : AL_STOPPED;
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_stop(ALuint id) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    if (voice) {
+        // A stopped source has processed everything queued on it
+        voice->state = AL_STOPPED;
+        voice->current = voice->queued;
+        voice->position = 0;
+        voice->start_offset = 0;
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_queue_buffers(ALuint id, ALsizei n, const ALuint *ids) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    for (ALsizei i = 0; voice && i < n; i++) {
+        if (voice->queued >= AUDIO_MIXER_QUEUE) {
+            l_error("Mixer: buffer queue full on source %u", id);
+            last_error = AL_INVALID_OPERATION;
+            break;
+        }
+        voice->queue[voice->queued++] = ids[i];
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_unqueue_buffers(ALuint id, ALsizei n, ALuint *ids) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    mixer_voice_t *voice = get_voice(id);
+    if (voice) {
+        if (n > voice->current) {
+            last_error = AL_INVALID_VALUE;
+            n = voice->current;
+        }
+        memcpy(ids, voice->queue, (size_t)n * sizeof(ALuint));
+        memmove(voice->queue, voice->queue + n, (size_t)(voice->queued - n) * sizeof(ALuint));
+        voice->queued -= n;
+        voice->current -= n;
+    }
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+void audio_mixer_set_gain(ALfloat gain) {
+    sceKernelLockLwMutex(&mixer_lock, 1, NULL);
+    master_gain = gain;
+    sceKernelUnlockLwMutex(&mixer_lock, 1);
+}
+
+ALenum audio_mixer_get_error(void) {
+    ALenum error = last_error;
+    last_error = AL_NO_ERROR;
+    return error;
+}
+
+// ===== HELPERS =====
+
+static void ensure_lock(void) {
+    if (!lock_ready) {
+        sceKernelCreateLwMutex(&mixer_lock, "audio_mixer", 0, 0, NULL);
+        lock_ready = 1;
+    }
+}
+
+static mixer_voice_t *get_voice(ALuint source) {
+    if (source == 0 || source > AUDIO_MIXER_VOICES || !voices[source - 1].used) {
+        return NULL;
+    }
+    return &voices[source - 1];
+}
+
+static mixer_buffer_t *get_buffer(ALuint buffer) {
+    if (buffer == 0 || buffer > AUDIO_MIXER_BUFFERS || !buffers[buffer - 1].used) {
+        return NULL;
+    }
+    return &buffers[buffer - 1];
+}
+
+// A position inside the buffer the voice is on
+static uint64_t clamp_position(const mixer_voice_t *voice, uint64_t position) {
+    const mixer_buffer_t *buffer = voice->current < voice->queued ? get_buffer(voice->queue[voice->current]) : NULL;
+    if (!buffer || buffer->frames == 0) {
+        return 0;
+    }
+
+    uint64_t end = (uint64_t)buffer->frames << 16;
+    return position < end ? position : end - 1;
+}
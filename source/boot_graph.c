@@ -0,0 +1,215 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Boot Task Graph
+ *
+ * One LwMutex guards the task table and one LwCond is broadcast whenever a
+ * task finishes. Each thread picks the first pending task of its kind whose
+ * dependencies are done, or sleeps on the cond until something changes.
+ * Since dependencies always point at earlier tasks the graph can't cycle,
+ * and the main thread keeps waiting after its own tasks until the workers'
+ * are done too.
+ */
+
+#include <stdint.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "boot_graph.h"
+#include "utils/logger.h"
+
+#define BOOT_WORKERS 2
+#define BOOT_WORKER_PRIORITY 0x10000100
+#define BOOT_WORKER_STACK_SIZE (256 * 1024)
+
+typedef enum {
+    TASK_PENDING = 0,
+    TASK_RUNNING,
+    TASK_DONE,
+    TASK_FAILED
+} task_state_t;
+
+typedef struct {
+    const char *name;
+    boot_task_fn fn;
+    boot_thread_t thread;
+    uint32_t deps;
+    task_state_t state;
+    uint64_t start;
+    uint64_t end;
+} boot_task_t;
+
+static boot_task_t tasks[BOOT_MAX_TASKS];
+static int task_count = 0;
+static SceKernelLwMutexWork graph_lock;
+static SceKernelLwCondWork graph_changed;
+
+// Function prototypes
+static int boot_worker_func(SceSize args, void *argp);
+static void run_tasks(boot_thread_t thread);
+static int take_ready(boot_thread_t thread);
+static int all_finished(void);
+
+int boot_graph_add(const char *name, boot_task_fn fn, boot_thread_t thread, uint32_t deps) {
+    if (task_count >= BOOT_MAX_TASKS || !fn || (deps >> task_count) != 0) {
+        l_error("Boot task %s rejected", name);
+        return -1;
+    }
+
+    boot_task_t *task = &tasks[task_count];
+    task->name = name;
+    task->fn = fn;
+    task->thread = thread;
+    task->deps = deps;
+    task->state = TASK_PENDING;
+    return task_count++;
+}
+
+int boot_graph_run(void) {
+#if SOLOADER_LOG_LEVEL <= LT_INFO
+    uint64_t start = sceKernelGetProcessTimeWide();
+#endif
+
+    sceKernelCreateLwMutex(&graph_lock, "boot_graph", 0, 0, NULL);
+    sceKernelCreateLwCond(&graph_changed, "boot_graph", 0, &graph_lock, NULL);
+
+    SceUID workers[BOOT_WORKERS];
+    for (int i = 0; i < BOOT_WORKERS; i++) {
+        // Cores 1 and 2
+        workers[i] = sceKernelCreateThread("boot_worker", boot_worker_func, BOOT_WORKER_PRIORITY,
+                                           BOOT_WORKER_STACK_SIZE, 0, SCE_KERNEL_CPU_MASK_USER_1 << i, NULL);
+        if (workers[i] >= 0) {
+            sceKernelStartThread(workers[i], 0, NULL);
+        } else {
+            l_warn("Boot worker %d unavailable: 0x%08X", i, workers[i]);
+        }
+    }
+
+    // With no workers at all, the main thread takes their tasks too
+    int have_workers = 0;
+    for (int i = 0; i < BOOT_WORKERS; i++) {
+        have_workers |= workers[i] >= 0;
+    }
+    if (!have_workers) {
+        for (int i = 0; i < task_count; i++) {
+            tasks[i].thread = BOOT_ON_MAIN;
+        }
+    }
+
+    run_tasks(BOOT_ON_MAIN);
+
+    sceKernelLockLwMutex(&graph_lock, 1, NULL);
+    while (!all_finished()) {
+        sceKernelWaitLwCond(&graph_changed, NULL);
+    }
+    sceKernelUnlockLwMutex(&graph_lock, 1);
+
+    for (int i = 0; i < BOOT_WORKERS; i++) {
+        if (workers[i] >= 0) {
+            sceKernelWaitThreadEnd(workers[i], NULL, NULL);
+            sceKernelDeleteThread(workers[i]);
+        }
+    }
+    sceKernelDeleteLwCond(&graph_changed);
+    sceKernelDeleteLwMutex(&graph_lock);
+
+    int failed = 0;
+    for (int i = 0; i < task_count; i++) {
+        failed += tasks[i].state != TASK_DONE;
+    }
+
+#if SOLOADER_LOG_LEVEL <= LT_INFO
+    uint64_t serial = 0;
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].state == TASK_DONE) {
+            serial += tasks[i].end - tasks[i].start;
+            l_debug("  Boot task %-16s %6llu ms (from +%llu ms)", tasks[i].name,
+                    (tasks[i].end - tasks[i].start) / 1000, (tasks[i].start - start) / 1000);
+        }
+    }
+
+    l_info("Boot graph: %d tasks in %llu ms (%llu ms if run in sequence)%s",
+           task_count, (sceKernelGetProcessTimeWide() - start) / 1000, serial / 1000,
+           failed ? ", some failed" : "");
+#endif
+    return failed ? -1 : 0;
+}
+
+// ===== EXECUTION =====
+
+static int boot_worker_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    run_tasks(BOOT_ON_WORKER);
+    return sceKernelExitThread(0);
+}
+
+static void run_tasks(boot_thread_t thread) {
+    sceKernelLockLwMutex(&graph_lock, 1, NULL);
+    for (;;) {
+        int index = take_ready(thread);
+        if (index == -2) {
+            break;
+        }
+        if (index < 0) {
+            sceKernelWaitLwCond(&graph_changed, NULL);
+            continue;
+        }
+
+        boot_task_t *task = &tasks[index];
+        sceKernelUnlockLwMutex(&graph_lock, 1);
+
+        task->start = sceKernelGetProcessTimeWide();
+        int ret = task->fn();
+        task->end = sceKernelGetProcessTimeWide();
+        if (ret != 0) {
+            l_error("Boot task %s failed", task->name);
+        }
+
+        sceKernelLockLwMutex(&graph_lock, 1, NULL);
+        task->state = ret == 0 ? TASK_DONE : TASK_FAILED;
+        sceKernelSignalAllLwCond(&graph_changed);
+    }
+    sceKernelUnlockLwMutex(&graph_lock, 1);
+}
+
+// Called with graph_lock held: index of a task to run, -1 to wait, -2 when
+// nothing of this kind is left
+static int take_ready(boot_thread_t thread) {
+    int pending = 0;
+    for (int i = 0; i < task_count; i++) {
+        boot_task_t *task = &tasks[i];
+        if (task->thread != thread || task->state != TASK_PENDING) {
+            continue;
+        }
+
+        int blocked = 0, skipped = 0;
+        for (int d = 0; d < task_count; d++) {
+            if (!(task->deps & BOOT_DEP(d))) {
+                continue;
+            }
+            skipped |= tasks[d].state == TASK_FAILED;
+            blocked |= tasks[d].state != TASK_DONE;
+        }
+
+        if (skipped) {
+            l_warn("Boot task %s skipped: a dependency failed", task->name);
+            task->state = TASK_FAILED;
+            sceKernelSignalAllLwCond(&graph_changed);
+            continue;
+        }
+        if (!blocked) {
+            task->state = TASK_RUNNING;
+            return i;
+        }
+        pending++;
+    }
+    return pending ? -1 : -2;
+}
+
+static int all_finished(void) {
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].state == TASK_PENDING || tasks[i].state == TASK_RUNNING) {
+            return 0;
+        }
+    }
+    return 1;
+}
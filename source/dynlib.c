@@ -34,7 +34,20 @@
 #include <zlib.h>
 
 #include <so_util/so_util.h>
+#include "config.h"
 #include "utils/logger.h"
+#include "reimpl/asset_manager.h"
+#include "reimpl/io.h"
+#include "reimpl/egl.h"
+#include "utils/glutil.h"
+#include "reimpl/mem.h"
+#include "reimpl/pthr.h"
+#include "reimpl/gl_state.h"
+#include "reimpl/gl_batch.h"
+#include "reimpl/gl_dynres.h"
+#include "reimpl/mem_pool.h"
+#include "reimpl/fast_libc.h"
+#include "utils/settings.h"
 
 // Fake FILE structure for compatibility
 FILE __sF_fake[3];
@@ -79,18 +92,48 @@ int gethostname(char *name, size_t len) {
     return 0;
 }
 
+// Allocator entry points, pooled for small sizes
+#if MEM_POOL
+#define MEM_POOLED(fn) (uintptr_t)&fn##_pooled
+#else
+#define MEM_POOLED(fn) (uintptr_t)&fn
+#endif
+
+// GL entry points routed through the state filter
+#if GL_STATE_FILTER
+#define GL_FILTERED(fn) (uintptr_t)&fn##_filtered
+#else
+#define GL_FILTERED(fn) (uintptr_t)&fn
+#endif
+
+// GL entry points that must flush a pending sprite batch
+#if GL_SPRITE_BATCH
+#define GL_BATCHED(fn) (uintptr_t)&fn##_batched
+#else
+#define GL_BATCHED(fn) (uintptr_t)&fn
+#endif
+
+// glViewport, mapped into the dynamic-resolution target (flushes batches itself)
+#if DYNAMIC_RESOLUTION
+#define GL_SCALED(fn) (uintptr_t)&fn##_scaled
+#else
+#define GL_SCALED(fn) GL_BATCHED(fn)
+#endif
+
 // Symbol resolution table
 so_default_dynlib default_dynlib[] = {
     // Memory functions
-    {"malloc", (uintptr_t)&malloc},
-    {"free", (uintptr_t)&free},
-    {"calloc", (uintptr_t)&calloc},
-    {"realloc", (uintptr_t)&realloc},
+    {"malloc", MEM_POOLED(malloc)},
+    {"free", MEM_POOLED(free)},
+    {"calloc", MEM_POOLED(calloc)},
+    {"realloc", MEM_POOLED(realloc)},
     {"memcpy", (uintptr_t)&memcpy},
     {"memmove", (uintptr_t)&memmove},
     {"memset", (uintptr_t)&memset},
     {"memcmp", (uintptr_t)&memcmp},
     {"memchr", (uintptr_t)&memchr},
+    {"mmap", (uintptr_t)&mmap},
+    {"munmap", (uintptr_t)&munmap},
 
     // String functions
     {"strlen", (uintptr_t)&strlen},
@@ -153,60 +196,61 @@ so_default_dynlib default_dynlib[] = {
     {"fmodf", (uintptr_t)&fmodf},
 
     // OpenGL ES 1.x functions
-    {"glActiveTexture", (uintptr_t)&glActiveTexture},
-    {"glAlphaFunc", (uintptr_t)&glAlphaFunc},
-    {"glBindTexture", (uintptr_t)&glBindTexture},
-    {"glBlendFunc", (uintptr_t)&glBlendFunc},
-    {"glClear", (uintptr_t)&glClear},
+    {"glActiveTexture", GL_FILTERED(glActiveTexture)},
+    {"glAlphaFunc", GL_BATCHED(glAlphaFunc)},
+    {"glBindTexture", GL_FILTERED(glBindTexture)},
+    {"glBlendFunc", GL_FILTERED(glBlendFunc)},
+    {"glClear", GL_BATCHED(glClear)},
     {"glClearColor", (uintptr_t)&glClearColor},
     {"glClearDepthf", (uintptr_t)&glClearDepthf},
-    {"glClientActiveTexture", (uintptr_t)&glClientActiveTexture},
-    {"glColor4f", (uintptr_t)&glColor4f},
-    {"glColorPointer", (uintptr_t)&glColorPointer},
-    {"glDeleteTextures", (uintptr_t)&glDeleteTextures},
-    {"glDepthFunc", (uintptr_t)&glDepthFunc},
-    {"glDepthMask", (uintptr_t)&glDepthMask},
-    {"glDisable", (uintptr_t)&glDisable},
-    {"glDisableClientState", (uintptr_t)&glDisableClientState},
-    {"glDrawArrays", (uintptr_t)&glDrawArrays},
-    {"glEnable", (uintptr_t)&glEnable},
-    {"glEnableClientState", (uintptr_t)&glEnableClientState},
-    {"glFinish", (uintptr_t)&glFinish},
-    {"glFlush", (uintptr_t)&glFlush},
-    {"glFrustumf", (uintptr_t)&glFrustumf},
+    {"glClientActiveTexture", GL_FILTERED(glClientActiveTexture)},
+    {"glColor4f", GL_BATCHED(glColor4f)},
+    {"glColorPointer", GL_BATCHED(glColorPointer)},
+    {"glDeleteTextures", GL_FILTERED(glDeleteTextures)},
+    {"glDepthFunc", GL_BATCHED(glDepthFunc)},
+    {"glDepthMask", GL_BATCHED(glDepthMask)},
+    {"glDisable", GL_FILTERED(glDisable)},
+    {"glDisableClientState", GL_FILTERED(glDisableClientState)},
+    {"glDrawArrays", GL_FILTERED(glDrawArrays)},
+    {"glDrawElements", GL_FILTERED(glDrawElements)},
+    {"glEnable", GL_FILTERED(glEnable)},
+    {"glEnableClientState", GL_FILTERED(glEnableClientState)},
+    {"glFinish", GL_BATCHED(glFinish)},
+    {"glFlush", GL_BATCHED(glFlush)},
+    {"glFrustumf", GL_BATCHED(glFrustumf)},
     {"glGenTextures", (uintptr_t)&glGenTextures},
     {"glGetError", (uintptr_t)&glGetError},
     {"glGetString", (uintptr_t)&glGetString},
-    {"glLoadIdentity", (uintptr_t)&glLoadIdentity},
-    {"glLoadMatrixf", (uintptr_t)&glLoadMatrixf},
+    {"glLoadIdentity", GL_BATCHED(glLoadIdentity)},
+    {"glLoadMatrixf", GL_BATCHED(glLoadMatrixf)},
     {"glMatrixMode", (uintptr_t)&glMatrixMode},
-    {"glOrthof", (uintptr_t)&glOrthof},
-    {"glPixelStorei", (uintptr_t)&glPixelStorei},
-    {"glPopMatrix", (uintptr_t)&glPopMatrix},
+    {"glOrthof", GL_BATCHED(glOrthof)},
+    {"glPixelStorei", GL_FILTERED(glPixelStorei)},
+    {"glPopMatrix", GL_BATCHED(glPopMatrix)},
     {"glPushMatrix", (uintptr_t)&glPushMatrix},
-    {"glRotatef", (uintptr_t)&glRotatef},
-    {"glScalef", (uintptr_t)&glScalef},
-    {"glTexCoordPointer", (uintptr_t)&glTexCoordPointer},
-    {"glTexEnvi", (uintptr_t)&glTexEnvi},
-    {"glTexImage2D", (uintptr_t)&glTexImage2D},
-    {"glTexParameteri", (uintptr_t)&glTexParameteri},
-    {"glTexSubImage2D", (uintptr_t)&glTexSubImage2D},
-    {"glTranslatef", (uintptr_t)&glTranslatef},
-    {"glVertexPointer", (uintptr_t)&glVertexPointer},
-    {"glViewport", (uintptr_t)&glViewport},
+    {"glRotatef", GL_BATCHED(glRotatef)},
+    {"glScalef", GL_BATCHED(glScalef)},
+    {"glTexCoordPointer", GL_BATCHED(glTexCoordPointer)},
+    {"glTexEnvi", GL_BATCHED(glTexEnvi)},
+    {"glTexImage2D", GL_BATCHED(glTexImage2D)},
+    {"glTexParameteri", GL_BATCHED(glTexParameteri)},
+    {"glTexSubImage2D", GL_BATCHED(glTexSubImage2D)},
+    {"glTranslatef", GL_BATCHED(glTranslatef)},
+    {"glVertexPointer", GL_BATCHED(glVertexPointer)},
+    {"glViewport", GL_SCALED(glViewport)},
     {"glGetIntegerv", (uintptr_t)&glGetIntegerv},
     {"glGetFloatv", (uintptr_t)&glGetFloatv},
 
     // OpenGL ES 2.x functions
     {"glAttachShader", (uintptr_t)&glAttachShader},
-    {"glBindBuffer", (uintptr_t)&glBindBuffer},
+    {"glBindBuffer", GL_BATCHED(glBindBuffer)},
     {"glBufferData", (uintptr_t)&glBufferData},
     {"glBufferSubData", (uintptr_t)&glBufferSubData},
-    {"glCompileShader", (uintptr_t)&glCompileShader},
+    {"glCompileShader", (uintptr_t)&glCompileShader_soloader},
     {"glCreateProgram", (uintptr_t)&glCreateProgram},
     {"glCreateShader", (uintptr_t)&glCreateShader},
-    {"glDeleteBuffers", (uintptr_t)&glDeleteBuffers},
-    {"glDeleteProgram", (uintptr_t)&glDeleteProgram},
+    {"glDeleteBuffers", GL_BATCHED(glDeleteBuffers)},
+    {"glDeleteProgram", GL_FILTERED(glDeleteProgram)},
     {"glDeleteShader", (uintptr_t)&glDeleteShader},
     {"glDetachShader", (uintptr_t)&glDetachShader_stub},
     {"glDisableVertexAttribArray", (uintptr_t)&glDisableVertexAttribArray},
@@ -220,25 +264,46 @@ so_default_dynlib default_dynlib[] = {
     {"glGetShaderiv", (uintptr_t)&glGetShaderiv},
     {"glGetShaderInfoLog", (uintptr_t)&glGetShaderInfoLog},
     {"glGetUniformLocation", (uintptr_t)&glGetUniformLocation},
-    {"glLinkProgram", (uintptr_t)&glLinkProgram},
-    {"glShaderSource", (uintptr_t)&glShaderSource},
-    {"glUniform1f", (uintptr_t)&glUniform1f},
-    {"glUniform1i", (uintptr_t)&glUniform1i},
-    {"glUniform2f", (uintptr_t)&glUniform2f},
-    {"glUniform3f", (uintptr_t)&glUniform3f},
-    {"glUniform4f", (uintptr_t)&glUniform4f},
-    {"glUniformMatrix4fv", (uintptr_t)&glUniformMatrix4fv},
-    {"glUseProgram", (uintptr_t)&glUseProgram},
+    {"glLinkProgram", GL_FILTERED(glLinkProgram)},
+    {"glShaderSource", (uintptr_t)&glShaderSource_soloader},
+    {"glUniform1f", GL_FILTERED(glUniform1f)},
+    {"glUniform1i", GL_FILTERED(glUniform1i)},
+    {"glUniform2f", GL_FILTERED(glUniform2f)},
+    {"glUniform3f", GL_FILTERED(glUniform3f)},
+    {"glUniform4f", GL_FILTERED(glUniform4f)},
+    {"glUniformMatrix4fv", GL_FILTERED(glUniformMatrix4fv)},
+    {"glUseProgram", GL_FILTERED(glUseProgram)},
     {"glVertexAttribPointer", (uintptr_t)&glVertexAttribPointer},
 
+    // EGL: static handles, presentation and vsync through the frame loop
+    {"eglChooseConfig", (uintptr_t)&eglChooseConfig},
+    {"eglCreateContext", (uintptr_t)&eglCreateContext},
+    {"eglCreateWindowSurface", (uintptr_t)&eglCreateWindowSurface},
+    {"eglDestroyContext", (uintptr_t)&eglDestroyContext},
+    {"eglDestroySurface", (uintptr_t)&eglDestroySurface},
+    {"eglGetConfigAttrib", (uintptr_t)&eglGetConfigAttrib},
+    {"eglGetConfigs", (uintptr_t)&eglGetConfigs},
+    {"eglGetCurrentContext", (uintptr_t)&eglGetCurrentContext},
+    {"eglGetCurrentDisplay", (uintptr_t)&eglGetCurrentDisplay_soloader},
+    {"eglGetCurrentSurface", (uintptr_t)&eglGetCurrentSurface_soloader},
+    {"eglGetDisplay", (uintptr_t)&eglGetDisplay_soloader},
+    {"eglInitialize", (uintptr_t)&eglInitialize},
+    {"eglMakeCurrent", (uintptr_t)&eglMakeCurrent},
+    {"eglQueryContext", (uintptr_t)&eglQueryContext},
+    {"eglQueryString", (uintptr_t)&eglQueryString},
+    {"eglQuerySurface", (uintptr_t)&eglQuerySurface},
+    {"eglSwapBuffers", (uintptr_t)&eglSwapBuffers_soloader},
+    {"eglSwapInterval", (uintptr_t)&eglSwapInterval_soloader},
+    {"eglTerminate", (uintptr_t)&eglTerminate},
+
     // Android logging functions
     {"__android_log_print", (uintptr_t)&__android_log_print},
     {"__android_log_vprint", (uintptr_t)&__android_log_vprint},
     {"__android_log_assert", (uintptr_t)&__android_log_assert},
 
     // File I/O functions
-    {"fopen", (uintptr_t)&fopen},
-    {"fclose", (uintptr_t)&fclose},
+    {"fopen", (uintptr_t)&fopen_soloader},
+    {"fclose", (uintptr_t)&fclose_soloader},
     {"fread", (uintptr_t)&fread},
     {"fwrite", (uintptr_t)&fwrite},
     {"fseek", (uintptr_t)&fseek},
@@ -278,18 +343,27 @@ so_default_dynlib default_dynlib[] = {
     {"gettimeofday", (uintptr_t)&gettimeofday},
 
     // Threading
-    {"pthread_create", (uintptr_t)&pthread_create},
+    {"pthread_create", (uintptr_t)&pthread_create_soloader},
+    {"pthread_exit", (uintptr_t)&pthread_exit_soloader},
+    {"pthread_setname_np", (uintptr_t)&pthread_setname_np_soloader},
+    {"pthread_attr_init", (uintptr_t)&pthread_attr_init_soloader},
+    {"pthread_attr_destroy", (uintptr_t)&pthread_attr_destroy_soloader},
+    {"pthread_attr_setdetachstate", (uintptr_t)&pthread_attr_setdetachstate_soloader},
+    {"pthread_attr_setstacksize", (uintptr_t)&pthread_attr_setstacksize_soloader},
     {"pthread_join", (uintptr_t)&pthread_join},
     {"pthread_detach", (uintptr_t)&pthread_detach},
-    {"pthread_mutex_init", (uintptr_t)&pthread_mutex_init},
-    {"pthread_mutex_destroy", (uintptr_t)&pthread_mutex_destroy},
-    {"pthread_mutex_lock", (uintptr_t)&pthread_mutex_lock},
-    {"pthread_mutex_unlock", (uintptr_t)&pthread_mutex_unlock},
-    {"pthread_cond_init", (uintptr_t)&pthread_cond_init},
-    {"pthread_cond_destroy", (uintptr_t)&pthread_cond_destroy},
-    {"pthread_cond_wait", (uintptr_t)&pthread_cond_wait},
-    {"pthread_cond_signal", (uintptr_t)&pthread_cond_signal},
-    {"pthread_cond_broadcast", (uintptr_t)&pthread_cond_broadcast},
+    // Bionic mutexes and conds are one word; the shims keep the real object behind it
+    {"pthread_mutex_init", (uintptr_t)&pthread_mutex_init_soloader},
+    {"pthread_mutex_destroy", (uintptr_t)&pthread_mutex_destroy_soloader},
+    {"pthread_mutex_lock", (uintptr_t)&pthread_mutex_lock_soloader},
+    {"pthread_mutex_trylock", (uintptr_t)&pthread_mutex_trylock_soloader},
+    {"pthread_mutex_unlock", (uintptr_t)&pthread_mutex_unlock_soloader},
+    {"pthread_cond_init", (uintptr_t)&pthread_cond_init_soloader},
+    {"pthread_cond_destroy", (uintptr_t)&pthread_cond_destroy_soloader},
+    {"pthread_cond_wait", (uintptr_t)&pthread_cond_wait_soloader},
+    {"pthread_cond_timedwait", (uintptr_t)&pthread_cond_timedwait_soloader},
+    {"pthread_cond_signal", (uintptr_t)&pthread_cond_signal_soloader},
+    {"pthread_cond_broadcast", (uintptr_t)&pthread_cond_broadcast_soloader},
 
     // Error handling
     {"__errno_location", (uintptr_t)&__errno_location},
@@ -326,6 +400,21 @@ so_default_dynlib default_dynlib[] = {
     {"inflateReset", (uintptr_t)&inflateReset},
     {"uncompress", (uintptr_t)&uncompress},
 
+    // Android asset manager
+    {"AAssetManager_open", (uintptr_t)&AAssetManager_open},
+    {"AAssetManager_openDir", (uintptr_t)&AAssetManager_openDir},
+    {"AAsset_close", (uintptr_t)&AAsset_close},
+    {"AAsset_read", (uintptr_t)&AAsset_read},
+    {"AAsset_seek", (uintptr_t)&AAsset_seek},
+    {"AAsset_getLength", (uintptr_t)&AAsset_getLength},
+    {"AAsset_getRemainingLength", (uintptr_t)&AAsset_getRemainingLength},
+    {"AAsset_getBuffer", (uintptr_t)&AAsset_getBuffer},
+    {"AAsset_openFileDescriptor", (uintptr_t)&AAsset_openFileDescriptor},
+    {"AAsset_isAllocated", (uintptr_t)&AAsset_isAllocated},
+    {"AAssetDir_getNextFileName", (uintptr_t)&AAssetDir_getNextFileName},
+    {"AAssetDir_rewind", (uintptr_t)&AAssetDir_rewind},
+    {"AAssetDir_close", (uintptr_t)&AAssetDir_close},
+
     // Dynamic loading
     {"dlopen", (uintptr_t)&dlopen},
     {"dlclose", (uintptr_t)&dlclose},
@@ -333,17 +422,52 @@ so_default_dynlib default_dynlib[] = {
     {"dlerror", (uintptr_t)&dlerror},
 };
 
-void resolve_imports(so_module* mod) {
-    l_info("Resolving imports for Fluffy Diver");
-
+void dynlib_init(void) {
     // Set up fake stdio
     __sF_fake[0] = *stdin;
     __sF_fake[1] = *stdout;
     __sF_fake[2] = *stderr;
 
+#if MEM_POOL
+    // Before anything in the game can allocate
+    mem_pool_init();
+#endif
+
+#if FAST_LIBC
+    // Before dynlib_hash(), so a different choice of imports misses the prelink cache
+    int replaced = 0;
+    for (size_t i = 0; i < sizeof(default_dynlib) / sizeof(so_default_dynlib); i++) {
+        uintptr_t func = fast_libc_import(default_dynlib[i].symbol, (uint32_t)setting_fastImports);
+        if (func) {
+            default_dynlib[i].func = func;
+            replaced++;
+        }
+    }
+    l_info("Fast imports: %d replaced (mask 0x%03X)", replaced, (unsigned)setting_fastImports);
+#endif
+}
+
+void resolve_imports(so_module* mod) {
+    l_info("Resolving imports for Fluffy Diver");
+
     // Resolve symbols using our custom table
-    so_resolve(mod, default_dynlib, sizeof(default_dynlib) / sizeof(so_default_dynlib), 0);
+    // so_resolve takes the table size in bytes
+    so_resolve(mod, default_dynlib, sizeof(default_dynlib), 0);
 
     l_success("Symbol resolution complete - %d symbols resolved",
               (int)(sizeof(default_dynlib) / sizeof(so_default_dynlib)));
 }
+
+uint32_t dynlib_hash(void) {
+    // FNV-1a over every name and address, so a relinked eboot changes it too
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(default_dynlib) / sizeof(so_default_dynlib); i++) {
+        for (const char *c = default_dynlib[i].symbol; *c; c++) {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        }
+        for (int b = 0; b < 4; b++) {
+            hash = (hash ^ ((default_dynlib[i].func >> (b * 8)) & 0xFF)) * 16777619u;
+        }
+    }
+    return hash;
+}
@@ -19,6 +19,7 @@
 #include <math.h>
 #include <libgen.h>
 
+#include "path_map.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
@@ -218,18 +219,12 @@ JNIEXPORT void JNICALL Java_com_hotdog_libraryInterface_hdNativeInterface_SetFil
     l_info("JNI: SetFilePath called with: %s", android_path);
 
     // Convert Android path to Vita path
-    char vita_path[256];
-
-    // Extract just the filename
-    char *filename = basename((char*)android_path);
-
-    // Create full Vita path
-    if (strstr(android_path, "save") || strstr(android_path, "Save")) {
-        // Save data path
-        snprintf(vita_path, sizeof(vita_path), "ux0:data/fluffydiver/save/%s", filename);
-    } else {
-        // General file path
-        snprintf(vita_path, sizeof(vita_path), "ux0:data/fluffydiver/files/%s", filename);
+    char scratch[256];
+    const char *vita_path = path_map_resolve(android_path, scratch, sizeof(scratch));
+    if (!vita_path) {
+        l_error("File path too long: %s", android_path);
+        (*env)->ReleaseStringUTFChars(env, path, (char*)android_path);
+        return;
     }
 
     // Store the path
@@ -255,14 +250,14 @@ JNIEXPORT void JNICALL Java_com_hotdog_libraryInterface_hdNativeInterface_SetRes
 
     l_info("JNI: SetResourcePath called with: %s", android_path);
 
-    // Convert Android resource path to Vita assets path
-    char vita_path[256];
-
-    // Extract filename from path
-    char *filename = basename((char*)android_path);
-
-    // Create Vita assets path
-    snprintf(vita_path, sizeof(vita_path), "ux0:data/fluffydiver/assets/%s", filename);
+    // Resources are looked up by name in the assets directory
+    char scratch[256];
+    const char *vita_path = path_map_asset(basename((char*)android_path), scratch, sizeof(scratch));
+    if (!vita_path) {
+        l_error("Resource path too long: %s", android_path);
+        (*env)->ReleaseStringUTFChars(env, path, (char*)android_path);
+        return;
+    }
 
     // Store the path
     strncpy(fluffy_state.resource_path, vita_path, sizeof(fluffy_state.resource_path) - 1);
@@ -0,0 +1,158 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Frame Pacing
+ *
+ * vitaGL flips on vblank by itself; the pacer only decides how many vblanks
+ * a frame may occupy. After the swap it waits on sceDisplayWaitVblankStartMulti
+ * until the frame's slot has passed, then measures the frame in whole vblanks
+ * from sceDisplayGetVcount. Nothing here sleeps on the process clock, so the
+ * pacer can never end up half a vblank out of phase with the display.
+ *
+ * The game step is that measurement run through an exponential filter and
+ * handed out as integer milliseconds, with the rounding remainder carried to
+ * the next frame so game time does not drift from real time.
+ */
+
+#include <stdint.h>
+#include <psp2/display.h>
+#include <psp2/kernel/processmgr.h>
+
+#include "config.h"
+#include "frame_pacer.h"
+#include "utils/logger.h"
+
+#define PACE_MAX_STEP_VBLANKS 6        // Clamp after loads and other stalls
+#define PACE_SMOOTHING 0.25f           // Weight of the newest frame
+#define PACE_EASE_SMOOTHING 0.08f      // Slower easing in the interpolated mode
+#define PACE_SLOW_FRAMES 3             // Missed slots before dropping to 30
+#define PACE_FAST_FRAMES 60            // Frames with a spare vblank before returning to 60
+
+static struct {
+    frame_pace_mode_t mode;
+    int interval;                       // Vblanks per frame the mode asks for
+    int swap_interval;                  // ...and the floor the game asks for
+    float vblank_ms;
+    unsigned int last_vcount;
+    uint64_t last_present;
+    uint64_t frame_time;
+    float step_ms;                      // Filtered frame length
+    float carry_ms;
+    int delta_ms;
+    int slow_frames;
+    int fast_frames;
+} pacer;
+
+// Function prototypes
+static void adapt_interval(int busy, int elapsed);
+
+int frame_pacer_init(frame_pace_mode_t mode) {
+    float refresh = 0.0f;
+    if (sceDisplayGetRefreshRate(&refresh) < 0 || refresh < 1.0f) {
+        refresh = 59.94f;
+    }
+
+    pacer.vblank_ms = 1000.0f / refresh;
+    pacer.last_vcount = (unsigned int)sceDisplayGetVcount();
+    pacer.last_present = sceKernelGetProcessTimeWide();
+    frame_pacer_set_mode(mode);
+
+    l_success("Frame pacer initialized: %.2f Hz display, mode %d", refresh, (int)mode);
+    return 0;
+}
+
+void frame_pacer_set_mode(frame_pace_mode_t mode) {
+    pacer.mode = mode;
+    pacer.interval = mode == FRAME_PACE_30 ? 2 : 1;
+    pacer.step_ms = pacer.interval * pacer.vblank_ms;
+    pacer.carry_ms = 0.0f;
+    pacer.delta_ms = (int)pacer.step_ms;
+    pacer.slow_frames = 0;
+    pacer.fast_frames = 0;
+}
+
+frame_pace_mode_t frame_pacer_get_mode(void) {
+    return pacer.mode;
+}
+
+void frame_pacer_set_swap_interval(int vblanks) {
+    // vitaGL always flips on vblank, so 0 (no vsync) is as fast as 1
+    if (vblanks < 1) {
+        vblanks = 1;
+    } else if (vblanks > FRAME_PACE_MAX_SWAP_INTERVAL) {
+        vblanks = FRAME_PACE_MAX_SWAP_INTERVAL;
+    }
+
+    if (vblanks != pacer.swap_interval) {
+        pacer.swap_interval = vblanks;
+        l_debug("Frame pacer: game swap interval %d", vblanks);
+    }
+}
+
+void frame_pacer_wait(void) {
+    unsigned int now = (unsigned int)sceDisplayGetVcount();
+    int busy = (int)(now - pacer.last_vcount);
+
+    int remaining = frame_pacer_interval() - busy;
+    if (remaining > 0) {
+        sceDisplayWaitVblankStartMulti(remaining);
+        now = (unsigned int)sceDisplayGetVcount();
+    }
+
+    int elapsed = (int)(now - pacer.last_vcount);
+    if (elapsed < 1) {
+        elapsed = 1;
+    }
+    pacer.last_vcount = now;
+
+    uint64_t present = sceKernelGetProcessTimeWide();
+    pacer.frame_time = present - pacer.last_present;
+    pacer.last_present = present;
+
+    if (pacer.mode == FRAME_PACE_HALF_INTERPOLATED) {
+        adapt_interval(busy, elapsed);
+    }
+
+    // Vblank-quantised length keeps measurement jitter out of the step
+    int vblanks = elapsed < PACE_MAX_STEP_VBLANKS ? elapsed : PACE_MAX_STEP_VBLANKS;
+    float measured = vblanks * pacer.vblank_ms;
+    float weight = pacer.mode == FRAME_PACE_HALF_INTERPOLATED ? PACE_EASE_SMOOTHING : PACE_SMOOTHING;
+    pacer.step_ms += (measured - pacer.step_ms) * weight;
+
+    float step = pacer.step_ms + pacer.carry_ms;
+    pacer.delta_ms = (int)step;
+    pacer.carry_ms = step - pacer.delta_ms;
+}
+
+int frame_pacer_delta_ms(void) {
+    return pacer.delta_ms;
+}
+
+uint64_t frame_pacer_frame_time(void) {
+    return pacer.frame_time;
+}
+
+int frame_pacer_interval(void) {
+    return pacer.interval > pacer.swap_interval ? pacer.interval : pacer.swap_interval;
+}
+
+// ===== ADAPTIVE RATE =====
+
+// busy: vblanks the frame's own work took; elapsed: vblanks it occupied
+static void adapt_interval(int busy, int elapsed) {
+    if (pacer.interval == 1) {
+        pacer.slow_frames = elapsed > 1 ? pacer.slow_frames + 1 : 0;
+        if (pacer.slow_frames >= PACE_SLOW_FRAMES) {
+            pacer.interval = 2;
+            pacer.slow_frames = 0;
+            l_debug("Frame pacer: dropping to half rate");
+        }
+        return;
+    }
+
+    pacer.fast_frames = busy < 1 ? pacer.fast_frames + 1 : 0;
+    if (pacer.fast_frames >= PACE_FAST_FRAMES) {
+        pacer.interval = 1;
+        pacer.fast_frames = 0;
+        l_debug("Frame pacer: back to full rate");
+    }
+}
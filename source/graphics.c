@@ -18,19 +18,51 @@
 #include <string.h>
 #include <math.h>
 
+#include "config.h"
+#include "graphics.h"
+#include "mem_budget.h"
+#include "mem_governor.h"
+#include "perf_hud.h"
+#include "perf_profile.h"
+#include "profiler.h"
+#include "texture_loader.h"
+#include "reimpl/gl_state.h"
+#include "reimpl/gl_batch.h"
+#include "reimpl/gl_atlas.h"
+#include "reimpl/gl_upload.h"
+#include "reimpl/gl_dynres.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
 // Graphics configuration
-#define MEMORY_VITAGL_THRESHOLD_MB 128
 #define VITA_SCREEN_WIDTH 960
 #define VITA_SCREEN_HEIGHT 544
 #define GAME_RENDER_WIDTH 960
 #define GAME_RENDER_HEIGHT 544
 
+// Texture uploads per frame, bounding the GL-thread cost of a burst of loads
+#define TEXTURE_UPLOADS_PER_FRAME 4
+
 // Shader cache configuration
 #define SHADER_CACHE_SIZE 128
+#define SHADER_INDEX_SIZE 256   // Power of two, 2x entries keeps probe chains short
+#define SHADER_PROGRAM_MAX 64
 #define SHADER_CACHE_PATH "ux0:data/fluffydiver/shaders"
+#define PROGRAM_BINARY_MAGIC 0x42504446   // "FDPB"
+#define PROGRAM_BINARY_VERSION 1
+#define PROGRAM_BINARY_MAX (256 * 1024)
+
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+
+// Header of SHADER_CACHE_PATH/<vertex sha1>_<fragment sha1>.bin
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;        // binaryFormat from glGetProgramBinary()
+    uint32_t size;
+} program_binary_header_t;
 
 // Graphics state management
 typedef struct {
@@ -58,27 +90,71 @@ typedef struct {
     int frame_count;
     int last_fps;
     uint64_t last_time;
+    uint64_t frame_start_time;
+    int frame_open;         // Started and not yet presented
 
-    // Shader cache
+    // Shader cache, keyed by the SHA-1 of the source like load_shader() in glutil.c
     struct {
         GLuint shader_id;
-        char hash[64];
+        GLenum type;
+        char hash[41];
+        uint32_t key;
+        int refs;           // Outstanding graphics_load_shader() calls plus live programs
+        int compiled;       // Deferred until a program misses the binary cache
+        uint32_t last_used;
         int used;
     } shader_cache[SHADER_CACHE_SIZE];
+    int16_t shader_index[SHADER_INDEX_SIZE]; // Open addressing over shader_cache, -1 = empty
+    uint32_t shader_clock;
+
+    // Programs from graphics_create_program() and the cache entries they hold
+    struct {
+        GLuint program;
+        int shaders[2];
+    } programs[SHADER_PROGRAM_MAX];
+    int program_binary_hits;
+    int program_binary_misses;
 
 } graphics_state_t;
 
 static graphics_state_t graphics_state = {0};
 
+// Per-frame timings. vitaGL owns the GXM context and the notifications on
+// its scenes, so the first point the port can see a frame finish on the GPU
+// is the display queue callback, which runs on vitaGL's display thread once
+// the scene's fragment work is done. Swaps are matched to callbacks through
+// a small ring of submit times, one writer on each side.
+#define GPU_SUBMIT_RING 4   // Power of two, more than vitaGL's display queue depth
+
+static struct {
+    uint32_t cpu_us[GRAPHICS_STATS_FRAMES];
+    uint32_t gpu_us[GRAPHICS_STATS_FRAMES];
+    volatile uint32_t cpu_frames;       // Written by the render thread
+    volatile uint32_t gpu_frames;       // Written by the display callback
+    uint64_t submit_time[GPU_SUBMIT_RING];
+    volatile uint32_t submitted;
+} frame_timing;
+
 // Forward declarations
 static void initialize_vitagl(void);
 static void setup_opengl_state(void);
 static void probe_gl_capabilities(void);
 static void setup_shader_cache(void);
 static void update_performance_metrics(void);
-static int get_cached_shader(const char *hash);
-static void cache_shader(GLuint shader, const char *hash);
+static void display_callback(void *framebuf);
+static void summarize_timing(const uint32_t *samples, int count, graphics_timing_t *out);
+static uint32_t shader_key(const char *hash, GLenum type);
+static int find_cached_shader(const char *hash, uint32_t key, GLenum type);
+static int find_shader_entry(GLuint shader);
+static int cache_shader(GLuint shader, GLenum type, const char *hash, uint32_t key);
+static int compile_shader(GLuint shader);
+static void program_binary_path(char *path, size_t size, int vertex_entry, int fragment_entry);
+static int load_program_binary(GLuint program, const char *path);
+static void save_program_binary(GLuint program, const char *path);
 static void create_directories(void);
+#if MEM_GOVERNOR
+static size_t purge_shaders(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+#endif
 
 // ===== INITIALIZATION FUNCTIONS =====
 
@@ -99,6 +175,25 @@ int graphics_init(void) {
 
     // Initialize shader cache
     setup_shader_cache();
+#if MEM_GOVERNOR
+    mem_governor_register("shaders", MEM_PRIORITY_SHADERS, 0, purge_shaders);
+#endif
+
+    // Start the texture decoder; uploads are drained in graphics_frame_start()
+    texture_loader_init();
+
+#if GL_SPRITE_BATCH
+    gl_batch_init();
+#endif
+#if GL_SPRITE_ATLAS
+    gl_atlas_init();
+#endif
+#if GL_UPLOAD_FILTER
+    gl_upload_init();
+#endif
+#if DYNAMIC_RESOLUTION
+    gl_dynres_init();
+#endif
 
     // Set up graphics state
     graphics_state.initialized = 1;
@@ -132,30 +227,14 @@ int graphics_init(void) {
 static void initialize_vitagl(void) {
     l_info("Initializing VitaGL with extended configuration");
 
-    // Calculate memory allocation
-    int available_memory = sceKernelGetFreeMemorySize(SCE_KERNEL_MEMBLOCK_TYPE_USER_MAIN_PHYCONT_RW);
-    int vitagl_memory = available_memory / 4; // Use 1/4 of available memory for VitaGL
-
-    if (vitagl_memory < 4 * 1024 * 1024) {
-        vitagl_memory = 4 * 1024 * 1024; // Minimum 4MB
-    }
-
-    l_info("  Available Memory: %d MB", available_memory / (1024 * 1024));
-    l_info("  VitaGL Memory: %d MB", vitagl_memory / (1024 * 1024));
-
-    // Initialize VitaGL with extended configuration for Fluffy Diver
-    vglInitExtended(
-        vitagl_memory,                    // Memory pool size
-        VITA_SCREEN_WIDTH,                // Screen width
-        VITA_SCREEN_HEIGHT,               // Screen height
-        0x1800000,                        // Vertex RAM size (24MB)
-    SCE_GXM_MULTISAMPLE_4X           // Anti-aliasing
-    );
+    // Pools sized from what is free now, MSAA per profile
+    mem_budget_init_gl(VITA_SCREEN_WIDTH, VITA_SCREEN_HEIGHT, perf_profile_msaa());
 
     // Enable advanced features
     vglUseVram(GL_TRUE);                 // Use VRAM for textures
     vglUseExtraMem(GL_TRUE);             // Use extended memory
     vglEnableRuntimeShaderCompiler(GL_TRUE);  // Enable runtime shader compilation
+    vglSetDisplayCallback(display_callback);  // GPU completion timestamps
 
     l_success("VitaGL initialized successfully");
 }
@@ -247,6 +326,9 @@ static void setup_shader_cache(void) {
 
     // Initialize cache
     memset(graphics_state.shader_cache, 0, sizeof(graphics_state.shader_cache));
+    memset(graphics_state.shader_index, 0xFF, sizeof(graphics_state.shader_index));
+    memset(graphics_state.programs, 0, sizeof(graphics_state.programs));
+    graphics_state.shader_clock = 0;
 
     l_success("Shader cache initialized");
 }
@@ -258,6 +340,22 @@ void graphics_frame_start(void) {
         return;
     }
 
+#if GL_STATE_FILTER
+    // The uploads below and other port code bind through vitaGL directly
+    gl_state_begin_frame();
+#endif
+
+    graphics_state.frame_start_time = sceKernelGetProcessTimeWide();
+    graphics_state.frame_open = 1;
+
+    // Upload textures decoded since the last frame
+    texture_loader_process_uploads(TEXTURE_UPLOADS_PER_FRAME);
+
+#if DYNAMIC_RESOLUTION
+    // The game draws into the scaled target; the clear below is for it
+    gl_dynres_begin_frame();
+#endif
+
     // Clear buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -266,12 +364,40 @@ void graphics_frame_start(void) {
 }
 
 void graphics_frame_end(void) {
-    if (!graphics_state.initialized) {
+    // An eglSwapBuffers() from the game has already presented this frame
+    if (!graphics_state.initialized || !graphics_state.frame_open) {
         return;
     }
+    graphics_state.frame_open = 0;
+
+#if GL_SPRITE_BATCH
+    // Draw the last batch of the frame
+    gl_batch_end_frame();
+#endif
+#if GL_UPLOAD_FILTER
+    gl_upload_end_frame();
+#endif
 
-    // Present frame
-    vglSwapBuffers(graphics_state.vsync_enabled ? GL_TRUE : GL_FALSE);
+#if DYNAMIC_RESOLUTION
+    // Upscale to the screen; the HUD is drawn over it at native size
+    gl_dynres_end_frame();
+#endif
+
+#if PERF_HUD
+    perf_hud_draw();
+#endif
+
+    // Present frame; vitaGL flips on vblank, the frame pacer holds the rate
+    vglSwapBuffers(GL_FALSE);
+
+    uint64_t submit = sceKernelGetProcessTimeWide();
+    uint32_t frame = frame_timing.cpu_frames;
+    frame_timing.cpu_us[frame % GRAPHICS_STATS_FRAMES] = (uint32_t)(submit - graphics_state.frame_start_time);
+    __atomic_store_n(&frame_timing.cpu_frames, frame + 1, __ATOMIC_RELEASE);
+
+    uint32_t slot = frame_timing.submitted;
+    frame_timing.submit_time[slot & (GPU_SUBMIT_RING - 1)] = submit;
+    __atomic_store_n(&frame_timing.submitted, slot + 1, __ATOMIC_RELEASE);
 
     // Increment frame counter
     graphics_state.frame_count++;
@@ -284,15 +410,28 @@ GLuint graphics_load_shader(GLenum type, const char *source) {
         return 0;
     }
 
-    // Create shader hash for caching
-    char hash[64];
-    snprintf(hash, sizeof(hash), "%08x_%d", (unsigned int)((uintptr_t)source % 0xFFFFFFFF), type);
+    if (!source) {
+        return 0;
+    }
+
+    // Key on the source text, so equal sources share a shader wherever they live
+    char *sha = str_sha1sum(source, strlen(source));
+    if (!sha) {
+        return 0;
+    }
+    char hash[41];
+    strncpy(hash, sha, sizeof(hash) - 1);
+    hash[sizeof(hash) - 1] = '\0';
+    free(sha);
+    uint32_t key = shader_key(hash, type);
 
     // Check cache first
-    int cached_shader = get_cached_shader(hash);
-    if (cached_shader > 0) {
+    int cached = find_cached_shader(hash, key, type);
+    if (cached >= 0) {
+        graphics_state.shader_cache[cached].refs++;
+        graphics_state.shader_cache[cached].last_used = ++graphics_state.shader_clock;
         l_debug("Using cached shader: %s", hash);
-        return cached_shader;
+        return graphics_state.shader_cache[cached].shader_id;
     }
 
     // Create new shader
@@ -305,6 +444,23 @@ GLuint graphics_load_shader(GLenum type, const char *source) {
     // Set shader source
     glShaderSource(shader, 1, &source, NULL);
 
+    // Cache the shader; the caller holds the first reference. Cached shaders
+    // compile only if a program using them has no stored binary.
+    if (cache_shader(shader, type, hash, key) < 0) {
+        l_warn("Shader cache full of referenced shaders, %s is uncached", hash);
+        if (compile_shader(shader) < 0) {
+            glDeleteShader(shader);
+            return 0;
+        }
+        l_debug("Compiled shader: %s", hash);
+    }
+
+    return shader;
+}
+
+static int compile_shader(GLuint shader) {
+    PROF_SCOPE("compile_shader");
+
     // Compile shader
     glCompileShader(shader);
 
@@ -322,16 +478,10 @@ GLuint graphics_load_shader(GLenum type, const char *source) {
             l_error("Shader compilation error: %s", infoLog);
             free(infoLog);
         }
-
-        glDeleteShader(shader);
-        return 0;
+        return -1;
     }
 
-    // Cache the shader
-    cache_shader(shader, hash);
-
-    l_debug("Compiled shader: %s", hash);
-    return shader;
+    return 0;
 }
 
 GLuint graphics_create_program(GLuint vertex_shader, GLuint fragment_shader) {
@@ -346,16 +496,52 @@ GLuint graphics_create_program(GLuint vertex_shader, GLuint fragment_shader) {
         return 0;
     }
 
-    // Attach shaders
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
+    int vertex_entry = find_shader_entry(vertex_shader);
+    int fragment_entry = find_shader_entry(fragment_shader);
 
-    // Link program
-    glLinkProgram(program);
+    // A stored binary for this source pair skips both compiles and the link
+    char binary_path[256] = "";
+    if (vertex_entry >= 0 && fragment_entry >= 0) {
+        program_binary_path(binary_path, sizeof(binary_path), vertex_entry, fragment_entry);
+    }
 
-    // Check link status
-    GLint linked;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    GLint linked = 0;
+    if (binary_path[0] && load_program_binary(program, binary_path) == 0) {
+        graphics_state.program_binary_hits++;
+        linked = 1;
+    } else {
+        graphics_state.program_binary_misses++;
+
+        int entries[2] = { vertex_entry, fragment_entry };
+        for (int i = 0; i < 2; i++) {
+            int entry = entries[i];
+            if (entry < 0 || graphics_state.shader_cache[entry].compiled) {
+                continue;
+            }
+            if (compile_shader(graphics_state.shader_cache[entry].shader_id) < 0) {
+                glDeleteProgram(program);
+                return 0;
+            }
+            graphics_state.shader_cache[entry].compiled = 1;
+            l_debug("Compiled shader: %s", graphics_state.shader_cache[entry].hash);
+        }
+
+        // Attach shaders
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+
+        // Link program
+        PROF_BEGIN(link_zone, "link_program");
+        glLinkProgram(program);
+        PROF_END(link_zone);
+
+        // Check link status
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+        if (linked && binary_path[0]) {
+            save_program_binary(program, binary_path);
+        }
+    }
 
     if (!linked) {
         GLint infoLen;
@@ -372,40 +558,158 @@ GLuint graphics_create_program(GLuint vertex_shader, GLuint fragment_shader) {
         return 0;
     }
 
+    // The program keeps its shaders referenced so eviction leaves them alone
+    int slot = -1;
+    for (int i = 0; i < SHADER_PROGRAM_MAX; i++) {
+        if (graphics_state.programs[i].program == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    int entries[2] = { vertex_entry, fragment_entry };
+    for (int i = 0; i < 2; i++) {
+        int entry = entries[i];
+        if (entry >= 0) {
+            graphics_state.shader_cache[entry].refs++;
+        }
+        if (slot >= 0) {
+            graphics_state.programs[slot].shaders[i] = entry;
+        }
+    }
+
+    if (slot >= 0) {
+        graphics_state.programs[slot].program = program;
+    } else {
+        // Untracked programs pin their shaders for good, which is still safe
+        l_warn("Program table full, shaders of program %d stay pinned", program);
+    }
+
     l_debug("Created program: %d", program);
     return program;
 }
 
+// ===== PROGRAM BINARY CACHE =====
+
+static void program_binary_path(char *path, size_t size, int vertex_entry, int fragment_entry) {
+    snprintf(path, size, SHADER_CACHE_PATH "/%s_%s.bin",
+             graphics_state.shader_cache[vertex_entry].hash,
+             graphics_state.shader_cache[fragment_entry].hash);
+}
+
+static int load_program_binary(GLuint program, const char *path) {
+    if (!file_exists(path)) {
+        return -1;
+    }
+
+    uint8_t *buffer = NULL;
+    size_t size = 0;
+    if (!file_load(path, &buffer, &size)) {
+        return -1;
+    }
+
+    program_binary_header_t header;
+    int valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, buffer, sizeof(header));
+        valid = header.magic == PROGRAM_BINARY_MAGIC && header.version == PROGRAM_BINARY_VERSION &&
+                header.size == size - sizeof(header);
+    }
+
+    GLint linked = 0;
+    if (valid) {
+        glProgramBinary(program, header.format, buffer + sizeof(header), header.size);
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    free(buffer);
+
+    if (!linked) {
+        // Truncated file or a binary from another vitaGL build: relink and rewrite
+        l_warn("Discarding stale program binary: %s", path);
+        sceIoRemove(path);
+        return -1;
+    }
+
+    l_debug("Restored linked program from %s", path);
+    return 0;
+}
+
+static void save_program_binary(GLuint program, const char *path) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || length > PROGRAM_BINARY_MAX) {
+        length = PROGRAM_BINARY_MAX;
+    }
+
+    uint8_t *buffer = malloc(sizeof(program_binary_header_t) + length);
+    if (!buffer) {
+        return;
+    }
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, buffer + sizeof(program_binary_header_t));
+    if (written > 0) {
+        program_binary_header_t header = { PROGRAM_BINARY_MAGIC, PROGRAM_BINARY_VERSION, format, (uint32_t)written };
+        memcpy(buffer, &header, sizeof(header));
+        file_save(path, buffer, sizeof(header) + written);
+        l_debug("Stored program binary: %s (%d bytes)", path, written);
+    }
+    free(buffer);
+}
+
+void graphics_release_shader(GLuint shader) {
+    int entry = find_shader_entry(shader);
+    if (entry < 0) {
+        // Never made it into the cache, so the caller was its only owner
+        glDeleteShader(shader);
+        return;
+    }
+
+    if (graphics_state.shader_cache[entry].refs > 0) {
+        graphics_state.shader_cache[entry].refs--;
+    }
+}
+
+void graphics_delete_program(GLuint program) {
+    if (program == 0) {
+        return;
+    }
+
+    for (int i = 0; i < SHADER_PROGRAM_MAX; i++) {
+        if (graphics_state.programs[i].program != program) {
+            continue;
+        }
+        for (int j = 0; j < 2; j++) {
+            int entry = graphics_state.programs[i].shaders[j];
+            if (entry >= 0 && graphics_state.shader_cache[entry].refs > 0) {
+                graphics_state.shader_cache[entry].refs--;
+            }
+        }
+        graphics_state.programs[i].program = 0;
+        break;
+    }
+
+    glDeleteProgram(program);
+}
+
 // ===== TEXTURE MANAGEMENT =====
 
-GLuint graphics_load_texture(const char *path __attribute__((unused))) {
-    if (!graphics_state.initialized) {
+GLuint graphics_load_texture(const char *path) {
+    if (!graphics_state.initialized || !path) {
         return 0;
     }
 
-    // This is a stub - actual implementation would load texture from file
-    // In the real implementation, this would handle various formats:
-    // - PNG files from assets
-    // - Compressed textures (.pvr, .dds)
-    // - Game-specific formats from asset_handler.c
+    // The loader takes asset-relative paths
+    size_t prefix = strlen(ASSETS_PATH);
+    if (strncmp(path, ASSETS_PATH, prefix) == 0 && path[prefix] == '/') {
+        path += prefix + 1;
+    }
 
     l_debug("Loading texture: %s", path);
 
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    // Set default texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // TODO: Load actual texture data from file
-    // For now, create a dummy 64x64 white texture
-    unsigned char white_data[64 * 64 * 4];
-    memset(white_data, 255, sizeof(white_data));
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 64, 64, 0, GL_RGBA, GL_UNSIGNED_BYTE, white_data);
+    // Returns at once with a placeholder; the decode runs off the GL thread
+    GLuint texture = texture_loader_load(path);
 
     l_debug("Created texture: %d", texture);
     return texture;
@@ -423,7 +727,20 @@ static void update_performance_metrics(void) {
         graphics_state.frame_count = 0;
         graphics_state.last_time = current_time;
 
+#if GL_STATE_FILTER
+        gl_state_stats_t stats;
+        gl_state_get_stats(&stats);
+        l_debug("FPS: %d (draws: %d, GL state calls: %d, filtered: %d)",
+                graphics_state.last_fps, stats.draws, stats.state_calls, stats.filtered);
+#else
         l_debug("FPS: %d", graphics_state.last_fps);
+#endif
+
+        graphics_frame_stats_t frame_stats;
+        graphics_get_frame_stats(&frame_stats);
+        l_debug("Frame CPU %.2f/%.2f ms, GPU %.2f/%.2f ms (avg/p99)",
+                frame_stats.cpu.avg_ms, frame_stats.cpu.p99_ms,
+                frame_stats.gpu.avg_ms, frame_stats.gpu.p99_ms);
     }
 }
 
@@ -431,43 +748,212 @@ int graphics_get_fps(void) {
     return graphics_state.last_fps;
 }
 
+void graphics_get_frame_stats(graphics_frame_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    uint32_t cpu_frames = __atomic_load_n(&frame_timing.cpu_frames, __ATOMIC_ACQUIRE);
+    uint32_t gpu_frames = __atomic_load_n(&frame_timing.gpu_frames, __ATOMIC_ACQUIRE);
+    int cpu_count = cpu_frames < GRAPHICS_STATS_FRAMES ? (int)cpu_frames : GRAPHICS_STATS_FRAMES;
+    int gpu_count = gpu_frames < GRAPHICS_STATS_FRAMES ? (int)gpu_frames : GRAPHICS_STATS_FRAMES;
+
+    stats->frames = cpu_count;
+    summarize_timing(frame_timing.cpu_us, cpu_count, &stats->cpu);
+    summarize_timing(frame_timing.gpu_us, gpu_count, &stats->gpu);
+}
+
+int graphics_get_gpu_times(uint32_t *out, int max) {
+    uint32_t gpu_frames = __atomic_load_n(&frame_timing.gpu_frames, __ATOMIC_ACQUIRE);
+    int count = gpu_frames < GRAPHICS_STATS_FRAMES ? (int)gpu_frames : GRAPHICS_STATS_FRAMES;
+    count = MIN(count, max);
+    for (int i = 0; i < count; i++) {
+        out[i] = frame_timing.gpu_us[(gpu_frames - 1 - i) % GRAPHICS_STATS_FRAMES];
+    }
+    return count;
+}
+
+// vitaGL's display thread: the oldest outstanding swap has finished rendering
+static void display_callback(void *framebuf __attribute__((unused))) {
+    uint64_t now = sceKernelGetProcessTimeWide();
+    uint32_t frame = frame_timing.gpu_frames;
+    if (frame == __atomic_load_n(&frame_timing.submitted, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    uint64_t submit = frame_timing.submit_time[frame & (GPU_SUBMIT_RING - 1)];
+    frame_timing.gpu_us[frame % GRAPHICS_STATS_FRAMES] = now > submit ? (uint32_t)(now - submit) : 0;
+    __atomic_store_n(&frame_timing.gpu_frames, frame + 1, __ATOMIC_RELEASE);
+}
+
+static void summarize_timing(const uint32_t *samples, int count, graphics_timing_t *out) {
+    if (count <= 0) {
+        out->min_ms = out->avg_ms = out->p99_ms = 0.0f;
+        return;
+    }
+
+    // 120 samples: an insertion sort on a copy is plenty
+    uint32_t sorted[GRAPHICS_STATS_FRAMES];
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t value = samples[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+        sum += value;
+    }
+
+    int p99 = (count * 99 + 99) / 100 - 1;
+    out->min_ms = sorted[0] / 1000.0f;
+    out->avg_ms = (float)sum / count / 1000.0f;
+    out->p99_ms = sorted[p99] / 1000.0f;
+}
+
 // ===== UTILITY FUNCTIONS =====
 
-static int get_cached_shader(const char *hash) {
+// Top 32 bits of the SHA-1 are already uniform; fold in the type
+static uint32_t shader_key(const char *hash, GLenum type) {
+    uint32_t key = 0;
+    for (int i = 0; i < 8 && hash[i]; i++) {
+        char c = hash[i];
+        key = (key << 4) | (uint32_t)(c <= '9' ? c - '0' : c - 'A' + 10);
+    }
+    return key ^ type;
+}
+
+static int find_cached_shader(const char *hash, uint32_t key, GLenum type) {
+    for (int probe = 0; probe < SHADER_INDEX_SIZE; probe++) {
+        int slot = (key + probe) & (SHADER_INDEX_SIZE - 1);
+        int entry = graphics_state.shader_index[slot];
+        if (entry < 0) {
+            return -1;
+        }
+        if (graphics_state.shader_cache[entry].key == key &&
+            graphics_state.shader_cache[entry].type == type &&
+            strcmp(graphics_state.shader_cache[entry].hash, hash) == 0) {
+            return entry;
+        }
+    }
+    return -1;
+}
+
+static int find_shader_entry(GLuint shader) {
+    if (shader == 0) {
+        return -1;
+    }
     for (int i = 0; i < SHADER_CACHE_SIZE; i++) {
-        if (graphics_state.shader_cache[i].used &&
-            strcmp(graphics_state.shader_cache[i].hash, hash) == 0) {
-            return graphics_state.shader_cache[i].shader_id;
-            }
+        if (graphics_state.shader_cache[i].used && graphics_state.shader_cache[i].shader_id == shader) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void shader_index_insert(int entry) {
+    uint32_t key = graphics_state.shader_cache[entry].key;
+    for (int probe = 0; probe < SHADER_INDEX_SIZE; probe++) {
+        int slot = (key + probe) & (SHADER_INDEX_SIZE - 1);
+        if (graphics_state.shader_index[slot] < 0) {
+            graphics_state.shader_index[slot] = entry;
+            return;
+        }
     }
-    return 0;
 }
 
-static void cache_shader(GLuint shader, const char *hash) {
+// Linear-probing delete with backward shift, as in the asset cache index
+static void shader_index_remove(int entry) {
+    int slot = graphics_state.shader_cache[entry].key & (SHADER_INDEX_SIZE - 1);
+    while (graphics_state.shader_index[slot] != entry) {
+        if (graphics_state.shader_index[slot] < 0) {
+            return;
+        }
+        slot = (slot + 1) & (SHADER_INDEX_SIZE - 1);
+    }
+
+    int hole = slot;
+    graphics_state.shader_index[hole] = -1;
+    for (int next = (hole + 1) & (SHADER_INDEX_SIZE - 1); graphics_state.shader_index[next] >= 0;
+         next = (next + 1) & (SHADER_INDEX_SIZE - 1)) {
+        int home = graphics_state.shader_cache[graphics_state.shader_index[next]].key & (SHADER_INDEX_SIZE - 1);
+        int distance_hole = (hole - home) & (SHADER_INDEX_SIZE - 1);
+        int distance_next = (next - home) & (SHADER_INDEX_SIZE - 1);
+        if (distance_hole < distance_next) {
+            graphics_state.shader_index[hole] = graphics_state.shader_index[next];
+            graphics_state.shader_index[next] = -1;
+            hole = next;
+        }
+    }
+}
+
+static int cache_shader(GLuint shader, GLenum type, const char *hash, uint32_t key) {
+    int entry = -1;
     for (int i = 0; i < SHADER_CACHE_SIZE; i++) {
         if (!graphics_state.shader_cache[i].used) {
-            graphics_state.shader_cache[i].shader_id = shader;
-            strncpy(graphics_state.shader_cache[i].hash, hash, sizeof(graphics_state.shader_cache[i].hash) - 1);
-            graphics_state.shader_cache[i].used = 1;
-            return;
+            entry = i;
+            break;
         }
     }
 
-    // Cache full, replace oldest entry (simple FIFO)
-    static int next_cache_index = 0;
-    int index = next_cache_index % SHADER_CACHE_SIZE;
+    // Cache full: evict the least recently used shader nobody references
+    if (entry < 0) {
+        uint32_t oldest = 0;
+        for (int i = 0; i < SHADER_CACHE_SIZE; i++) {
+            if (graphics_state.shader_cache[i].refs == 0 &&
+                (entry < 0 || graphics_state.shader_clock - graphics_state.shader_cache[i].last_used > oldest)) {
+                entry = i;
+                oldest = graphics_state.shader_clock - graphics_state.shader_cache[i].last_used;
+            }
+        }
+        if (entry < 0) {
+            return -1;
+        }
 
-    if (graphics_state.shader_cache[index].used) {
-        glDeleteShader(graphics_state.shader_cache[index].shader_id);
+        l_debug("Evicting cached shader: %s", graphics_state.shader_cache[entry].hash);
+        shader_index_remove(entry);
+        glDeleteShader(graphics_state.shader_cache[entry].shader_id);
     }
 
-    graphics_state.shader_cache[index].shader_id = shader;
-    strncpy(graphics_state.shader_cache[index].hash, hash, sizeof(graphics_state.shader_cache[index].hash) - 1);
-    graphics_state.shader_cache[index].hash[sizeof(graphics_state.shader_cache[index].hash) - 1] = '\0';
-    graphics_state.shader_cache[index].used = 1;
+    graphics_state.shader_cache[entry].shader_id = shader;
+    graphics_state.shader_cache[entry].type = type;
+    strncpy(graphics_state.shader_cache[entry].hash, hash, sizeof(graphics_state.shader_cache[entry].hash) - 1);
+    graphics_state.shader_cache[entry].hash[sizeof(graphics_state.shader_cache[entry].hash) - 1] = '\0';
+    graphics_state.shader_cache[entry].key = key;
+    graphics_state.shader_cache[entry].refs = 1;
+    graphics_state.shader_cache[entry].compiled = 0;
+    graphics_state.shader_cache[entry].last_used = ++graphics_state.shader_clock;
+    graphics_state.shader_cache[entry].used = 1;
+    shader_index_insert(entry);
+    return entry;
+}
+
+#if MEM_GOVERNOR
+// vitaGL doesn't report what a shader holds (source, GXP binary, patcher
+// programs); a rough figure is enough for the governor to move on
+#define SHADER_PURGE_BYTES (16 * 1024)
+
+// Governor purge, critical pressure only: a dropped shader costs a recompile
+// (or a binary load) the next time the game asks for it
+static size_t purge_shaders(mem_kind_t kind, mem_pressure_t pressure, size_t wanted) {
+    if (kind != MEM_KIND_HEAP || pressure != MEM_PRESSURE_CRITICAL) {
+        return 0;
+    }
 
-    next_cache_index++;
+    size_t freed = 0;
+    for (int i = 0; i < SHADER_CACHE_SIZE && freed < wanted; i++) {
+        if (!graphics_state.shader_cache[i].used || graphics_state.shader_cache[i].refs > 0) {
+            continue;
+        }
+        shader_index_remove(i);
+        glDeleteShader(graphics_state.shader_cache[i].shader_id);
+        graphics_state.shader_cache[i].used = 0;
+        freed += SHADER_PURGE_BYTES;
+    }
+    return freed;
 }
+#endif
 
 static void create_directories(void) {
     // Create necessary directories
@@ -509,6 +995,22 @@ void graphics_cleanup(void) {
 
     l_info("Cleaning up graphics system");
 
+    // Stop the texture decoder before the GL context goes away
+    texture_loader_shutdown();
+
+#if GL_SPRITE_BATCH
+    gl_batch_shutdown();
+#endif
+#if GL_SPRITE_ATLAS
+    gl_atlas_shutdown();
+#endif
+#if GL_UPLOAD_FILTER
+    gl_upload_shutdown();
+#endif
+#if DYNAMIC_RESOLUTION
+    gl_dynres_shutdown();
+#endif
+
     // Clean up shader cache
     for (int i = 0; i < SHADER_CACHE_SIZE; i++) {
         if (graphics_state.shader_cache[i].used) {
@@ -517,6 +1019,7 @@ void graphics_cleanup(void) {
     }
 
     // Cleanup VitaGL
+    mem_budget_report();
     vglEnd();
 
     graphics_state.initialized = 0;
@@ -528,6 +1031,7 @@ void graphics_cleanup(void) {
 
 void graphics_set_vsync(int enabled) {
     graphics_state.vsync_enabled = enabled;
+    vglWaitVblankStart(enabled ? GL_TRUE : GL_FALSE);
     l_info("VSync %s", enabled ? "enabled" : "disabled");
 }
 
@@ -551,6 +1055,10 @@ void graphics_enable_gles1_compatibility(void) {
     glEnable(GL_TEXTURE_2D);
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+#if GL_SPRITE_BATCH
+    gl_batch_client_state(GL_VERTEX_ARRAY, 1);
+    gl_batch_client_state(GL_TEXTURE_COORD_ARRAY, 1);
+#endif
 
     l_info("OpenGL ES 1.x compatibility enabled");
 }
@@ -564,6 +1072,10 @@ void graphics_enable_gles2_compatibility(void) {
     // Just ensure proper state
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+#if GL_SPRITE_BATCH
+    gl_batch_client_state(GL_VERTEX_ARRAY, 0);
+    gl_batch_client_state(GL_TEXTURE_COORD_ARRAY, 0);
+#endif
 
     l_info("OpenGL ES 2.x compatibility enabled");
 }
@@ -589,6 +1101,28 @@ void graphics_debug_info(void) {
     l_info("  Max Texture Size: %d", graphics_state.max_texture_size);
     l_info("  Max Texture Units: %d", graphics_state.max_texture_units);
 
+#if GL_STATE_FILTER
+    gl_state_stats_t stats;
+    gl_state_get_stats(&stats);
+    l_info("  Draw Calls (last frame): %d", stats.draws);
+    l_info("  GL State Calls Filtered: %d of %d", stats.filtered, stats.state_calls);
+#endif
+#if GL_SPRITE_BATCH
+    gl_batch_stats_t batch_stats;
+    gl_batch_get_stats(&batch_stats);
+    l_info("  Sprite Batching: %d draws in %d batches", batch_stats.draws, batch_stats.batches);
+#endif
+#if GL_SPRITE_ATLAS
+    gl_atlas_stats_t atlas_stats;
+    gl_atlas_get_stats(&atlas_stats);
+    l_info("  Sprite Atlas: %d sprites on %d pages, %d didn't fit", atlas_stats.sprites, atlas_stats.pages, atlas_stats.rejected);
+#endif
+#if GL_UPLOAD_FILTER
+    gl_upload_stats_t upload_stats;
+    gl_upload_get_stats(&upload_stats);
+    l_info("  Texture Uploads Dropped: %d of %d", upload_stats.dropped, upload_stats.uploads);
+#endif
+
     // Memory information
     SceKernelFreeMemorySizeInfo info;
     sceKernelGetFreeMemorySize(&info);
@@ -602,4 +1136,6 @@ void graphics_debug_info(void) {
         }
     }
     l_info("  Cached Shaders: %d/%d", cached_shaders, SHADER_CACHE_SIZE);
+    l_info("  Program Binaries: %d restored, %d linked", graphics_state.program_binary_hits,
+           graphics_state.program_binary_misses);
 }
@@ -0,0 +1,246 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Streaming HGG Decoder
+ *
+ * Two chunk buffers are passed between the reading thread and the decoder
+ * thread: while chunk N is being inflated, chunk N+1 is being read. One
+ * decode runs at a time; concurrent callers queue on decode_lock.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "hgg_decoder.h"
+#include "utils/logger.h"
+
+#define HGG_CHUNK_SIZE (128 * 1024)
+#define HGG_CHUNK_COUNT 2
+#define HGG_DECODER_PRIORITY 160
+#define HGG_DECODER_AFFINITY 0x40000  // Core 2, next to the asset workers
+#define HGG_DECODER_STACK_SIZE (32 * 1024)
+
+typedef struct {
+    uint8_t data[HGG_CHUNK_SIZE];
+    int length;                    // 0 marks the end of the stream
+} hgg_chunk_t;
+
+typedef struct {
+    z_stream stream;
+    uint8_t *dest;
+    size_t dest_size;
+    int status;                    // Z_OK while running, Z_STREAM_END when complete
+} hgg_job_t;
+
+static hgg_chunk_t *chunks = NULL;
+static hgg_job_t job;
+static SceKernelLwMutexWork decode_lock;
+static SceUID free_sema = -1;      // Chunks the reader may fill
+static SceUID full_sema = -1;      // Chunks the decoder may inflate
+static SceUID done_sema = -1;
+static SceUID decoder_thread = -1;
+static volatile int decoder_running = 0;
+static int fill_index = 0;         // Persist across decodes so both sides stay in step
+static int decode_index = 0;
+
+// Function prototypes
+static int hgg_decoder_func(SceSize args, void *argp);
+static void inflate_chunk(const uint8_t *data, int length);
+
+int hgg_decoder_init(void) {
+    if (decoder_running) {
+        return 0;
+    }
+
+    chunks = malloc(sizeof(hgg_chunk_t) * HGG_CHUNK_COUNT);
+    if (!chunks) {
+        l_error("Failed to allocate HGG chunk buffers");
+        return -1;
+    }
+
+    sceKernelCreateLwMutex(&decode_lock, "hgg_decode_lock", 0, 0, NULL);
+    free_sema = sceKernelCreateSema("hgg_free", 0, HGG_CHUNK_COUNT, HGG_CHUNK_COUNT, NULL);
+    full_sema = sceKernelCreateSema("hgg_full", 0, 0, HGG_CHUNK_COUNT, NULL);
+    done_sema = sceKernelCreateSema("hgg_done", 0, 0, 1, NULL);
+
+    decoder_running = 1;
+    decoder_thread = sceKernelCreateThread("hgg_decoder", hgg_decoder_func, HGG_DECODER_PRIORITY,
+                                           HGG_DECODER_STACK_SIZE, 0, HGG_DECODER_AFFINITY, NULL);
+    if (decoder_thread < 0) {
+        // hgg_decode() still works, it just inflates on the calling thread
+        l_warn("Failed to create HGG decoder thread: 0x%08X", decoder_thread);
+        decoder_running = 0;
+        return -1;
+    }
+
+    sceKernelStartThread(decoder_thread, 0, NULL);
+    l_success("HGG decoder thread started");
+    return 0;
+}
+
+void hgg_decoder_shutdown(void) {
+    if (decoder_running) {
+        decoder_running = 0;
+        sceKernelSignalSema(full_sema, 1);
+        sceKernelWaitThreadEnd(decoder_thread, NULL, NULL);
+        decoder_thread = -1;
+    }
+
+    if (chunks) {
+        sceKernelDeleteSema(free_sema);
+        sceKernelDeleteSema(full_sema);
+        sceKernelDeleteSema(done_sema);
+        sceKernelDeleteLwMutex(&decode_lock);
+        free(chunks);
+        chunks = NULL;
+    }
+}
+
+int hgg_is_compressed(const void *header, size_t size) {
+    if (!header || size < HGG_HEADER_SIZE) {
+        return 0;
+    }
+
+    return memcmp(header, HGG_SIGNATURE, HGG_SIGNATURE_SIZE) == 0;
+}
+
+int hgg_decode(hgg_read_fn read, void *ctx, size_t src_size, void **out, size_t *out_size) {
+    uint32_t header[2];
+    if (src_size < HGG_HEADER_SIZE || read(ctx, header, 0, HGG_HEADER_SIZE) != HGG_HEADER_SIZE ||
+        !hgg_is_compressed(header, HGG_HEADER_SIZE)) {
+        return -1;
+    }
+
+    // Allocated once up front; the stream is inflated straight into it
+    size_t raw_size = header[1];
+    uint8_t *dest = malloc(raw_size ? raw_size : 1);
+    if (!dest) {
+        l_error("Out of memory for %zu byte HGG payload", raw_size);
+        return -1;
+    }
+
+    int threaded = decoder_running;
+    if (threaded) {
+        sceKernelLockLwMutex(&decode_lock, 1, NULL);
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.dest = dest;
+    job.dest_size = raw_size;
+    job.stream.next_out = dest;
+    job.stream.avail_out = raw_size;
+    job.status = inflateInit(&job.stream);
+
+    int read_failed = 0;
+    if (threaded) {
+        size_t offset = HGG_HEADER_SIZE;
+        for (;;) {
+            sceKernelWaitSema(free_sema, 1, NULL);
+
+            hgg_chunk_t *chunk = &chunks[fill_index];
+            size_t count = src_size - offset;
+            if (count > HGG_CHUNK_SIZE) count = HGG_CHUNK_SIZE;
+
+            chunk->length = 0;
+            if (count > 0 && !read_failed) {
+                int got = read(ctx, chunk->data, offset, count);
+                if (got > 0) {
+                    chunk->length = got;
+                    offset += got;
+                } else {
+                    read_failed = 1;
+                }
+            }
+
+            int length = chunk->length;
+            sceKernelSignalSema(full_sema, 1);
+            fill_index = (fill_index + 1) % HGG_CHUNK_COUNT;
+            if (length == 0) {
+                break;
+            }
+        }
+
+        sceKernelWaitSema(done_sema, 1, NULL);
+    } else {
+        // No decoder thread: same chunked inflate, just serially
+        uint8_t *buffer = malloc(HGG_CHUNK_SIZE);
+        size_t offset = HGG_HEADER_SIZE;
+        while (buffer && offset < src_size && job.status == Z_OK) {
+            size_t count = src_size - offset;
+            if (count > HGG_CHUNK_SIZE) count = HGG_CHUNK_SIZE;
+            int got = read(ctx, buffer, offset, count);
+            if (got <= 0) {
+                read_failed = 1;
+                break;
+            }
+            inflate_chunk(buffer, got);
+            offset += got;
+        }
+        read_failed |= !buffer;
+        free(buffer);
+    }
+
+    int status = job.status;
+    size_t produced = job.stream.total_out;
+    inflateEnd(&job.stream);
+
+    if (threaded) {
+        sceKernelUnlockLwMutex(&decode_lock, 1);
+    }
+
+    if (read_failed || status != Z_STREAM_END || produced != raw_size) {
+        l_error("HGG decode failed (status %d, %zu/%zu bytes)", status, produced, raw_size);
+        free(dest);
+        return -1;
+    }
+
+    *out = dest;
+    *out_size = raw_size;
+    return 0;
+}
+
+// ===== DECODER THREAD =====
+
+static void inflate_chunk(const uint8_t *data, int length) {
+    if (job.status != Z_OK) {
+        return;
+    }
+
+    job.stream.next_in = (Bytef *)data;
+    job.stream.avail_in = length;
+    while (job.stream.avail_in > 0 && job.status == Z_OK) {
+        int ret = inflate(&job.stream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            job.status = Z_STREAM_END;
+        } else if (ret != Z_OK) {
+            // Z_BUF_ERROR here means the header's size was too small
+            job.status = ret;
+        }
+    }
+}
+
+static int hgg_decoder_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    while (1) {
+        sceKernelWaitSema(full_sema, 1, NULL);
+        if (!decoder_running) {
+            break;
+        }
+
+        hgg_chunk_t *chunk = &chunks[decode_index];
+        decode_index = (decode_index + 1) % HGG_CHUNK_COUNT;
+
+        if (chunk->length == 0) {
+            sceKernelSignalSema(free_sema, 1);
+            sceKernelSignalSema(done_sema, 1);
+            continue;
+        }
+
+        inflate_chunk(chunk->data, chunk->length);
+        sceKernelSignalSema(free_sema, 1);
+    }
+
+    return sceKernelExitDeleteThread(0);
+}
@@ -0,0 +1,186 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Input Sampling
+ *
+ * The ring is written only by the sampling thread and read only by the game
+ * loop, so head and tail each have one writer and need nothing beyond
+ * acquire/release ordering. A full ring drops the newest event rather than
+ * blocking the sampler.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <psp2/ctrl.h>
+#include <psp2/touch.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "input.h"
+#include "utils/logger.h"
+
+#define INPUT_THREAD_PRIORITY 96        // Above the game; the thread sleeps in the driver
+#define INPUT_THREAD_AFFINITY 0x40000   // Core 2
+#define INPUT_THREAD_STACK_SIZE (16 * 1024)
+#define INPUT_QUEUE_SIZE 512            // Power of two
+
+static input_event_t queue[INPUT_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;   // Next slot to write (sampler)
+static volatile uint32_t queue_tail = 0;   // Next slot to read (game loop)
+static volatile int dropped_events = 0;
+
+static SceUID input_thread = -1;
+static volatile int input_running = 0;
+
+// Function prototypes
+static int input_thread_func(SceSize args, void *argp);
+static void push_event(const input_event_t *event);
+static void push_touch(uint64_t timestamp, int action, const SceTouchReport *report);
+static void diff_touch(const SceTouchData *prev, const SceTouchData *touch);
+
+int input_init(void) {
+    if (input_running) {
+        return 0;
+    }
+
+    queue_head = queue_tail = 0;
+    dropped_events = 0;
+
+    input_running = 1;
+    input_thread = sceKernelCreateThread("input_sampler", input_thread_func, INPUT_THREAD_PRIORITY,
+                                         INPUT_THREAD_STACK_SIZE, 0, INPUT_THREAD_AFFINITY, NULL);
+    if (input_thread < 0) {
+        l_warn("Failed to create input thread: 0x%08X", input_thread);
+        input_running = 0;
+        return -1;
+    }
+
+    sceKernelStartThread(input_thread, 0, NULL);
+    l_success("Input sampling thread started");
+    return 0;
+}
+
+void input_shutdown(void) {
+    if (!input_running) {
+        return;
+    }
+
+    // The blocking read returns with the next sample
+    input_running = 0;
+    sceKernelWaitThreadEnd(input_thread, NULL, NULL);
+    input_thread = -1;
+
+    if (dropped_events > 0) {
+        l_warn("Input queue dropped %d events", dropped_events);
+    }
+}
+
+int input_is_threaded(void) {
+    return input_running;
+}
+
+int input_poll(input_event_t *event) {
+    uint32_t tail = queue_tail;
+    if (tail == __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    *event = queue[tail & (INPUT_QUEUE_SIZE - 1)];
+    __atomic_store_n(&queue_tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int input_dropped_events(void) {
+    return dropped_events;
+}
+
+// ===== SAMPLING THREAD =====
+
+static int input_thread_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    SceCtrlData ctrl;
+    SceTouchData touch;
+    SceTouchData prev_touch;
+    uint32_t prev_buttons = 0;
+
+    memset(&prev_touch, 0, sizeof(prev_touch));
+
+    while (input_running) {
+        if (sceCtrlReadBufferPositive(0, &ctrl, 1) < 0) {
+            sceKernelDelayThread(1000);
+            continue;
+        }
+
+        if (ctrl.buttons != prev_buttons) {
+            input_event_t event;
+            memset(&event, 0, sizeof(event));
+            event.timestamp = ctrl.timeStamp;
+            event.type = INPUT_EVENT_BUTTONS;
+            event.buttons = ctrl.buttons;
+            push_event(&event);
+            prev_buttons = ctrl.buttons;
+        }
+
+        // The panel samples at its own rate; only diff fresh frames
+        if (sceTouchPeek(SCE_TOUCH_PORT_FRONT, &touch, 1) > 0 && touch.timeStamp != prev_touch.timeStamp) {
+            diff_touch(&prev_touch, &touch);
+            prev_touch = touch;
+        }
+    }
+
+    return sceKernelExitDeleteThread(0);
+}
+
+static void push_event(const input_event_t *event) {
+    uint32_t head = queue_head;
+    if (head - __atomic_load_n(&queue_tail, __ATOMIC_ACQUIRE) >= INPUT_QUEUE_SIZE) {
+        dropped_events++;
+        return;
+    }
+
+    queue[head & (INPUT_QUEUE_SIZE - 1)] = *event;
+    __atomic_store_n(&queue_head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void push_touch(uint64_t timestamp, int action, const SceTouchReport *report) {
+    input_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.timestamp = timestamp;
+    event.type = INPUT_EVENT_TOUCH;
+    event.action = (uint8_t)action;
+    event.pointer = report->id;
+    event.x = report->x;
+    event.y = report->y;
+    push_event(&event);
+}
+
+// Match reports by id: new ids go DOWN, lifted ids go UP, moved ids go MOVE
+static void diff_touch(const SceTouchData *prev, const SceTouchData *touch) {
+    for (unsigned int i = 0; i < prev->reportNum; i++) {
+        int still_down = 0;
+        for (unsigned int j = 0; j < touch->reportNum; j++) {
+            if (touch->report[j].id == prev->report[i].id) {
+                still_down = 1;
+                break;
+            }
+        }
+        if (!still_down) {
+            push_touch(touch->timeStamp, INPUT_ACTION_UP, &prev->report[i]);
+        }
+    }
+
+    for (unsigned int j = 0; j < touch->reportNum; j++) {
+        const SceTouchReport *report = &touch->report[j];
+        const SceTouchReport *before = NULL;
+        for (unsigned int i = 0; i < prev->reportNum; i++) {
+            if (prev->report[i].id == report->id) {
+                before = &prev->report[i];
+                break;
+            }
+        }
+
+        if (!before) {
+            push_touch(touch->timeStamp, INPUT_ACTION_DOWN, report);
+        } else if (before->x != report->x || before->y != report->y) {
+            push_touch(touch->timeStamp, INPUT_ACTION_MOVE, report);
+        }
+    }
+}
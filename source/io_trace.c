@@ -0,0 +1,241 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * I/O Trace
+ *
+ * Writers claim a record with one atomic add and fill it in place; the ring
+ * wraps, so a dump holds the newest IO_TRACE_RECORDS events and the header
+ * says how many were written in total. Paths are interned once, on open,
+ * into a hashed table whose string pool is dumped alongside the records.
+ *
+ * File layout: header, path_bytes of NUL-terminated paths in id order, then
+ * count records oldest first.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/io/stat.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "io_trace.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+#define IO_TRACE_PATH DATA_PATH "cache/io_trace.bin"
+#define IO_TRACE_MAGIC 0x52544F49    // "IOTR"
+#define IO_TRACE_VERSION 1
+#define IO_TRACE_RECORDS 32768       // Power of two
+#define IO_TRACE_MAX_PATHS 2048      // Power of two
+#define IO_TRACE_POOL_SIZE (96 * 1024)
+
+typedef struct {
+    uint32_t time_us;                // Since io_trace_init()
+    int32_t thread;                  // SceUID of the caller
+    uint16_t op;                     // io_trace_op_t
+    uint16_t path;                   // Interned id or IO_TRACE_NO_PATH
+    uint32_t offset;
+    uint32_t length;
+} __attribute__((packed)) io_trace_event_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t count;                  // Records in this file
+    uint32_t total;                  // Records written since boot
+    uint32_t path_count;
+    uint32_t path_bytes;
+    uint32_t reserved;
+} io_trace_header_t;
+
+#if IO_TRACE
+static io_trace_event_t events[IO_TRACE_RECORDS];
+static volatile uint32_t event_head = 0;
+static uint64_t trace_start = 0;
+static volatile int trace_ready = 0;
+static volatile int dumped_full = 0;
+
+// Open-addressed: slot -> id + 1, 0 = empty
+static uint16_t path_slots[IO_TRACE_MAX_PATHS];
+static uint32_t path_hashes[IO_TRACE_MAX_PATHS];
+static uint32_t path_offsets[IO_TRACE_MAX_PATHS];
+static char path_pool[IO_TRACE_POOL_SIZE];
+static uint32_t path_pool_used = 0;
+static int path_count = 0;
+static SceKernelLwMutexWork path_lock;
+
+// Function prototypes
+static uint32_t path_hash(const char *path);
+#endif
+
+int io_trace_init(void) {
+#if IO_TRACE
+    if (trace_ready) {
+        return 0;
+    }
+
+    sceKernelCreateLwMutex(&path_lock, "io_trace_paths", 0, 0, NULL);
+    trace_start = sceKernelGetProcessTimeWide();
+    __atomic_store_n(&trace_ready, 1, __ATOMIC_RELEASE);
+
+    l_success("I/O trace enabled: %d records, dumped to %s", IO_TRACE_RECORDS, IO_TRACE_PATH);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+uint16_t io_trace_path(const char *path) {
+#if IO_TRACE
+    if (!__atomic_load_n(&trace_ready, __ATOMIC_ACQUIRE) || !path) {
+        return IO_TRACE_NO_PATH;
+    }
+
+    uint32_t hash = path_hash(path);
+    uint16_t id = IO_TRACE_NO_PATH;
+
+    sceKernelLockLwMutex(&path_lock, 1, NULL);
+    for (uint32_t probe = 0; probe < IO_TRACE_MAX_PATHS; probe++) {
+        uint32_t slot = (hash + probe) & (IO_TRACE_MAX_PATHS - 1);
+        if (path_slots[slot] == 0) {
+            size_t len = strlen(path) + 1;
+            // Keep the table at most half full so probes stay short
+            if (path_count >= IO_TRACE_MAX_PATHS / 2 || path_pool_used + len > IO_TRACE_POOL_SIZE) {
+                break;
+            }
+            memcpy(path_pool + path_pool_used, path, len);
+            path_offsets[path_count] = path_pool_used;
+            path_hashes[slot] = hash;
+            path_pool_used += len;
+            id = (uint16_t)path_count++;
+            path_slots[slot] = id + 1;
+            break;
+        }
+
+        uint16_t candidate = path_slots[slot] - 1;
+        if (path_hashes[slot] == hash && strcmp(path_pool + path_offsets[candidate], path) == 0) {
+            id = candidate;
+            break;
+        }
+    }
+    sceKernelUnlockLwMutex(&path_lock, 1);
+
+    return id;
+#else
+    (void)path;
+    return IO_TRACE_NO_PATH;
+#endif
+}
+
+void io_trace_record(io_trace_op_t op, uint16_t path_id, uint32_t offset, uint32_t length) {
+#if IO_TRACE
+    if (!__atomic_load_n(&trace_ready, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    uint32_t index = __atomic_fetch_add(&event_head, 1, __ATOMIC_RELAXED);
+    io_trace_event_t *event = &events[index & (IO_TRACE_RECORDS - 1)];
+    event->time_us = (uint32_t)(sceKernelGetProcessTimeWide() - trace_start);
+    event->thread = sceKernelGetThreadId();
+    event->op = (uint16_t)op;
+    event->path = path_id;
+    event->offset = offset;
+    event->length = length;
+
+    // Save the boot-time trace before the ring starts overwriting it
+    if (index == IO_TRACE_RECORDS - 1 && !dumped_full) {
+        dumped_full = 1;
+        io_trace_dump();
+    }
+#else
+    (void)op;
+    (void)path_id;
+    (void)offset;
+    (void)length;
+#endif
+}
+
+void io_trace_record_path(io_trace_op_t op, const char *path, uint32_t offset, uint32_t length) {
+#if IO_TRACE
+    io_trace_record(op, io_trace_path(path), offset, length);
+#else
+    (void)op;
+    (void)path;
+    (void)offset;
+    (void)length;
+#endif
+}
+
+int io_trace_dump(void) {
+#if IO_TRACE
+    if (!__atomic_load_n(&trace_ready, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+
+    // Events still being filled in by other threads may come out torn;
+    // the trace is a profile, not a log, so that is acceptable
+    uint32_t total = __atomic_load_n(&event_head, __ATOMIC_ACQUIRE);
+    uint32_t count = total < IO_TRACE_RECORDS ? total : IO_TRACE_RECORDS;
+
+    sceKernelLockLwMutex(&path_lock, 1, NULL);
+    io_trace_header_t header = {
+        .magic = IO_TRACE_MAGIC,
+        .version = IO_TRACE_VERSION,
+        .record_size = sizeof(io_trace_event_t),
+        .count = count,
+        .total = total,
+        .path_count = (uint32_t)path_count,
+        .path_bytes = path_pool_used,
+        .reserved = 0
+    };
+
+    size_t size = sizeof(header) + header.path_bytes + count * sizeof(io_trace_event_t);
+    uint8_t *buffer = malloc(size);
+    if (!buffer) {
+        sceKernelUnlockLwMutex(&path_lock, 1);
+        l_warn("I/O trace: no memory for a %d KB dump", (int)(size / 1024));
+        return -1;
+    }
+
+    uint8_t *p = buffer;
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    memcpy(p, path_pool, header.path_bytes);
+    p += header.path_bytes;
+    sceKernelUnlockLwMutex(&path_lock, 1);
+
+    uint32_t first = total - count;
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(p, &events[(first + i) & (IO_TRACE_RECORDS - 1)], sizeof(io_trace_event_t));
+        p += sizeof(io_trace_event_t);
+    }
+
+    sceIoMkdir(DATA_PATH "cache", 0777);
+    int ok = file_save(IO_TRACE_PATH, buffer, size);
+    free(buffer);
+
+    if (!ok) {
+        l_warn("I/O trace: could not write %s", IO_TRACE_PATH);
+        return -1;
+    }
+    l_info("I/O trace dumped: %u of %u events, %u paths", count, total, header.path_count);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+// ===== INTERNALS =====
+
+#if IO_TRACE
+static uint32_t path_hash(const char *path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+#endif
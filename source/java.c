@@ -1,5 +1,7 @@
 #include <falso_jni/FalsoJNI_Impl.h>
 
+#include "jni_cache.h"
+
 /*
  * JNI Methods
 */
@@ -50,3 +52,4 @@ FieldsLong fieldsLong[] = {};
 FieldsShort fieldsShort[] = {};
 
 __FALSOJNI_IMPL_CONTAINER_SIZES
+JNI_CACHE_TABLE_SIZES
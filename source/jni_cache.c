@@ -0,0 +1,300 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * JNI Lookup Cache
+ *
+ * Names go into open-addressed FNV-1a tables, probed on the stored hash
+ * before any strcmp. Method and field IDs stay the ids java.c assigns, so
+ * IDs handed out here and by FalsoJNI are interchangeable; each id below
+ * JNI_CACHE_MAX_ID gets a slot with one pointer per type, filled from the
+ * typed arrays. The tables are built once at boot and only read after.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <falso_jni/FalsoJNI_Impl.h>
+
+#include "config.h"
+#include "jni_cache.h"
+#include "utils/logger.h"
+
+#define JNI_CACHE_NAME_SLOTS 512        // Power of two, at least twice the names
+#define JNI_CACHE_MAX_ID 1024           // Ids above this are left to FalsoJNI
+
+#if JNI_LOOKUP_CACHE
+
+// java.c
+extern NameToMethodID nameToMethodId[];
+extern NameToFieldID nameToFieldId[];
+extern MethodsVoid methodsVoid[];
+extern const int jni_cache_method_names_count;
+extern const int jni_cache_field_names_count;
+extern const int jni_cache_methodsVoid_count;
+
+#define DECLARE_TABLES(Type, type) \
+    extern Methods##Type methods##Type[]; \
+    extern Fields##Type fields##Type[]; \
+    extern const int jni_cache_methods##Type##_count; \
+    extern const int jni_cache_fields##Type##_count;
+JNI_CACHE_TYPES(DECLARE_TABLES)
+
+#define METHOD_SLOT(Type, type) __typeof__(((Methods##Type *)0)->Method) Type;
+#define FIELD_SLOT(Type, type) type *Type;
+
+typedef struct {
+    __typeof__(((MethodsVoid *)0)->Method) Void;
+    JNI_CACHE_TYPES(METHOD_SLOT)
+} method_slot_t;
+
+typedef struct {
+    JNI_CACHE_TYPES(FIELD_SLOT)
+} field_slot_t;
+
+typedef struct {
+    uint32_t hash;
+    int entry;                          // Index into the name table, -1 if free
+} name_slot_t;
+
+static name_slot_t method_names[JNI_CACHE_NAME_SLOTS];
+static name_slot_t field_names[JNI_CACHE_NAME_SLOTS];
+static method_slot_t *method_slots = NULL;
+static field_slot_t *field_slots = NULL;
+static int method_slot_count = 0;
+static int field_slot_count = 0;
+
+// FalsoJNI's table, for whatever the cache cannot answer, and the patched copy
+static struct JNINativeInterface falso_env;
+static struct JNINativeInterface cached_env;
+
+// Function prototypes
+static uint32_t name_hash(const char *name);
+static void index_names(name_slot_t *slots, const char *(*name_at)(int), int count);
+static int find_name(const name_slot_t *slots, const char *(*name_at)(int), const char *name);
+static const char *method_name_at(int entry);
+static const char *field_name_at(int entry);
+static int slot_count(int max_id);
+static jmethodID GetMethodID_cached(JNIEnv *env, jclass clazz, const char *name, const char *sig);
+static jfieldID GetFieldID_cached(JNIEnv *env, jclass clazz, const char *name, const char *sig);
+static void CallVoidMethodV_cached(JNIEnv *env, jobject obj, jmethodID method, va_list args);
+static void CallVoidMethod_cached(JNIEnv *env, jobject obj, jmethodID method, ...);
+
+#define ENTRY_PROTOTYPES(Type, type) \
+    static type Call##Type##MethodV_cached(JNIEnv *env, jobject obj, jmethodID method, va_list args); \
+    static type Call##Type##Method_cached(JNIEnv *env, jobject obj, jmethodID method, ...); \
+    static type Get##Type##Field_cached(JNIEnv *env, jobject obj, jfieldID field);
+JNI_CACHE_TYPES(ENTRY_PROTOTYPES)
+
+#endif
+
+int jni_cache_init(void) {
+#if JNI_LOOKUP_CACHE
+    if (!jni) {
+        l_error("JNI cache: FalsoJNI is not initialised");
+        return -1;
+    }
+
+    index_names(method_names, method_name_at, jni_cache_method_names_count);
+    index_names(field_names, field_name_at, jni_cache_field_names_count);
+
+    int max_id = -1;
+    for (int i = 0; i < jni_cache_method_names_count; i++) {
+        max_id = nameToMethodId[i].id > max_id ? nameToMethodId[i].id : max_id;
+    }
+    method_slot_count = slot_count(max_id);
+
+    max_id = -1;
+    for (int i = 0; i < jni_cache_field_names_count; i++) {
+        max_id = nameToFieldId[i].id > max_id ? nameToFieldId[i].id : max_id;
+    }
+    field_slot_count = slot_count(max_id);
+
+    method_slots = calloc(method_slot_count + 1, sizeof(method_slot_t));
+    field_slots = calloc(field_slot_count + 1, sizeof(field_slot_t));
+    if (!method_slots || !field_slots) {
+        l_error("JNI cache: out of memory");
+        free(method_slots);
+        free(field_slots);
+        method_slots = NULL;
+        field_slots = NULL;
+        method_slot_count = 0;
+        field_slot_count = 0;
+        return -1;
+    }
+
+    for (int i = 0; i < jni_cache_methodsVoid_count; i++) {
+        int id = methodsVoid[i].id;
+        if (id >= 0 && id < method_slot_count) {
+            method_slots[id].Void = methodsVoid[i].Method;
+        }
+    }
+
+#define FILL_SLOTS(Type, type) \
+    for (int i = 0; i < jni_cache_methods##Type##_count; i++) { \
+        int id = methods##Type[i].id; \
+        if (id >= 0 && id < method_slot_count) { \
+            method_slots[id].Type = methods##Type[i].Method; \
+        } \
+    } \
+    for (int i = 0; i < jni_cache_fields##Type##_count; i++) { \
+        int id = fields##Type[i].id; \
+        if (id >= 0 && id < field_slot_count) { \
+            field_slots[id].Type = &fields##Type[i].value; \
+        } \
+    }
+    JNI_CACHE_TYPES(FILL_SLOTS)
+#undef FILL_SLOTS
+
+    falso_env = *jni;
+    cached_env = falso_env;
+    cached_env.GetMethodID = GetMethodID_cached;
+    cached_env.GetStaticMethodID = GetMethodID_cached;
+    cached_env.GetFieldID = GetFieldID_cached;
+    cached_env.GetStaticFieldID = GetFieldID_cached;
+    cached_env.CallVoidMethod = CallVoidMethod_cached;
+    cached_env.CallVoidMethodV = CallVoidMethodV_cached;
+    cached_env.CallStaticVoidMethod = CallVoidMethod_cached;
+    cached_env.CallStaticVoidMethodV = CallVoidMethodV_cached;
+#define INSTALL(Type, type) \
+    cached_env.Call##Type##Method = Call##Type##Method_cached; \
+    cached_env.Call##Type##MethodV = Call##Type##MethodV_cached; \
+    cached_env.CallStatic##Type##Method = Call##Type##Method_cached; \
+    cached_env.CallStatic##Type##MethodV = Call##Type##MethodV_cached; \
+    cached_env.Get##Type##Field = Get##Type##Field_cached; \
+    cached_env.GetStatic##Type##Field = Get##Type##Field_cached;
+    JNI_CACHE_TYPES(INSTALL)
+#undef INSTALL
+    jni = &cached_env;
+
+    l_success("JNI cache: %d methods, %d fields indexed",
+              jni_cache_method_names_count, jni_cache_field_names_count);
+#endif
+    return 0;
+}
+
+#if JNI_LOOKUP_CACHE
+
+// ===== ENV ENTRIES =====
+
+// Static and instance variants share these: FalsoJNI ignores the receiver
+
+static jmethodID GetMethodID_cached(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+    int entry = find_name(method_names, method_name_at, name);
+    if (entry < 0) {
+        return falso_env.GetMethodID(env, clazz, name, sig);
+    }
+    return (jmethodID)(intptr_t)nameToMethodId[entry].id;
+}
+
+static jfieldID GetFieldID_cached(JNIEnv *env, jclass clazz, const char *name, const char *sig) {
+    int entry = find_name(field_names, field_name_at, name);
+    if (entry < 0) {
+        return falso_env.GetFieldID(env, clazz, name, sig);
+    }
+    return (jfieldID)(intptr_t)nameToFieldId[entry].id;
+}
+
+static void CallVoidMethodV_cached(JNIEnv *env, jobject obj, jmethodID method, va_list args) {
+    uintptr_t id = (uintptr_t)method;
+    if (id < (uintptr_t)method_slot_count && method_slots[id].Void) {
+        method_slots[id].Void(method, args);
+        return;
+    }
+    falso_env.CallVoidMethodV(env, obj, method, args);
+}
+
+static void CallVoidMethod_cached(JNIEnv *env, jobject obj, jmethodID method, ...) {
+    va_list args;
+    va_start(args, method);
+    CallVoidMethodV_cached(env, obj, method, args);
+    va_end(args);
+}
+
+#define CACHED_ENTRIES(Type, type) \
+static type Call##Type##MethodV_cached(JNIEnv *env, jobject obj, jmethodID method, va_list args) { \
+    uintptr_t id = (uintptr_t)method; \
+    if (id < (uintptr_t)method_slot_count && method_slots[id].Type) { \
+        return method_slots[id].Type(method, args); \
+    } \
+    return falso_env.Call##Type##MethodV(env, obj, method, args); \
+} \
+static type Call##Type##Method_cached(JNIEnv *env, jobject obj, jmethodID method, ...) { \
+    va_list args; \
+    va_start(args, method); \
+    type result = Call##Type##MethodV_cached(env, obj, method, args); \
+    va_end(args); \
+    return result; \
+} \
+static type Get##Type##Field_cached(JNIEnv *env, jobject obj, jfieldID field) { \
+    uintptr_t id = (uintptr_t)field; \
+    if (id < (uintptr_t)field_slot_count && field_slots[id].Type) { \
+        return *field_slots[id].Type; \
+    } \
+    return falso_env.Get##Type##Field(env, obj, field); \
+}
+JNI_CACHE_TYPES(CACHED_ENTRIES)
+#undef CACHED_ENTRIES
+
+// ===== NAME TABLES =====
+
+static uint32_t name_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void index_names(name_slot_t *slots, const char *(*name_at)(int), int count) {
+    for (int i = 0; i < JNI_CACHE_NAME_SLOTS; i++) {
+        slots[i].entry = -1;
+    }
+
+    if (count > JNI_CACHE_NAME_SLOTS / 2) {
+        l_warn("JNI cache: %d names, only %d indexed", count, JNI_CACHE_NAME_SLOTS / 2);
+        count = JNI_CACHE_NAME_SLOTS / 2;
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint32_t hash = name_hash(name_at(i));
+        uint32_t slot = hash & (JNI_CACHE_NAME_SLOTS - 1);
+        while (slots[slot].entry >= 0) {
+            slot = (slot + 1) & (JNI_CACHE_NAME_SLOTS - 1);
+        }
+        slots[slot].hash = hash;
+        slots[slot].entry = i;
+    }
+}
+
+// Table index for `name`, the first entry winning as in FalsoJNI; -1 if absent
+static int find_name(const name_slot_t *slots, const char *(*name_at)(int), const char *name) {
+    uint32_t hash = name_hash(name);
+    uint32_t slot = hash & (JNI_CACHE_NAME_SLOTS - 1);
+    while (slots[slot].entry >= 0) {
+        if (slots[slot].hash == hash && strcmp(name_at(slots[slot].entry), name) == 0) {
+            return slots[slot].entry;
+        }
+        slot = (slot + 1) & (JNI_CACHE_NAME_SLOTS - 1);
+    }
+    return -1;
+}
+
+static const char *method_name_at(int entry) {
+    return nameToMethodId[entry].name;
+}
+
+static const char *field_name_at(int entry) {
+    return nameToFieldId[entry].name;
+}
+
+static int slot_count(int max_id) {
+    if (max_id >= JNI_CACHE_MAX_ID) {
+        l_warn("JNI cache: ids from %d on are not cached", JNI_CACHE_MAX_ID);
+        return JNI_CACHE_MAX_ID;
+    }
+    return max_id + 1;
+}
+
+#endif
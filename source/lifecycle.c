@@ -0,0 +1,194 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * App Suspend/Resume
+ *
+ * Power callbacks only run on the thread that created them while it waits
+ * in a CB call, so a small thread owns the callback and does nothing else.
+ * It only records what happened; the suspend itself needs the GL context
+ * and the game's JNI env and runs in lifecycle_poll() on the main thread.
+ * The system freezes the process soon after the suspend notification, so
+ * the callback holds it up to LIFECYCLE_SUSPEND_WAIT_US while the main
+ * thread releases. Resume is signalled twice, by the power callback and by
+ * sceAppMgr's ON_RESUME event; a resume with nothing suspended is ignored.
+ */
+
+#include <stdint.h>
+#include <psp2/appmgr.h>
+#include <psp2/power.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "audio.h"
+#include "config.h"
+#include "lifecycle.h"
+#include "mem_governor.h"
+#include "save_writer.h"
+#include "utils/logger.h"
+
+#define LIFECYCLE_THREAD_PRIORITY 0x10000100
+#define LIFECYCLE_THREAD_STACK_SIZE (16 * 1024)
+#define LIFECYCLE_SUSPEND_WAIT_US 500000    // Longest the callback holds back a suspend
+#define LIFECYCLE_EVF_RELEASED 1
+
+typedef enum {
+    LIFECYCLE_NONE = 0,
+    LIFECYCLE_SUSPEND,
+    LIFECYCLE_RESUME
+} lifecycle_request_t;
+
+static lifecycle_fn pause_fn = NULL;
+static lifecycle_fn resume_fn = NULL;
+static SceUID callback_thread = -1;
+static SceUID released_flag = -1;
+static volatile int callback_running = 0;
+static int pending = LIFECYCLE_NONE;        // Set by the callback, taken by lifecycle_poll()
+static int suspended = 0;
+static uint32_t suspend_count = 0;
+
+// Function prototypes
+static int callback_thread_func(SceSize args, void *argp);
+static int power_callback(int notify_id, int notify_count, int power_info, void *common);
+static void do_suspend(void);
+static void do_resume(void);
+
+int lifecycle_init(lifecycle_fn pause_game, lifecycle_fn resume_game) {
+    pause_fn = pause_game;
+    resume_fn = resume_game;
+
+    released_flag = sceKernelCreateEventFlag("lifecycle_released", 0, 0, NULL);
+    if (released_flag < 0) {
+        l_warn("Lifecycle: no event flag (0x%08X), suspends won't wait for the release", released_flag);
+    }
+
+    callback_running = 1;
+    callback_thread = sceKernelCreateThread("lifecycle_cb", callback_thread_func, LIFECYCLE_THREAD_PRIORITY,
+                                            LIFECYCLE_THREAD_STACK_SIZE, 0, 0, NULL);
+    if (callback_thread < 0) {
+        l_error("Lifecycle: failed to create callback thread: 0x%08X", callback_thread);
+        callback_running = 0;
+        return -1;
+    }
+    sceKernelStartThread(callback_thread, 0, NULL);
+
+    l_success("Lifecycle: releasing caches and audio on suspend");
+    return 0;
+}
+
+void lifecycle_poll(void) {
+    // ON_RESUME also covers a return the power callback doesn't report
+    SceAppMgrSystemEvent event;
+    if (sceAppMgrReceiveSystemEvent(&event) >= 0 && event.systemEvent == SCE_APPMGR_SYSTEMEVENT_ON_RESUME) {
+        __atomic_store_n(&pending, LIFECYCLE_RESUME, __ATOMIC_RELEASE);
+    }
+
+    switch (__atomic_exchange_n(&pending, LIFECYCLE_NONE, __ATOMIC_ACQ_REL)) {
+        case LIFECYCLE_SUSPEND:
+            do_suspend();
+            if (released_flag >= 0) {
+                sceKernelSetEventFlag(released_flag, LIFECYCLE_EVF_RELEASED);
+            }
+            break;
+        case LIFECYCLE_RESUME:
+            do_resume();
+            break;
+        default:
+            break;
+    }
+}
+
+int lifecycle_is_suspended(void) {
+    return suspended;
+}
+
+void lifecycle_shutdown(void) {
+    if (callback_running) {
+        callback_running = 0;
+        sceKernelWaitThreadEnd(callback_thread, NULL, NULL);
+        sceKernelDeleteThread(callback_thread);
+        callback_thread = -1;
+    }
+    if (released_flag >= 0) {
+        sceKernelDeleteEventFlag(released_flag);
+        released_flag = -1;
+    }
+    if (suspend_count > 0) {
+        l_info("Lifecycle: %u suspends", (unsigned)suspend_count);
+    }
+}
+
+// ===== TRANSITIONS =====
+
+static void do_suspend(void) {
+    if (suspended) {
+        return;
+    }
+    suspended = 1;
+    suspend_count++;
+    l_info("Lifecycle: suspending");
+
+    if (pause_fn) {
+        pause_fn();
+    }
+
+    // Standby can turn into a power loss; don't leave saves in memory
+    save_writer_flush();
+
+#if MEM_GOVERNOR
+    // Everything cheaper to rebuild than shaders; the FIOS cache stays
+    mem_governor_release(MEM_PRIORITY_SHADERS);
+#endif
+
+    // After the release, so the SFX bank trim it asked for runs here
+    audio_suspend();
+}
+
+static void do_resume(void) {
+    if (!suspended) {
+        return;
+    }
+    suspended = 0;
+    l_info("Lifecycle: resuming");
+
+    // Nothing is reloaded here; released caches miss and refill as they're touched
+    audio_resume();
+
+    if (resume_fn) {
+        resume_fn();
+    }
+}
+
+// ===== CALLBACK THREAD =====
+
+static int callback_thread_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    SceUID callback = sceKernelCreateCallback("lifecycle_power", 0, power_callback, NULL);
+    if (callback < 0 || scePowerRegisterCallback(callback) < 0) {
+        l_error("Lifecycle: failed to register the power callback: 0x%08X", callback);
+        return 0;
+    }
+
+    while (callback_running) {
+        sceKernelDelayThreadCB(100 * 1000);
+    }
+
+    scePowerUnregisterCallback(callback);
+    sceKernelDeleteCallback(callback);
+    return 0;
+}
+
+static int power_callback(int notify_id __attribute__((unused)), int notify_count __attribute__((unused)), int power_info,
+                          void *common __attribute__((unused))) {
+    if (power_info & SCE_POWER_CB_SUSPENDING) {
+        if (released_flag >= 0) {
+            sceKernelClearEventFlag(released_flag, ~LIFECYCLE_EVF_RELEASED);
+        }
+        __atomic_store_n(&pending, LIFECYCLE_SUSPEND, __ATOMIC_RELEASE);
+
+        if (released_flag >= 0) {
+            SceUInt timeout = LIFECYCLE_SUSPEND_WAIT_US;
+            sceKernelWaitEventFlag(released_flag, LIFECYCLE_EVF_RELEASED,
+                                   SCE_EVENT_WAITOR | SCE_EVENT_WAITCLEAR, NULL, &timeout);
+        }
+    } else if (power_info & SCE_POWER_CB_RESUME_COMPLETE) {
+        __atomic_store_n(&pending, LIFECYCLE_RESUME, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
@@ -18,6 +18,7 @@
 #include <kubridge.h>
 #include <so_util/so_util.h>
 #include <falso_jni/FalsoJNI.h>
+#include <fios/fios.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,8 +31,27 @@
 #include "utils/settings.h"
 #include "utils/utils.h"
 #include "utils/glutil.h"
+#include "reimpl/gl_state.h"
+#include "reimpl/pthr.h"
 #include "graphics.h"
 #include "audio.h"
+#include "asset_handler.h"
+#include "asset_pack.h"
+#include "boot_graph.h"
+#include "io_trace.h"
+#include "jni_cache.h"
+#include "lifecycle.h"
+#include "mem_budget.h"
+#include "mem_governor.h"
+#include "path_map.h"
+#include "save_writer.h"
+#include "perf_hud.h"
+#include "perf_profile.h"
+#include "profiler.h"
+#include "replay.h"
+#include "frame_pacer.h"
+#include "input.h"
+#include "config.h"
 
 // Game configuration
 #define LOAD_ADDRESS 0x98000000
@@ -60,10 +80,13 @@ typedef struct {
 
     // Performance
     uint64_t frame_time;
-    uint64_t last_frame_time;
     int fps_counter;
     int target_fps;
 
+    // Fixed-timestep mode
+    int64_t tick_accumulator;           // Real time not yet simulated, us
+    int tick_carry;                     // Sub-millisecond remainder of the tick length, us
+
     // JNI environment
     JavaVM *java_vm;
     JNIEnv *jni_env;
@@ -75,18 +98,37 @@ static so_module so_mod = {0};
 
 // Forward declarations
 static int initialize_systems(void);
+static int boot_assets(void);
+static int boot_graphics(void);
+static int boot_library(void);
+static int boot_audio(void);
+static int boot_shader_prefetch(void);
+static int boot_shader_warmup(void);
+static int boot_jni(void);
 static int load_game_library(void);
 static int initialize_jni(void);
 static void setup_file_paths(void);
 static void game_loop(void);
 static void update_input(void);
 static void process_touch_input(void);
+static void drain_input_events(void);
+static void replay_input(void);
 static void simulate_android_touch(float x, float y, int action);
 static void handle_vita_controls(void);
 static void update_game_logic(void);
+#if GAME_FIXED_TIMESTEP
+static void run_fixed_ticks(void);
+#endif
 static void render_frame(void);
 static void handle_system_events(void);
 static void cleanup_and_exit(void);
+#if MEM_GOVERNOR
+static size_t purge_fios_cache(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+#endif
+#if APP_LIFECYCLE
+static void suspend_game(void);
+static void resume_game(void);
+#endif
 
 // JNI function prototypes (from game library)
 typedef void (*OnGameInitialize_t)(JNIEnv *env, jobject obj);
@@ -112,38 +154,31 @@ int main(int argc __attribute__((unused)), char *argv[] __attribute__((unused)))
     l_info("Version: 1.0.0");
     l_info("Build Date: " __DATE__ " " __TIME__);
 
-    // Initialize all systems
+#if PROFILER_BOOT_CAPTURE
+    prof_capture_start(PROFILER_CAPTURE_FRAMES);
+#endif
+
+    // Initialize all systems, load the game library and warm caches,
+    // overlapped across cores where the dependencies allow
     if (!initialize_systems()) {
         l_error("Failed to initialize systems");
         cleanup_and_exit();
         return -1;
     }
 
-    // Load game library
-    if (!load_game_library()) {
-        l_error("Failed to load game library");
-        cleanup_and_exit();
-        return -1;
-    }
-
-    // Initialize JNI environment
-    if (!initialize_jni()) {
-        l_error("Failed to initialize JNI");
-        cleanup_and_exit();
-        return -1;
-    }
-
-    // Set up file paths
-    setup_file_paths();
-
     // Initialize game
     if (game_initialize) {
         l_info("Initializing game...");
+        PROF_BEGIN(zone, "OnGameInitialize");
         game_initialize(game_state.jni_env, NULL);
+        PROF_END(zone);
         game_state.game_initialized = 1;
         l_success("Game initialized successfully");
     }
 
+    // Boot is done: drop to the profile's clocks
+    perf_profile_start();
+
     // Main game loop
     game_state.running = 1;
     l_info("Starting main game loop");
@@ -161,37 +196,166 @@ static int initialize_systems(void) {
 
     // Initialize basic utilities (from boilerplate)
 
+    // Keep the render thread's core to itself; game threads start on cores 1-2
+    pthr_apply_thread_policy(sceKernelGetThreadId(), "main");
+
+#if MEM_GOVERNOR
+    // The caches register their purges as they come up
+    mem_governor_init();
+#endif
+
+    // Android path rules, before anything opens a file
+    path_map_init();
+    save_writer_init();
+
+    // Performance profile: full clocks for boot, then graphics, audio and
+    // the pacer are sized from it
+    settings_load();
+    perf_profile_init();
+    audio_set_source_limit(perf_profile_get()->audio_sources);
+
+#if IO_TRACE
+    // Before any asset work so the boot reads are in the trace
+    io_trace_init();
+#endif
+
     // Initialize input
     sceCtrlSetSamplingMode(SCE_CTRL_MODE_ANALOG);
     sceTouchSetSamplingState(SCE_TOUCH_PORT_FRONT, SCE_TOUCH_SAMPLING_STATE_START);
+#if INPUT_THREAD
+    if (input_init() < 0) {
+        l_warn("Input thread unavailable, polling once per frame");
+    }
+#endif
+
+    // The GL context belongs to the main thread, so graphics and the shader
+    // compile stay here; file-bound steps and OpenAL go to the workers
+    boot_graph_add("assets", boot_assets, BOOT_ON_WORKER, 0);
+    int library = boot_graph_add("library", boot_library, BOOT_ON_WORKER, 0);
+    boot_graph_add("audio", boot_audio, BOOT_ON_WORKER, 0);
+    int prefetch = boot_graph_add("shader_prefetch", boot_shader_prefetch, BOOT_ON_WORKER, 0);
+    int graphics = boot_graph_add("graphics", boot_graphics, BOOT_ON_MAIN, 0);
+    boot_graph_add("shader_warmup", boot_shader_warmup, BOOT_ON_MAIN, BOOT_DEP(graphics) | BOOT_DEP(prefetch));
+    boot_graph_add("jni", boot_jni, BOOT_ON_MAIN, BOOT_DEP(library));
+
+    if (boot_graph_run() < 0) {
+        return 0;
+    }
+
+    // Set up game state
+    game_state.initialized = 1;
+    game_state.screen_width = 960;
+    game_state.screen_height = 544;
+    game_state.game_width = 960;
+    game_state.game_height = 544;
+    game_state.target_fps = 60 / frame_pacer_interval();
+
+    // After the boot graph: a replay's report reads the asset cache counters
+    replay_init(REPLAY_MODE);
+
+#if APP_LIFECYCLE
+    // Last, so a suspend never finds a system half up
+    lifecycle_init(suspend_game, resume_game);
+#endif
+
+    l_success("All systems initialized successfully");
+    return 1;
+}
+
+// ===== BOOT TASKS =====
+
+static int boot_assets(void) {
+    // FIOS RAM cache under the data path backs the pooled asset handles
+    if (fios_init(DATA_PATH) == 0) {
+        l_success("FIOS initialized");
+#if MEM_GOVERNOR
+        mem_governor_register("fios", MEM_PRIORITY_FIOS, 0, purge_fios_cache);
+#endif
+    } else {
+        l_warn("FIOS unavailable, asset reads go straight to the card");
+    }
+
+    // Open the asset archive once and set up the cache behind load_asset()
+    // and AAsset buffers; everything packed is read through the archive.
+    // Also starts the loader threads warming the critical assets.
+    if (init_asset_system() < 0) {
+        l_warn("Asset system unavailable, assets will fail to load");
+    }
+    return 0;
+}
+
+#if MEM_GOVERNOR
+// Last resort, never undone: asset reads go straight to the card afterwards
+static size_t purge_fios_cache(mem_kind_t kind, mem_pressure_t pressure, size_t wanted __attribute__((unused))) {
+    if (kind != MEM_KIND_HEAP || pressure != MEM_PRESSURE_CRITICAL) {
+        return 0;
+    }
+
+    size_t freed = fios_drop_cache();
+    if (freed > 0) {
+        l_warn("Dropped the FIOS RAM cache (%zu KB) under memory pressure", freed / 1024);
+    }
+    return freed;
+}
+#endif
+
+static int boot_graphics(void) {
+    // Before vglInit; the library task runs on a worker and can't order it
+    gl_preload();
+    l_success("OpenGL preloaded.");
 
     // Initialize graphics system
     l_info("Initializing graphics system...");
     if (!graphics_init()) {
         l_error("Failed to initialize graphics");
-        return 0;
+        return -1;
     }
     game_state.graphics_ready = 1;
 
+    // Vblank-driven frame clock for the game loop
+    frame_pacer_init((frame_pace_mode_t)perf_profile_get()->pace_mode);
+    return 0;
+}
+
+static int boot_library(void) {
+    if (!load_game_library()) {
+        l_error("Failed to load game library");
+        return -1;
+    }
+    return 0;
+}
+
+static int boot_audio(void) {
     // Initialize audio system
     l_info("Initializing audio system...");
     if (!audio_init()) {
         l_error("Failed to initialize audio");
-        return 0;
+        return -1;
     }
     game_state.audio_ready = 1;
+    return 0;
+}
 
-    // Set up game state
-    game_state.initialized = 1;
-    game_state.screen_width = 960;
-    game_state.screen_height = 544;
-    game_state.game_width = 960;
-    game_state.game_height = 544;
-    game_state.target_fps = 60;
-    game_state.last_frame_time = sceKernelGetProcessTimeWide();
+static int boot_shader_prefetch(void) {
+    gl_prefetch_shaders();
+    return 0;
+}
 
-    l_success("All systems initialized successfully");
-    return 1;
+static int boot_shader_warmup(void) {
+    // Bind last session's shaders before the game can ask for them mid-play
+    gl_warmup_shaders();
+    return 0;
+}
+
+static int boot_jni(void) {
+    if (!initialize_jni()) {
+        l_error("Failed to initialize JNI");
+        return -1;
+    }
+
+    // Set up file paths
+    setup_file_paths();
+    return 0;
 }
 
 static int load_game_library(void) {
@@ -239,7 +403,10 @@ static int load_game_library(void) {
 static int initialize_jni(void) {
     l_info("Initializing JNI environment");
 
-    // FalsoJNI globals are available automatically
+    jni_init();
+    jni_cache_init();
+
+    // The game reaches the env through &jni, so the cached table applies
     game_state.java_vm = &jvm;
     game_state.jni_env = &jni;
 
@@ -264,42 +431,71 @@ static void setup_file_paths(void) {
 static void game_loop(void) {
     l_info("Entering main game loop");
 
+    uint64_t mark = sceKernelGetProcessTimeWide();
+
     while (game_state.running) {
-        // Calculate frame time
-        uint64_t current_time = sceKernelGetProcessTimeWide();
-        game_state.frame_time = current_time - game_state.last_frame_time;
-        game_state.last_frame_time = current_time;
+        PROF_BEGIN(frame_zone, "frame");
+        uint64_t frame_begin = sceKernelGetProcessTimeWide();
+
+        // Length of the previous frame, measured by the pacer
+        game_state.frame_time = frame_pacer_frame_time();
 
         // Start frame
         if (game_state.graphics_ready) {
             graphics_frame_start();
         }
+        perf_hud_lap(PERF_HUD_GL, &mark);
 
         // Handle system events
         handle_system_events();
 
         // Update input
-        update_input();
+        {
+            PROF_SCOPE("input");
+            update_input();
+        }
+        perf_hud_lap(PERF_HUD_INPUT, &mark);
 
         // Update game logic
         if (!game_state.paused) {
             update_game_logic();
         }
+        perf_hud_lap(PERF_HUD_UPDATE, &mark);
 
         // Render frame
         if (game_state.graphics_ready) {
             render_frame();
             graphics_frame_end();
         }
+        perf_hud_lap(PERF_HUD_GL, &mark);
 
-        // FPS limiting
-        if (game_state.target_fps > 0) {
-            uint64_t target_frame_time = 1000000 / game_state.target_fps;
-            uint64_t actual_frame_time = sceKernelGetProcessTimeWide() - current_time;
-            if (actual_frame_time < target_frame_time) {
-                sceKernelDelayThread(target_frame_time - actual_frame_time);
-            }
+        // Hold the frame to its vblank slot
+        uint64_t work_us = sceKernelGetProcessTimeWide() - frame_begin;
+        {
+            PROF_SCOPE("pacer_wait");
+            frame_pacer_wait();
         }
+        game_state.target_fps = 60 / frame_pacer_interval();
+        perf_hud_lap(PERF_HUD_WAIT, &mark);
+
+        replay_end_frame(frame_pacer_frame_time(), work_us);
+        if (replay_done()) {
+            l_info("Replay finished, exiting");
+            game_state.running = 0;
+        }
+
+        perf_governor_update();
+        mem_budget_sample();
+#if MEM_GOVERNOR
+        mem_governor_poll();
+#endif
+
+#if PERF_HUD
+        perf_hud_end_frame();
+#endif
+
+        PROF_END(frame_zone);
+        prof_frame();
 
         game_state.fps_counter++;
     }
@@ -310,6 +506,16 @@ static void game_loop(void) {
 // ===== INPUT HANDLING =====
 
 static void update_input(void) {
+    if (replay_is_playing()) {
+        replay_input();
+        return;
+    }
+
+    if (input_is_threaded()) {
+        drain_input_events();
+        return;
+    }
+
     // Store previous input state
     game_state.prev_ctrl_data = game_state.ctrl_data;
     game_state.prev_touch_data = game_state.touch_data;
@@ -355,30 +561,93 @@ static void process_touch_input(void) {
         }
     }
 
-    // Handle touch release
-    if (game_state.prev_touch_data.reportNum > 0 && game_state.touch_data.reportNum == 0) {
-        // All touches released
-        float x = game_state.prev_touch_data.report[0].x;
-        float y = game_state.prev_touch_data.report[0].y;
-        float game_x, game_y;
-        graphics_screen_to_game_coords(x, y, &game_x, &game_y);
-        simulate_android_touch(game_x, game_y, 1); // ACTION_UP
+    // Handle touch release of every lifted pointer
+    for (unsigned int i = 0; i < game_state.prev_touch_data.reportNum; i++) {
+        int still_down = 0;
+        for (unsigned int j = 0; j < game_state.touch_data.reportNum; j++) {
+            if (game_state.touch_data.report[j].id == game_state.prev_touch_data.report[i].id) {
+                still_down = 1;
+                break;
+            }
+        }
+
+        if (!still_down) {
+            float x = game_state.prev_touch_data.report[i].x;
+            float y = game_state.prev_touch_data.report[i].y;
+            float game_x, game_y;
+            graphics_screen_to_game_coords(x, y, &game_x, &game_y);
+            simulate_android_touch(game_x, game_y, 1); // ACTION_UP
+        }
+    }
+}
+
+// Replays everything the input thread saw since the last frame, in order
+static void drain_input_events(void) {
+    input_event_t event;
+    while (input_poll(&event)) {
+        if (event.type == INPUT_EVENT_TOUCH) {
+            float game_x, game_y;
+            graphics_screen_to_game_coords(event.x, event.y, &game_x, &game_y);
+            simulate_android_touch(game_x, game_y, event.action);
+            continue;
+        }
+
+        game_state.prev_ctrl_data.buttons = game_state.ctrl_data.buttons;
+        game_state.ctrl_data.buttons = event.buttons;
+        game_state.ctrl_data.timeStamp = event.timestamp;
+        handle_vita_controls();
+    }
+}
+
+// REPLAY_MODE 2: the recording drives the game; live input only for the exit combo
+static void replay_input(void) {
+    input_event_t discarded;
+    while (input_poll(&discarded)) {
+    }
+
+    SceCtrlData live;
+    if (sceCtrlPeekBufferPositive(0, &live, 1) >= 0 &&
+        (live.buttons & SCE_CTRL_LTRIGGER) && (live.buttons & SCE_CTRL_RTRIGGER) &&
+        (live.buttons & SCE_CTRL_SELECT)) {
+        l_info("Replay aborted by user");
+        game_state.running = 0;
+        return;
+    }
+
+    replay_event_t event;
+    while (replay_poll(&event)) {
+        if (event.type == REPLAY_EVENT_TOUCH) {
+            simulate_android_touch(event.x, event.y, event.action);
+            continue;
+        }
+
+        game_state.prev_ctrl_data.buttons = game_state.ctrl_data.buttons;
+        game_state.ctrl_data.buttons = event.buttons;
+        handle_vita_controls();
     }
 }
 
 static void simulate_android_touch(float x, float y, int action) {
+    replay_record_touch(action, x, y);
+
     if (game_touch_event && game_state.game_initialized) {
+        PROF_SCOPE("OnGameTouchEvent");
         game_touch_event(game_state.jni_env, NULL, action, x, y);
     }
 }
 
 static void handle_vita_controls(void) {
+    if (game_state.ctrl_data.buttons != game_state.prev_ctrl_data.buttons) {
+        replay_record_buttons(game_state.ctrl_data.buttons);
+    }
+
     // Handle button presses
     uint32_t pressed = game_state.ctrl_data.buttons & ~game_state.prev_ctrl_data.buttons;
 
     // Back button (SELECT)
     if (pressed & SCE_CTRL_SELECT) {
         if (game_back && game_state.game_initialized) {
+            PROF_SCOPE("OnGameBack");
             game_back(game_state.jni_env, NULL);
         }
     }
@@ -388,16 +657,36 @@ static void handle_vita_controls(void) {
         if (game_state.paused) {
             game_state.paused = 0;
             if (game_resume && game_state.game_initialized) {
+                PROF_SCOPE("OnGameResume");
                 game_resume(game_state.jni_env, NULL);
             }
         } else {
             game_state.paused = 1;
             if (game_pause && game_state.game_initialized) {
+                PROF_SCOPE("OnGamePause");
                 game_pause(game_state.jni_env, NULL);
             }
         }
     }
 
+#if PERF_HUD
+    // L + R + TRIANGLE: performance HUD
+    if ((pressed & SCE_CTRL_TRIANGLE) &&
+        (game_state.ctrl_data.buttons & SCE_CTRL_LTRIGGER) &&
+        (game_state.ctrl_data.buttons & SCE_CTRL_RTRIGGER)) {
+        perf_hud_toggle();
+    }
+#endif
+
+#if ENABLE_PROFILING
+    // L + R + CIRCLE: capture a trace
+    if ((pressed & SCE_CTRL_CIRCLE) &&
+        (game_state.ctrl_data.buttons & SCE_CTRL_LTRIGGER) &&
+        (game_state.ctrl_data.buttons & SCE_CTRL_RTRIGGER)) {
+        prof_capture_start(PROFILER_CAPTURE_FRAMES);
+    }
+#endif
+
     // Map face buttons to touch events
     if (pressed & SCE_CTRL_CROSS) {
         simulate_android_touch(480, 272, 0); // Center screen touch down
@@ -411,10 +700,65 @@ static void handle_vita_controls(void) {
 
 static void update_game_logic(void) {
     if (game_update && game_state.game_initialized) {
-        int delta_time = (int)(game_state.frame_time / 1000); // Convert to milliseconds
+        if (replay_is_active()) {
+            // Same step every frame, so a replay simulates what was recorded
+            PROF_SCOPE("OnGameUpdate");
+            game_update(game_state.jni_env, NULL, REPLAY_DELTA_MS);
+        } else {
+#if GAME_FIXED_TIMESTEP
+            run_fixed_ticks();
+#else
+            int delta_time = frame_pacer_delta_ms(); // Smoothed, in milliseconds
+            PROF_SCOPE("OnGameUpdate");
+            game_update(game_state.jni_env, NULL, delta_time);
+#endif
+        }
+    }
+
+    // Pick up sounds the audio thread finished since last frame
+    if (game_state.audio_ready) {
+        audio_update();
+    }
+}
+
+#if GAME_FIXED_TIMESTEP
+// OnGameUpdate both simulates and draws, and vitaGL's context belongs to
+// this thread, so the simulation can't move to a thread of its own. Instead
+// the game is stepped at a fixed rate here, as many times as real time
+// requires, and only the last step of a frame is allowed to draw.
+static void run_fixed_ticks(void) {
+    const int tick_us = 1000000 / GAME_TICK_RATE;
+
+    game_state.tick_accumulator += (int64_t)game_state.frame_time;
+
+    // Always step once so every presented frame gets drawn; the accumulator
+    // may go negative and is paid back by the next frames
+    int ticks = (int)(game_state.tick_accumulator / tick_us);
+    if (ticks < 1) {
+        ticks = 1;
+    } else if (ticks > GAME_MAX_TICKS) {
+        ticks = GAME_MAX_TICKS;
+        game_state.tick_accumulator = (int64_t)ticks * tick_us;
+    }
+
+    for (int i = 0; i < ticks; i++) {
+        int step_us = tick_us + game_state.tick_carry;
+        int delta_time = step_us / 1000;
+        game_state.tick_carry = step_us % 1000;
+        game_state.tick_accumulator -= tick_us;
+
+#if GL_STATE_FILTER
+        gl_state_skip_draws(i < ticks - 1);
+#endif
+        PROF_SCOPE("OnGameUpdate");
         game_update(game_state.jni_env, NULL, delta_time);
     }
+
+#if GL_STATE_FILTER
+    gl_state_skip_draws(0);
+#endif
 }
+#endif
 
 static void render_frame(void) {
     // The actual rendering is handled by the game library
@@ -437,18 +781,59 @@ static void handle_system_events(void) {
         l_info("Exit requested by user");
     game_state.running = 0;
         }
+
+#if APP_LIFECYCLE
+    // Standby and resume, handed over by the power callback
+    lifecycle_poll();
+#endif
+}
+
+#if APP_LIFECYCLE
+static int paused_before_suspend = 0;
+
+// The game pauses as if START were pressed, unless the player already had
+static void suspend_game(void) {
+    paused_before_suspend = game_state.paused;
+    if (!game_state.paused) {
+        game_state.paused = 1;
+        if (game_pause && game_state.game_initialized) {
+            PROF_SCOPE("OnGamePause");
+            game_pause(game_state.jni_env, NULL);
+        }
+    }
 }
 
+static void resume_game(void) {
+    if (!paused_before_suspend) {
+        game_state.paused = 0;
+        if (game_resume && game_state.game_initialized) {
+            PROF_SCOPE("OnGameResume");
+            game_resume(game_state.jni_env, NULL);
+        }
+    }
+}
+#endif
+
 // ===== CLEANUP =====
 
 static void cleanup_and_exit(void) {
     l_info("Cleaning up and exiting...");
 
+#if APP_LIFECYCLE
+    lifecycle_shutdown();
+#endif
+
     // Stop game
     if (game_state.game_initialized && game_pause) {
         game_pause(game_state.jni_env, NULL);
     }
 
+    // Anything the game saved on the way out goes to the card first
+    save_writer_shutdown();
+
+    input_shutdown();
+    replay_shutdown();
+
     // Cleanup audio system
     if (game_state.audio_ready) {
         audio_cleanup();
@@ -459,6 +844,17 @@ static void cleanup_and_exit(void) {
         graphics_cleanup();
     }
 
+#if MEM_GOVERNOR
+    mem_governor_report();
+#endif
+
+    cleanup_asset_system();
+    asset_pack_close();
+
+#if IO_TRACE
+    io_trace_dump();
+#endif
+
     // Cleanup - handled by boilerplate
 
     l_success("Cleanup complete");
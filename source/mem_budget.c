@@ -0,0 +1,144 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * vitaGL Memory Budget
+ *
+ * Each pool gets what is free in its memory type less a reserve for the
+ * rest of the port: thread stacks, audio buffers and kubridge come out of
+ * user RAM, sceAudioOut and the decoders out of phycont. Whatever vitaGL
+ * cannot fit in its pools spills to the newlib heap (vglUseExtraMem),
+ * which works but is the slow path this planner exists to keep it off;
+ * a pool that ran nearly dry is called out in the exit report.
+ */
+
+#include <vitaGL.h>
+#include <psp2/kernel/sysmem.h>
+
+#include "config.h"
+#include "mem_budget.h"
+#include "perf_profile.h"
+#include "utils/logger.h"
+#include "utils/settings.h"
+
+#define MB (1024 * 1024)
+#define RESERVE_USER (16 * MB)          // Stacks, audio, kubridge, prelink image
+#define RESERVE_CDRAM (2 * MB)
+#define RESERVE_PHYCONT (4 * MB)        // sceAudioOut and codec buffers
+#define CDLG_POOL (2 * MB)              // Common dialogs (IME, messages)
+#define MIN_POOL (1 * MB)
+#define SAMPLE_INTERVAL 30              // Frames between pool samples
+#define LOW_WATER_PERCENT 5             // Free share that counts as running dry
+
+typedef struct {
+    const char *name;
+    vglMemType type;
+    int size;
+    int min_free;
+} pool_usage_t;
+
+static mem_budget_t plan;
+static int planned = 0;
+static int sample_frames = 0;
+
+static pool_usage_t pools[] = {
+    { "VRAM", VGL_MEM_VRAM, 0, 0 },
+    { "RAM", VGL_MEM_RAM, 0, 0 },
+    { "PHYCONT", VGL_MEM_SLOW, 0, 0 },
+};
+
+// Function prototypes
+static int size_pool(const char *key, int free_bytes, int reserve, int cap, int setting_mb);
+
+const mem_budget_t *mem_budget_plan(void) {
+    if (planned) {
+        return &plan;
+    }
+
+    SceKernelFreeMemorySizeInfo info;
+    info.size = sizeof(info);
+    sceKernelGetFreeMemorySize(&info);
+    plan.free_user = info.size_user;
+    plan.free_cdram = info.size_cdram;
+    plan.free_phycont = info.size_phycont;
+
+    plan.legacy_pool = VERTEX_POOL_SIZE;
+    plan.cdlg_pool = CDLG_POOL;
+    plan.cdram_pool = size_pool("vgl_vram_mb", plan.free_cdram, RESERVE_CDRAM, 0, setting_vglVramMb);
+    plan.ram_pool = size_pool("vgl_ram_mb", plan.free_user, RESERVE_USER + plan.legacy_pool,
+                              perf_profile_get()->vertex_ram, setting_vglRamMb);
+    plan.phycont_pool = size_pool("vgl_phycont_mb", plan.free_phycont, RESERVE_PHYCONT + plan.cdlg_pool,
+                                  0, setting_vglPhycontMb);
+
+    // Textures live in VRAM; leave an eighth for render targets
+    plan.texture_budget = MIN(TEXTURE_CACHE_SIZE, plan.cdram_pool - plan.cdram_pool / 8);
+
+    pools[0].size = plan.cdram_pool;
+    pools[1].size = plan.ram_pool;
+    pools[2].size = plan.phycont_pool;
+    for (int i = 0; i < (int)ARRAY_SIZE(pools); i++) {
+        pools[i].min_free = pools[i].size;
+    }
+
+    l_info("Memory free: user %d MB, CDRAM %d MB, phycont %d MB",
+           plan.free_user / MB, plan.free_cdram / MB, plan.free_phycont / MB);
+    l_info("vitaGL pools: VRAM %d MB, RAM %d MB, phycont %d MB, legacy %d KB; texture budget %d MB",
+           plan.cdram_pool / MB, plan.ram_pool / MB, plan.phycont_pool / MB,
+           plan.legacy_pool / 1024, plan.texture_budget / MB);
+
+    planned = 1;
+    return &plan;
+}
+
+int mem_budget_init_gl(int width, int height, int msaa) {
+    const mem_budget_t *budget = mem_budget_plan();
+    if (!vglInitWithCustomSizes(budget->legacy_pool, width, height, budget->ram_pool, budget->cdram_pool,
+                                budget->phycont_pool, budget->cdlg_pool, (SceGxmMultisampleMode)msaa)) {
+        l_error("vitaGL rejected the planned pools");
+        return -1;
+    }
+    return 0;
+}
+
+void mem_budget_sample(void) {
+    if (!planned || ++sample_frames < SAMPLE_INTERVAL) {
+        return;
+    }
+    sample_frames = 0;
+
+    for (int i = 0; i < (int)ARRAY_SIZE(pools); i++) {
+        int free_bytes = (int)vglMemFree(pools[i].type);
+        if (free_bytes < pools[i].min_free) {
+            pools[i].min_free = free_bytes;
+        }
+    }
+}
+
+void mem_budget_report(void) {
+    if (!planned) {
+        return;
+    }
+
+    mem_budget_sample();
+    for (int i = 0; i < (int)ARRAY_SIZE(pools); i++) {
+        const pool_usage_t *pool = &pools[i];
+        l_info("vitaGL %s pool: peak %d of %d MB", pool->name, (pool->size - pool->min_free) / MB, pool->size / MB);
+        if (pool->size > 0 && (int64_t)pool->min_free * 100 < (int64_t)pool->size * LOW_WATER_PERCENT) {
+            l_warn("vitaGL %s pool ran dry (%d KB left): allocations likely spilled to the heap",
+                   pool->name, pool->min_free / 1024);
+        }
+    }
+}
+
+// Everything free less the reserve, capped, or the setting clamped to that
+static int size_pool(const char *key __attribute__((unused)), int free_bytes, int reserve, int cap, int setting_mb) {
+    int available = MAX(free_bytes - reserve, MIN_POOL);
+    int size = cap > 0 ? MIN(available, cap) : available;
+
+    if (setting_mb > 0) {
+        size = setting_mb * MB;
+        if (size > available) {
+            l_warn("%s %d MB does not fit, using %d MB", key, setting_mb, available / MB);
+            size = available;
+        }
+    }
+    return size;
+}
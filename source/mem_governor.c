@@ -0,0 +1,234 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Memory Governor
+ *
+ * Free heap is HEAP_SIZE less newlib's in-use bytes (mallinfo), free VRAM
+ * is vitaGL's own count; both are sampled every POLL_INTERVAL frames and
+ * by every reserve or reclaim. Only one purge runs at a time: a thread that
+ * runs short while another is purging gets nothing and fails as it would
+ * have, rather than waiting on locks the purging thread may need. Purges
+ * that belong to the main thread are skipped off it and run, under
+ * critical pressure, at the next poll.
+ */
+
+#include <limits.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vitaGL.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "mem_governor.h"
+#include "utils/logger.h"
+
+#define MAX_PURGERS 8
+#define POLL_INTERVAL 30                // Frames between free-memory checks
+
+typedef struct {
+    const char *name;
+    int priority;
+    int flags;
+    mem_purge_fn purge;
+    uint32_t calls;                     // Purges that freed something
+    size_t freed;
+    int ready;                          // Set last, once the fields above are in place
+} purger_t;
+
+static purger_t purgers[MAX_PURGERS];
+static int purger_slots = 0;
+static const size_t low_water[MEM_KIND_COUNT] = { MEM_HEAP_LOW_WATER, MEM_VRAM_LOW_WATER };
+#if SOLOADER_LOG_LEVEL <= LT_WARN
+static const char *const kind_names[MEM_KIND_COUNT] = { "heap", "VRAM" };
+#endif
+static uint32_t shortages[MEM_KIND_COUNT];
+static SceUID main_thread = -1;
+static int poll_frames = 0;
+static int purging = 0;
+static int deferred = 0;                // Bit per mem_kind_t left for the main thread
+
+// Function prototypes
+static size_t free_bytes(mem_kind_t kind);
+static size_t purge(mem_kind_t kind, mem_pressure_t pressure, size_t target, int max_priority);
+static int sorted_purgers(int *order);
+
+void mem_governor_init(void) {
+    main_thread = sceKernelGetThreadId();
+    l_success("Memory governor: purging below %d MB heap / %d MB VRAM free",
+              MEM_HEAP_LOW_WATER / (1024 * 1024), MEM_VRAM_LOW_WATER / (1024 * 1024));
+}
+
+int mem_governor_register(const char *name, int priority, int flags, mem_purge_fn purge_fn) {
+    int slot = __atomic_fetch_add(&purger_slots, 1, __ATOMIC_ACQ_REL);
+    if (slot >= MAX_PURGERS) {
+        l_error("Memory governor: no slot for %s", name);
+        return -1;
+    }
+
+    purger_t *purger = &purgers[slot];
+    purger->name = name;
+    purger->priority = priority;
+    purger->flags = flags;
+    purger->purge = purge_fn;
+    __atomic_store_n(&purger->ready, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void mem_governor_poll(void) {
+    if (main_thread < 0) {
+        return;
+    }
+
+    int pending = __atomic_exchange_n(&deferred, 0, __ATOMIC_ACQ_REL);
+    if (++poll_frames < POLL_INTERVAL && !pending) {
+        return;
+    }
+    poll_frames = 0;
+
+    for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+        size_t available = free_bytes((mem_kind_t)kind);
+        if (available >= low_water[kind] && !(pending & (1 << kind))) {
+            continue;
+        }
+
+        mem_pressure_t pressure = (pending & (1 << kind)) || available < low_water[kind] / 2
+                                  ? MEM_PRESSURE_CRITICAL : MEM_PRESSURE_LOW;
+        shortages[kind]++;
+#if SOLOADER_LOG_LEVEL <= LT_DEBUG
+        size_t freed = purge((mem_kind_t)kind, pressure, low_water[kind] * 2, INT_MAX);
+        l_debug("Memory governor: %s at %zu KB free, purged %zu KB",
+                kind_names[kind], available / 1024, freed / 1024);
+#else
+        purge((mem_kind_t)kind, pressure, low_water[kind] * 2, INT_MAX);
+#endif
+    }
+}
+
+void mem_governor_reserve(mem_kind_t kind, size_t bytes) {
+    if (main_thread < 0) {
+        return;
+    }
+
+    size_t available = free_bytes(kind);
+    if (available >= bytes + low_water[kind]) {
+        return;
+    }
+
+    shortages[kind]++;
+    purge(kind, available < bytes ? MEM_PRESSURE_CRITICAL : MEM_PRESSURE_LOW, bytes + low_water[kind] * 2, INT_MAX);
+}
+
+int mem_governor_reclaim(mem_kind_t kind, size_t bytes) {
+    if (main_thread < 0) {
+        return 0;
+    }
+
+    shortages[kind]++;
+    size_t freed = purge(kind, MEM_PRESSURE_CRITICAL, bytes + low_water[kind] * 2, INT_MAX);
+    l_warn("Memory governor: %zu KB %s allocation failed, purged %zu KB",
+           bytes / 1024, kind_names[kind], freed / 1024);
+    return freed > 0;
+}
+
+size_t mem_governor_release(int max_priority) {
+    if (main_thread < 0) {
+        return 0;
+    }
+
+    size_t freed = 0;
+    for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+        freed += purge((mem_kind_t)kind, MEM_PRESSURE_CRITICAL, SIZE_MAX, max_priority);
+    }
+    l_info("Memory governor: released %zu KB of caches", freed / 1024);
+    return freed;
+}
+
+void *mem_governor_malloc(size_t size) {
+    void *ptr = malloc(size);
+    if (!ptr && size > 0 && mem_governor_reclaim(MEM_KIND_HEAP, size)) {
+        ptr = malloc(size);
+    }
+    return ptr;
+}
+
+void mem_governor_report(void) {
+    l_info("Memory governor: %u heap and %u VRAM shortages",
+           (unsigned)shortages[MEM_KIND_HEAP], (unsigned)shortages[MEM_KIND_VRAM]);
+
+    int order[MAX_PURGERS];
+    int count = sorted_purgers(order);
+    for (int i = 0; i < count; i++) {
+        const purger_t *purger = &purgers[order[i]];
+        if (purger->calls > 0) {
+            l_info("  %s: %u purges, %zu KB", purger->name, (unsigned)purger->calls, purger->freed / 1024);
+        }
+    }
+}
+
+// ===== PURGING =====
+
+static size_t free_bytes(mem_kind_t kind) {
+    if (kind == MEM_KIND_VRAM) {
+        return vglMemFree(VGL_MEM_VRAM);
+    }
+
+    struct mallinfo info = mallinfo();
+    return (size_t)info.uordblks < HEAP_SIZE ? HEAP_SIZE - (size_t)info.uordblks : 0;
+}
+
+// Purge in priority order, up to `max_priority`, until `target` bytes of `kind` are free; bytes freed
+static size_t purge(mem_kind_t kind, mem_pressure_t pressure, size_t target, int max_priority) {
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&purging, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    int on_main = sceKernelGetThreadId() == main_thread;
+    int order[MAX_PURGERS];
+    int count = sorted_purgers(order);
+    size_t freed = 0;
+    size_t available = free_bytes(kind);
+
+    for (int i = 0; i < count && available < target; i++) {
+        purger_t *purger = &purgers[order[i]];
+        if (purger->priority > max_priority) {
+            break;
+        }
+        if (!on_main && !(purger->flags & MEM_PURGE_ANY_THREAD)) {
+            if (pressure == MEM_PRESSURE_CRITICAL) {
+                __atomic_or_fetch(&deferred, 1 << kind, __ATOMIC_ACQ_REL);
+            }
+            continue;
+        }
+
+        size_t got = purger->purge(kind, pressure, target - available);
+        if (got > 0) {
+            purger->calls++;
+            purger->freed += got;
+            freed += got;
+            available = free_bytes(kind);
+        }
+    }
+
+    __atomic_store_n(&purging, 0, __ATOMIC_RELEASE);
+    return freed;
+}
+
+// Indices of the registered purgers, lowest priority first; returns the count
+static int sorted_purgers(int *order) {
+    int slots = __atomic_load_n(&purger_slots, __ATOMIC_ACQUIRE);
+    int count = 0;
+
+    for (int i = 0; i < slots && i < MAX_PURGERS; i++) {
+        if (!__atomic_load_n(&purgers[i].ready, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        int j = count++;
+        while (j > 0 && purgers[order[j - 1]].priority > purgers[i].priority) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    return count;
+}
@@ -8,27 +8,53 @@
 #include <psp2/kernel/processmgr.h>
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <so_util/so_util.h>
+#include "config.h"
+#include "reimpl/mem_pool.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
-// Memory tracking
-#define MAX_ALLOCS 2048
+// Memory tracking. Live blocks sit in ALLOC_STRIPES independent open-addressed
+// tables, each behind its own lock; the pointer hash picks the stripe.
+#define ALLOC_STRIPES 16
+#define ALLOC_STRIPE_SLOTS 1024         // Power of two
+#define ALLOC_SITE_SLOTS 512            // Power of two
+#define ALLOC_TOP_SITES 16
 
 typedef struct {
-    void *ptr;
+    void *ptr;                          // NULL = empty slot
     size_t size;
-    const char *func;
-    int line;
-    int used;
+    int site;                           // Index into alloc_sites, -1 if untracked
 } alloc_info_t;
 
-static alloc_info_t alloc_table[MAX_ALLOCS];
-static int alloc_count = 0;
-static size_t total_allocated = 0;
+typedef struct {
+    alloc_info_t slots[ALLOC_STRIPE_SLOTS];
+    SceKernelLwMutexWork lock;
+    int count;
+} alloc_stripe_t;
+
+// Live and peak usage per allocating call site
+typedef struct {
+    const char *func;                   // NULL = empty slot
+    int line;
+    int count;
+    size_t bytes;
+    size_t peak_bytes;
+    unsigned int total_allocs;
+} alloc_site_t;
+
+static alloc_stripe_t alloc_stripes[ALLOC_STRIPES];
+static alloc_site_t alloc_sites[ALLOC_SITE_SLOTS];
+static SceKernelLwMutexWork site_lock;
+static volatile int alloc_count = 0;
+static volatile size_t total_allocated = 0;
+static volatile size_t peak_allocated = 0;
+static volatile int untracked_allocs = 0;
+static int tracking_ready = 0;
 static int memory_tracking_enabled = 1;
 
 // Function pointer storage for patches
@@ -61,6 +87,9 @@ static void patch_graphics_functions(void);
 static void patch_audio_functions(void);
 static void patch_monetization_system(void);
 static void init_memory_tracking(void);
+static void track_alloc(void *ptr, size_t size, const char *func, int line);
+static void untrack_alloc(void *ptr);
+static int find_site(const char *func, int line);
 
 // ===== MAIN PATCH ENTRY POINT =====
 
@@ -90,11 +119,24 @@ void patch_game(void) {
 // ===== MEMORY MANAGEMENT PATCHES =====
 
 static void init_memory_tracking(void) {
-    memset(alloc_table, 0, sizeof(alloc_table));
+    if (tracking_ready) {
+        return;
+    }
+
+    memset(alloc_stripes, 0, sizeof(alloc_stripes));
+    memset(alloc_sites, 0, sizeof(alloc_sites));
+    for (int i = 0; i < ALLOC_STRIPES; i++) {
+        sceKernelCreateLwMutex(&alloc_stripes[i].lock, "alloc_stripe", 0, 0, NULL);
+    }
+    sceKernelCreateLwMutex(&site_lock, "alloc_sites", 0, 0, NULL);
     alloc_count = 0;
     total_allocated = 0;
+    peak_allocated = 0;
+    untracked_allocs = 0;
+    tracking_ready = 1;
 
-    l_info("Memory tracking initialized");
+    l_info("Memory tracking initialized (%d slots in %d stripes)",
+           ALLOC_STRIPES * ALLOC_STRIPE_SLOTS, ALLOC_STRIPES);
 }
 
 static void patch_memory_functions(void) {
@@ -111,48 +153,18 @@ static void patch_memory_functions(void) {
 }
 
 void* malloc_tracked(size_t size, const char* func, int line) {
-    if (!memory_tracking_enabled) {
-        return malloc(size);
-    }
-
     void* ptr = malloc(size);
-    if (ptr && alloc_count < MAX_ALLOCS) {
-        // Find empty slot
-        for (int i = 0; i < MAX_ALLOCS; i++) {
-            if (!alloc_table[i].used) {
-                alloc_table[i].ptr = ptr;
-                alloc_table[i].size = size;
-                alloc_table[i].func = func;
-                alloc_table[i].line = line;
-                alloc_table[i].used = 1;
-                alloc_count++;
-                total_allocated += size;
-                break;
-            }
-        }
+    if (ptr && memory_tracking_enabled) {
+        track_alloc(ptr, size, func, line);
     }
-
     return ptr;
 }
 
 void free_tracked(void* ptr, const char* func __attribute__((unused)), int line __attribute__((unused))) {
-    if (!memory_tracking_enabled) {
-        free(ptr);
-        return;
-    }
-
-    if (ptr) {
-        // Find and remove from tracking
-        for (int i = 0; i < MAX_ALLOCS; i++) {
-            if (alloc_table[i].used && alloc_table[i].ptr == ptr) {
-                total_allocated -= alloc_table[i].size;
-                alloc_table[i].used = 0;
-                alloc_count--;
-                break;
-            }
-        }
-        free(ptr);
+    if (ptr && memory_tracking_enabled) {
+        untrack_alloc(ptr);
     }
+    free(ptr);
 }
 
 void* realloc_tracked(void* ptr, size_t size, const char* func, int line) {
@@ -160,64 +172,166 @@ void* realloc_tracked(void* ptr, size_t size, const char* func, int line) {
         return realloc(ptr, size);
     }
 
-    // Remove old tracking entry
+    void* new_ptr = realloc(ptr, size);
+    if (!new_ptr && size > 0) {
+        // The old block is still valid and still tracked
+        return NULL;
+    }
+
     if (ptr) {
-        for (int i = 0; i < MAX_ALLOCS; i++) {
-            if (alloc_table[i].used && alloc_table[i].ptr == ptr) {
-                total_allocated -= alloc_table[i].size;
-                alloc_table[i].used = 0;
-                alloc_count--;
-                break;
-            }
-        }
+        untrack_alloc(ptr);
+    }
+    if (new_ptr) {
+        track_alloc(new_ptr, size, func, line);
     }
+    return new_ptr;
+}
 
-    // Reallocate
-    void* new_ptr = realloc(ptr, size);
+void* calloc_tracked(size_t num, size_t size, const char* func, int line) {
+    void* ptr = calloc(num, size);
+    if (ptr && memory_tracking_enabled) {
+        track_alloc(ptr, num * size, func, line);
+    }
+    return ptr;
+}
 
-    // Add new tracking entry
-    if (new_ptr && alloc_count < MAX_ALLOCS) {
-        for (int i = 0; i < MAX_ALLOCS; i++) {
-            if (!alloc_table[i].used) {
-                alloc_table[i].ptr = new_ptr;
-                alloc_table[i].size = size;
-                alloc_table[i].func = func;
-                alloc_table[i].line = line;
-                alloc_table[i].used = 1;
-                alloc_count++;
-                total_allocated += size;
-                break;
-            }
+// ===== ALLOCATION TABLE =====
+
+static inline uint32_t ptr_hash(const void *ptr) {
+    return (uint32_t)(((uintptr_t)ptr >> 3) * 2654435761u);
+}
+
+static void track_alloc(void *ptr, size_t size, const char *func, int line) {
+    if (!tracking_ready) {
+        return;
+    }
+
+    uint32_t hash = ptr_hash(ptr);
+    alloc_stripe_t *stripe = &alloc_stripes[hash >> 28];
+
+    // Site first so the stripe lock is never held while taking site_lock
+    sceKernelLockLwMutex(&site_lock, 1, NULL);
+    int site = find_site(func, line);
+    if (site >= 0) {
+        alloc_site_t *entry = &alloc_sites[site];
+        entry->count++;
+        entry->total_allocs++;
+        entry->bytes += size;
+        if (entry->bytes > entry->peak_bytes) {
+            entry->peak_bytes = entry->bytes;
         }
     }
+    sceKernelUnlockLwMutex(&site_lock, 1);
+
+    sceKernelLockLwMutex(&stripe->lock, 1, NULL);
+    int stored = 0;
+    if (stripe->count < ALLOC_STRIPE_SLOTS - 1) {
+        uint32_t index = hash & (ALLOC_STRIPE_SLOTS - 1);
+        while (stripe->slots[index].ptr) {
+            index = (index + 1) & (ALLOC_STRIPE_SLOTS - 1);
+        }
+        stripe->slots[index].ptr = ptr;
+        stripe->slots[index].size = size;
+        stripe->slots[index].site = site;
+        stripe->count++;
+        stored = 1;
+    }
+    sceKernelUnlockLwMutex(&stripe->lock, 1);
+
+    if (!stored) {
+        // Give the site its bytes back; this block won't be seen again on free
+        if (site >= 0) {
+            sceKernelLockLwMutex(&site_lock, 1, NULL);
+            alloc_sites[site].count--;
+            alloc_sites[site].bytes -= size;
+            sceKernelUnlockLwMutex(&site_lock, 1);
+        }
+        __atomic_add_fetch(&untracked_allocs, 1, __ATOMIC_RELAXED);
+        return;
+    }
 
-    return new_ptr;
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    size_t total = __atomic_add_fetch(&total_allocated, size, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&peak_allocated, __ATOMIC_RELAXED);
+    while (total > peak &&
+           !__atomic_compare_exchange_n(&peak_allocated, &peak, total, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
 }
 
-void* calloc_tracked(size_t num, size_t size, const char* func, int line) {
-    if (!memory_tracking_enabled) {
-        return calloc(num, size);
+static void untrack_alloc(void *ptr) {
+    if (!tracking_ready) {
+        return;
     }
 
-    size_t total_size = num * size;
-    void* ptr = calloc(num, size);
+    uint32_t hash = ptr_hash(ptr);
+    alloc_stripe_t *stripe = &alloc_stripes[hash >> 28];
+    size_t size = 0;
+    int site = -1;
+    int found = 0;
+
+    sceKernelLockLwMutex(&stripe->lock, 1, NULL);
+    uint32_t index = hash & (ALLOC_STRIPE_SLOTS - 1);
+    while (stripe->slots[index].ptr) {
+        if (stripe->slots[index].ptr == ptr) {
+            size = stripe->slots[index].size;
+            site = stripe->slots[index].site;
+            found = 1;
+            break;
+        }
+        index = (index + 1) & (ALLOC_STRIPE_SLOTS - 1);
+    }
 
-    if (ptr && alloc_count < MAX_ALLOCS) {
-        for (int i = 0; i < MAX_ALLOCS; i++) {
-            if (!alloc_table[i].used) {
-                alloc_table[i].ptr = ptr;
-                alloc_table[i].size = total_size;
-                alloc_table[i].func = func;
-                alloc_table[i].line = line;
-                alloc_table[i].used = 1;
-                alloc_count++;
-                total_allocated += total_size;
-                break;
+    if (found) {
+        // Backward-shift delete keeps every probe chain unbroken
+        uint32_t hole = index;
+        uint32_t next = (hole + 1) & (ALLOC_STRIPE_SLOTS - 1);
+        while (stripe->slots[next].ptr) {
+            uint32_t home = ptr_hash(stripe->slots[next].ptr) & (ALLOC_STRIPE_SLOTS - 1);
+            if (((next - home) & (ALLOC_STRIPE_SLOTS - 1)) >= ((next - hole) & (ALLOC_STRIPE_SLOTS - 1))) {
+                stripe->slots[hole] = stripe->slots[next];
+                hole = next;
             }
+            next = (next + 1) & (ALLOC_STRIPE_SLOTS - 1);
         }
+        stripe->slots[hole].ptr = NULL;
+        stripe->count--;
     }
+    sceKernelUnlockLwMutex(&stripe->lock, 1);
 
-    return ptr;
+    if (!found) {
+        return;
+    }
+
+    __atomic_sub_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&total_allocated, size, __ATOMIC_RELAXED);
+    if (site >= 0) {
+        sceKernelLockLwMutex(&site_lock, 1, NULL);
+        alloc_sites[site].count--;
+        alloc_sites[site].bytes -= size;
+        sceKernelUnlockLwMutex(&site_lock, 1);
+    }
+}
+
+// Called with site_lock held; -1 once every site slot is taken
+static int find_site(const char *func, int line) {
+    if (!func) {
+        func = "?";
+    }
+
+    uint32_t hash = (uint32_t)((uintptr_t)func * 2654435761u) ^ (uint32_t)line * 40503u;
+    for (int probe = 0; probe < ALLOC_SITE_SLOTS; probe++) {
+        int index = (int)((hash + probe) & (ALLOC_SITE_SLOTS - 1));
+        alloc_site_t *site = &alloc_sites[index];
+        if (!site->func) {
+            site->func = func;
+            site->line = line;
+            return index;
+        }
+        if (site->func == func && site->line == line) {
+            return index;
+        }
+    }
+    return -1;
 }
 
 // ===== OTHER PATCHES =====
@@ -274,29 +388,91 @@ static void patch_monetization_system(void) {
 
 // ===== MEMORY TRACKING UTILITIES =====
 
+static int compare_sites(const void *a, const void *b) {
+    const alloc_site_t *sa = (const alloc_site_t *)a;
+    const alloc_site_t *sb = (const alloc_site_t *)b;
+    if (sa->peak_bytes != sb->peak_bytes) {
+        return sa->peak_bytes < sb->peak_bytes ? 1 : -1;
+    }
+    return 0;
+}
+
 void print_memory_stats(void) {
+#if SOLOADER_LOG_LEVEL <= LT_INFO
+    int count = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+    size_t total = __atomic_load_n(&total_allocated, __ATOMIC_RELAXED);
+#endif
+
     l_info("=== Memory Statistics ===");
-    l_info("  Total allocations: %d", alloc_count);
-    l_info("  Total allocated: %zu bytes", total_allocated);
-    l_info("  Average allocation: %zu bytes", alloc_count > 0 ? total_allocated / alloc_count : 0);
+    l_info("  Total allocations: %d", count);
+    l_info("  Total allocated: %zu bytes", total);
+    l_info("  Peak allocated: %zu bytes", (size_t)peak_allocated);
+    l_info("  Average allocation: %zu bytes", count > 0 ? total / count : 0);
+    if (untracked_allocs > 0) {
+        l_info("  Untracked (table full): %d", untracked_allocs);
+    }
+
+    if (!tracking_ready) {
+        return;
+    }
 
     // Memory usage by category
     size_t small_allocs = 0, medium_allocs = 0, large_allocs = 0;
-    for (int i = 0; i < MAX_ALLOCS; i++) {
-        if (alloc_table[i].used) {
-            if (alloc_table[i].size < 1024) {
+    for (int i = 0; i < ALLOC_STRIPES; i++) {
+        alloc_stripe_t *stripe = &alloc_stripes[i];
+        sceKernelLockLwMutex(&stripe->lock, 1, NULL);
+        for (int j = 0; j < ALLOC_STRIPE_SLOTS; j++) {
+            if (!stripe->slots[j].ptr) {
+                continue;
+            }
+            if (stripe->slots[j].size < 1024) {
                 small_allocs++;
-            } else if (alloc_table[i].size < 65536) {
+            } else if (stripe->slots[j].size < 65536) {
                 medium_allocs++;
             } else {
                 large_allocs++;
             }
         }
+        sceKernelUnlockLwMutex(&stripe->lock, 1);
     }
 
     l_info("  Small allocations (<1KB): %zu", small_allocs);
     l_info("  Medium allocations (1KB-64KB): %zu", medium_allocs);
     l_info("  Large allocations (>64KB): %zu", large_allocs);
+
+#if MEM_POOL
+    // The game's own small allocations
+    size_t pool_used, pool_capacity;
+    mem_pool_get_usage(&pool_used, &pool_capacity);
+    l_info("  Pool arena: %zu of %zu KB in slabs, %d newlib fallbacks",
+           pool_used / 1024, pool_capacity / 1024, mem_pool_fallbacks());
+    for (int i = 0; i < MEM_POOL_CLASSES; i++) {
+        mem_pool_class_stats_t pool;
+        if (mem_pool_get_class_stats(i, &pool) == 0 && pool.slabs > 0) {
+            l_info("    %4zu B: %d slabs, %d in use, peak %d",
+                   pool.block_size, pool.slabs, pool.in_use, pool.peak_in_use);
+        }
+    }
+#endif
+
+    // Call sites by high-water mark
+    static alloc_site_t sites[ALLOC_SITE_SLOTS];
+    int site_count = 0;
+    sceKernelLockLwMutex(&site_lock, 1, NULL);
+    for (int i = 0; i < ALLOC_SITE_SLOTS; i++) {
+        if (alloc_sites[i].func) {
+            sites[site_count++] = alloc_sites[i];
+        }
+    }
+    sceKernelUnlockLwMutex(&site_lock, 1);
+
+    qsort(sites, site_count, sizeof(alloc_site_t), compare_sites);
+    l_info("  Top call sites (%d tracked):", site_count);
+    for (int i = 0; i < site_count && i < ALLOC_TOP_SITES; i++) {
+        l_info("    %s:%d  live %d / %zu bytes, peak %zu bytes, %u allocs",
+               sites[i].func, sites[i].line, sites[i].count, sites[i].bytes,
+               sites[i].peak_bytes, sites[i].total_allocs);
+    }
 }
 
 void cleanup_memory_tracking(void) {
@@ -306,14 +482,18 @@ void cleanup_memory_tracking(void) {
 
     l_info("Cleaning up memory tracking");
 
-    // Check for leaks
+    // Check for leaks, reported per call site
     int leaks = 0;
-    for (int i = 0; i < MAX_ALLOCS; i++) {
-        if (alloc_table[i].used) {
-            leaks++;
-            l_warn("Memory leak: %zu bytes at %s:%d",
-                   alloc_table[i].size, alloc_table[i].func, alloc_table[i].line);
+    if (tracking_ready) {
+        sceKernelLockLwMutex(&site_lock, 1, NULL);
+        for (int i = 0; i < ALLOC_SITE_SLOTS; i++) {
+            if (alloc_sites[i].func && alloc_sites[i].count > 0) {
+                leaks += alloc_sites[i].count;
+                l_warn("Memory leak: %d blocks, %zu bytes at %s:%d", alloc_sites[i].count,
+                       alloc_sites[i].bytes, alloc_sites[i].func, alloc_sites[i].line);
+            }
         }
+        sceKernelUnlockLwMutex(&site_lock, 1);
     }
 
     if (leaks > 0) {
@@ -0,0 +1,268 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Path Mapping
+ *
+ * Rules are literal prefixes in a byte trie, with '*' standing for one
+ * path component (the package name); the longest prefix that matches is
+ * replaced. Resolved paths go into an open-addressed table keyed on the
+ * source path and its kind, source and mapping side by side in one string
+ * pool. Inserts take a lock; lookups don't, since a slot is published with
+ * a release store only once its strings are in place and nothing is ever
+ * removed.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "path_map.h"
+#include "utils/logger.h"
+
+#define PATH_MAP_TRIE_NODES 512
+#define PATH_MAP_SLOTS 8192             // Power of two, kept at most half full
+#define PATH_MAP_POOL_SIZE (512 * 1024)
+#define PATH_MAP_MAX_PATH 512
+
+typedef enum {
+    PATH_KIND_FILE = 0,
+    PATH_KIND_ASSET
+} path_kind_t;
+
+typedef struct {
+    const char *prefix;
+    const char *replacement;
+} path_rule_t;
+
+typedef struct {
+    char c;                             // Edge into this node; '*' = one path component
+    int16_t child;                      // First child, -1 if none
+    int16_t sibling;
+    int16_t rule;                       // Rule whose prefix ends here, -1 if none
+} trie_node_t;
+
+typedef struct {
+    uint32_t hash;
+    uint32_t key;                       // Pool offset of the source path
+    uint32_t value;                     // Pool offset of the mapped path
+    uint32_t kind;                      // path_kind_t + 1 once published, 0 = empty
+} intern_slot_t;
+
+static const path_rule_t rules[] = {
+    { "/proc/",                                   "app0:/" },
+    { "/data/data/*/",                            DATA_PATH },
+    { "/data/user/0/*/",                          DATA_PATH },
+    { "/sdcard/Android/data/*/files/",            DATA_PATH },
+    { "/storage/emulated/0/Android/data/*/files/", DATA_PATH },
+    { "file:///android_asset/",                   PATH_MAP_ASSET_ROOT },
+};
+
+static trie_node_t trie[PATH_MAP_TRIE_NODES];
+static int trie_count = 0;
+
+static intern_slot_t slots[PATH_MAP_SLOTS];
+static char pool[PATH_MAP_POOL_SIZE];
+static uint32_t pool_used = 0;
+static int interned = 0;
+static SceKernelLwMutexWork intern_lock;
+static volatile int map_state = 0;      // 0 = not built, 1 = building, 2 = ready
+
+// Function prototypes
+static const char *resolve(path_kind_t kind, const char *path, char *scratch, size_t size);
+static int expand(path_kind_t kind, const char *path, char *out, size_t size);
+static int trie_insert(const char *prefix, int rule);
+static void trie_match(int node, const char *path, int consumed, int *rule, int *length);
+static uint32_t path_hash(path_kind_t kind, const char *path);
+
+int path_map_init(void) {
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&map_state, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Built, or another thread is building it
+        while (__atomic_load_n(&map_state, __ATOMIC_ACQUIRE) != 2) {
+            sceKernelDelayThread(100);
+        }
+        return 0;
+    }
+
+    trie[0].child = -1;
+    trie[0].sibling = -1;
+    trie[0].rule = -1;
+    trie_count = 1;
+    for (int i = 0; i < (int)ARRAY_SIZE(rules); i++) {
+        if (trie_insert(rules[i].prefix, i) < 0) {
+            l_error("Path map: trie full at rule %s", rules[i].prefix);
+        }
+    }
+
+    sceKernelCreateLwMutex(&intern_lock, "path_map", 0, 0, NULL);
+    __atomic_store_n(&map_state, 2, __ATOMIC_RELEASE);
+
+    l_info("Path map: %d rules, %d trie nodes", (int)ARRAY_SIZE(rules), trie_count);
+    return 0;
+}
+
+const char *path_map_resolve(const char *path, char *scratch, size_t size) {
+    return resolve(PATH_KIND_FILE, path, scratch, size);
+}
+
+const char *path_map_asset(const char *name, char *scratch, size_t size) {
+    return resolve(PATH_KIND_ASSET, name, scratch, size);
+}
+
+// ===== INTERNING =====
+
+static const char *resolve(path_kind_t kind, const char *path, char *scratch, size_t size) {
+    if (!path) {
+        return NULL;
+    }
+    if (__atomic_load_n(&map_state, __ATOMIC_ACQUIRE) != 2) {
+        path_map_init();
+    }
+
+    uint32_t hash = path_hash(kind, path);
+    uint32_t slot = hash & (PATH_MAP_SLOTS - 1);
+
+    // Published slots never change, so the probe needs no lock
+    uint32_t state;
+    while ((state = __atomic_load_n(&slots[slot].kind, __ATOMIC_ACQUIRE)) != 0) {
+        if (state == (uint32_t)kind + 1 && slots[slot].hash == hash && strcmp(pool + slots[slot].key, path) == 0) {
+            return pool + slots[slot].value;
+        }
+        slot = (slot + 1) & (PATH_MAP_SLOTS - 1);
+    }
+
+    char mapped[PATH_MAP_MAX_PATH];
+    int mapped_len = expand(kind, path, mapped, sizeof(mapped));
+    if (mapped_len < 0) {
+        l_error("Path map: path too long: %s", path);
+        return NULL;
+    }
+
+    size_t key_len = strlen(path) + 1;
+    int same = kind == PATH_KIND_FILE && strcmp(mapped, path) == 0;
+    size_t needed = key_len + (same ? 0 : (size_t)mapped_len + 1);
+    const char *result = NULL;
+
+    sceKernelLockLwMutex(&intern_lock, 1, NULL);
+    // Another thread may have interned it since the lock-free probe
+    while ((state = slots[slot].kind) != 0) {
+        if (state == (uint32_t)kind + 1 && slots[slot].hash == hash && strcmp(pool + slots[slot].key, path) == 0) {
+            result = pool + slots[slot].value;
+            break;
+        }
+        slot = (slot + 1) & (PATH_MAP_SLOTS - 1);
+    }
+
+    if (!result && interned < PATH_MAP_SLOTS / 2 && pool_used + needed <= PATH_MAP_POOL_SIZE) {
+        intern_slot_t *entry = &slots[slot];
+        entry->hash = hash;
+        entry->key = pool_used;
+        memcpy(pool + pool_used, path, key_len);
+        entry->value = same ? pool_used : pool_used + (uint32_t)key_len;
+        if (!same) {
+            memcpy(pool + entry->value, mapped, (size_t)mapped_len + 1);
+        }
+        pool_used += (uint32_t)needed;
+        interned++;
+        __atomic_store_n(&entry->kind, (uint32_t)kind + 1, __ATOMIC_RELEASE);
+        result = pool + entry->value;
+    }
+    sceKernelUnlockLwMutex(&intern_lock, 1);
+
+    if (result) {
+        return result;
+    }
+
+    // Table full: this path is mapped again on every open
+    if (!scratch || (size_t)mapped_len + 1 > size) {
+        return NULL;
+    }
+    memcpy(scratch, mapped, (size_t)mapped_len + 1);
+    return scratch;
+}
+
+// Apply the longest matching rule; length of the result, or -1 if it doesn't fit
+static int expand(path_kind_t kind, const char *path, char *out, size_t size) {
+    const char *replacement = "";
+    const char *rest = path;
+
+    if (kind == PATH_KIND_ASSET) {
+        replacement = PATH_MAP_ASSET_ROOT;
+    } else {
+        int rule = -1;
+        int length = 0;
+        trie_match(0, path, 0, &rule, &length);
+        if (rule >= 0) {
+            replacement = rules[rule].replacement;
+            rest = path + length;
+        }
+    }
+
+    size_t head = strlen(replacement);
+    size_t tail = strlen(rest);
+    if (head + tail + 1 > size) {
+        return -1;
+    }
+    memcpy(out, replacement, head);
+    memcpy(out + head, rest, tail + 1);
+    return (int)(head + tail);
+}
+
+// ===== RULE TRIE =====
+
+static int trie_insert(const char *prefix, int rule) {
+    int node = 0;
+    for (const char *p = prefix; *p; p++) {
+        int child = trie[node].child;
+        while (child >= 0 && trie[child].c != *p) {
+            child = trie[child].sibling;
+        }
+
+        if (child < 0) {
+            if (trie_count >= PATH_MAP_TRIE_NODES) {
+                return -1;
+            }
+            child = trie_count++;
+            trie[child].c = *p;
+            trie[child].child = -1;
+            trie[child].rule = -1;
+            trie[child].sibling = trie[node].child;
+            trie[node].child = (int16_t)child;
+        }
+        node = child;
+    }
+
+    trie[node].rule = (int16_t)rule;
+    return 0;
+}
+
+// Longest rule prefix of path below `node`
+static void trie_match(int node, const char *path, int consumed, int *rule, int *length) {
+    if (trie[node].rule >= 0 && consumed >= *length) {
+        *rule = trie[node].rule;
+        *length = consumed;
+    }
+
+    for (int child = trie[node].child; child >= 0; child = trie[child].sibling) {
+        if (trie[child].c == '*') {
+            int span = 0;
+            while (path[consumed + span] && path[consumed + span] != '/') {
+                span++;
+            }
+            if (span > 0) {
+                trie_match(child, path, consumed + span, rule, length);
+            }
+        } else if (trie[child].c == path[consumed]) {
+            trie_match(child, path, consumed + 1, rule, length);
+        }
+    }
+}
+
+static uint32_t path_hash(path_kind_t kind, const char *path) {
+    uint32_t hash = 2166136261u ^ (uint32_t)kind;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,311 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Performance HUD
+ *
+ * Everything is drawn as untextured quads through vitaGL's fixed-function
+ * immediate mode, text included: a 3x5 bitmap font, one quad per lit pixel.
+ * That needs no texture or shader of its own, so turning the HUD on can't
+ * disturb the texture cache or the shader manifest. The GL state the HUD
+ * touches is saved and put back, since the game sets much of its state once
+ * and expects it to survive across frames.
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <vitaGL.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "asset_handler.h"
+#include "audio.h"
+#include "graphics.h"
+#include "perf_hud.h"
+#include "utils/logger.h"
+
+#define HUD_X 8
+#define HUD_Y 8
+#define HUD_WIDTH (PERF_HUD_HISTORY * 2 + 16)
+#define HUD_GRAPH_HEIGHT 100
+#define HUD_GRAPH_MS 33.4f              // Graph top; two 60 Hz frames
+#define HUD_TEXT_SCALE 2
+#define HUD_LINE_HEIGHT (6 * HUD_TEXT_SCALE + 4)
+#define HUD_LINES 6
+#define HUD_AVERAGE_FRAMES 30
+
+typedef struct {
+    uint32_t us[PERF_HUD_SECTIONS];
+    uint32_t total_us;
+} hud_frame_t;
+
+static const uint8_t section_colors[PERF_HUD_SECTIONS][3] = {
+    { 0x40, 0xC0, 0xFF },               // Input
+    { 0x50, 0xE0, 0x50 },               // Update
+    { 0xFF, 0x90, 0x20 },               // GL
+    { 0x60, 0x60, 0x80 },               // Wait
+};
+
+static const char *section_names[PERF_HUD_SECTIONS] = { "IN", "UPD", "GL", "WAIT" };
+
+// 3x5 glyphs for ' ' .. 'Z', rows top to bottom, 3 bits each, MSB left
+static const uint16_t font[] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01C0, 0x0002, 0x12A4,
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249,
+    0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+    0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+    0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+    0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+    0x5AAD, 0x5A92, 0x72A7,
+};
+
+static hud_frame_t history[PERF_HUD_HISTORY];
+static hud_frame_t current;
+static int history_pos = 0;
+static int visible = 0;
+
+// Audio thread CPU, sampled once per frame while visible
+static uint64_t audio_last_clocks = 0;
+static uint64_t audio_last_time = 0;
+static float audio_ms = 0.0f;
+static float audio_percent = 0.0f;
+
+// Function prototypes
+static void sample_audio_cpu(void);
+static void quad(float x, float y, float w, float h, uint8_t r, uint8_t g, uint8_t b, uint8_t a);
+static void text(float x, float y, const char *s);
+static void draw_graph(float x, float y);
+static void draw_stats(float x, float y);
+
+void perf_hud_toggle(void) {
+    visible = !visible;
+    audio_last_time = 0;
+    l_info("Performance HUD %s", visible ? "shown" : "hidden");
+}
+
+int perf_hud_visible(void) {
+    return visible;
+}
+
+void perf_hud_add(perf_hud_section_t section, uint64_t us) {
+    if (section < PERF_HUD_SECTIONS) {
+        current.us[section] += (uint32_t)us;
+    }
+}
+
+void perf_hud_end_frame(void) {
+    uint32_t total = 0;
+    for (int i = 0; i < PERF_HUD_SECTIONS; i++) {
+        total += current.us[i];
+    }
+    current.total_us = total;
+
+    history[history_pos] = current;
+    history_pos = (history_pos + 1) % PERF_HUD_HISTORY;
+    memset(&current, 0, sizeof(current));
+
+    if (visible) {
+        sample_audio_cpu();
+    }
+}
+
+void perf_hud_draw(void) {
+    if (!visible) {
+        return;
+    }
+
+    // Save what the HUD changes
+    GLint program = 0, matrix_mode = 0, blend_src = 0, blend_dst = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_MATRIX_MODE, &matrix_mode);
+    glGetIntegerv(GL_BLEND_SRC, &blend_src);
+    glGetIntegerv(GL_BLEND_DST, &blend_dst);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cull = glIsEnabled(GL_CULL_FACE);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    GLboolean texture = glIsEnabled(GL_TEXTURE_2D);
+    GLboolean alpha_test = glIsEnabled(GL_ALPHA_TEST);
+
+    glUseProgram(0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_ALPHA_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    float height = HUD_GRAPH_HEIGHT + 8 + HUD_LINES * HUD_LINE_HEIGHT + 8;
+    glBegin(GL_QUADS);
+    quad(HUD_X, HUD_Y, HUD_WIDTH, height, 0, 0, 0, 0xA0);
+    draw_graph(HUD_X + 8, HUD_Y + 8);
+    draw_stats(HUD_X + 8, HUD_Y + 16 + HUD_GRAPH_HEIGHT);
+    glEnd();
+
+    // Restore the game's state
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glMatrixMode(matrix_mode);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glBlendFunc(blend_src, blend_dst);
+    if (!blend) glDisable(GL_BLEND);
+    if (depth) glEnable(GL_DEPTH_TEST);
+    if (cull) glEnable(GL_CULL_FACE);
+    if (scissor) glEnable(GL_SCISSOR_TEST);
+    if (texture) glEnable(GL_TEXTURE_2D);
+    if (alpha_test) glEnable(GL_ALPHA_TEST);
+    glUseProgram(program);
+}
+
+// ===== DRAWING =====
+
+static void quad(float x, float y, float w, float h, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    glColor4ub(r, g, b, a);
+    glVertex2f(x, y);
+    glVertex2f(x + w, y);
+    glVertex2f(x + w, y + h);
+    glVertex2f(x, y + h);
+}
+
+static void text(float x, float y, const char *s) {
+    const float px = HUD_TEXT_SCALE;
+    for (; *s; s++, x += 4 * px) {
+        int c = *s;
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        if (c < ' ' || c > 'Z') {
+            continue;
+        }
+
+        uint16_t bits = font[c - ' '];
+        for (int row = 0; row < 5; row++) {
+            for (int col = 0; col < 3; col++) {
+                if (bits & (1 << (14 - row * 3 - col))) {
+                    quad(x + col * px, y + row * px, px, px, 0xFF, 0xFF, 0xFF, 0xFF);
+                }
+            }
+        }
+    }
+}
+
+// Oldest frame on the left; each bar stacks the sections bottom up
+static void draw_graph(float x, float y) {
+    const float scale = HUD_GRAPH_HEIGHT / (HUD_GRAPH_MS * 1000.0f);
+
+    for (int i = 0; i < PERF_HUD_HISTORY; i++) {
+        const hud_frame_t *frame = &history[(history_pos + i) % PERF_HUD_HISTORY];
+        float bottom = y + HUD_GRAPH_HEIGHT;
+        for (int s = 0; s < PERF_HUD_SECTIONS && bottom > y; s++) {
+            float h = frame->us[s] * scale;
+            if (bottom - h < y) {
+                h = bottom - y;
+            }
+            bottom -= h;
+            quad(x + i * 2, bottom, 2, h, section_colors[s][0], section_colors[s][1], section_colors[s][2], 0xE0);
+        }
+    }
+
+    // 60 and 30 Hz budgets
+    quad(x, y + HUD_GRAPH_HEIGHT - 16667 * scale, PERF_HUD_HISTORY * 2, 1, 0xFF, 0xFF, 0xFF, 0x80);
+    quad(x, y, PERF_HUD_HISTORY * 2, 1, 0xFF, 0x40, 0x40, 0x80);
+}
+
+static void draw_stats(float x, float y) {
+    char line[64];
+    float avg[PERF_HUD_SECTIONS] = { 0 };
+    float avg_total = 0.0f;
+    uint32_t worst = 0;
+
+    for (int i = 0; i < PERF_HUD_HISTORY; i++) {
+        const hud_frame_t *frame = &history[(history_pos + PERF_HUD_HISTORY - 1 - i) % PERF_HUD_HISTORY];
+        if (frame->total_us > worst) {
+            worst = frame->total_us;
+        }
+        if (i < HUD_AVERAGE_FRAMES) {
+            for (int s = 0; s < PERF_HUD_SECTIONS; s++) {
+                avg[s] += frame->us[s] / (1000.0f * HUD_AVERAGE_FRAMES);
+            }
+            avg_total += frame->total_us / (1000.0f * HUD_AVERAGE_FRAMES);
+        }
+    }
+
+    snprintf(line, sizeof(line), "FRAME %.1f MS  MAX %.1f MS", avg_total, worst / 1000.0f);
+    text(x, y, line);
+    y += HUD_LINE_HEIGHT;
+
+    float cx = x;
+    for (int s = 0; s < PERF_HUD_SECTIONS; s++) {
+        quad(cx, y, 3 * HUD_TEXT_SCALE, 5 * HUD_TEXT_SCALE,
+             section_colors[s][0], section_colors[s][1], section_colors[s][2], 0xFF);
+        snprintf(line, sizeof(line), "%s %.1f", section_names[s], avg[s]);
+        text(cx + 4 * HUD_TEXT_SCALE, y, line);
+        cx += (strlen(line) + 2) * 4 * HUD_TEXT_SCALE;
+    }
+    y += HUD_LINE_HEIGHT;
+
+    graphics_frame_stats_t frame_stats;
+    graphics_get_frame_stats(&frame_stats);
+    snprintf(line, sizeof(line), "CPU %.1f P99 %.1f  GPU %.1f P99 %.1f",
+             frame_stats.cpu.avg_ms, frame_stats.cpu.p99_ms, frame_stats.gpu.avg_ms, frame_stats.gpu.p99_ms);
+    text(x, y, line);
+    y += HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "AUDIO %.2f MS  %.0f%% CPU", audio_ms, audio_percent);
+    text(x, y, line);
+    y += HUD_LINE_HEIGHT;
+
+    struct mallinfo heap = mallinfo();
+    snprintf(line, sizeof(line), "HEAP %d/%d MB  ASSETS %d/%d MB",
+             (int)(heap.uordblks >> 20), HEAP_SIZE >> 20,
+             (int)(asset_get_cache_usage() >> 20), (int)(asset_get_cache_budget() >> 20));
+    text(x, y, line);
+    y += HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "FREE VRAM %d MB  RAM %d MB",
+             (int)(vglMemFree(VGL_MEM_VRAM) >> 20), (int)(vglMemFree(VGL_MEM_RAM) >> 20));
+    text(x, y, line);
+}
+
+// ===== AUDIO CPU =====
+
+static void sample_audio_cpu(void) {
+    int thread = audio_get_thread_id();
+    if (thread < 0) {
+        return;
+    }
+
+    SceKernelThreadInfo info;
+    memset(&info, 0, sizeof(info));
+    info.size = sizeof(info);
+    if (sceKernelGetThreadInfo(thread, &info) < 0) {
+        return;
+    }
+
+    uint64_t now = sceKernelGetProcessTimeWide();
+    uint64_t clocks = info.runClocks;
+    if (audio_last_time != 0 && now > audio_last_time) {
+        float run_us = (float)(clocks - audio_last_clocks);
+        float wall_us = (float)(now - audio_last_time);
+        // Per frame, smoothed so the readout is legible
+        audio_ms += (run_us / 1000.0f - audio_ms) * 0.1f;
+        audio_percent += (run_us * 100.0f / wall_us - audio_percent) * 0.1f;
+    }
+    audio_last_clocks = clocks;
+    audio_last_time = now;
+}
@@ -0,0 +1,179 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Performance Profiles and Clock Governor
+ *
+ * Clocks move along two short ladders, one for the ARM cores and one for
+ * the GPU with the bus and crossbar that feed it, so the governor only ever
+ * asks for combinations known to be stable. It reads the rolling frame
+ * stats every GOVERNOR_WINDOW frames: a p99 over budget steps that side up
+ * at once, while stepping down waits for several windows of headroom, so a
+ * level that was just needed is not given up on one quiet stretch. The
+ * window is as long as the stats history, so each decision sees only
+ * frames run at the current clocks.
+ */
+
+#include <string.h>
+#include <vitaGL.h>
+#include <psp2/power.h>
+
+#include "config.h"
+#include "frame_pacer.h"
+#include "graphics.h"
+#include "perf_profile.h"
+#include "utils/logger.h"
+#include "utils/settings.h"
+
+#define GOVERNOR_WINDOW 120             // Frames between decisions
+#define GOVERNOR_RAISE 0.95f            // p99 / budget that steps a clock up
+#define GOVERNOR_LOWER 0.60f            // p99 / budget that counts as headroom
+#define GOVERNOR_CALM_WINDOWS 5         // Windows of headroom before stepping down
+
+typedef struct {
+    int gpu;
+    int bus;
+    int xbar;
+} gpu_clocks_t;
+
+static const int cpu_ladder[] = { 333, 444 };
+
+static const gpu_clocks_t gpu_ladder[] = {
+    { 111, 166, 111 },
+    { 166, 222, 111 },
+    { 222, 222, 166 },
+};
+
+static const perf_profile_t profiles[PERF_PROFILE_COUNT] = {
+    { "battery", 0, 0, FRAME_PACE_30, SCE_GXM_MULTISAMPLE_NONE, 16 * 1024 * 1024, 16 },
+    { "balanced", 0, 1, FRAME_PACE_MODE, SCE_GXM_MULTISAMPLE_2X, VERTEX_RAM_SIZE, 24 },
+    { "max", 1, 2, FRAME_PACE_60, SCE_GXM_MULTISAMPLE_4X, VERTEX_RAM_SIZE, MAX_AUDIO_SOURCES },
+};
+
+static const perf_profile_t *profile = &profiles[PERF_PROFILE_DEFAULT];
+static int governor_enabled = 0;
+static int cpu_level = -1;
+static int gpu_level = -1;
+static int window_frames = 0;
+static int calm_windows = 0;
+
+// Function prototypes
+static void set_clocks(int cpu, int gpu);
+
+int perf_profile_init(void) {
+    int id = setting_perfProfile;
+    if (id < 0 || id >= PERF_PROFILE_COUNT) {
+        l_warn("Unknown performance profile %d, using %s", id, profiles[PERF_PROFILE_DEFAULT].name);
+        id = PERF_PROFILE_DEFAULT;
+    }
+    profile = &profiles[id];
+    governor_enabled = setting_perfGovernor;
+
+    perf_profile_boot_clocks();
+
+    l_success("Performance profile: %s (governor %s)", profile->name, governor_enabled ? "on" : "off");
+    return 0;
+}
+
+void perf_profile_boot_clocks(void) {
+    set_clocks((int)ARRAY_SIZE(cpu_ladder) - 1, (int)ARRAY_SIZE(gpu_ladder) - 1);
+}
+
+void perf_profile_start(void) {
+    set_clocks(profile->cpu_level, profile->gpu_level);
+    window_frames = 0;
+    calm_windows = 0;
+}
+
+void perf_governor_update(void) {
+    if (!governor_enabled || ++window_frames < GOVERNOR_WINDOW) {
+        return;
+    }
+    window_frames = 0;
+
+    graphics_frame_stats_t stats;
+    graphics_get_frame_stats(&stats);
+    if (stats.frames < GOVERNOR_WINDOW / 2) {
+        return;
+    }
+
+    float budget_ms = frame_pacer_interval() * 1000.0f / 60.0f;
+    int cpu = cpu_level;
+    int gpu = gpu_level;
+
+    if (stats.cpu.p99_ms > budget_ms * GOVERNOR_RAISE && cpu < (int)ARRAY_SIZE(cpu_ladder) - 1) {
+        cpu++;
+    }
+    if (stats.gpu.p99_ms > budget_ms * GOVERNOR_RAISE && gpu < (int)ARRAY_SIZE(gpu_ladder) - 1) {
+        gpu++;
+    }
+
+    if (cpu != cpu_level || gpu != gpu_level) {
+        calm_windows = 0;
+        l_info("Governor: CPU p99 %.1f ms, GPU p99 %.1f ms over %.1f ms budget, raising clocks",
+               stats.cpu.p99_ms, stats.gpu.p99_ms, budget_ms);
+        set_clocks(cpu, gpu);
+        return;
+    }
+
+    if (stats.cpu.p99_ms < budget_ms * GOVERNOR_LOWER && stats.gpu.p99_ms < budget_ms * GOVERNOR_LOWER) {
+        calm_windows++;
+    } else {
+        calm_windows = 0;
+    }
+
+    if (calm_windows >= GOVERNOR_CALM_WINDOWS &&
+        (cpu_level > profile->cpu_level || gpu_level > profile->gpu_level)) {
+        calm_windows = 0;
+        set_clocks(MAX(cpu_level - 1, profile->cpu_level), MAX(gpu_level - 1, profile->gpu_level));
+        l_info("Governor: headroom, lowering clocks");
+    }
+}
+
+const perf_profile_t *perf_profile_get(void) {
+    return profile;
+}
+
+int perf_profile_msaa(void) {
+#if ENABLE_MSAA
+    return profile->msaa;
+#else
+    return SCE_GXM_MULTISAMPLE_NONE;
+#endif
+}
+
+int perf_profile_find(const char *name) {
+    for (int i = 0; i < PERF_PROFILE_COUNT; i++) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *perf_profile_name(int id) {
+    return id >= 0 && id < PERF_PROFILE_COUNT ? profiles[id].name : "unknown";
+}
+
+void perf_profile_get_clocks(int *cpu_mhz, int *gpu_mhz) {
+    if (cpu_mhz) {
+        *cpu_mhz = cpu_level >= 0 ? cpu_ladder[cpu_level] : 0;
+    }
+    if (gpu_mhz) {
+        *gpu_mhz = gpu_level >= 0 ? gpu_ladder[gpu_level].gpu : 0;
+    }
+}
+
+// ===== CLOCKS =====
+
+static void set_clocks(int cpu, int gpu) {
+    if (cpu != cpu_level) {
+        scePowerSetArmClockFrequency(cpu_ladder[cpu]);
+        cpu_level = cpu;
+    }
+    if (gpu != gpu_level) {
+        scePowerSetBusClockFrequency(gpu_ladder[gpu].bus);
+        scePowerSetGpuClockFrequency(gpu_ladder[gpu].gpu);
+        scePowerSetGpuXbarClockFrequency(gpu_ladder[gpu].xbar);
+        gpu_level = gpu;
+    }
+    l_debug("Clocks: ARM %d, GPU %d MHz", cpu_ladder[cpu_level], gpu_ladder[gpu_level].gpu);
+}
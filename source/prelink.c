@@ -0,0 +1,228 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Prelink Cache
+ *
+ * The cache is keyed by the SHA-1 of the .so and a hash of the import table
+ * that includes every resolved address, so a rebuilt eboot, an edited table
+ * or a different library all miss. Hashing the whole .so costs a full read,
+ * so the file's size and mtime are kept alongside the digest and the SHA-1
+ * is only recomputed when that stamp changes.
+ *
+ * File layout: header, then n_fixups {offset, value} pairs for relocations
+ * outside the data segments, then each data segment's bytes in order.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/io/stat.h>
+#include <psp2/kernel/processmgr.h>
+#include <kubridge.h>
+
+#include "config.h"
+#include "prelink.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+#define PRELINK_PATH DATA_PATH "cache/prelink.bin"
+#define PRELINK_MAGIC 0x4B4E4C50     // "PLNK"
+#define PRELINK_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    char so_sha1[41];
+    uint8_t pad[3];
+    uint64_t so_size;
+    uint64_t so_mtime;
+    uint32_t dynlib_hash;
+    uint32_t text_base;
+    uint32_t n_data;
+    uint32_t data_base[MAX_DATA_SEG];
+    uint32_t data_size[MAX_DATA_SEG];
+    uint32_t n_fixups;
+} prelink_header_t;
+
+typedef struct {
+    uint32_t offset;                  // From text_base, as in the relocation
+    uint32_t value;
+} prelink_fixup_t;
+
+// Function prototypes
+static int so_stamp(const char *so_path, uint64_t *size, uint64_t *mtime);
+static int in_data(so_module *mod, uintptr_t addr);
+static int is_fixup_reloc(int type);
+
+int prelink_apply(so_module *mod, const char *so_path, uint32_t dynlib_hash) {
+#if PRELINK_CACHE
+#if SOLOADER_LOG_LEVEL <= LT_INFO
+    uint64_t start = sceKernelGetProcessTimeWide();
+#endif
+
+    uint8_t *buffer = NULL;
+    size_t size = 0;
+    if (!file_exists(PRELINK_PATH) || !file_load(PRELINK_PATH, &buffer, &size)) {
+        return -1;
+    }
+
+    prelink_header_t header;
+    int valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, buffer, sizeof(header));
+        valid = header.magic == PRELINK_MAGIC && header.version == PRELINK_VERSION &&
+                header.dynlib_hash == dynlib_hash && header.text_base == mod->text_base &&
+                header.n_data == (uint32_t)mod->n_data;
+    }
+
+    size_t expected = sizeof(header);
+    if (valid) {
+        expected += (size_t)header.n_fixups * sizeof(prelink_fixup_t);
+        for (int i = 0; i < mod->n_data; i++) {
+            valid &= header.data_base[i] == mod->data_base[i] && header.data_size[i] == mod->data_size[i];
+            expected += header.data_size[i];
+        }
+        valid &= expected == size;
+    }
+
+    if (valid) {
+        uint64_t so_size, so_mtime;
+        if (so_stamp(so_path, &so_size, &so_mtime) < 0) {
+            valid = 0;
+        } else if (so_size != header.so_size || so_mtime != header.so_mtime) {
+            // Touched since the snapshot; only the content decides
+            char *sha1 = file_sha1sum(so_path);
+            valid = sha1 && strcmp(sha1, header.so_sha1) == 0;
+            free(sha1);
+        }
+    }
+
+    if (!valid) {
+        l_info("Prelink cache is stale, relocating from scratch");
+        free(buffer);
+        sceIoRemove(PRELINK_PATH);
+        return -1;
+    }
+
+    const prelink_fixup_t *fixups = (const prelink_fixup_t *)(buffer + sizeof(header));
+    for (uint32_t i = 0; i < header.n_fixups; i++) {
+        kuKernelCpuUnrestrictedMemcpy((void *)(mod->text_base + fixups[i].offset), &fixups[i].value, sizeof(uint32_t));
+    }
+
+    const uint8_t *image = (const uint8_t *)(fixups + header.n_fixups);
+    for (int i = 0; i < mod->n_data; i++) {
+        kuKernelCpuUnrestrictedMemcpy((void *)mod->data_base[i], image, mod->data_size[i]);
+        image += mod->data_size[i];
+    }
+
+    free(buffer);
+    l_success("Prelink cache applied: %d segments, %u text fixups in %llu us",
+              mod->n_data, header.n_fixups, sceKernelGetProcessTimeWide() - start);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int prelink_store(so_module *mod, const char *so_path, uint32_t dynlib_hash) {
+#if PRELINK_CACHE
+    prelink_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PRELINK_MAGIC;
+    header.version = PRELINK_VERSION;
+    header.dynlib_hash = dynlib_hash;
+    header.text_base = mod->text_base;
+    header.n_data = mod->n_data;
+
+    if (so_stamp(so_path, &header.so_size, &header.so_mtime) < 0) {
+        return -1;
+    }
+    char *sha1 = file_sha1sum(so_path);
+    if (!sha1) {
+        return -1;
+    }
+    strncpy(header.so_sha1, sha1, sizeof(header.so_sha1) - 1);
+    free(sha1);
+
+    // Relocated words the segment images don't cover
+    for (int i = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
+        Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
+        if (is_fixup_reloc(ELF32_R_TYPE(rel->r_info)) && !in_data(mod, mod->text_base + rel->r_offset)) {
+            header.n_fixups++;
+        }
+    }
+
+    size_t size = sizeof(header) + (size_t)header.n_fixups * sizeof(prelink_fixup_t);
+    for (int i = 0; i < mod->n_data; i++) {
+        header.data_base[i] = mod->data_base[i];
+        header.data_size[i] = mod->data_size[i];
+        size += mod->data_size[i];
+    }
+
+    uint8_t *buffer = malloc(size);
+    if (!buffer) {
+        l_warn("Prelink cache: no memory for a %d KB snapshot", (int)(size / 1024));
+        return -1;
+    }
+
+    memcpy(buffer, &header, sizeof(header));
+    prelink_fixup_t *fixups = (prelink_fixup_t *)(buffer + sizeof(header));
+    for (int i = 0, n = 0; i < mod->num_reldyn + mod->num_relplt; i++) {
+        Elf32_Rel *rel = i < mod->num_reldyn ? &mod->reldyn[i] : &mod->relplt[i - mod->num_reldyn];
+        uintptr_t addr = mod->text_base + rel->r_offset;
+        if (is_fixup_reloc(ELF32_R_TYPE(rel->r_info)) && !in_data(mod, addr)) {
+            fixups[n].offset = rel->r_offset;
+            fixups[n].value = *(uint32_t *)addr;
+            n++;
+        }
+    }
+
+    uint8_t *image = (uint8_t *)(fixups + header.n_fixups);
+    for (int i = 0; i < mod->n_data; i++) {
+        memcpy(image, (void *)mod->data_base[i], mod->data_size[i]);
+        image += mod->data_size[i];
+    }
+
+    sceIoMkdir(DATA_PATH "cache", 0777);
+    int ok = file_save(PRELINK_PATH, buffer, size);
+    free(buffer);
+
+    if (!ok) {
+        l_warn("Prelink cache: could not write %s", PRELINK_PATH);
+        return -1;
+    }
+    l_success("Prelink cache stored: %d KB, %u text fixups", (int)(size / 1024), header.n_fixups);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+// ===== INTERNALS =====
+
+static int so_stamp(const char *so_path, uint64_t *size, uint64_t *mtime) {
+    SceIoStat stat;
+    if (sceIoGetstat(so_path, &stat) < 0) {
+        return -1;
+    }
+
+    *size = (uint64_t)stat.st_size;
+    *mtime = ((uint64_t)stat.st_mtime.year << 40) | ((uint64_t)stat.st_mtime.month << 32) |
+             ((uint64_t)stat.st_mtime.day << 24) | ((uint64_t)stat.st_mtime.hour << 16) |
+             ((uint64_t)stat.st_mtime.minute << 8) | stat.st_mtime.second;
+    return 0;
+}
+
+static int in_data(so_module *mod, uintptr_t addr) {
+    for (int i = 0; i < mod->n_data; i++) {
+        if (addr >= mod->data_base[i] && addr + sizeof(uint32_t) <= mod->data_base[i] + mod->data_size[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Relocation types so_relocate() and so_resolve() write through
+static int is_fixup_reloc(int type) {
+    return type == R_ARM_ABS32 || type == R_ARM_RELATIVE ||
+           type == R_ARM_GLOB_DAT || type == R_ARM_JUMP_SLOT;
+}
@@ -0,0 +1,237 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Hot-Path Profiler
+ *
+ * Each thread that records a zone claims one buffer, found by thread id in
+ * a small table, and is the only writer of it: an event is filled in and
+ * then published by bumping the buffer's count, so recording takes no lock.
+ * Events are complete spans (name, start, duration) written when the zone
+ * ends, which is what Chrome's "X" phase wants. Buffers are allocated when
+ * a capture starts and kept for the next one.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
+#include <psp2/kernel/processmgr.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "profiler.h"
+#include "utils/logger.h"
+
+#if ENABLE_PROFILING
+
+#define PROF_TRACE_PATH DATA_PATH "cache/trace.json"
+#define PROF_MAX_THREADS 16             // Power of two
+#define PROF_THREAD_EVENTS 8192
+#define PROF_WRITE_BUFFER (32 * 1024)
+
+typedef struct {
+    const char *name;
+    uint32_t start;                     // us since the capture began
+    uint32_t duration;
+} prof_event_t;
+
+typedef struct {
+    volatile SceUID owner;              // 0 = unclaimed
+    char thread_name[32];
+    volatile uint32_t count;
+    uint32_t dropped;
+    prof_event_t *events;
+} prof_buffer_t;
+
+volatile int prof_active = 0;
+
+static prof_buffer_t buffers[PROF_MAX_THREADS];
+static prof_event_t *event_storage = NULL;
+static uint64_t capture_base = 0;
+static int frames_left = 0;
+static int frame_index = 0;
+
+// Function prototypes
+static prof_buffer_t *thread_buffer(void);
+static int write_trace(void);
+
+uint32_t prof_now(void) {
+    return (uint32_t)(sceKernelGetProcessTimeWide() - capture_base);
+}
+
+void prof_record(const char *name, uint32_t start) {
+    uint32_t end = prof_now();
+    if (!prof_active) {
+        return;
+    }
+
+    prof_buffer_t *buffer = thread_buffer();
+    if (!buffer) {
+        return;
+    }
+
+    uint32_t index = buffer->count;
+    if (index >= PROF_THREAD_EVENTS) {
+        buffer->dropped++;
+        return;
+    }
+
+    prof_event_t *event = &buffer->events[index];
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+    __atomic_store_n(&buffer->count, index + 1, __ATOMIC_RELEASE);
+}
+
+void prof_capture_start(int frames) {
+    if (prof_active || frames <= 0) {
+        return;
+    }
+
+    if (!event_storage) {
+        event_storage = malloc(sizeof(prof_event_t) * PROF_THREAD_EVENTS * PROF_MAX_THREADS);
+        if (!event_storage) {
+            l_warn("Profiler: no memory for %d KB of event buffers",
+                   (int)(sizeof(prof_event_t) * PROF_THREAD_EVENTS * PROF_MAX_THREADS / 1024));
+            return;
+        }
+    }
+
+    for (int i = 0; i < PROF_MAX_THREADS; i++) {
+        buffers[i].owner = 0;
+        buffers[i].count = 0;
+        buffers[i].dropped = 0;
+        buffers[i].events = event_storage + i * PROF_THREAD_EVENTS;
+    }
+
+    frames_left = frames;
+    frame_index = 0;
+    capture_base = sceKernelGetProcessTimeWide();
+    __atomic_store_n(&prof_active, 1, __ATOMIC_RELEASE);
+    l_info("Profiler: capturing %d frames", frames);
+}
+
+void prof_frame(void) {
+    if (!prof_active) {
+        return;
+    }
+
+    frame_index++;
+    if (--frames_left > 0) {
+        return;
+    }
+
+    __atomic_store_n(&prof_active, 0, __ATOMIC_RELEASE);
+    // Let zones that were mid-record on other threads finish
+    sceKernelDelayThread(1000);
+    write_trace();
+}
+
+// ===== INTERNALS =====
+
+static prof_buffer_t *thread_buffer(void) {
+    SceUID self = sceKernelGetThreadId();
+    uint32_t hash = (uint32_t)self * 2654435761u;
+
+    for (int probe = 0; probe < PROF_MAX_THREADS; probe++) {
+        prof_buffer_t *buffer = &buffers[(hash + probe) & (PROF_MAX_THREADS - 1)];
+        SceUID owner = buffer->owner;
+        if (owner == self) {
+            return buffer;
+        }
+        if (owner == 0) {
+            SceUID expected = 0;
+            if (__atomic_compare_exchange_n(&buffer->owner, &expected, self, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                SceKernelThreadInfo info;
+                memset(&info, 0, sizeof(info));
+                info.size = sizeof(info);
+                if (sceKernelGetThreadInfo(self, &info) >= 0) {
+                    strncpy(buffer->thread_name, info.name, sizeof(buffer->thread_name) - 1);
+                } else {
+                    snprintf(buffer->thread_name, sizeof(buffer->thread_name), "thread %08X", self);
+                }
+                return buffer;
+            }
+            if (expected == self) {
+                return buffer;
+            }
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    SceUID fd;
+    char data[PROF_WRITE_BUFFER];
+    int used;
+} trace_writer_t;
+
+static void writer_flush(trace_writer_t *w) {
+    if (w->used > 0) {
+        sceIoWrite(w->fd, w->data, w->used);
+        w->used = 0;
+    }
+}
+
+static void writer_printf(trace_writer_t *w, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void writer_printf(trace_writer_t *w, const char *fmt, ...) {
+    if (w->used > PROF_WRITE_BUFFER - 256) {
+        writer_flush(w);
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->data + w->used, PROF_WRITE_BUFFER - w->used, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        w->used += n < PROF_WRITE_BUFFER - w->used ? n : PROF_WRITE_BUFFER - w->used - 1;
+    }
+}
+
+static int write_trace(void) {
+    static trace_writer_t w;
+
+    sceIoMkdir(DATA_PATH "cache", 0777);
+    w.fd = sceIoOpen(PROF_TRACE_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+    if (w.fd < 0) {
+        l_warn("Profiler: could not open %s: 0x%08X", PROF_TRACE_PATH, w.fd);
+        return -1;
+    }
+    w.used = 0;
+
+    int events = 0, dropped = 0;
+    int first = 1;
+    writer_printf(&w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < PROF_MAX_THREADS; i++) {
+        prof_buffer_t *buffer = &buffers[i];
+        if (buffer->owner == 0) {
+            continue;
+        }
+
+        writer_printf(&w, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                      first ? "" : ",\n", buffer->owner, buffer->thread_name);
+        first = 0;
+
+        uint32_t count = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+        for (uint32_t j = 0; j < count; j++) {
+            const prof_event_t *event = &buffer->events[j];
+            writer_printf(&w, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%u,\"dur\":%u}",
+                          event->name, buffer->owner, event->start, event->duration);
+        }
+        events += count;
+        dropped += buffer->dropped;
+    }
+    writer_printf(&w, "\n]}\n");
+    writer_flush(&w);
+    sceIoClose(w.fd);
+
+    l_success("Profiler: %d frames, %d events written to %s", frame_index, events, PROF_TRACE_PATH);
+    if (dropped > 0) {
+        l_warn("Profiler: %d events dropped, thread buffers full", dropped);
+    }
+    return 0;
+}
+
+#endif // ENABLE_PROFILING
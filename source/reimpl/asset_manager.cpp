@@ -1,12 +1,18 @@
 #include "reimpl/asset_manager.h"
 #include "utils/logger.h"
+#include "asset_dir.h"
+#include "asset_handler.h"
+#include "asset_pack.h"
+#include "io_trace.h"
+#include "path_map.h"
 
 #include <pthread.h>
 #include <malloc.h>
+#include <fcntl.h>
 #include <cstring>
 #include <cstdio>
-#include <libc_bridge/libc_bridge.h>
-#include <string>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
 
 typedef struct assetManager {
     int dummy = 0; // TODO: mb we will need to store something here in future
@@ -14,14 +20,152 @@ typedef struct assetManager {
 } assetManager;
 
 typedef struct aAsset {
-    char * filename;
-    FILE* f;
+    const char * path;                  // Mapped path, interned or in scratch
+    const char * name;                  // Asset-relative part of path
+    char scratch[256];                  // path, when the path map is full
+    int mode;
+    int slot;                           // Loose files: index into g_HandlePool
+    const asset_pack_entry_t * packed;  // Served from the archive handle
+    asset_handle_t handle;              // Pinned asset cache slot, if any
+    const void * view;                  // Whole asset in memory: cache slot or buffer
+    void * buffer;                      // Private copy owned by this AAsset
     size_t bytesRead;
     size_t fileSize;
+    uint16_t traceId;                   // io_trace path id of name
+    struct aAsset * nextFree;
 } asset;
 
+// Loose files stay open in a small LRU pool. Reads are positional, so every
+// AAsset over the same file shares one kernel handle (and the FIOS RAM cache
+// that fios_init() layers over DATA_PATH) and reopening costs nothing.
+#define ASSET_HANDLE_POOL_SIZE 16
+#define ASSET_OBJECT_POOL_SIZE 64
+
+typedef struct {
+    char path[256];
+    uint32_t hash;
+    SceUID fd;
+    int refs;
+    size_t size;
+    uint32_t lastUsed;
+} handleSlot;
+
+static handleSlot g_HandlePool[ASSET_HANDLE_POOL_SIZE];
+static uint32_t g_HandleClock = 0;
+static pthread_mutex_t g_PoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+// AAsset objects are recycled instead of allocated per open
+static aAsset g_AssetObjects[ASSET_OBJECT_POOL_SIZE];
+static aAsset * g_FreeAssets = nullptr;
+static int g_AssetObjectsReady = 0;
+
 static AAssetManager * g_AAssetManager = nullptr;
 
+static uint32_t path_hash(const char * path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t) *path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Returns a referenced pool slot for path, or -1 if it can't be opened
+static int handle_acquire(const char * path) {
+    uint32_t hash = path_hash(path);
+
+    pthread_mutex_lock(&g_PoolLock);
+
+    int victim = -1;
+    for (int i = 0; i < ASSET_HANDLE_POOL_SIZE; i++) {
+        handleSlot * slot = &g_HandlePool[i];
+        if (slot->fd >= 0 && slot->hash == hash && strcmp(slot->path, path) == 0) {
+            slot->refs++;
+            slot->lastUsed = ++g_HandleClock;
+            pthread_mutex_unlock(&g_PoolLock);
+            return i;
+        }
+        if (slot->refs == 0 && (victim < 0 || slot->fd < 0 ||
+            (g_HandlePool[victim].fd >= 0 && slot->lastUsed < g_HandlePool[victim].lastUsed))) {
+            victim = i;
+        }
+    }
+
+    if (victim < 0) {
+        pthread_mutex_unlock(&g_PoolLock);
+        l_warn("AAsset handle pool exhausted, cannot open %s", path);
+        return -1;
+    }
+
+    handleSlot * slot = &g_HandlePool[victim];
+    if (slot->fd >= 0) {
+        sceIoClose(slot->fd);
+        slot->fd = -1;
+    }
+
+    SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+    SceIoStat stat;
+    if (fd < 0 || sceIoGetstatByFd(fd, &stat) < 0) {
+        if (fd >= 0) sceIoClose(fd);
+        pthread_mutex_unlock(&g_PoolLock);
+        return -1;
+    }
+
+    strncpy(slot->path, path, sizeof(slot->path) - 1);
+    slot->path[sizeof(slot->path) - 1] = '\0';
+    slot->hash = hash;
+    slot->fd = fd;
+    slot->refs = 1;
+    slot->size = (size_t) stat.st_size;
+    slot->lastUsed = ++g_HandleClock;
+
+    pthread_mutex_unlock(&g_PoolLock);
+    return victim;
+}
+
+// The fd stays open for the next AAssetManager_open() of the same file
+static void handle_release(int slot) {
+    pthread_mutex_lock(&g_PoolLock);
+    if (g_HandlePool[slot].refs > 0) {
+        g_HandlePool[slot].refs--;
+    }
+    pthread_mutex_unlock(&g_PoolLock);
+}
+
+static aAsset * asset_object_alloc() {
+    pthread_mutex_lock(&g_PoolLock);
+    if (!g_AssetObjectsReady) {
+        for (int i = 0; i < ASSET_OBJECT_POOL_SIZE; i++) {
+            g_AssetObjects[i].nextFree = g_FreeAssets;
+            g_FreeAssets = &g_AssetObjects[i];
+        }
+        for (int i = 0; i < ASSET_HANDLE_POOL_SIZE; i++) {
+            g_HandlePool[i].fd = -1;
+        }
+        g_AssetObjectsReady = 1;
+    }
+
+    aAsset * a = g_FreeAssets;
+    if (a) {
+        g_FreeAssets = a->nextFree;
+    }
+    pthread_mutex_unlock(&g_PoolLock);
+
+    return a ? a : new aAsset;
+}
+
+static void asset_object_free(aAsset * a) {
+    if (a < g_AssetObjects || a >= g_AssetObjects + ASSET_OBJECT_POOL_SIZE) {
+        delete a;
+        return;
+    }
+
+    pthread_mutex_lock(&g_PoolLock);
+    a->nextFree = g_FreeAssets;
+    g_FreeAssets = a;
+    pthread_mutex_unlock(&g_PoolLock);
+}
+
 AAssetManager * AAssetManager_create() {
     if (g_AAssetManager) return g_AAssetManager;
 
@@ -36,38 +180,67 @@ AAssetManager * AAssetManager_create() {
 }
 
 AAsset* AAssetManager_open(AAssetManager* mgr, const char* filename, int mode) {
-    std::string realp = std::string(DATA_PATH) + std::string("assets/") + std::string(filename);
+    auto * a = asset_object_alloc();
+    a->path = path_map_asset(filename, a->scratch, sizeof(a->scratch));
+    if (!a->path) {
+        l_error("[AAssetManager] Path too long: %s", filename);
+        asset_object_free(a);
+        return nullptr;
+    }
 
-    auto * a = new aAsset;
-    a->filename = (char *) malloc(realp.length() + 1);
-    strcpy(a->filename, realp.c_str());
+    a->name = a->path + strlen(PATH_MAP_ASSET_ROOT);
+    a->mode = mode;
+    a->slot = -1;
     a->bytesRead = 0;
+    a->handle = ASSET_HANDLE_INVALID;
+    a->view = nullptr;
+    a->buffer = nullptr;
+    a->packed = asset_pack_find(filename);
+    a->traceId = io_trace_path(a->name);
+
+    // BUFFER mode shares the load_asset() cache slot instead of copying
+    if (mode == AASSET_MODE_BUFFER && asset_cache_is_raw(filename)) {
+        a->handle = asset_acquire(filename);
+        if (a->handle != ASSET_HANDLE_INVALID) {
+            a->view = asset_handle_data(a->handle, &a->fileSize);
+            io_trace_record(IO_OP_ASSET_OPEN, a->traceId, 0, (uint32_t) a->fileSize);
+            l_debug("[AAssetManager] AAssetManager_open(%p, %s, %i): %p (cached)", mgr, filename, mode, a);
+            return (AAsset *) a;
+        }
+    }
 
-#ifdef USE_SCELIBC_IO
-    a->f = sceLibcBridge_fopen((const char *)a->filename, "r");
-#else
-    a->f = fopen((cost char *)a->filename, "r");
-#endif
+    if (a->packed) {
+        // Stored entries are read in place; compressed ones are inflated once
+        a->fileSize = a->packed->raw_size;
+        if (a->packed->flags & ASSET_PACK_FLAG_LZ4) {
+            size_t size;
+            a->buffer = asset_pack_load(a->packed, &size);
+            a->view = a->buffer;
+            if (!a->buffer) {
+                io_trace_record(IO_OP_FAIL, a->traceId, 0, 0);
+                asset_object_free(a);
+                a = nullptr;
+            }
+        }
+        if (a) {
+            io_trace_record(IO_OP_ASSET_OPEN, a->traceId, 0, (uint32_t) a->fileSize);
+        }
 
-    if (!a->f) {
-        free(a->filename);
-        delete a;
+        l_debug("[AAssetManager] AAssetManager_open(%p, %s, %i): %p (packed)", mgr, filename, mode, a);
+        return (AAsset *) a;
+    }
+
+    a->slot = handle_acquire(a->path);
+    if (a->slot < 0) {
+        io_trace_record(IO_OP_FAIL, a->traceId, 0, 0);
+        asset_object_free(a);
         a = nullptr;
     } else {
-#ifdef USE_SCELIBC_IO
-        sceLibcBridge_fseek(a->f, 0, SEEK_END);
-        a->fileSize = sceLibcBridge_ftell(a->f);
-        sceLibcBridge_fseek(a->f, 0, SEEK_SET);
-        sceLibcBridge_fclose(a->f);
-#else
-        fseek(a->f, 0, SEEK_END);
-        a->fileSize = ftell(a->f);
-        fseek(a->f, 0, SEEK_SET);
-        fclose(a->f);
-#endif
-    }
-
-    l_debug("[AAssetManager] AAssetManager_open(%p, %s, %i): %p", mgr, realp.c_str(), mode, a);
+        a->fileSize = g_HandlePool[a->slot].size;
+        io_trace_record(IO_OP_ASSET_OPEN, a->traceId, 0, (uint32_t) a->fileSize);
+    }
+
+    l_debug("[AAssetManager] AAssetManager_open(%p, %s, %i): %p", mgr, filename, mode, a);
     return (AAsset *) a;
 }
 
@@ -76,9 +249,15 @@ void AAsset_close(AAsset* asset) {
 
     if (asset) {
         auto * a = (aAsset *) asset;
-        free(a->filename);
-        fclose(a->f);
-        delete a;
+        io_trace_record(IO_OP_ASSET_CLOSE, a->traceId, (uint32_t) a->bytesRead, 0);
+        if (a->handle != ASSET_HANDLE_INVALID) {
+            asset_release(a->handle);
+        }
+        if (a->slot >= 0) {
+            handle_release(a->slot);
+        }
+        free(a->buffer);
+        asset_object_free(a);
     }
 }
 
@@ -91,26 +270,26 @@ int AAsset_read(AAsset* asset, void* buf, size_t count) {
 
     auto * a = (aAsset *) asset;
 
-#ifdef USE_SCELIBC_IO
-    size_t ret = sceLibcBridge_fread(buf, 1, count, a->f);
-#else
-    size_t ret = fread(buf, 1, count, a->f);
-#endif
+    size_t remaining = a->fileSize - a->bytesRead;
+    if (count > remaining) count = remaining;
+    if (count == 0) return 0;
+
+    int ret;
+    if (a->view) {
+        memcpy(buf, (const char *) a->view + a->bytesRead, count);
+        ret = (int) count;
+    } else if (a->packed) {
+        ret = asset_pack_read(a->packed, buf, a->bytesRead, count);
+    } else {
+        ret = sceIoPread(g_HandlePool[a->slot].fd, buf, count, (SceOff) a->bytesRead);
+    }
 
     if (ret > 0) {
+        io_trace_record(IO_OP_ASSET_READ, a->traceId, (uint32_t) a->bytesRead, (uint32_t) ret);
         a->bytesRead += ret;
-        return (int) ret;
-    } else {
-#ifdef USE_SCELIBC_IO
-        if (ret == 0 || sceLibcBridge_feof(a->f)) {
-#else
-        if (ret == 0 || feof(a->f)) {
-#endif
-            return 0;
-        } else {
-            return -1;
-        }
+        return ret;
     }
+    return ret < 0 ? -1 : 0;
 }
 
 off_t AAsset_seek(AAsset* asset, off_t offset, int whence) {
@@ -122,13 +301,16 @@ off_t AAsset_seek(AAsset* asset, off_t offset, int whence) {
 
     auto * a = (aAsset *) asset;
 
-#ifdef USE_SCELIBC_IO
-    auto ret = (off_t) sceLibcBridge_fseek(a->f, offset, whence);
-#else
-    auto ret = (off_t) fseek(a->f, offset, whence);
-#endif
-
-    return ret;
+    // Every backend reads positionally, so seeking is just bookkeeping
+    off_t base = (whence == SEEK_SET) ? 0 :
+                 (whence == SEEK_CUR) ? (off_t) a->bytesRead : (off_t) a->fileSize;
+    off_t pos = base + offset;
+    if (pos < 0 || pos > (off_t) a->fileSize) {
+        return (off_t) -1;
+    }
+    a->bytesRead = (size_t) pos;
+    io_trace_record(IO_OP_ASSET_SEEK, a->traceId, (uint32_t) pos, 0);
+    return pos;
 }
 
 off_t AAsset_getRemainingLength(AAsset* asset) {
@@ -153,12 +335,127 @@ off_t AAsset_getLength(AAsset* asset) {
     return (off_t)a->fileSize;
 }
 
+const void* AAsset_getBuffer(AAsset* asset) {
+    l_debug("AAsset_getBuffer(%p)", asset);
+
+    if (!asset) {
+        return nullptr;
+    }
+
+    auto * a = (aAsset *) asset;
+    io_trace_record(IO_OP_ASSET_BUFFER, a->traceId, 0, (uint32_t) a->fileSize);
+    if (a->view) {
+        return a->view;
+    }
+
+    // Prefer the shared cache slot, fall back to a private copy
+    if (asset_cache_is_raw(a->name)) {
+        a->handle = asset_acquire(a->name);
+    }
+    if (a->handle != ASSET_HANDLE_INVALID) {
+        a->view = asset_handle_data(a->handle, nullptr);
+        return a->view;
+    }
+
+    if (a->packed) {
+        size_t size;
+        a->buffer = asset_pack_load(a->packed, &size);
+    } else if (a->slot >= 0) {
+        a->buffer = malloc(a->fileSize + 1);
+        if (a->buffer) {
+            int got = sceIoPread(g_HandlePool[a->slot].fd, a->buffer, a->fileSize, 0);
+            if (got != (int) a->fileSize) {
+                free(a->buffer);
+                a->buffer = nullptr;
+            }
+        }
+    }
+
+    a->view = a->buffer;
+    if (!a->view) {
+        l_error("AAsset_getBuffer: failed to buffer %s", a->name);
+    }
+    return a->view;
+}
+
+int AAsset_openFileDescriptor(AAsset* asset, off_t* outStart, off_t* outLength) {
+    l_debug("AAsset_openFileDescriptor(%p)", asset);
+
+    if (!asset || !outStart || !outLength) {
+        return -1;
+    }
+
+    auto * a = (aAsset *) asset;
+
+    // Like compressed APK entries, LZ4 archive entries have no raw byte range
+    if (a->packed) {
+        if (a->packed->flags & ASSET_PACK_FLAG_LZ4) {
+            return -1;
+        }
+        int fd = open(asset_pack_get_path(), O_RDONLY);
+        if (fd >= 0) {
+            *outStart = (off_t) a->packed->offset;
+            *outLength = (off_t) a->packed->size;
+        }
+        return fd;
+    }
+
+    int fd = open(a->path, O_RDONLY);
+    if (fd >= 0) {
+        *outStart = 0;
+        *outLength = (off_t) a->fileSize;
+    }
+    return fd;
+}
+
+int AAsset_isAllocated(AAsset* asset) {
+    if (!asset) {
+        return 0;
+    }
+
+    // Both the cache slot and a private copy live in ordinary RAM
+    return ((aAsset *) asset)->view != nullptr;
+}
+
+typedef struct aAssetDir {
+    int first;
+    int count;
+    int pos;
+} assetDir;
+
 AAssetDir* AAssetManager_openDir(AAssetManager* mgr, const char* dirName) {
-    l_error("AAssetManager_openDir: %s", dirName);
-    return (AAssetDir *)strdup("dummy");
+    auto * d = new aAssetDir;
+    d->pos = 0;
+
+    // Unknown directories are simply empty, as on Android
+    if (asset_dir_find(dirName ? dirName : "", &d->first, &d->count) < 0) {
+        d->first = 0;
+        d->count = 0;
+    }
+
+    l_debug("[AAssetManager] AAssetManager_openDir(%p, %s): %i files", mgr, dirName, d->count);
+    return (AAssetDir *) d;
+}
+
+const char* AAssetDir_getNextFileName(AAssetDir* assetDir) {
+    if (!assetDir) {
+        return nullptr;
+    }
+
+    auto * d = (aAssetDir *) assetDir;
+    if (d->pos >= d->count) {
+        return nullptr;
+    }
+    return asset_dir_file_name(d->first + d->pos++);
+}
+
+void AAssetDir_rewind(AAssetDir* assetDir) {
+    if (assetDir) {
+        ((aAssetDir *) assetDir)->pos = 0;
+    }
 }
 
 void AAssetDir_close(AAssetDir* assetDir) {
-    l_error("AAssetDir_close");
-    free(assetDir);
+    l_debug("AAssetDir_close(%p)", assetDir);
+    delete (aAssetDir *) assetDir;
 }
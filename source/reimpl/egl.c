@@ -7,16 +7,32 @@
 
 #include "reimpl/egl.h"
 
+#include "frame_pacer.h"
+#include "graphics.h"
 #include "utils/glutil.h"
 #include "utils/logger.h"
 
-#include <string.h>
-#include <stdlib.h>
+#include <stddef.h>
 
-EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor) {
+// vitaGL has one display, config, context and surface, all current from
+// graphics_init() on, so every handle is a pointer to one of these. Engines
+// ask for the current context every frame; none of it may allocate.
+static struct { const char *name; } egl_display = { "display" },
+                                    egl_config = { "config" },
+                                    egl_context = { "context" },
+                                    egl_surface = { "surface" };
+
+EGLDisplay eglGetDisplay_soloader(void * display_id __attribute__((unused))) {
+    return (EGLDisplay)&egl_display;
+}
+
+EGLBoolean eglInitialize(EGLDisplay dpy __attribute__((unused)), EGLint *major, EGLint *minor) {
     l_debug("eglInitialize(0x%x)", (int)dpy);
 
-    gl_init();
+    // vitaGL is normally up before the game runs; it can only be set up once
+    if (!graphics_is_initialized()) {
+        gl_init();
+    }
 
     if (major) *major = 2;
     if (minor) *minor = 2;
@@ -24,8 +40,8 @@ EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor) {
     return EGL_TRUE;
 }
 
-EGLBoolean eglQueryContext(EGLDisplay dpy, EGLContext ctx, EGLint attribute,
-                           EGLint *value) {
+EGLBoolean eglQueryContext(EGLDisplay dpy __attribute__((unused)), EGLContext ctx __attribute__((unused)),
+                           EGLint attribute, EGLint *value) {
     EGLBoolean ret = EGL_TRUE;
     switch (attribute) {
         case EGL_CONFIG_ID:
@@ -50,7 +66,7 @@ EGLBoolean eglQueryContext(EGLDisplay dpy, EGLContext ctx, EGLint attribute,
 }
 
 
-EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface eglSurface,
+EGLBoolean eglQuerySurface(EGLDisplay dpy __attribute__((unused)), EGLSurface eglSurface __attribute__((unused)),
                            EGLint attribute, EGLint *value) {
     EGLBoolean ret = EGL_TRUE;
     switch (attribute) {
@@ -115,7 +131,7 @@ EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface eglSurface,
 }
 
 
-EGLBoolean eglGetConfigAttrib(EGLDisplay display, EGLConfig config,
+EGLBoolean eglGetConfigAttrib(EGLDisplay display __attribute__((unused)), EGLConfig config __attribute__((unused)),
                               EGLint attribute, EGLint * value) {
     switch (attribute) {
         case EGL_ALPHA_SIZE: {
@@ -187,11 +203,11 @@ EGLBoolean eglGetConfigAttrib(EGLDisplay display, EGLConfig config,
             break;
         }
         case EGL_MAX_SWAP_INTERVAL: {
-            *value = 0;
+            *value = FRAME_PACE_MAX_SWAP_INTERVAL;
             break;
         }
         case EGL_MIN_SWAP_INTERVAL: {
-            *value = 0;
+            *value = 1;
             break;
         }
         case EGL_NATIVE_RENDERABLE: {
@@ -253,61 +269,78 @@ EGLBoolean eglGetConfigAttrib(EGLDisplay display, EGLConfig config,
     return EGL_TRUE;
 }
 
-EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list,
+EGLBoolean eglChooseConfig(EGLDisplay dpy __attribute__((unused)), const EGLint *attrib_list __attribute__((unused)),
                            EGLConfig *configs, EGLint config_size,
                            EGLint *num_config) {
     if (!num_config) {
-        return EGL_BAD_PARAMETER;
+        l_error("eglChooseConfig / EGL_BAD_PARAMETER");
+        return EGL_FALSE;
     }
 
-    if (!configs) {
-        *num_config = 1;
-        return EGL_TRUE;
+    if (configs && config_size > 0) {
+        *configs = (EGLConfig)&egl_config;
     }
 
-    *configs = strdup("conf");
     *num_config = 1;
 
     return EGL_TRUE;
 }
 
-EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
-                            EGLContext share_context,
-                            const EGLint *attrib_list) {
-    // Just something that is a valid pointer which can be freed later
-    return strdup("ctx");
+EGLContext eglCreateContext(EGLDisplay dpy __attribute__((unused)), EGLConfig config __attribute__((unused)),
+                            EGLContext share_context __attribute__((unused)),
+                            const EGLint *attrib_list __attribute__((unused))) {
+    return (EGLContext)&egl_context;
 }
 
-EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config,
-                                  void * win, const EGLint *attrib_list) {
-    // Just something that is a valid pointer which can be freed later
-    return strdup("surface");
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy __attribute__((unused)), EGLConfig config __attribute__((unused)),
+                                  void * win __attribute__((unused)),
+                                  const EGLint *attrib_list __attribute__((unused))) {
+    return (EGLSurface)&egl_surface;
 }
 
-EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read,
-                          EGLContext ctx) {
+EGLBoolean eglMakeCurrent(EGLDisplay dpy __attribute__((unused)), EGLSurface draw __attribute__((unused)),
+                          EGLSurface read __attribute__((unused)), EGLContext ctx __attribute__((unused))) {
     return EGL_TRUE;
 }
 
-EGLBoolean eglDestroyContext (EGLDisplay dpy, EGLContext ctx) {
-    if (ctx) free(ctx);
+EGLBoolean eglDestroyContext (EGLDisplay dpy __attribute__((unused)), EGLContext ctx __attribute__((unused))) {
     return EGL_TRUE;
 }
 
-EGLBoolean eglDestroySurface (EGLDisplay dpy, EGLSurface surface) {
-    if (surface) free(surface);
+EGLBoolean eglDestroySurface (EGLDisplay dpy __attribute__((unused)), EGLSurface surface __attribute__((unused))) {
     return EGL_TRUE;
 }
 
-EGLBoolean eglTerminate(EGLDisplay dpy) {
+EGLBoolean eglTerminate(EGLDisplay dpy __attribute__((unused))) {
     return EGL_TRUE;
 }
 
 EGLContext eglGetCurrentContext (void) {
-    return strdup("ctx");
+    return (EGLContext)&egl_context;
+}
+
+EGLDisplay eglGetCurrentDisplay_soloader(void) {
+    return (EGLDisplay)&egl_display;
+}
+
+EGLSurface eglGetCurrentSurface_soloader(EGLint readdraw __attribute__((unused))) {
+    return (EGLSurface)&egl_surface;
+}
+
+EGLBoolean eglSwapInterval_soloader(EGLDisplay dpy __attribute__((unused)), EGLint interval) {
+    // Out-of-range intervals are clamped silently, as EGL specifies
+    frame_pacer_set_swap_interval(interval);
+    return EGL_TRUE;
+}
+
+EGLBoolean eglSwapBuffers_soloader(EGLDisplay dpy __attribute__((unused)), EGLSurface surface __attribute__((unused))) {
+    // Presents once; the main loop's own graphics_frame_end() then does
+    // nothing and the frame pacer holds the frame to its vblank slot
+    graphics_frame_end();
+    return EGL_TRUE;
 }
 
-char const * eglQueryString(EGLDisplay display, EGLint name) {
+char const * eglQueryString(EGLDisplay display __attribute__((unused)), EGLint name) {
     switch (name) {
     case EGL_CLIENT_APIS:
         return "OpenGL OpenGL_ES";
@@ -330,7 +363,7 @@ char const * eglQueryString(EGLDisplay display, EGLint name) {
     }
 }
 
-EGLBoolean eglGetConfigs(EGLDisplay display, EGLConfig * configs,
+EGLBoolean eglGetConfigs(EGLDisplay display __attribute__((unused)), EGLConfig * configs,
                          EGLint config_size, EGLint * num_config) {
     if (!num_config) {
         l_error("eglGetConfigs / EGL_BAD_PARAMETER");
@@ -338,7 +371,7 @@ EGLBoolean eglGetConfigs(EGLDisplay display, EGLConfig * configs,
     }
 
     if (configs && config_size > 0) {
-        *configs = strdup("conf");
+        *configs = (EGLConfig)&egl_config;
     }
 
     *num_config = 1;
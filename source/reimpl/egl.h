@@ -54,6 +54,22 @@ EGLBoolean eglTerminate(EGLDisplay dpy);
 
 EGLContext eglGetCurrentContext (void);
 
+/*
+ * Entry points vitaGL may export itself carry a suffix, so they can't clash
+ * at link time; the import table maps the game's names onto them.
+ */
+EGLDisplay eglGetDisplay_soloader(void * display_id);
+
+EGLDisplay eglGetCurrentDisplay_soloader(void);
+
+EGLSurface eglGetCurrentSurface_soloader(EGLint readdraw);
+
+// Sets the frame pacer's swap interval
+EGLBoolean eglSwapInterval_soloader(EGLDisplay dpy, EGLint interval);
+
+// Presents through graphics_frame_end()
+EGLBoolean eglSwapBuffers_soloader(EGLDisplay dpy, EGLSurface surface);
+
 EGLBoolean eglGetConfigs(EGLDisplay display, EGLConfig * configs,
                          EGLint config_size, EGLint * num_config);
 
@@ -0,0 +1,203 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Fast libc and Math Imports
+ *
+ * The trig reduction is Cody-Waite with pi/2 split three ways, exact for
+ * quadrants under 8192, and the sinf/cosf polynomials are Cephes' over
+ * [-pi/4, pi/4]. atan2f folds into one octant for the Abramowitz & Stegun
+ * 4.4.49 polynomial; expf scales a degree-6 polynomial in r = x - k ln 2
+ * by 2^k built straight into the exponent bits.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <psp2/kernel/clib.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "reimpl/fast_libc.h"
+
+#define TRIG_RANGE   8192.0f            // Quadrants beyond this lose bits in the reduction
+#define TWO_OVER_PI  0.636619772367581343f
+#define PIO2_A       1.5703125f         // pi/2 = A + B + C, A and B with trailing zero bits
+#define PIO2_B       4.837512969970703125e-4f
+#define PIO2_C       7.54978995489188216e-8f
+#define PI_F         3.14159265358979f
+#define HALF_PI_F    1.57079632679490f
+#define LOG2E        1.44269504088896341f
+#define LN2_HI       0.693145751953125f
+#define LN2_LO       1.42860682030941723212e-6f
+
+typedef struct {
+    const char *symbol;
+    uint32_t flag;
+    uintptr_t func;
+} fast_import_t;
+
+static const fast_import_t fast_imports[] = {
+    {"memcpy", FAST_IMPORT_MEMCPY, (uintptr_t)&sceClibMemcpy},
+    {"memmove", FAST_IMPORT_MEMMOVE, (uintptr_t)&sceClibMemmove},
+    {"memset", FAST_IMPORT_MEMSET, (uintptr_t)&sceClibMemset},
+    {"strlen", FAST_IMPORT_STRLEN, (uintptr_t)&strlen_fast},
+    {"strcmp", FAST_IMPORT_STRCMP, (uintptr_t)&sceClibStrcmp},
+    {"sqrtf", FAST_IMPORT_SQRTF, (uintptr_t)&sqrtf_fast},
+    {"sinf", FAST_IMPORT_SINF, (uintptr_t)&sinf_fast},
+    {"cosf", FAST_IMPORT_COSF, (uintptr_t)&cosf_fast},
+    {"atan2f", FAST_IMPORT_ATAN2F, (uintptr_t)&atan2f_fast},
+    {"expf", FAST_IMPORT_EXPF, (uintptr_t)&expf_fast},
+};
+
+// Function prototypes
+static float reduce_quadrant(float x, int *quadrant);
+static float sin_poly(float r);
+static float cos_poly(float r);
+
+uintptr_t fast_libc_import(const char *symbol, uint32_t mask) {
+    for (size_t i = 0; i < sizeof(fast_imports) / sizeof(fast_imports[0]); i++) {
+        if ((mask & fast_imports[i].flag) && strcmp(fast_imports[i].symbol, symbol) == 0) {
+            return fast_imports[i].func;
+        }
+    }
+    return 0;
+}
+
+// ===== STRINGS =====
+
+size_t strlen_fast(const char *s) {
+    const char *p = s;
+
+    // Bytes up to a 16-byte boundary; aligned loads past the end never cross a page
+    while ((uintptr_t)p & 15) {
+        if (*p == '\0') {
+            return p - s;
+        }
+        p++;
+    }
+
+#if defined(__ARM_NEON)
+    for (;; p += 16) {
+        uint8x16_t zero = vceqq_u8(vld1q_u8((const uint8_t *)p), vdupq_n_u8(0));
+        uint8x8_t any = vorr_u8(vget_low_u8(zero), vget_high_u8(zero));
+        if (vget_lane_u64(vreinterpret_u64_u8(any), 0)) {
+            break;
+        }
+    }
+#else
+    typedef uint32_t __attribute__((may_alias)) word_t;
+    for (;; p += 4) {
+        uint32_t word = *(const word_t *)p;
+        if ((word - 0x01010101u) & ~word & 0x80808080u) {
+            break;
+        }
+    }
+#endif
+
+    while (*p != '\0') {
+        p++;
+    }
+    return p - s;
+}
+
+// ===== MATH =====
+
+float sqrtf_fast(float x) {
+#if defined(__ARM_FP)
+    // Correctly rounded like newlib's, without the errno check around it
+    float result;
+    __asm__("vsqrt.f32 %0, %1" : "=t"(result) : "t"(x));
+    return result;
+#else
+    return sqrtf(x);
+#endif
+}
+
+float sinf_fast(float x) {
+    if (!(fabsf(x) < TRIG_RANGE)) {
+        return sinf(x);
+    }
+
+    int quadrant;
+    float r = reduce_quadrant(x, &quadrant);
+    switch (quadrant & 3) {
+        case 0: return sin_poly(r);
+        case 1: return cos_poly(r);
+        case 2: return -sin_poly(r);
+        default: return -cos_poly(r);
+    }
+}
+
+float cosf_fast(float x) {
+    if (!(fabsf(x) < TRIG_RANGE)) {
+        return cosf(x);
+    }
+
+    int quadrant;
+    float r = reduce_quadrant(x, &quadrant);
+    switch (quadrant & 3) {
+        case 0: return cos_poly(r);
+        case 1: return -sin_poly(r);
+        case 2: return -cos_poly(r);
+        default: return sin_poly(r);
+    }
+}
+
+float atan2f_fast(float y, float x) {
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float hi = ax > ay ? ax : ay;
+    float lo = ax > ay ? ay : ax;
+
+    // Zeros, infinities and NaN: libm knows every sign rule
+    if (!(hi > 0.0f) || hi == INFINITY) {
+        return atan2f(y, x);
+    }
+
+    float z = lo / hi;
+    float z2 = z * z;
+    float angle = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+    if (ay > ax) {
+        angle = HALF_PI_F - angle;
+    }
+    if (x < 0.0f) {
+        angle = PI_F - angle;
+    }
+    return signbit(y) ? -angle : angle;
+}
+
+float expf_fast(float x) {
+    // Overflow, underflow to denormals and NaN keep libm's answers
+    if (!(x > -87.0f && x < 88.0f)) {
+        return expf(x);
+    }
+
+    int k = (int)(x * LOG2E + (x < 0.0f ? -0.5f : 0.5f));
+    float r = (x - k * LN2_HI) - k * LN2_LO;
+    float p = 1.0f + r * (1.0f + r * (0.5f + r * (1.0f / 6 + r * (1.0f / 24 + r * (1.0f / 120 + r * (1.0f / 720))))));
+
+    union {
+        uint32_t bits;
+        float value;
+    } scale = { .bits = (uint32_t)(k + 127) << 23 };
+    return p * scale.value;
+}
+
+// x - quadrant * pi/2, in [-pi/4, pi/4]
+static float reduce_quadrant(float x, int *quadrant) {
+    int q = (int)(x * TWO_OVER_PI + (x < 0.0f ? -0.5f : 0.5f));
+    float k = (float)q;
+    *quadrant = q;
+    return ((x - k * PIO2_A) - k * PIO2_B) - k * PIO2_C;
+}
+
+static float sin_poly(float r) {
+    float r2 = r * r;
+    return r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+}
+
+static float cos_poly(float r) {
+    float r2 = r * r;
+    return 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+}
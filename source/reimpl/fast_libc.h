@@ -0,0 +1,55 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Fast libc and Math Imports
+ *
+ * Replacements for the handful of libc and libm calls the engine makes in
+ * its sprite transform and vertex copy loops. With FAST_LIBC set, each one
+ * whose bit is in settings.cfg's fast_imports mask takes the place of the
+ * newlib entry in the import table. The FAST_IMPORTS_EXACT group gives the
+ * same results as newlib: sceClib's NEON memory routines, a NEON strlen
+ * and a bare vsqrt. The FAST_IMPORTS_MATH group trades accuracy for speed
+ * and is off unless asked for: within 1e-7 for sinf/cosf under |x| < 8192,
+ * about 1e-5 rad for atan2f and a few ulp for expf, with anything outside
+ * that range (and NaN or infinity) handed back to libm.
+ */
+
+#ifndef SOLOADER_FAST_LIBC_H
+#define SOLOADER_FAST_LIBC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bits of the fast_imports setting
+#define FAST_IMPORT_MEMCPY   0x001
+#define FAST_IMPORT_MEMMOVE  0x002
+#define FAST_IMPORT_MEMSET   0x004
+#define FAST_IMPORT_STRLEN   0x008
+#define FAST_IMPORT_STRCMP   0x010
+#define FAST_IMPORT_SQRTF    0x020
+#define FAST_IMPORT_SINF     0x100
+#define FAST_IMPORT_COSF     0x200
+#define FAST_IMPORT_ATAN2F   0x400
+#define FAST_IMPORT_EXPF     0x800
+
+#define FAST_IMPORTS_EXACT   0x03F      // Same results as newlib
+#define FAST_IMPORTS_MATH    0xF00      // Reduced precision
+
+// Replacement for `symbol` if its bit is in `mask`, 0 otherwise
+uintptr_t fast_libc_import(const char *symbol, uint32_t mask);
+
+size_t strlen_fast(const char *s);
+float sqrtf_fast(float x);
+float sinf_fast(float x);
+float cosf_fast(float x);
+float atan2f_fast(float y, float x);
+float expf_fast(float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_FAST_LIBC_H
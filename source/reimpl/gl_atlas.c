@@ -0,0 +1,527 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Sprite Atlas
+ *
+ * Pages are packed with a bottom-left skyline. Each sprite gets a one-texel
+ * border copied from its edge pixels, so bilinear filtering at the edge of
+ * a sprite never reads its neighbour. A skyline can't give single rectangles
+ * back: a deleted sprite's space is reclaimed when its page empties, which
+ * is how the game unloads sprites anyway, a level or a screen at a time.
+ * Pages are always GL_LINEAR / GL_CLAMP_TO_EDGE without mips, and the
+ * game's glTexParameteri calls on an alias are dropped.
+ *
+ * Only unit 0 draws are remapped; the game's sprites use no other unit.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vitaGL.h>
+
+#include "config.h"
+#include "mem_governor.h"
+#include "reimpl/gl_atlas.h"
+#include "reimpl/gl_state.h"
+#include "utils/logger.h"
+
+#define ATLAS_MAX_PAGES  8
+#define ATLAS_MAX_NAMES  8192           // Texture names above this are never packed
+#define ATLAS_MAX_NODES  256            // Skyline segments per page
+#define ATLAS_UNITS      8
+
+typedef struct {
+    int16_t x;
+    int16_t y;                          // Height of the skyline over [x, x + width)
+    int16_t width;
+} skyline_node_t;
+
+typedef struct {
+    GLuint texture;                     // 0 = never created
+    GLint internalformat;
+    GLenum format;
+    GLenum type;
+    int live;                           // Sprites aliased into it
+    int node_count;
+    skyline_node_t nodes[ATLAS_MAX_NODES];
+} atlas_page_t;
+
+typedef struct {
+    int8_t page;                        // -1 = not packed
+    int16_t x;                          // Sprite origin in the page, inside its border
+    int16_t y;
+    int16_t width;
+    int16_t height;
+} atlas_alias_t;
+
+static atlas_page_t pages[ATLAS_MAX_PAGES];
+static atlas_alias_t aliases[ATLAS_MAX_NAMES];
+static GLuint bound[ATLAS_UNITS];       // Game's name bound on each unit
+static int active_unit = 0;
+static gl_atlas_uv_t bound_uv;
+static int bound_uv_valid = 0;
+static int matrix_pushed = 0;
+static uint8_t *staging = NULL;
+static int rejected = 0;
+static int initialized = 0;
+
+// Function prototypes
+static int bytes_per_pixel(GLenum format, GLenum type);
+static atlas_alias_t *find_alias(GLuint texture);
+static void release_alias(atlas_alias_t *alias);
+static int pack(GLint internalformat, GLenum format, GLenum type, int width, int height, int *x, int *y);
+static int create_page(atlas_page_t *page, GLint internalformat, GLenum format, GLenum type);
+static void reset_skyline(atlas_page_t *page);
+static int skyline_fit(const atlas_page_t *page, int index, int width, int height);
+static int skyline_insert(atlas_page_t *page, int width, int height, int *x, int *y);
+static void extrude(const uint8_t *src, size_t src_stride, int width, int height, int bpp);
+static void update_bound_uv(void);
+#if MEM_GOVERNOR
+static size_t purge_pages(mem_kind_t kind, mem_pressure_t pressure, size_t wanted);
+#endif
+
+int gl_atlas_init(void) {
+    memset(pages, 0, sizeof(pages));
+    for (int i = 0; i < ATLAS_MAX_NAMES; i++) {
+        aliases[i].page = -1;
+    }
+
+    size_t max_side = GL_ATLAS_MAX_SPRITE + 2;
+    staging = malloc(max_side * max_side * 4);
+    if (!staging) {
+        l_error("Failed to allocate sprite atlas staging buffer");
+        return -1;
+    }
+
+#if MEM_GOVERNOR
+    mem_governor_register("atlas", MEM_PRIORITY_ATLAS, 0, purge_pages);
+#endif
+
+    initialized = 1;
+    l_success("Sprite atlas initialized (%dx%d pages, sprites up to %d px)",
+              GL_ATLAS_PAGE_SIZE, GL_ATLAS_PAGE_SIZE, GL_ATLAS_MAX_SPRITE);
+    return 0;
+}
+
+void gl_atlas_shutdown(void) {
+    for (int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        if (pages[i].texture) {
+            glDeleteTextures(1, &pages[i].texture);
+        }
+    }
+    memset(pages, 0, sizeof(pages));
+    free(staging);
+    staging = NULL;
+    initialized = 0;
+    bound_uv_valid = 0;
+}
+
+// ===== BINDING =====
+
+void gl_atlas_active_unit(GLenum texture) {
+    int unit = (int)(texture - GL_TEXTURE0);
+    active_unit = (unit >= 0 && unit < ATLAS_UNITS) ? unit : -1;
+}
+
+GLuint gl_atlas_bind(GLenum target, GLuint texture) {
+    if (target != GL_TEXTURE_2D || active_unit < 0) {
+        return texture;
+    }
+
+    bound[active_unit] = texture;
+    if (active_unit == 0) {
+        update_bound_uv();
+    }
+
+    atlas_alias_t *alias = find_alias(texture);
+    return alias ? pages[alias->page].texture : texture;
+}
+
+void gl_atlas_delete(GLuint texture) {
+    atlas_alias_t *alias = find_alias(texture);
+    if (alias) {
+        release_alias(alias);
+    }
+
+    for (int unit = 0; unit < ATLAS_UNITS; unit++) {
+        if (bound[unit] == texture) {
+            bound[unit] = 0;
+        }
+    }
+    update_bound_uv();
+}
+
+const gl_atlas_uv_t *gl_atlas_bound_uv(void) {
+    return bound_uv_valid ? &bound_uv : NULL;
+}
+
+void gl_atlas_draw_begin(void) {
+    if (!bound_uv_valid) {
+        return;
+    }
+
+    // Texture matrices are per unit: make unit 0's current for the change
+    GLint matrix_mode;
+    glGetIntegerv(GL_MATRIX_MODE, &matrix_mode);
+    if (active_unit != 0) glActiveTexture(GL_TEXTURE0);
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glTranslatef(bound_uv.offset_u, bound_uv.offset_v, 0.0f);
+    glScalef(bound_uv.scale_u, bound_uv.scale_v, 1.0f);
+    glMatrixMode(matrix_mode);
+    if (active_unit > 0) glActiveTexture(GL_TEXTURE0 + active_unit);
+    matrix_pushed = 1;
+}
+
+void gl_atlas_draw_end(void) {
+    if (!matrix_pushed) {
+        return;
+    }
+
+    GLint matrix_mode;
+    glGetIntegerv(GL_MATRIX_MODE, &matrix_mode);
+    if (active_unit != 0) glActiveTexture(GL_TEXTURE0);
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(matrix_mode);
+    if (active_unit > 0) glActiveTexture(GL_TEXTURE0 + active_unit);
+    matrix_pushed = 0;
+}
+
+void gl_atlas_get_stats(gl_atlas_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        if (pages[i].live > 0) {
+            stats->pages++;
+            stats->sprites += pages[i].live;
+        }
+    }
+    stats->rejected = rejected;
+}
+
+// ===== UPLOADS =====
+
+int gl_atlas_tex_image(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                       GLsizei height, GLint border, GLenum format, GLenum type, const void *data) {
+    if (!initialized || target != GL_TEXTURE_2D || active_unit != 0) {
+        return 0;
+    }
+
+    GLuint texture = bound[0];
+    atlas_alias_t *alias = find_alias(texture);
+    if (alias && level > 0) {
+        // Pages carry no mips; the sprite keeps its level 0
+        return 1;
+    }
+    if (level != 0 || texture == 0 || texture >= ATLAS_MAX_NAMES) {
+        return 0;
+    }
+
+    // Respecified: the old rectangle goes whatever the new image is
+    int was_packed = alias != NULL;
+    if (was_packed) {
+        release_alias(alias);
+    }
+
+    int bpp = bytes_per_pixel(format, type);
+    int fits = data && border == 0 && bpp > 0 && width > 0 && height > 0 &&
+               width <= GL_ATLAS_MAX_SPRITE && height <= GL_ATLAS_MAX_SPRITE;
+    int page = -1;
+    int x = 0;
+    int y = 0;
+    if (fits) {
+        page = pack(internalformat, format, type, width + 2, height + 2, &x, &y);
+        if (page < 0) {
+            rejected++;
+        }
+    }
+
+    if (page < 0) {
+        // Goes to the game's own texture, which may be the page bound right now
+        if (was_packed) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            gl_state_texture_bound(texture);
+            update_bound_uv();
+        }
+        return 0;
+    }
+
+    GLint alignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    if (alignment <= 0) {
+        alignment = 4;
+    }
+    size_t row = (size_t)width * bpp;
+    size_t stride = (row + alignment - 1) / alignment * alignment;
+    extrude(data, stride, width, height, bpp);
+
+    glBindTexture(GL_TEXTURE_2D, pages[page].texture);
+    gl_state_texture_bound(pages[page].texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width + 2, height + 2, format, type, staging);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+    alias = &aliases[texture];
+    alias->page = (int8_t)page;
+    alias->x = (int16_t)(x + 1);
+    alias->y = (int16_t)(y + 1);
+    alias->width = (int16_t)width;
+    alias->height = (int16_t)height;
+    pages[page].live++;
+    update_bound_uv();
+    return 1;
+}
+
+int gl_atlas_tex_sub_image(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                           GLsizei height, GLenum format, GLenum type, const void *pixels) {
+    if (target != GL_TEXTURE_2D || active_unit < 0) {
+        return 0;
+    }
+
+    atlas_alias_t *alias = find_alias(bound[active_unit]);
+    if (!alias) {
+        return 0;
+    }
+
+    // Out-of-range updates are errors in GL too; the border keeps the old edge
+    if (level == 0 && xoffset >= 0 && yoffset >= 0 &&
+        xoffset + width <= alias->width && yoffset + height <= alias->height) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, alias->x + xoffset, alias->y + yoffset, width, height,
+                        format, type, pixels);
+    }
+    return 1;
+}
+
+int gl_atlas_tex_parameter(GLenum target, GLenum pname, GLint param) {
+    (void)pname;
+    (void)param;
+    return target == GL_TEXTURE_2D && active_unit >= 0 && find_alias(bound[active_unit]) != NULL;
+}
+
+// ===== PAGES =====
+
+static int bytes_per_pixel(GLenum format, GLenum type) {
+    if (type == GL_UNSIGNED_BYTE) {
+        switch (format) {
+            case GL_RGBA: return 4;
+            case GL_RGB: return 3;
+            case GL_LUMINANCE_ALPHA: return 2;
+            case GL_LUMINANCE:
+            case GL_ALPHA: return 1;
+            default: return 0;
+        }
+    }
+    if ((type == GL_UNSIGNED_SHORT_5_6_5 && format == GL_RGB) ||
+        ((type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1) && format == GL_RGBA)) {
+        return 2;
+    }
+    return 0;
+}
+
+static atlas_alias_t *find_alias(GLuint texture) {
+    if (texture == 0 || texture >= ATLAS_MAX_NAMES || aliases[texture].page < 0) {
+        return NULL;
+    }
+    return &aliases[texture];
+}
+
+static void release_alias(atlas_alias_t *alias) {
+    atlas_page_t *page = &pages[alias->page];
+    alias->page = -1;
+    if (--page->live == 0) {
+        // Nothing left on it: the whole page is free again
+        reset_skyline(page);
+    }
+}
+
+// Room for a width x height rectangle in a page of this format; page index or -1
+static int pack(GLint internalformat, GLenum format, GLenum type, int width, int height, int *x, int *y) {
+    int unused = -1;
+    for (int i = 0; i < ATLAS_MAX_PAGES; i++) {
+        atlas_page_t *page = &pages[i];
+        if (page->texture && page->format == format && page->type == type &&
+            page->internalformat == internalformat) {
+            if (skyline_insert(page, width, height, x, y) == 0) {
+                return i;
+            }
+        } else if (unused < 0 && (!page->texture || page->live == 0)) {
+            unused = i;
+        }
+    }
+
+    if (unused < 0 || create_page(&pages[unused], internalformat, format, type) < 0) {
+        return -1;
+    }
+    return skyline_insert(&pages[unused], width, height, x, y) == 0 ? unused : -1;
+}
+
+#if MEM_GOVERNOR
+// Governor purge: emptied pages keep their storage for the next sprite of
+// their format; under pressure, give it back to vitaGL
+static size_t purge_pages(mem_kind_t kind, mem_pressure_t pressure __attribute__((unused)), size_t wanted) {
+    if (kind != MEM_KIND_VRAM) {
+        return 0;
+    }
+
+    size_t freed = 0;
+    for (int i = 0; i < ATLAS_MAX_PAGES && freed < wanted; i++) {
+        atlas_page_t *page = &pages[i];
+        if (!page->texture || page->live > 0) {
+            continue;
+        }
+        freed += (size_t)GL_ATLAS_PAGE_SIZE * GL_ATLAS_PAGE_SIZE * bytes_per_pixel(page->format, page->type);
+        glDeleteTextures_filtered(1, &page->texture);
+        page->texture = 0;
+    }
+    return freed;
+}
+#endif
+
+// Give a never-used or emptied page storage in this format
+static int create_page(atlas_page_t *page, GLint internalformat, GLenum format, GLenum type) {
+    if (!page->texture) {
+        glGenTextures(1, &page->texture);
+        if (!page->texture) {
+            return -1;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, page->texture);
+    gl_state_texture_bound(page->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalformat, GL_ATLAS_PAGE_SIZE, GL_ATLAS_PAGE_SIZE, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    page->internalformat = internalformat;
+    page->format = format;
+    page->type = type;
+    page->live = 0;
+    reset_skyline(page);
+
+    l_debug("Sprite atlas: page %u for format 0x%x/0x%x", page->texture, format, type);
+    return 0;
+}
+
+static void reset_skyline(atlas_page_t *page) {
+    page->nodes[0] = (skyline_node_t){ 0, 0, GL_ATLAS_PAGE_SIZE };
+    page->node_count = 1;
+}
+
+// ===== SKYLINE =====
+
+// Lowest y a rectangle starting at node `index` can sit at, or -1 if it doesn't fit
+static int skyline_fit(const atlas_page_t *page, int index, int width, int height) {
+    if (page->nodes[index].x + width > GL_ATLAS_PAGE_SIZE) {
+        return -1;
+    }
+
+    int y = 0;
+    int left = width;
+    for (int i = index; left > 0 && i < page->node_count; i++) {
+        if (page->nodes[i].y > y) {
+            y = page->nodes[i].y;
+        }
+        if (y + height > GL_ATLAS_PAGE_SIZE) {
+            return -1;
+        }
+        left -= page->nodes[i].width;
+    }
+    return y;
+}
+
+// Bottom-left placement, ties going to the narrowest segment; 0 on success
+static int skyline_insert(atlas_page_t *page, int width, int height, int *x, int *y) {
+    int best = -1;
+    int best_top = GL_ATLAS_PAGE_SIZE + 1;
+    int best_width = GL_ATLAS_PAGE_SIZE + 1;
+
+    for (int i = 0; i < page->node_count; i++) {
+        int fit = skyline_fit(page, i, width, height);
+        if (fit < 0) {
+            continue;
+        }
+        int top = fit + height;
+        if (top < best_top || (top == best_top && page->nodes[i].width < best_width)) {
+            best = i;
+            best_top = top;
+            best_width = page->nodes[i].width;
+            *x = page->nodes[i].x;
+            *y = fit;
+        }
+    }
+
+    if (best < 0 || page->node_count >= ATLAS_MAX_NODES) {
+        return -1;
+    }
+
+    skyline_node_t *nodes = page->nodes;
+    memmove(&nodes[best + 1], &nodes[best], (page->node_count - best) * sizeof(nodes[0]));
+    nodes[best] = (skyline_node_t){ (int16_t)*x, (int16_t)(*y + height), (int16_t)width };
+    page->node_count++;
+
+    // Cut the segments the new one now covers
+    int end = *x + width;
+    for (int i = best + 1; i < page->node_count; ) {
+        if (nodes[i].x >= end) {
+            break;
+        }
+        int covered = end - nodes[i].x;
+        if (covered < nodes[i].width) {
+            nodes[i].x += (int16_t)covered;
+            nodes[i].width -= (int16_t)covered;
+            break;
+        }
+        memmove(&nodes[i], &nodes[i + 1], (page->node_count - i - 1) * sizeof(nodes[0]));
+        page->node_count--;
+    }
+
+    // Merge neighbours at the same height
+    for (int i = 0; i + 1 < page->node_count; ) {
+        if (nodes[i].y == nodes[i + 1].y) {
+            nodes[i].width += nodes[i + 1].width;
+            memmove(&nodes[i + 1], &nodes[i + 2], (page->node_count - i - 2) * sizeof(nodes[0]));
+            page->node_count--;
+        } else {
+            i++;
+        }
+    }
+    return 0;
+}
+
+// ===== STAGING =====
+
+// Copy the sprite into staging with its edge pixels repeated one texel outward
+static void extrude(const uint8_t *src, size_t src_stride, int width, int height, int bpp) {
+    size_t row = (size_t)(width + 2) * bpp;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *in = src + (size_t)y * src_stride;
+        uint8_t *out = staging + (size_t)(y + 1) * row;
+        memcpy(out, in, bpp);
+        memcpy(out + bpp, in, (size_t)width * bpp);
+        memcpy(out + (size_t)(width + 1) * bpp, in + (size_t)(width - 1) * bpp, bpp);
+    }
+
+    memcpy(staging, staging + row, row);
+    memcpy(staging + (size_t)(height + 1) * row, staging + (size_t)height * row, row);
+}
+
+static void update_bound_uv(void) {
+    atlas_alias_t *alias = find_alias(bound[0]);
+    bound_uv_valid = alias != NULL;
+    if (!alias) {
+        return;
+    }
+
+    const float texel = 1.0f / GL_ATLAS_PAGE_SIZE;
+    bound_uv.scale_u = alias->width * texel;
+    bound_uv.scale_v = alias->height * texel;
+    bound_uv.offset_u = alias->x * texel;
+    bound_uv.offset_v = alias->y * texel;
+}
@@ -0,0 +1,70 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Sprite Atlas
+ *
+ * The game decodes every .spr itself and uploads it as its own texture, so
+ * a sprite-heavy scene binds a different texture for almost every draw.
+ * With GL_SPRITE_ATLAS set, small level-0 uploads are packed into shared
+ * GL_ATLAS_PAGE_SIZE pages instead, one set of pages per pixel format, and
+ * the game's texture name becomes an alias for its rectangle. Binding an
+ * alias binds its page, so the state filter drops the switch between two
+ * sprites of the same page and the sprite batcher keeps merging; the
+ * batcher rewrites texture coordinates into the rectangle as it copies
+ * them, and draws that aren't batched get the same mapping through the
+ * texture matrix. Sprites loaded together land on the same pages, so in
+ * practice a page holds one level's or one screen's sprites.
+ */
+
+#ifndef SOLOADER_GL_ATLAS_H
+#define SOLOADER_GL_ATLAS_H
+
+#include <vitaGL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    float scale_u;
+    float scale_v;
+    float offset_u;
+    float offset_v;
+} gl_atlas_uv_t;
+
+typedef struct {
+    int pages;          // Pages holding at least one sprite
+    int sprites;        // Texture names currently aliased into a page
+    int rejected;       // Uploads that qualified but found no room
+} gl_atlas_stats_t;
+
+int gl_atlas_init(void);
+void gl_atlas_shutdown(void);
+
+// Notifications from the state filter, made on every call
+void gl_atlas_active_unit(GLenum texture);
+void gl_atlas_delete(GLuint texture);
+
+// The GL name to bind for the game's `texture` on the active unit
+GLuint gl_atlas_bind(GLenum target, GLuint texture);
+
+// 1 if the call was taken over for an aliased (or newly packed) texture
+int gl_atlas_tex_image(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                       GLsizei height, GLint border, GLenum format, GLenum type, const void *data);
+int gl_atlas_tex_sub_image(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                           GLsizei height, GLenum format, GLenum type, const void *pixels);
+int gl_atlas_tex_parameter(GLenum target, GLenum pname, GLint param);
+
+// Texture coordinate mapping of the sprite bound on unit 0, NULL if it isn't packed
+const gl_atlas_uv_t *gl_atlas_bound_uv(void);
+
+// Around a draw that isn't batched: map texture coordinates through the texture matrix
+void gl_atlas_draw_begin(void);
+void gl_atlas_draw_end(void);
+
+void gl_atlas_get_stats(gl_atlas_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_GL_ATLAS_H
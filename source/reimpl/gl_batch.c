@@ -0,0 +1,555 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * GLES1 Sprite Batcher
+ *
+ * Vertices are copied out of the game's arrays at draw time, so the game may
+ * reuse its scratch arrays immediately. The batch layout (position / texcoord
+ * sizes, color type) is taken from the first draw; a draw with a different
+ * layout flushes first. vitaGL copies client arrays into its vertex pool on
+ * submission, so one VERTEX_POOL_SIZE staging buffer is reused for every
+ * batch.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vitaGL.h>
+
+#include "config.h"
+#include "reimpl/gl_batch.h"
+#include "reimpl/gl_atlas.h"
+#include "reimpl/gl_upload.h"
+#include "utils/logger.h"
+
+#define BATCH_VERTEX_BYTES (VERTEX_POOL_SIZE / 4 * 3)
+#define BATCH_INDEX_MAX    (VERTEX_POOL_SIZE / 4 / sizeof(GLushort))
+#define BATCH_VERTEX_MAX   0xFFFF        // Indices are GL_UNSIGNED_SHORT
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+
+typedef struct {
+    GLint size;
+    GLenum type;
+    GLsizei stride;
+    const void *pointer;
+    int set;
+} client_array_t;
+
+typedef struct {
+    int position_size;
+    int texcoord_size;                  // 0 = no texcoord array
+    GLenum color_type;                  // 0 = no color array
+    int stride;
+} batch_layout_t;
+
+static struct {
+    uint8_t *vertices;
+    GLushort *indices;
+    int vertex_count;
+    int index_count;
+    int draws;
+    batch_layout_t layout;
+} batch;
+
+static struct {
+    client_array_t vertex;
+    client_array_t color;
+    client_array_t texcoord;            // Texture unit 0
+    int client_unit;
+    int vertex_enabled;
+    int color_enabled;
+    int normal_enabled;
+    uint32_t texcoord_enabled;          // Bit per client texture unit
+    GLuint program;
+    GLuint array_buffer;
+    GLuint element_buffer;
+} client;
+
+static gl_batch_stats_t frame_stats;
+static gl_batch_stats_t last_stats;
+
+// Function prototypes
+static int current_layout(batch_layout_t *layout);
+static int triangle_indices(GLenum mode, int count);
+static int reserve(const batch_layout_t *layout, int vertices, int indices);
+static void copy_attribute(uint8_t *out, const client_array_t *array, size_t element, int index, int components);
+static void copy_vertices(int first, int count);
+static void emit_triangles(GLenum mode, const int *order, int count, int base);
+static void restore_pointers(void);
+
+int gl_batch_init(void) {
+    memset(&batch, 0, sizeof(batch));
+    memset(&client, 0, sizeof(client));
+
+    batch.vertices = malloc(BATCH_VERTEX_BYTES);
+    batch.indices = malloc(BATCH_INDEX_MAX * sizeof(GLushort));
+    if (!batch.vertices || !batch.indices) {
+        l_error("Failed to allocate sprite batch buffers");
+        gl_batch_shutdown();
+        return -1;
+    }
+
+    l_success("Sprite batcher initialized (%d KB staging)", VERTEX_POOL_SIZE / 1024);
+    return 0;
+}
+
+void gl_batch_shutdown(void) {
+    free(batch.vertices);
+    free(batch.indices);
+    memset(&batch, 0, sizeof(batch));
+}
+
+void gl_batch_flush(void) {
+    if (batch.index_count == 0) {
+        return;
+    }
+
+    const batch_layout_t *layout = &batch.layout;
+    glVertexPointer(layout->position_size, GL_FLOAT, layout->stride, batch.vertices);
+    size_t offset = layout->position_size * sizeof(float);
+    if (layout->texcoord_size) {
+        glTexCoordPointer(layout->texcoord_size, GL_FLOAT, layout->stride, batch.vertices + offset);
+        offset += layout->texcoord_size * sizeof(float);
+    }
+    if (layout->color_type) {
+        glColorPointer(4, layout->color_type, layout->stride, batch.vertices + offset);
+    }
+
+    glDrawElements(GL_TRIANGLES, batch.index_count, GL_UNSIGNED_SHORT, batch.indices);
+    restore_pointers();
+
+    frame_stats.draws += batch.draws;
+    frame_stats.batches++;
+    batch.vertex_count = 0;
+    batch.index_count = 0;
+    batch.draws = 0;
+}
+
+void gl_batch_end_frame(void) {
+    gl_batch_flush();
+    last_stats = frame_stats;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+void gl_batch_get_stats(gl_batch_stats_t *stats) {
+    if (stats) {
+        *stats = last_stats;
+    }
+}
+
+// ===== STATE NOTIFICATIONS =====
+
+void gl_batch_client_unit(GLenum texture) {
+    client.client_unit = (int)(texture - GL_TEXTURE0);
+}
+
+void gl_batch_client_state(GLenum array, int enabled) {
+    switch (array) {
+        case GL_VERTEX_ARRAY:
+            client.vertex_enabled = enabled;
+            break;
+        case GL_COLOR_ARRAY:
+            client.color_enabled = enabled;
+            break;
+        case GL_NORMAL_ARRAY:
+            client.normal_enabled = enabled;
+            break;
+        case GL_TEXTURE_COORD_ARRAY:
+            if (client.client_unit >= 0 && client.client_unit < 32) {
+                uint32_t bit = 1u << client.client_unit;
+                client.texcoord_enabled = enabled ? (client.texcoord_enabled | bit)
+                                                  : (client.texcoord_enabled & ~bit);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void gl_batch_program(GLuint program) {
+    client.program = program;
+}
+
+// ===== DRAWS =====
+
+int gl_batch_draw_arrays(GLenum mode, GLint first, GLsizei count) {
+    batch_layout_t layout;
+    int indices = triangle_indices(mode, count);
+    if (!batch.vertices || first < 0 || indices <= 0 || current_layout(&layout) < 0 ||
+        reserve(&layout, count, indices) < 0) {
+        gl_batch_flush();
+        return 0;
+    }
+
+    int base = batch.vertex_count;
+    copy_vertices(first, count);
+    emit_triangles(mode, NULL, count, base);
+    batch.draws++;
+    return 1;
+}
+
+int gl_batch_draw_elements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    batch_layout_t layout;
+    int index_count = triangle_indices(mode, count);
+    if (!batch.vertices || !indices || client.element_buffer != 0 || index_count <= 0 ||
+        (type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_BYTE) || current_layout(&layout) < 0) {
+        gl_batch_flush();
+        return 0;
+    }
+
+    // Only the referenced vertex range is copied, then indices are rebased
+    int order[256];
+    if (count > (int)(sizeof(order) / sizeof(order[0]))) {
+        gl_batch_flush();
+        return 0;
+    }
+
+    int lowest = 0xFFFF;
+    int highest = 0;
+    for (int i = 0; i < count; i++) {
+        int index = type == GL_UNSIGNED_SHORT ? ((const GLushort *)indices)[i] : ((const GLubyte *)indices)[i];
+        order[i] = index;
+        if (index < lowest) lowest = index;
+        if (index > highest) highest = index;
+    }
+
+    int range = highest - lowest + 1;
+    if (reserve(&layout, range, index_count) < 0) {
+        gl_batch_flush();
+        return 0;
+    }
+
+    int base = batch.vertex_count - lowest;
+    copy_vertices(lowest, range);
+    emit_triangles(mode, order, count, base);
+    batch.draws++;
+    return 1;
+}
+
+// ===== CLIENT ARRAYS =====
+
+void glVertexPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer) {
+    client.vertex = (client_array_t){ size, type, stride, pointer, 1 };
+    glVertexPointer(size, type, stride, pointer);
+}
+
+void glColorPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer) {
+    client.color = (client_array_t){ size, type, stride, pointer, 1 };
+    glColorPointer(size, type, stride, pointer);
+}
+
+void glTexCoordPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer) {
+    if (client.client_unit == 0) {
+        client.texcoord = (client_array_t){ size, type, stride, pointer, 1 };
+    }
+    glTexCoordPointer(size, type, stride, pointer);
+}
+
+void glBindBuffer_batched(GLenum target, GLuint buffer) {
+    gl_batch_flush();
+    if (target == GL_ARRAY_BUFFER) {
+        client.array_buffer = buffer;
+    } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        client.element_buffer = buffer;
+    }
+    glBindBuffer(target, buffer);
+}
+
+void glDeleteBuffers_batched(GLsizei n, const GLuint *buffers) {
+    gl_batch_flush();
+    for (GLsizei i = 0; i < n; i++) {
+        if (buffers[i] == client.array_buffer) client.array_buffer = 0;
+        if (buffers[i] == client.element_buffer) client.element_buffer = 0;
+    }
+    glDeleteBuffers(n, buffers);
+}
+
+// ===== STATE CHANGES =====
+
+void glAlphaFunc_batched(GLenum func, GLfloat ref) {
+    gl_batch_flush();
+    glAlphaFunc(func, ref);
+}
+
+void glClear_batched(GLbitfield mask) {
+    gl_batch_flush();
+    glClear(mask);
+}
+
+void glColor4f_batched(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    gl_batch_flush();
+    glColor4f(red, green, blue, alpha);
+}
+
+void glDepthFunc_batched(GLenum func) {
+    gl_batch_flush();
+    glDepthFunc(func);
+}
+
+void glDepthMask_batched(GLboolean flag) {
+    gl_batch_flush();
+    glDepthMask(flag);
+}
+
+void glTexEnvi_batched(GLenum target, GLenum pname, GLint param) {
+    gl_batch_flush();
+    glTexEnvi(target, pname, param);
+}
+
+void glTexParameteri_batched(GLenum target, GLenum pname, GLint param) {
+    gl_batch_flush();
+#if GL_SPRITE_ATLAS
+    if (gl_atlas_tex_parameter(target, pname, param)) {
+        return;
+    }
+#endif
+    glTexParameteri(target, pname, param);
+}
+
+void glTexImage2D_batched(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                          GLsizei height, GLint border, GLenum format, GLenum type, const void *data) {
+#if GL_UPLOAD_FILTER
+    // Pixels the texture already holds: dropped before they break the batch
+    if (gl_upload_tex_image(target, level, internalformat, width, height, format, type, data)) {
+        return;
+    }
+#endif
+    gl_batch_flush();
+#if GL_SPRITE_ATLAS
+    if (gl_atlas_tex_image(target, level, internalformat, width, height, border, format, type, data)) {
+        return;
+    }
+#endif
+    glTexImage2D(target, level, internalformat, width, height, border, format, type, data);
+}
+
+void glTexSubImage2D_batched(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                             GLsizei height, GLenum format, GLenum type, const void *pixels) {
+#if GL_UPLOAD_FILTER
+    if (gl_upload_tex_sub_image(target, level, xoffset, yoffset, width, height, format, type, pixels)) {
+        return;
+    }
+#endif
+    gl_batch_flush();
+#if GL_SPRITE_ATLAS
+    if (gl_atlas_tex_sub_image(target, level, xoffset, yoffset, width, height, format, type, pixels)) {
+        return;
+    }
+#endif
+    glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+void glLoadIdentity_batched(void) {
+    gl_batch_flush();
+    glLoadIdentity();
+}
+
+void glLoadMatrixf_batched(const GLfloat *m) {
+    gl_batch_flush();
+    glLoadMatrixf(m);
+}
+
+void glPopMatrix_batched(void) {
+    gl_batch_flush();
+    glPopMatrix();
+}
+
+void glRotatef_batched(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+    gl_batch_flush();
+    glRotatef(angle, x, y, z);
+}
+
+void glScalef_batched(GLfloat x, GLfloat y, GLfloat z) {
+    gl_batch_flush();
+    glScalef(x, y, z);
+}
+
+void glTranslatef_batched(GLfloat x, GLfloat y, GLfloat z) {
+    gl_batch_flush();
+    glTranslatef(x, y, z);
+}
+
+void glOrthof_batched(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat near_val, GLfloat far_val) {
+    gl_batch_flush();
+    glOrthof(left, right, bottom, top, near_val, far_val);
+}
+
+void glFrustumf_batched(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat near_val, GLfloat far_val) {
+    gl_batch_flush();
+    glFrustumf(left, right, bottom, top, near_val, far_val);
+}
+
+void glViewport_batched(GLint x, GLint y, GLsizei width, GLsizei height) {
+    gl_batch_flush();
+    glViewport(x, y, width, height);
+}
+
+void glFinish_batched(void) {
+    gl_batch_flush();
+    glFinish();
+}
+
+void glFlush_batched(void) {
+    gl_batch_flush();
+    glFlush();
+}
+
+// ===== BATCH BUILDING =====
+
+// Layout of a draw made now, or -1 if the fixed-function state can't be batched
+static int current_layout(batch_layout_t *layout) {
+    if (client.program != 0 || client.array_buffer != 0 || !client.vertex_enabled ||
+        client.normal_enabled || client.client_unit != 0 || (client.texcoord_enabled & ~1u)) {
+        return -1;
+    }
+
+    const client_array_t *vertex = &client.vertex;
+    if (!vertex->set || !vertex->pointer || vertex->type != GL_FLOAT || vertex->size < 2 || vertex->size > 4) {
+        return -1;
+    }
+
+    memset(layout, 0, sizeof(*layout));
+    layout->position_size = vertex->size;
+
+    if (client.texcoord_enabled & 1u) {
+        const client_array_t *texcoord = &client.texcoord;
+        if (!texcoord->set || !texcoord->pointer || texcoord->type != GL_FLOAT ||
+            texcoord->size < 2 || texcoord->size > 4) {
+            return -1;
+        }
+        layout->texcoord_size = texcoord->size;
+    }
+
+    if (client.color_enabled) {
+        const client_array_t *color = &client.color;
+        if (!color->set || !color->pointer || color->size != 4 ||
+            (color->type != GL_FLOAT && color->type != GL_UNSIGNED_BYTE)) {
+            return -1;
+        }
+        layout->color_type = color->type;
+    }
+
+    layout->stride = (layout->position_size + layout->texcoord_size) * sizeof(float) +
+                     (layout->color_type == GL_FLOAT ? 4 * sizeof(float) :
+                      layout->color_type ? 4 : 0);
+    return 0;
+}
+
+static int triangle_indices(GLenum mode, int count) {
+    switch (mode) {
+        case GL_TRIANGLES:
+            return count - count % 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            return count >= 3 ? (count - 2) * 3 : 0;
+        default:
+            return 0;
+    }
+}
+
+// Make room for a draw, flushing a full or differently laid-out batch
+static int reserve(const batch_layout_t *layout, int vertices, int indices) {
+    if (vertices > BATCH_VERTEX_MAX || indices > (int)BATCH_INDEX_MAX ||
+        (size_t)vertices * layout->stride > BATCH_VERTEX_BYTES) {
+        return -1;
+    }
+
+    if (batch.index_count > 0) {
+        int same = memcmp(&batch.layout, layout, sizeof(*layout)) == 0;
+        int fits = batch.vertex_count + vertices <= BATCH_VERTEX_MAX &&
+                   batch.index_count + indices <= (int)BATCH_INDEX_MAX &&
+                   (size_t)(batch.vertex_count + vertices) * layout->stride <= BATCH_VERTEX_BYTES;
+        if (same && fits) {
+            return 0;
+        }
+        gl_batch_flush();
+    }
+
+    batch.layout = *layout;
+    return 0;
+}
+
+static void copy_attribute(uint8_t *out, const client_array_t *array, size_t element, int index, int components) {
+    size_t stride = array->stride ? (size_t)array->stride : components * element;
+    memcpy(out, (const uint8_t *)array->pointer + (size_t)index * stride, components * element);
+}
+
+static void copy_vertices(int first, int count) {
+    const batch_layout_t *layout = &batch.layout;
+    uint8_t *out = batch.vertices + (size_t)batch.vertex_count * layout->stride;
+#if GL_SPRITE_ATLAS
+    // A packed sprite's coordinates move into its page rectangle, clamped like its own texture
+    const gl_atlas_uv_t *uv = layout->texcoord_size ? gl_atlas_bound_uv() : NULL;
+#endif
+
+    for (int i = first; i < first + count; i++) {
+        uint8_t *vertex = out;
+        copy_attribute(vertex, &client.vertex, sizeof(float), i, layout->position_size);
+        vertex += layout->position_size * sizeof(float);
+        if (layout->texcoord_size) {
+            copy_attribute(vertex, &client.texcoord, sizeof(float), i, layout->texcoord_size);
+#if GL_SPRITE_ATLAS
+            if (uv) {
+                float *st = (float *)vertex;
+                st[0] = uv->offset_u + (st[0] < 0.0f ? 0.0f : st[0] > 1.0f ? 1.0f : st[0]) * uv->scale_u;
+                st[1] = uv->offset_v + (st[1] < 0.0f ? 0.0f : st[1] > 1.0f ? 1.0f : st[1]) * uv->scale_v;
+            }
+#endif
+            vertex += layout->texcoord_size * sizeof(float);
+        }
+        if (layout->color_type) {
+            copy_attribute(vertex, &client.color, layout->color_type == GL_FLOAT ? sizeof(float) : 1, i, 4);
+        }
+        out += layout->stride;
+    }
+
+    batch.vertex_count += count;
+}
+
+// Append a draw as a triangle list; order is NULL for sequential vertices
+static void emit_triangles(GLenum mode, const int *order, int count, int base) {
+    GLushort *out = batch.indices + batch.index_count;
+
+#define VERTEX(i) ((GLushort)(base + (order ? order[i] : (i))))
+    if (mode == GL_TRIANGLES) {
+        for (int i = 0; i + 2 < count; i += 3) {
+            *out++ = VERTEX(i);
+            *out++ = VERTEX(i + 1);
+            *out++ = VERTEX(i + 2);
+        }
+    } else if (mode == GL_TRIANGLE_STRIP) {
+        // Swap every other triangle to keep the winding consistent
+        for (int i = 0; i + 2 < count; i++) {
+            *out++ = VERTEX(i & 1 ? i + 1 : i);
+            *out++ = VERTEX(i & 1 ? i : i + 1);
+            *out++ = VERTEX(i + 2);
+        }
+    } else {
+        for (int i = 1; i + 1 < count; i++) {
+            *out++ = VERTEX(0);
+            *out++ = VERTEX(i);
+            *out++ = VERTEX(i + 1);
+        }
+    }
+#undef VERTEX
+
+    batch.index_count = (int)(out - batch.indices);
+}
+
+// Point GL back at the game's arrays after drawing from the staging buffer
+static void restore_pointers(void) {
+    if (client.vertex.set) {
+        glVertexPointer(client.vertex.size, client.vertex.type, client.vertex.stride, client.vertex.pointer);
+    }
+    if (client.texcoord.set) {
+        glTexCoordPointer(client.texcoord.size, client.texcoord.type, client.texcoord.stride, client.texcoord.pointer);
+    }
+    if (client.color.set) {
+        glColorPointer(client.color.size, client.color.type, client.color.stride, client.color.pointer);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * GLES1 Sprite Batcher
+ *
+ * The game draws most sprites as separate 4-vertex glDrawArrays calls. With
+ * GL_SPRITE_BATCH set, consecutive fixed-function draws from client memory
+ * are copied into one interleaved stream and submitted as a single indexed
+ * GL_TRIANGLES draw. Anything that changes render state flushes the batch
+ * first: the state filter (gl_state.c) calls gl_batch_flush() before every
+ * real change, the *_batched entry points below cover the remaining GLES1
+ * calls the game imports.
+ */
+
+#ifndef SOLOADER_GL_BATCH_H
+#define SOLOADER_GL_BATCH_H
+
+#include <vitaGL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int draws;          // Game draws merged into a batch
+    int batches;        // Draws actually submitted for them
+} gl_batch_stats_t;
+
+int gl_batch_init(void);
+void gl_batch_shutdown(void);
+
+// Submit the pending batch, if any
+void gl_batch_flush(void);
+
+// Flush and roll the per-frame counters over; call before swapping buffers
+void gl_batch_end_frame(void);
+
+// Counters of the last complete frame
+void gl_batch_get_stats(gl_batch_stats_t *stats);
+
+// State notifications from the state filter, made on every call
+void gl_batch_client_unit(GLenum texture);
+void gl_batch_client_state(GLenum array, int enabled);
+void gl_batch_program(GLuint program);
+
+// Queue a draw; 0 if it can't be batched (the batch has been flushed)
+int gl_batch_draw_arrays(GLenum mode, GLint first, GLsizei count);
+int gl_batch_draw_elements(GLenum mode, GLsizei count, GLenum type, const void *indices);
+
+void glVertexPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer);
+void glColorPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer);
+void glTexCoordPointer_batched(GLint size, GLenum type, GLsizei stride, const void *pointer);
+void glBindBuffer_batched(GLenum target, GLuint buffer);
+void glDeleteBuffers_batched(GLsizei n, const GLuint *buffers);
+void glAlphaFunc_batched(GLenum func, GLfloat ref);
+void glClear_batched(GLbitfield mask);
+void glColor4f_batched(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void glDepthFunc_batched(GLenum func);
+void glDepthMask_batched(GLboolean flag);
+void glTexEnvi_batched(GLenum target, GLenum pname, GLint param);
+void glTexParameteri_batched(GLenum target, GLenum pname, GLint param);
+void glTexImage2D_batched(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                          GLsizei height, GLint border, GLenum format, GLenum type, const void *data);
+void glTexSubImage2D_batched(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                             GLsizei height, GLenum format, GLenum type, const void *pixels);
+void glLoadIdentity_batched(void);
+void glLoadMatrixf_batched(const GLfloat *m);
+void glPopMatrix_batched(void);
+void glRotatef_batched(GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+void glScalef_batched(GLfloat x, GLfloat y, GLfloat z);
+void glTranslatef_batched(GLfloat x, GLfloat y, GLfloat z);
+void glOrthof_batched(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat near_val, GLfloat far_val);
+void glFrustumf_batched(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat near_val, GLfloat far_val);
+void glViewport_batched(GLint x, GLint y, GLsizei width, GLsizei height);
+void glFinish_batched(void);
+void glFlush_batched(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_GL_BATCH_H
@@ -0,0 +1,303 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Dynamic Resolution
+ *
+ * The target is allocated once at native size and only its lower-left
+ * corner is drawn into at reduced scales, so a scale change costs nothing
+ * but a viewport; the blit samples just that corner. Decisions are made
+ * every DYNRES_INTERVAL frames from the newest GPU times, skipping the few
+ * still in flight from before the last change. Scaling down is immediate
+ * once frames run close to their budget; scaling up waits until the time
+ * predicted at the larger size, by pixel count, leaves clear headroom.
+ */
+
+#include <vitaGL.h>
+
+#include "config.h"
+#include "frame_pacer.h"
+#include "graphics.h"
+#include "reimpl/gl_batch.h"
+#include "reimpl/gl_dynres.h"
+#include "utils/logger.h"
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#endif
+#ifndef GL_RENDERBUFFER
+#define GL_RENDERBUFFER 0x8D41
+#endif
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#endif
+#ifndef GL_DEPTH_STENCIL_ATTACHMENT
+#define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+#endif
+#ifndef GL_DEPTH24_STENCIL8_OES
+#define GL_DEPTH24_STENCIL8_OES 0x88F0
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+#define DYNRES_LEVELS 5                 // Native down to DYNRES_MIN_WIDTH
+#define DYNRES_INTERVAL 30              // Frames between decisions
+#define DYNRES_LAG 6                    // Newest frames whose GPU time may predate a change
+#define DYNRES_DOWN 0.90f               // GPU time / budget that scales down
+#define DYNRES_UP 0.75f                 // Predicted GPU time / budget that allows scaling up
+
+#if DYNAMIC_RESOLUTION
+
+static struct {
+    int active;
+    GLuint framebuffer;
+    GLuint texture;
+    GLuint depth;
+    int level;
+    int width;
+    int height;
+    int window_frames;
+    GLint viewport[4];                  // Last viewport the game asked for
+} dynres;
+
+// Function prototypes
+static void level_size(int level, int *width, int *height);
+static void set_level(int level);
+static void apply_viewport(void);
+static void pick_scale(void);
+static void blit(void);
+
+#endif // DYNAMIC_RESOLUTION
+
+int gl_dynres_init(void) {
+#if DYNAMIC_RESOLUTION
+    glGenTextures(1, &dynres.texture);
+    glBindTexture(GL_TEXTURE_2D, dynres.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &dynres.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, dynres.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8_OES, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    glGenFramebuffers(1, &dynres.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, dynres.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dynres.texture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, dynres.depth);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        l_error("Dynamic resolution target incomplete (0x%04X), rendering at native size", status);
+        gl_dynres_shutdown();
+        return -1;
+    }
+
+    dynres.viewport[2] = SCREEN_WIDTH;
+    dynres.viewport[3] = SCREEN_HEIGHT;
+    set_level(0);
+    dynres.active = 1;
+
+    l_success("Dynamic resolution initialized (%dx%d down to %dx%d)", SCREEN_WIDTH, SCREEN_HEIGHT,
+              DYNRES_MIN_WIDTH, DYNRES_MIN_WIDTH * SCREEN_HEIGHT / SCREEN_WIDTH);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+void gl_dynres_shutdown(void) {
+#if DYNAMIC_RESOLUTION
+    if (dynres.framebuffer) {
+        glDeleteFramebuffers(1, &dynres.framebuffer);
+    }
+    if (dynres.depth) {
+        glDeleteRenderbuffers(1, &dynres.depth);
+    }
+    if (dynres.texture) {
+        glDeleteTextures(1, &dynres.texture);
+    }
+    dynres.framebuffer = dynres.depth = dynres.texture = 0;
+    dynres.active = 0;
+#endif
+}
+
+void gl_dynres_begin_frame(void) {
+#if DYNAMIC_RESOLUTION
+    if (!dynres.active) {
+        return;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, dynres.framebuffer);
+    apply_viewport();
+#endif
+}
+
+void gl_dynres_end_frame(void) {
+#if DYNAMIC_RESOLUTION
+    if (!dynres.active) {
+        return;
+    }
+    blit();
+    pick_scale();
+#endif
+}
+
+void gl_dynres_get_size(int *width, int *height) {
+#if DYNAMIC_RESOLUTION
+    if (dynres.active) {
+        *width = dynres.width;
+        *height = dynres.height;
+        return;
+    }
+#endif
+    *width = SCREEN_WIDTH;
+    *height = SCREEN_HEIGHT;
+}
+
+void glViewport_scaled(GLint x, GLint y, GLsizei width, GLsizei height) {
+#if GL_SPRITE_BATCH
+    gl_batch_flush();
+#endif
+#if DYNAMIC_RESOLUTION
+    dynres.viewport[0] = x;
+    dynres.viewport[1] = y;
+    dynres.viewport[2] = width;
+    dynres.viewport[3] = height;
+    if (dynres.active) {
+        apply_viewport();
+        return;
+    }
+#endif
+    glViewport(x, y, width, height);
+}
+
+#if DYNAMIC_RESOLUTION
+
+// ===== SCALING =====
+
+static void level_size(int level, int *width, int *height) {
+    int step = (SCREEN_WIDTH - DYNRES_MIN_WIDTH) / (DYNRES_LEVELS - 1);
+    *width = SCREEN_WIDTH - level * step;
+    *height = (*width * SCREEN_HEIGHT / SCREEN_WIDTH) & ~1;
+}
+
+static void set_level(int level) {
+    dynres.level = level;
+    level_size(level, &dynres.width, &dynres.height);
+    dynres.window_frames = 0;
+}
+
+static void apply_viewport(void) {
+    const GLint *v = dynres.viewport;
+    glViewport(v[0] * dynres.width / SCREEN_WIDTH, v[1] * dynres.height / SCREEN_HEIGHT,
+               v[2] * dynres.width / SCREEN_WIDTH, v[3] * dynres.height / SCREEN_HEIGHT);
+}
+
+static void pick_scale(void) {
+    if (++dynres.window_frames < DYNRES_INTERVAL) {
+        return;
+    }
+    dynres.window_frames = 0;
+
+    uint32_t samples[DYNRES_INTERVAL - DYNRES_LAG];
+    int count = graphics_get_gpu_times(samples, (int)ARRAY_SIZE(samples));
+    if (count < (int)ARRAY_SIZE(samples)) {
+        return;
+    }
+
+    uint64_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    float gpu_us = (float)sum / count;
+    float budget_us = frame_pacer_interval() * 1000000.0f / 60.0f;
+
+    if (gpu_us > budget_us * DYNRES_DOWN && dynres.level < DYNRES_LEVELS - 1) {
+        set_level(dynres.level + 1);
+        l_debug("Dynamic resolution: GPU %.1f ms, down to %dx%d", gpu_us / 1000.0f, dynres.width, dynres.height);
+    } else if (dynres.level > 0) {
+        int width, height;
+        level_size(dynres.level - 1, &width, &height);
+        float predicted_us = gpu_us * (width * height) / (float)(dynres.width * dynres.height);
+        if (predicted_us < budget_us * DYNRES_UP) {
+            set_level(dynres.level - 1);
+            l_debug("Dynamic resolution: GPU %.1f ms, up to %dx%d", gpu_us / 1000.0f, dynres.width, dynres.height);
+        }
+    }
+}
+
+// ===== BLIT =====
+
+static void blit(void) {
+    // Save what the blit changes
+    GLint program = 0, matrix_mode = 0, active_texture = 0, bound_texture = 0;
+    GLfloat color[4];
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glGetIntegerv(GL_MATRIX_MODE, &matrix_mode);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &active_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound_texture);
+    glGetFloatv(GL_CURRENT_COLOR, color);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean cull = glIsEnabled(GL_CULL_FACE);
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    GLboolean texture = glIsEnabled(GL_TEXTURE_2D);
+    GLboolean alpha_test = glIsEnabled(GL_ALPHA_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glUseProgram(0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, 1, 0, 1, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_ALPHA_TEST);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, dynres.texture);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    // Only the corner this frame was drawn into
+    float u = (float)dynres.width / SCREEN_WIDTH;
+    float v = (float)dynres.height / SCREEN_HEIGHT;
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f);
+    glVertex2f(0.0f, 0.0f);
+    glTexCoord2f(u, 0.0f);
+    glVertex2f(1.0f, 0.0f);
+    glTexCoord2f(u, v);
+    glVertex2f(1.0f, 1.0f);
+    glTexCoord2f(0.0f, v);
+    glVertex2f(0.0f, 1.0f);
+    glEnd();
+
+    // Restore the game's state; the viewport is reapplied with the target
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glMatrixMode(matrix_mode);
+    glBindTexture(GL_TEXTURE_2D, bound_texture);
+    glActiveTexture(active_texture);
+    glColor4f(color[0], color[1], color[2], color[3]);
+    if (blend) glEnable(GL_BLEND);
+    if (depth) glEnable(GL_DEPTH_TEST);
+    if (cull) glEnable(GL_CULL_FACE);
+    if (scissor) glEnable(GL_SCISSOR_TEST);
+    if (!texture) glDisable(GL_TEXTURE_2D);
+    if (alpha_test) glEnable(GL_ALPHA_TEST);
+    glUseProgram(program);
+}
+
+#endif // DYNAMIC_RESOLUTION
@@ -0,0 +1,42 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Dynamic Resolution
+ *
+ * With DYNAMIC_RESOLUTION set the game draws into an offscreen target
+ * instead of the framebuffer, and graphics_frame_end() stretches it to the
+ * screen with a bilinear blit. Only the sub-rectangle the current scale
+ * covers is rendered: glViewport_scaled, bound in place of glViewport,
+ * maps the game's viewports into it, so the game's projection, and with
+ * it touch mapping, stays in 960x544 game coordinates at every scale.
+ * The scale steps between DYNRES_MIN_WIDTH and native on recent GPU time.
+ */
+
+#ifndef SOLOADER_GL_DYNRES_H
+#define SOLOADER_GL_DYNRES_H
+
+#include <vitaGL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create the offscreen target; -1 leaves rendering at native resolution
+int gl_dynres_init(void);
+void gl_dynres_shutdown(void);
+
+// Bind the offscreen target at the current scale; call before clearing
+void gl_dynres_begin_frame(void);
+
+// Blit to the screen and pick the next frame's scale; call before overlays and the swap
+void gl_dynres_end_frame(void);
+
+// Size the game is currently rendered at
+void gl_dynres_get_size(int *width, int *height);
+
+void glViewport_scaled(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_GL_DYNRES_H
@@ -0,0 +1,506 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * GL State Filter
+ *
+ * Every tracked value starts out unknown, so the first call after
+ * gl_state_begin_frame() always reaches vitaGL. Uniform values live with
+ * their program in GL, so they are kept across frames and only dropped
+ * when a program is relinked or deleted.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vitaGL.h>
+
+#include "config.h"
+#include "profiler.h"
+#include "reimpl/gl_state.h"
+#include "reimpl/gl_batch.h"
+#include "reimpl/gl_atlas.h"
+#include "reimpl/gl_upload.h"
+
+#define GL_STATE_UNITS 8
+#define GL_STATE_UNKNOWN 0xFF
+#define UNIFORM_SLOTS 512               // Power of two
+
+// A pending sprite batch is drawn with the state it was queued under
+#if GL_SPRITE_BATCH
+#define BATCH_FLUSH() gl_batch_flush()
+#else
+#define BATCH_FLUSH() ((void)0)
+#endif
+
+#ifndef GL_ALPHA_TEST
+#define GL_ALPHA_TEST 0x0BC0
+#endif
+
+// Server-side caps tracked outside the per-unit GL_TEXTURE_2D enable
+enum {
+    CAP_BLEND,
+    CAP_DEPTH_TEST,
+    CAP_CULL_FACE,
+    CAP_ALPHA_TEST,
+    CAP_SCISSOR_TEST,
+    CAP_STENCIL_TEST,
+    CAP_COUNT
+};
+
+enum {
+    ARRAY_VERTEX,
+    ARRAY_COLOR,
+    ARRAY_NORMAL,
+    ARRAY_COUNT
+};
+
+enum {
+    UNIFORM_1F = 1,
+    UNIFORM_1I,
+    UNIFORM_2F,
+    UNIFORM_3F,
+    UNIFORM_4F,
+    UNIFORM_MAT4
+};
+
+typedef struct {
+    GLuint program;
+    GLint location;
+    uint8_t kind;                       // UNIFORM_*, 0 = empty slot
+    uint32_t value[16];                 // Raw bits, so -0.0f and NaN compare exactly
+} uniform_slot_t;
+
+static struct {
+    int active_unit;                    // -1 = unknown
+    int client_unit;
+    GLuint bound_texture[GL_STATE_UNITS];
+    uint8_t bound_known[GL_STATE_UNITS];
+    uint8_t texture_enabled[GL_STATE_UNITS];
+    uint8_t texcoord_array[GL_STATE_UNITS];
+    uint8_t caps[CAP_COUNT];
+    uint8_t arrays[ARRAY_COUNT];
+    GLenum blend_src;
+    GLenum blend_dst;
+    int blend_known;
+    GLuint program;
+    int program_known;
+} shadow;
+
+static uniform_slot_t uniforms[UNIFORM_SLOTS];
+static gl_state_stats_t frame_stats;
+static gl_state_stats_t last_stats;
+static int shadow_ready = 0;
+static int skip_draws = 0;
+
+// Function prototypes
+static void shadow_reset(void);
+static int cap_index(GLenum cap);
+static int array_index(GLenum array);
+static int update_flag(uint8_t *flag, int enabled);
+static int set_cap(GLenum cap, int enabled);
+static int set_array(GLenum array, int enabled);
+static int uniform_changed(GLint location, int kind, const void *value, size_t size);
+
+void gl_state_begin_frame(void) {
+    last_stats = frame_stats;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    shadow_reset();
+}
+
+void gl_state_skip_draws(int skip) {
+    skip_draws = skip;
+}
+
+void gl_state_get_stats(gl_state_stats_t *stats) {
+    if (stats) {
+        *stats = last_stats;
+    }
+}
+
+void gl_state_texture_bound(GLuint texture) {
+    if (shadow_ready && shadow.active_unit >= 0) {
+        shadow.bound_texture[shadow.active_unit] = texture;
+        shadow.bound_known[shadow.active_unit] = 1;
+    }
+}
+
+// ===== TEXTURES =====
+
+void glActiveTexture_filtered(GLenum texture) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_SPRITE_ATLAS
+    gl_atlas_active_unit(texture);
+#endif
+#if GL_UPLOAD_FILTER
+    gl_upload_active_unit(texture);
+#endif
+
+    int unit = (int)(texture - GL_TEXTURE0);
+    if (unit >= 0 && unit < GL_STATE_UNITS && shadow.active_unit == unit) {
+        frame_stats.filtered++;
+        return;
+    }
+
+    shadow.active_unit = (unit >= 0 && unit < GL_STATE_UNITS) ? unit : -1;
+    glActiveTexture(texture);
+}
+
+void glBindTexture_filtered(GLenum target, GLuint texture) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_UPLOAD_FILTER
+    gl_upload_bind(target, texture);
+#endif
+#if GL_SPRITE_ATLAS
+    // Sprites sharing a page bind the same name, and the switch is dropped
+    texture = gl_atlas_bind(target, texture);
+#endif
+
+    int unit = shadow.active_unit;
+    if (target != GL_TEXTURE_2D || unit < 0) {
+        BATCH_FLUSH();
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (shadow.bound_known[unit] && shadow.bound_texture[unit] == texture) {
+        frame_stats.filtered++;
+        return;
+    }
+
+    shadow.bound_texture[unit] = texture;
+    shadow.bound_known[unit] = 1;
+    BATCH_FLUSH();
+    glBindTexture(target, texture);
+}
+
+void glDeleteTextures_filtered(GLsizei n, const GLuint *textures) {
+    if (!shadow_ready) shadow_reset();
+
+    // GL rebinds 0 wherever a deleted texture was bound
+    for (GLsizei i = 0; i < n; i++) {
+#if GL_SPRITE_ATLAS
+        gl_atlas_delete(textures[i]);
+#endif
+#if GL_UPLOAD_FILTER
+        gl_upload_forget(textures[i]);
+#endif
+        for (int unit = 0; unit < GL_STATE_UNITS; unit++) {
+            if (shadow.bound_known[unit] && shadow.bound_texture[unit] == textures[i]) {
+                shadow.bound_texture[unit] = 0;
+            }
+        }
+    }
+    BATCH_FLUSH();
+    glDeleteTextures(n, textures);
+}
+
+void glPixelStorei_filtered(GLenum pname, GLint param) {
+#if GL_UPLOAD_FILTER
+    gl_upload_pixel_store(pname, param);
+#endif
+    glPixelStorei(pname, param);
+}
+
+// ===== FIXED-FUNCTION STATE =====
+
+void glBlendFunc_filtered(GLenum sfactor, GLenum dfactor) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+
+    if (shadow.blend_known && shadow.blend_src == sfactor && shadow.blend_dst == dfactor) {
+        frame_stats.filtered++;
+        return;
+    }
+
+    shadow.blend_src = sfactor;
+    shadow.blend_dst = dfactor;
+    shadow.blend_known = 1;
+    BATCH_FLUSH();
+    glBlendFunc(sfactor, dfactor);
+}
+
+void glEnable_filtered(GLenum cap) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+
+    if (!set_cap(cap, 1)) {
+        frame_stats.filtered++;
+        return;
+    }
+    BATCH_FLUSH();
+    glEnable(cap);
+}
+
+void glDisable_filtered(GLenum cap) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+
+    if (!set_cap(cap, 0)) {
+        frame_stats.filtered++;
+        return;
+    }
+    BATCH_FLUSH();
+    glDisable(cap);
+}
+
+void glClientActiveTexture_filtered(GLenum texture) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_SPRITE_BATCH
+    gl_batch_client_unit(texture);
+#endif
+
+    int unit = (int)(texture - GL_TEXTURE0);
+    if (unit >= 0 && unit < GL_STATE_UNITS && shadow.client_unit == unit) {
+        frame_stats.filtered++;
+        return;
+    }
+
+    shadow.client_unit = (unit >= 0 && unit < GL_STATE_UNITS) ? unit : -1;
+    BATCH_FLUSH();
+    glClientActiveTexture(texture);
+}
+
+void glEnableClientState_filtered(GLenum array) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_SPRITE_BATCH
+    gl_batch_client_state(array, 1);
+#endif
+
+    if (!set_array(array, 1)) {
+        frame_stats.filtered++;
+        return;
+    }
+    BATCH_FLUSH();
+    glEnableClientState(array);
+}
+
+void glDisableClientState_filtered(GLenum array) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_SPRITE_BATCH
+    gl_batch_client_state(array, 0);
+#endif
+
+    if (!set_array(array, 0)) {
+        frame_stats.filtered++;
+        return;
+    }
+    BATCH_FLUSH();
+    glDisableClientState(array);
+}
+
+// ===== PROGRAMS AND UNIFORMS =====
+
+void glUseProgram_filtered(GLuint program) {
+    if (!shadow_ready) shadow_reset();
+    frame_stats.state_calls++;
+#if GL_SPRITE_BATCH
+    gl_batch_program(program);
+#endif
+
+    if (shadow.program_known && shadow.program == program) {
+        frame_stats.filtered++;
+        return;
+    }
+
+    shadow.program = program;
+    shadow.program_known = 1;
+    BATCH_FLUSH();
+    glUseProgram(program);
+}
+
+void glLinkProgram_filtered(GLuint program) {
+    // Linking resets every uniform of the program to zero
+    memset(uniforms, 0, sizeof(uniforms));
+    PROF_SCOPE("glLinkProgram");
+    glLinkProgram(program);
+}
+
+void glDeleteProgram_filtered(GLuint program) {
+    // The name may come back from glCreateProgram with fresh uniforms
+    memset(uniforms, 0, sizeof(uniforms));
+    if (shadow.program == program) {
+        shadow.program_known = 0;
+    }
+    glDeleteProgram(program);
+}
+
+void glUniform1f_filtered(GLint location, GLfloat v0) {
+    if (uniform_changed(location, UNIFORM_1F, &v0, sizeof(v0))) {
+        glUniform1f(location, v0);
+    }
+}
+
+void glUniform1i_filtered(GLint location, GLint v0) {
+    if (uniform_changed(location, UNIFORM_1I, &v0, sizeof(v0))) {
+        glUniform1i(location, v0);
+    }
+}
+
+void glUniform2f_filtered(GLint location, GLfloat v0, GLfloat v1) {
+    GLfloat value[2] = { v0, v1 };
+    if (uniform_changed(location, UNIFORM_2F, value, sizeof(value))) {
+        glUniform2f(location, v0, v1);
+    }
+}
+
+void glUniform3f_filtered(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+    GLfloat value[3] = { v0, v1, v2 };
+    if (uniform_changed(location, UNIFORM_3F, value, sizeof(value))) {
+        glUniform3f(location, v0, v1, v2);
+    }
+}
+
+void glUniform4f_filtered(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+    GLfloat value[4] = { v0, v1, v2, v3 };
+    if (uniform_changed(location, UNIFORM_4F, value, sizeof(value))) {
+        glUniform4f(location, v0, v1, v2, v3);
+    }
+}
+
+void glUniformMatrix4fv_filtered(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+    // Arrays of matrices are rare enough to pass straight through
+    if (count != 1 || !value || uniform_changed(location, UNIFORM_MAT4, value, 16 * sizeof(GLfloat))) {
+        glUniformMatrix4fv(location, count, transpose, value);
+    }
+}
+
+// ===== DRAWS =====
+
+void glDrawArrays_filtered(GLenum mode, GLint first, GLsizei count) {
+    if (skip_draws) {
+        frame_stats.skipped++;
+        return;
+    }
+
+    frame_stats.draws++;
+#if GL_SPRITE_BATCH
+    if (gl_batch_draw_arrays(mode, first, count)) {
+        return;
+    }
+#endif
+#if GL_SPRITE_ATLAS
+    gl_atlas_draw_begin();
+#endif
+    glDrawArrays(mode, first, count);
+#if GL_SPRITE_ATLAS
+    gl_atlas_draw_end();
+#endif
+}
+
+void glDrawElements_filtered(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    if (skip_draws) {
+        frame_stats.skipped++;
+        return;
+    }
+
+    frame_stats.draws++;
+#if GL_SPRITE_BATCH
+    if (gl_batch_draw_elements(mode, count, type, indices)) {
+        return;
+    }
+#endif
+#if GL_SPRITE_ATLAS
+    gl_atlas_draw_begin();
+#endif
+    glDrawElements(mode, count, type, indices);
+#if GL_SPRITE_ATLAS
+    gl_atlas_draw_end();
+#endif
+}
+
+// ===== SHADOW STATE =====
+
+static void shadow_reset(void) {
+    memset(&shadow, 0, sizeof(shadow));
+    shadow.active_unit = -1;
+    shadow.client_unit = -1;
+    memset(shadow.texture_enabled, GL_STATE_UNKNOWN, sizeof(shadow.texture_enabled));
+    memset(shadow.texcoord_array, GL_STATE_UNKNOWN, sizeof(shadow.texcoord_array));
+    memset(shadow.caps, GL_STATE_UNKNOWN, sizeof(shadow.caps));
+    memset(shadow.arrays, GL_STATE_UNKNOWN, sizeof(shadow.arrays));
+    shadow_ready = 1;
+}
+
+static int cap_index(GLenum cap) {
+    switch (cap) {
+        case GL_BLEND: return CAP_BLEND;
+        case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+        case GL_CULL_FACE: return CAP_CULL_FACE;
+        case GL_ALPHA_TEST: return CAP_ALPHA_TEST;
+        case GL_SCISSOR_TEST: return CAP_SCISSOR_TEST;
+        case GL_STENCIL_TEST: return CAP_STENCIL_TEST;
+        default: return -1;
+    }
+}
+
+static int array_index(GLenum array) {
+    switch (array) {
+        case GL_VERTEX_ARRAY: return ARRAY_VERTEX;
+        case GL_COLOR_ARRAY: return ARRAY_COLOR;
+        case GL_NORMAL_ARRAY: return ARRAY_NORMAL;
+        default: return -1;
+    }
+}
+
+// Records the new value; 0 if it was already set (the call is redundant)
+static int update_flag(uint8_t *flag, int enabled) {
+    if (*flag == enabled) {
+        return 0;
+    }
+    *flag = (uint8_t)enabled;
+    return 1;
+}
+
+static int set_cap(GLenum cap, int enabled) {
+    if (cap == GL_TEXTURE_2D) {
+        // Per texture unit under GLES1
+        return shadow.active_unit < 0 ? 1 : update_flag(&shadow.texture_enabled[shadow.active_unit], enabled);
+    }
+
+    int index = cap_index(cap);
+    return index < 0 ? 1 : update_flag(&shadow.caps[index], enabled);
+}
+
+static int set_array(GLenum array, int enabled) {
+    if (array == GL_TEXTURE_COORD_ARRAY) {
+        return shadow.client_unit < 0 ? 1 : update_flag(&shadow.texcoord_array[shadow.client_unit], enabled);
+    }
+
+    int index = array_index(array);
+    return index < 0 ? 1 : update_flag(&shadow.arrays[index], enabled);
+}
+
+// 1 if the uniform must be sent; the value is remembered for the current program
+static int uniform_changed(GLint location, int kind, const void *value, size_t size) {
+    frame_stats.state_calls++;
+    if (!shadow_ready || !shadow.program_known || shadow.program == 0 || location < 0) {
+        return 1;
+    }
+
+    uint32_t hash = (shadow.program * 2654435761u) ^ ((uint32_t)location * 40503u);
+    for (int probe = 0; probe < UNIFORM_SLOTS; probe++) {
+        uniform_slot_t *slot = &uniforms[(hash + probe) & (UNIFORM_SLOTS - 1)];
+        if (slot->kind == 0) {
+            slot->program = shadow.program;
+            slot->location = location;
+            slot->kind = (uint8_t)kind;
+            memcpy(slot->value, value, size);
+            return 1;
+        }
+        if (slot->program == shadow.program && slot->location == location) {
+            if (slot->kind == kind && memcmp(slot->value, value, size) == 0) {
+                frame_stats.filtered++;
+                return 0;
+            }
+            slot->kind = (uint8_t)kind;
+            memcpy(slot->value, value, size);
+            return 1;
+        }
+    }
+
+    // Table full until the next relink: send everything
+    return 1;
+}
@@ -0,0 +1,66 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * GL State Filter
+ *
+ * Shadow copies of the GL state the game changes most often. The *_filtered
+ * entry points are bound in place of vitaGL's through default_dynlib[] when
+ * GL_STATE_FILTER is set, and drop any call that would not change state.
+ */
+
+#ifndef SOLOADER_GL_STATE_H
+#define SOLOADER_GL_STATE_H
+
+#include <vitaGL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int draws;          // glDrawArrays / glDrawElements calls
+    int state_calls;    // Filterable calls the game made
+    int filtered;       // ...of which were dropped as redundant
+    int skipped;        // Draws dropped by gl_state_skip_draws()
+} gl_state_stats_t;
+
+// Forget the shadow state (port code may have touched GL directly) and roll
+// the per-frame counters over. Called once per frame.
+void gl_state_begin_frame(void);
+
+// Drop the game's draws while set; state changes still go through. Used for
+// simulation ticks whose output would be overdrawn in the same frame.
+void gl_state_skip_draws(int skip);
+
+// Counters of the last complete frame
+void gl_state_get_stats(gl_state_stats_t *stats);
+
+// Port code bound `texture` on the active unit without going through the filter
+void gl_state_texture_bound(GLuint texture);
+
+void glActiveTexture_filtered(GLenum texture);
+void glBindTexture_filtered(GLenum target, GLuint texture);
+void glDeleteTextures_filtered(GLsizei n, const GLuint *textures);
+void glPixelStorei_filtered(GLenum pname, GLint param);
+void glBlendFunc_filtered(GLenum sfactor, GLenum dfactor);
+void glEnable_filtered(GLenum cap);
+void glDisable_filtered(GLenum cap);
+void glClientActiveTexture_filtered(GLenum texture);
+void glEnableClientState_filtered(GLenum array);
+void glDisableClientState_filtered(GLenum array);
+void glUseProgram_filtered(GLuint program);
+void glLinkProgram_filtered(GLuint program);
+void glDeleteProgram_filtered(GLuint program);
+void glUniform1f_filtered(GLint location, GLfloat v0);
+void glUniform1i_filtered(GLint location, GLint v0);
+void glUniform2f_filtered(GLint location, GLfloat v0, GLfloat v1);
+void glUniform3f_filtered(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void glUniform4f_filtered(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void glUniformMatrix4fv_filtered(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
+void glDrawArrays_filtered(GLenum mode, GLint first, GLsizei count);
+void glDrawElements_filtered(GLenum mode, GLsizei count, GLenum type, const void *indices);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_GL_STATE_H
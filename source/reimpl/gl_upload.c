@@ -0,0 +1,259 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Texture Upload Filter
+ *
+ * Records are keyed by the game's texture name, as bound before the sprite
+ * atlas translates it, so two sprites sharing a page never match each
+ * other. Pixels are hashed row by row at the stride GL_UNPACK_ALIGNMENT
+ * gives them, so row padding, which GL never reads, can't hide a change.
+ * Texture contents only change through the two upload calls the game
+ * imports, the texture loader (which calls gl_upload_forget()) and
+ * glDeleteTextures, so a matching record is what the texture holds.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vitaGL.h>
+
+#include "config.h"
+#include "reimpl/gl_upload.h"
+#include "utils/logger.h"
+
+#define UPLOAD_RECORDS 256              // Power of two
+#define UPLOAD_UNITS   8
+#define WHOLE_LEVEL    (-1)             // Record xoffset of a glTexImage2D
+
+typedef struct {
+    GLuint texture;                     // Game's name, 0 = empty record
+    GLint level;
+    GLint x;                            // WHOLE_LEVEL for a full glTexImage2D
+    GLint y;
+    GLsizei width;
+    GLsizei height;
+    GLint internalformat;
+    GLenum format;
+    GLenum type;
+    uint64_t hash;
+} upload_record_t;
+
+static upload_record_t records[UPLOAD_RECORDS];
+static uint32_t next_record = 0;
+static GLuint bound[UPLOAD_UNITS];      // Game's name bound on each unit
+static int active_unit = 0;
+static int unpack_alignment = 4;
+static gl_upload_stats_t frame_stats;
+static gl_upload_stats_t last_stats;
+static int initialized = 0;
+
+// Function prototypes
+static int bytes_per_pixel(GLenum format, GLenum type);
+static int pixel_hash(const void *pixels, GLsizei width, GLsizei height, GLenum format, GLenum type, uint64_t *hash);
+static void forget_region(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height);
+static void remember(const upload_record_t *record);
+static void refresh(int index);
+
+int gl_upload_init(void) {
+    memset(records, 0, sizeof(records));
+    memset(bound, 0, sizeof(bound));
+    next_record = 0;
+    active_unit = 0;
+    unpack_alignment = 4;
+    initialized = 1;
+    l_success("Texture upload filter initialized (%d records, uploads up to %d KB)",
+              UPLOAD_RECORDS, GL_UPLOAD_FILTER_MAX_BYTES / 1024);
+    return 0;
+}
+
+void gl_upload_shutdown(void) {
+    initialized = 0;
+}
+
+// ===== NOTIFICATIONS =====
+
+void gl_upload_active_unit(GLenum texture) {
+    int unit = (int)(texture - GL_TEXTURE0);
+    if (unit >= 0 && unit < UPLOAD_UNITS) {
+        active_unit = unit;
+    }
+}
+
+void gl_upload_bind(GLenum target, GLuint texture) {
+    if (target == GL_TEXTURE_2D) {
+        bound[active_unit] = texture;
+    }
+}
+
+void gl_upload_pixel_store(GLenum pname, GLint param) {
+    if (pname == GL_UNPACK_ALIGNMENT) {
+        unpack_alignment = param;
+    }
+}
+
+void gl_upload_forget(GLuint texture) {
+    if (texture == 0) {
+        return;
+    }
+    for (int i = 0; i < UPLOAD_RECORDS; i++) {
+        if (records[i].texture == texture) {
+            records[i].texture = 0;
+        }
+    }
+    for (int unit = 0; unit < UPLOAD_UNITS; unit++) {
+        if (bound[unit] == texture) {
+            bound[unit] = 0;
+        }
+    }
+}
+
+// ===== UPLOADS =====
+
+int gl_upload_tex_image(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                        GLsizei height, GLenum format, GLenum type, const void *data) {
+    GLuint texture = bound[active_unit];
+    if (!initialized || target != GL_TEXTURE_2D || texture == 0) {
+        return 0;
+    }
+    frame_stats.uploads++;
+
+    upload_record_t record = { texture, level, WHOLE_LEVEL, 0, width, height, internalformat, format, type, 0 };
+    if (!pixel_hash(data, width, height, format, type, &record.hash)) {
+        forget_region(texture, level, WHOLE_LEVEL, 0, 0, 0);
+        return 0;
+    }
+
+    for (int i = 0; i < UPLOAD_RECORDS; i++) {
+        const upload_record_t *r = &records[i];
+        if (r->texture == texture && r->hash == record.hash && r->level == level && r->x == WHOLE_LEVEL &&
+            r->width == width && r->height == height && r->internalformat == internalformat &&
+            r->format == format && r->type == type) {
+            frame_stats.dropped++;
+            refresh(i);
+            return 1;
+        }
+    }
+
+    // A new definition of the level replaces everything recorded on it
+    forget_region(texture, level, WHOLE_LEVEL, 0, 0, 0);
+    remember(&record);
+    return 0;
+}
+
+int gl_upload_tex_sub_image(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                            GLsizei height, GLenum format, GLenum type, const void *pixels) {
+    GLuint texture = bound[active_unit];
+    if (!initialized || target != GL_TEXTURE_2D || texture == 0) {
+        return 0;
+    }
+    frame_stats.uploads++;
+
+    upload_record_t record = { texture, level, xoffset, yoffset, width, height, 0, format, type, 0 };
+    int hashed = pixel_hash(pixels, width, height, format, type, &record.hash);
+
+    if (hashed) {
+        for (int i = 0; i < UPLOAD_RECORDS; i++) {
+            const upload_record_t *r = &records[i];
+            if (r->texture == texture && r->hash == record.hash && r->level == level && r->x == xoffset &&
+                r->y == yoffset && r->width == width && r->height == height &&
+                r->format == format && r->type == type) {
+                frame_stats.dropped++;
+                refresh(i);
+                return 1;
+            }
+        }
+    }
+
+    forget_region(texture, level, xoffset, yoffset, width, height);
+    if (hashed) {
+        remember(&record);
+    }
+    return 0;
+}
+
+void gl_upload_end_frame(void) {
+    last_stats = frame_stats;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+void gl_upload_get_stats(gl_upload_stats_t *stats) {
+    if (stats) {
+        *stats = last_stats;
+    }
+}
+
+// ===== RECORDS =====
+
+static int bytes_per_pixel(GLenum format, GLenum type) {
+    if (type == GL_UNSIGNED_BYTE) {
+        switch (format) {
+            case GL_RGBA: return 4;
+            case GL_RGB: return 3;
+            case GL_LUMINANCE_ALPHA: return 2;
+            case GL_LUMINANCE:
+            case GL_ALPHA: return 1;
+            default: return 0;
+        }
+    }
+    if ((type == GL_UNSIGNED_SHORT_5_6_5 && format == GL_RGB) ||
+        ((type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1) && format == GL_RGBA)) {
+        return 2;
+    }
+    return 0;
+}
+
+// 0 if the upload can't be recorded: no pixels, an unknown format or too large
+static int pixel_hash(const void *pixels, GLsizei width, GLsizei height, GLenum format, GLenum type, uint64_t *hash) {
+    int bpp = bytes_per_pixel(format, type);
+    if (!pixels || bpp == 0 || width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    size_t row_bytes = (size_t)width * bpp;
+    if (row_bytes * height > GL_UPLOAD_FILTER_MAX_BYTES) {
+        return 0;
+    }
+    size_t alignment = unpack_alignment > 0 ? (size_t)unpack_alignment : 1;
+    size_t stride = (row_bytes + alignment - 1) / alignment * alignment;
+
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ ((uint64_t)row_bytes << 32) ^ (uint64_t)height;
+    for (GLsizei y = 0; y < height; y++) {
+        const uint8_t *row = (const uint8_t *)pixels + y * stride;
+        size_t i = 0;
+        for (; i + 8 <= row_bytes; i += 8) {
+            uint64_t word;
+            memcpy(&word, row + i, sizeof(word));
+            h = (h ^ word) * 0x9E3779B97F4A7C15ull;
+            h ^= h >> 29;
+        }
+        for (; i < row_bytes; i++) {
+            h = (h ^ row[i]) * 0x100000001B3ull;
+        }
+    }
+    *hash = h;
+    return 1;
+}
+
+// Drop the records of `texture` a write to this region changes; x == WHOLE_LEVEL means all of the level
+static void forget_region(GLuint texture, GLint level, GLint x, GLint y, GLsizei width, GLsizei height) {
+    for (int i = 0; i < UPLOAD_RECORDS; i++) {
+        upload_record_t *r = &records[i];
+        if (r->texture != texture || r->level != level) {
+            continue;
+        }
+        if (x == WHOLE_LEVEL || r->x == WHOLE_LEVEL ||
+            (x < r->x + r->width && r->x < x + width && y < r->y + r->height && r->y < y + height)) {
+            r->texture = 0;
+        }
+    }
+}
+
+// The ring overwrites its oldest slot; refresh() keeps matched records off it
+static void remember(const upload_record_t *record) {
+    records[next_record++ & (UPLOAD_RECORDS - 1)] = *record;
+}
+
+// Move a matched record to the newest slot, so eviction is least recently used
+static void refresh(int index) {
+    upload_record_t record = records[index];
+    records[index].texture = 0;
+    remember(&record);
+}
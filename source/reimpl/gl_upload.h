@@ -0,0 +1,57 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Texture Upload Filter
+ *
+ * The game rasterises its text itself and uploads the glyph quads again on
+ * every draw that shows them, so a score counter or depth readout costs an
+ * upload (and, with GL_SPRITE_BATCH, a batch flush) per glyph per frame even
+ * when nothing in it changed. With GL_UPLOAD_FILTER set, each small upload
+ * is hashed and remembered per texture name and region; an upload of the
+ * same pixels to the same place is dropped before it flushes anything, so
+ * unchanged text runs stay in one batch. Uploads that overlap a remembered
+ * region, a redefinition of the texture and its deletion forget what was
+ * there; when the records run out the oldest one is replaced.
+ */
+
+#ifndef SOLOADER_GL_UPLOAD_H
+#define SOLOADER_GL_UPLOAD_H
+
+#include <vitaGL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int uploads;        // Uploads the game made
+    int dropped;        // ...of which repeated pixels the texture already held
+} gl_upload_stats_t;
+
+int gl_upload_init(void);
+void gl_upload_shutdown(void);
+
+// Notifications from the state filter, made on every call
+void gl_upload_active_unit(GLenum texture);
+void gl_upload_bind(GLenum target, GLuint texture);
+void gl_upload_pixel_store(GLenum pname, GLint param);
+
+// Port code replaced `texture`'s contents, or it was deleted
+void gl_upload_forget(GLuint texture);
+
+// 1 if the upload repeats what the bound texture already holds and can be dropped
+int gl_upload_tex_image(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                        GLsizei height, GLenum format, GLenum type, const void *data);
+int gl_upload_tex_sub_image(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                            GLsizei height, GLenum format, GLenum type, const void *pixels);
+
+// Roll the per-frame counters over; call once per frame
+void gl_upload_end_frame(void);
+
+// Counters of the last complete frame
+void gl_upload_get_stats(gl_upload_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_GL_UPLOAD_H
@@ -21,6 +21,9 @@
 #include <libc_bridge/libc_bridge.h>
 #endif
 
+#include "io_trace.h"
+#include "path_map.h"
+#include "save_writer.h"
 #include "utils/logger.h"
 #include "utils/utils.h"
 
@@ -30,11 +33,22 @@
 // void stat_newlib_to_bionic(struct stat * src, stat64_bionic * dst);
 #include "reimpl/bits/_struct_converters.c"
 
+// Android paths are mapped (path_map.c) before they reach the Vita's I/O;
+// scratch buffers are only written when the interned table is full
+
 FILE * fopen_soloader(const char * filename, const char * mode) {
-    if (strcmp(filename, "/proc/cpuinfo") == 0) {
-        return fopen_soloader("app0:/cpuinfo", mode);
-    } else if (strcmp(filename, "/proc/meminfo") == 0) {
-        return fopen_soloader("app0:/meminfo", mode);
+    char scratch[512];
+    filename = path_map_resolve(filename, scratch, sizeof(scratch));
+    if (!filename) {
+        return NULL;
+    }
+
+    // Saves are written behind the game's back (save_writer.c)
+    if (save_writer_owns(filename)) {
+        FILE* ret = save_writer_fopen(filename, mode);
+        io_trace_record_path(ret ? IO_OP_FOPEN : IO_OP_FAIL, filename, 0, 0);
+        l_debug("fopen(%s, %s): %p (save image)", filename, mode, ret);
+        return ret;
     }
 
 #ifdef USE_SCELIBC_IO
@@ -43,6 +57,8 @@ FILE * fopen_soloader(const char * filename, const char * mode) {
     FILE* ret = fopen(filename, mode);
 #endif
 
+    io_trace_record_path(ret ? IO_OP_FOPEN : IO_OP_FAIL, filename, 0, 0);
+
     if (ret)
         l_debug("fopen(%s, %s): %p", filename, mode, ret);
     else
@@ -52,10 +68,10 @@ FILE * fopen_soloader(const char * filename, const char * mode) {
 }
 
 int open_soloader(const char * path, int oflag, ...) {
-    if (strcmp(path, "/proc/cpuinfo") == 0) {
-        return open_soloader("app0:/cpuinfo", oflag);
-    } else if (strcmp(path, "/proc/meminfo") == 0) {
-        return open_soloader("app0:/meminfo", oflag);
+    char scratch[512];
+    path = path_map_resolve(path, scratch, sizeof(scratch));
+    if (!path) {
+        return -1;
     }
 
     mode_t mode = 0666;
@@ -69,6 +85,7 @@ int open_soloader(const char * path, int oflag, ...) {
 
     oflag = oflags_bionic_to_newlib(oflag);
     int ret = open(path, oflag, mode);
+    io_trace_record_path(ret >= 0 ? IO_OP_OPEN : IO_OP_FAIL, path, 0, (uint32_t)oflag);
     if (ret >= 0)
         l_debug("open(%s, %x): %i", path, oflag, ret);
     else
@@ -88,6 +105,12 @@ int fstat_soloader(int fd, stat64_bionic * buf) {
 }
 
 int stat_soloader(const char * path, stat64_bionic * buf) {
+    char scratch[512];
+    path = path_map_resolve(path, scratch, sizeof(scratch));
+    if (!path) {
+        return -1;
+    }
+
     struct stat st;
     int res = stat(path, &st);
 
@@ -116,8 +139,14 @@ int close_soloader(int fd) {
 }
 
 DIR* opendir_soloader(char* _pathname) {
-    DIR* ret = opendir(_pathname);
-    l_debug("opendir(\"%s\"): %p", _pathname, ret);
+    char scratch[512];
+    const char * path = path_map_resolve(_pathname, scratch, sizeof(scratch));
+    if (!path) {
+        return NULL;
+    }
+
+    DIR* ret = opendir(path);
+    l_debug("opendir(\"%s\"): %p", path, ret);
     return ret;
 }
 
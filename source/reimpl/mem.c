@@ -12,24 +12,184 @@
 
 #include <string.h>
 #include <malloc.h>
+#include <stdint.h>
+#include <unistd.h>
 #include <psp2/kernel/clib.h>
+#include <psp2/kernel/sysmem.h>
+#include <psp2/kernel/threadmgr.h>
+
+#define MMAP_PAGE_SIZE 4096
+#define MMAP_MAX_MAPPINGS 64
+#define MMAP_READ_CHUNK (256 * 1024)
+
+/*
+ * Every mapping owns one memory block. The Vita can't release part of a
+ * block, so munmap() only clears the pages it covers in the mapping's page
+ * bitmap and the block goes back to the kernel with its last page.
+ */
+typedef struct {
+    uint8_t *base;
+    size_t length;              // Page-rounded
+    SceUID block;
+    uint32_t *pages;            // Bit set = still mapped
+    size_t mapped_pages;
+} mmap_region_t;
+
+static mmap_region_t regions[MMAP_MAX_MAPPINGS];
+static SceKernelLwMutexWork regions_lock;
+static int regions_ready = 0;
+
+static mmap_region_t *find_region(const uint8_t *addr) {
+    for (int i = 0; i < MMAP_MAX_MAPPINGS; i++) {
+        mmap_region_t *r = &regions[i];
+        if (r->base && addr >= r->base && addr < r->base + r->length) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+// Read length bytes at offs straight into the mapping, zeroing past EOF
+static int fill_from_file(uint8_t *dst, size_t length, int fd, off_t offs) {
+    if (lseek(fd, offs, SEEK_SET) < 0) {
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < length) {
+        size_t chunk = length - done < MMAP_READ_CHUNK ? length - done : MMAP_READ_CHUNK;
+        ssize_t got = read(fd, dst + done, chunk);
+        if (got < 0) {
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        done += (size_t)got;
+    }
+
+    if (done < length) {
+        sceClibMemset(dst + done, 0, length - done);
+    }
+    return 0;
+}
 
 void *sceClibMemclr(void *dst, size_t len) {
     return sceClibMemset(dst, 0, len);
 }
 
 void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offs) {
-    l_warn("mmap(%p, %i, %i, %i, %i, %li)", addr, length, prot, flags, fd, offs);
+    l_debug("mmap(%p, %i, %i, %i, %i, %li)", addr, length, prot, flags, fd, offs);
+
+    if (length == 0 || (offs & (MMAP_PAGE_SIZE - 1)) != 0) {
+        return MAP_FAILED;
+    }
+    if (flags & MAP_FIXED) {
+        l_warn("mmap: MAP_FIXED at %p is not supported", addr);
+        return MAP_FAILED;
+    }
+    if ((flags & MAP_SHARED) && (prot & PROT_WRITE) && !(flags & MAP_ANONYMOUS)) {
+        l_warn("mmap: writes to shared fd %i will not reach the file", fd);
+    }
+
+    if (!regions_ready) {
+        // The first call comes from the game's static constructors, before any threads
+        sceKernelCreateLwMutex(&regions_lock, "mmap_regions", 0, 0, NULL);
+        regions_ready = 1;
+    }
 
-    if (length <= 0) {
+    size_t size = (length + MMAP_PAGE_SIZE - 1) & ~(size_t)(MMAP_PAGE_SIZE - 1);
+    size_t page_count = size / MMAP_PAGE_SIZE;
+
+    SceUID block = sceKernelAllocMemBlock("mmap", SCE_KERNEL_MEMBLOCK_TYPE_USER_RW, size, NULL);
+    if (block < 0) {
+        l_warn("mmap: no memory block for %i bytes: 0x%08X", size, block);
+        return MAP_FAILED;
+    }
+
+    void *base = NULL;
+    uint32_t *pages = malloc(((page_count + 31) / 32) * sizeof(uint32_t));
+    if (!pages || sceKernelGetMemBlockBase(block, &base) < 0) {
+        free(pages);
+        sceKernelFreeMemBlock(block);
+        return MAP_FAILED;
+    }
+    memset(pages, 0xFF, ((page_count + 31) / 32) * sizeof(uint32_t));
+
+    if (flags & MAP_ANONYMOUS) {
+        sceClibMemset(base, 0, size);
+    } else if (fill_from_file(base, size, fd, offs) < 0) {
+        l_warn("mmap: failed to read %i bytes from fd %i", length, fd);
+        free(pages);
+        sceKernelFreeMemBlock(block);
+        return MAP_FAILED;
+    }
+
+    sceKernelLockLwMutex(&regions_lock, 1, NULL);
+    mmap_region_t *slot = NULL;
+    for (int i = 0; i < MMAP_MAX_MAPPINGS && !slot; i++) {
+        if (!regions[i].base) {
+            slot = &regions[i];
+        }
+    }
+    if (slot) {
+        slot->base = base;
+        slot->length = size;
+        slot->block = block;
+        slot->pages = pages;
+        slot->mapped_pages = page_count;
+    }
+    sceKernelUnlockLwMutex(&regions_lock, 1);
+
+    if (!slot) {
+        l_warn("mmap: more than %i live mappings", MMAP_MAX_MAPPINGS);
+        free(pages);
+        sceKernelFreeMemBlock(block);
         return MAP_FAILED;
     }
-    void* ret= malloc(length);
-    memset(ret, 0, length);
-    return ret;
+
+    return base;
 }
 
 int munmap(void *addr, size_t length) {
-    if (addr) free(addr);
+    uint8_t *start = (uint8_t *)addr;
+    if (!start || ((uintptr_t)start & (MMAP_PAGE_SIZE - 1)) != 0 || length == 0 || !regions_ready) {
+        return -1;
+    }
+
+    sceKernelLockLwMutex(&regions_lock, 1, NULL);
+    mmap_region_t *r = find_region(start);
+    if (!r) {
+        sceKernelUnlockLwMutex(&regions_lock, 1);
+        return -1;
+    }
+
+    // Like POSIX, pages past the end of the mapping are ignored
+    size_t first = (size_t)(start - r->base) / MMAP_PAGE_SIZE;
+    size_t last = (size_t)(start - r->base + length + MMAP_PAGE_SIZE - 1) / MMAP_PAGE_SIZE;
+    if (last > r->length / MMAP_PAGE_SIZE) {
+        last = r->length / MMAP_PAGE_SIZE;
+    }
+    for (size_t page = first; page < last; page++) {
+        uint32_t bit = 1u << (page & 31);
+        if (r->pages[page / 32] & bit) {
+            r->pages[page / 32] &= ~bit;
+            r->mapped_pages--;
+        }
+    }
+
+    SceUID block = -1;
+    uint32_t *pages = NULL;
+    if (r->mapped_pages == 0) {
+        block = r->block;
+        pages = r->pages;
+        memset(r, 0, sizeof(mmap_region_t));
+    }
+    sceKernelUnlockLwMutex(&regions_lock, 1);
+
+    if (pages) {
+        free(pages);
+        sceKernelFreeMemBlock(block);
+    }
     return 0;
 }
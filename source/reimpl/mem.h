@@ -23,10 +23,29 @@ extern "C" {
 
 #define MAP_FAILED (void*)-1
 
+// Bionic values, as the game passes them
+#define PROT_NONE     0x0
+#define PROT_READ     0x1
+#define PROT_WRITE    0x2
+#define PROT_EXEC     0x4
+#define MAP_SHARED    0x01
+#define MAP_PRIVATE   0x02
+#define MAP_FIXED     0x10
+#define MAP_ANONYMOUS 0x20
+
 void *sceClibMemclr(void *dst, size_t len);
 
+/**
+ * Anonymous maps are zeroed memory blocks; file maps are read from fd at
+ * offs in one pass, since user code can't take page faults to fill lazily.
+ * MAP_FIXED is refused and shared writable maps are never written back.
+ */
 void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offs);
 
+/**
+ * Page-granular: unmapped pages are tracked and a mapping's memory is freed
+ * once none of its pages remain mapped.
+ */
 int munmap(void *addr, size_t length);
 
 #ifdef __cplusplus
@@ -0,0 +1,333 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Size-Class Pool Allocator
+ *
+ * The arena is cut into 64 KB slabs, each owned by one size class for the
+ * rest of the session, so small-object churn can never fragment the newlib
+ * heap. Every class keeps a global free list behind its own lock; on top of
+ * that each thread gets a cache of up to POOL_CACHE_LIMIT blocks per class,
+ * which it alone touches, so the common malloc/free pair takes no lock.
+ * Caches are found by thread id in a small table and refill from, or spill
+ * half into, the global list in batches.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "reimpl/mem_pool.h"
+#include "mem_governor.h"
+#include "utils/logger.h"
+
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_CACHE_SLOTS 32             // Power of two
+#define POOL_CACHE_LIMIT 64             // Blocks per class per thread
+#define POOL_REFILL 16                  // Blocks moved per refill
+
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    pool_block_t *free;
+    uint8_t *carve;                     // Unused tail of the newest slab
+    uint8_t *carve_end;
+    SceKernelLwMutexWork lock;
+    int slabs;
+    volatile int in_use;
+    int peak_in_use;
+} pool_class_t;
+
+typedef struct {
+    volatile SceUID owner;              // 0 = unclaimed
+    pool_block_t *free[MEM_POOL_CLASSES];
+    int count[MEM_POOL_CLASSES];
+} pool_cache_t;
+
+static const uint16_t class_sizes[MEM_POOL_CLASSES] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+static uint8_t size_classes[MEM_POOL_MAX_SIZE / 16 + 1];   // (size + 15) / 16 -> class
+static uint8_t slab_classes[MEM_POOL_ARENA_SIZE / POOL_SLAB_SIZE];
+static pool_class_t classes[MEM_POOL_CLASSES];
+static pool_cache_t caches[POOL_CACHE_SLOTS];
+static uint8_t *arena = NULL;
+static uint8_t *arena_end = NULL;
+static uint8_t *arena_next = NULL;
+static SceKernelLwMutexWork arena_lock;
+static volatile int fallbacks = 0;
+static int pool_ready = 0;
+
+// Function prototypes
+static pool_cache_t *thread_cache(void);
+static int refill(int index, pool_block_t **list, int max);
+static void spill(int index, pool_block_t *head, pool_block_t *tail);
+static int grab_slab(pool_class_t *cls);
+
+int mem_pool_init(void) {
+    if (pool_ready) {
+        return 0;
+    }
+
+    arena = malloc(MEM_POOL_ARENA_SIZE);
+    if (!arena) {
+        l_warn("Pool allocator disabled: no %d MB arena", MEM_POOL_ARENA_SIZE / (1024 * 1024));
+        return -1;
+    }
+    arena_end = arena + MEM_POOL_ARENA_SIZE;
+    arena_next = arena;
+    sceKernelCreateLwMutex(&arena_lock, "pool_arena", 0, 0, NULL);
+
+    int index = 0;
+    for (int i = 0; i <= MEM_POOL_MAX_SIZE / 16; i++) {
+        while (class_sizes[index] < i * 16) index++;
+        size_classes[i] = (uint8_t)index;
+    }
+
+    for (int i = 0; i < MEM_POOL_CLASSES; i++) {
+        memset(&classes[i], 0, sizeof(pool_class_t));
+        sceKernelCreateLwMutex(&classes[i].lock, "pool_class", 0, 0, NULL);
+    }
+    memset(caches, 0, sizeof(caches));
+
+    pool_ready = 1;
+    l_success("Pool allocator: %d classes up to %d bytes, %d MB arena",
+              MEM_POOL_CLASSES, MEM_POOL_MAX_SIZE, MEM_POOL_ARENA_SIZE / (1024 * 1024));
+    return 0;
+}
+
+void *malloc_pooled(size_t size) {
+    if (!pool_ready || size > MEM_POOL_MAX_SIZE) {
+        return mem_governor_malloc(size);
+    }
+
+    int index = size_classes[(size + 15) / 16];
+    pool_class_t *cls = &classes[index];
+    pool_block_t *block;
+
+    pool_cache_t *cache = thread_cache();
+    if (cache) {
+        if (!cache->free[index]) {
+            cache->count[index] = refill(index, &cache->free[index], POOL_REFILL);
+        }
+        block = cache->free[index];
+        if (block) {
+            cache->free[index] = block->next;
+            cache->count[index]--;
+        }
+    } else {
+        block = NULL;
+        refill(index, &block, 1);
+    }
+
+    if (!block) {
+        __atomic_add_fetch(&fallbacks, 1, __ATOMIC_RELAXED);
+        return mem_governor_malloc(size);
+    }
+
+    int in_use = __atomic_add_fetch(&cls->in_use, 1, __ATOMIC_RELAXED);
+    if (in_use > cls->peak_in_use) {
+        cls->peak_in_use = in_use;
+    }
+    return block;
+}
+
+void free_pooled(void *ptr) {
+    uint8_t *p = (uint8_t *)ptr;
+    if (!p || p < arena || p >= arena_end) {
+        free(ptr);
+        return;
+    }
+
+    int index = slab_classes[(p - arena) / POOL_SLAB_SIZE];
+    pool_block_t *block = (pool_block_t *)p;
+    __atomic_sub_fetch(&classes[index].in_use, 1, __ATOMIC_RELAXED);
+
+    pool_cache_t *cache = thread_cache();
+    if (!cache) {
+        block->next = NULL;
+        spill(index, block, block);
+        return;
+    }
+
+    block->next = cache->free[index];
+    cache->free[index] = block;
+    if (++cache->count[index] > POOL_CACHE_LIMIT) {
+        // Hand the older half back so other threads can reuse it
+        int keep = POOL_CACHE_LIMIT / 2;
+        pool_block_t *last = cache->free[index];
+        for (int i = 1; i < keep; i++) {
+            last = last->next;
+        }
+        pool_block_t *head = last->next;
+        pool_block_t *tail = head;
+        while (tail->next) {
+            tail = tail->next;
+        }
+        last->next = NULL;
+        cache->count[index] = keep;
+        spill(index, head, tail);
+    }
+}
+
+void *calloc_pooled(size_t num, size_t size) {
+    if (size && num > SIZE_MAX / size) {
+        return NULL;
+    }
+
+    size_t total = num * size;
+    if (!pool_ready || total > MEM_POOL_MAX_SIZE) {
+        void *ptr = calloc(num, size);
+        if (!ptr && total > 0 && mem_governor_reclaim(MEM_KIND_HEAP, total)) {
+            ptr = calloc(num, size);
+        }
+        return ptr;
+    }
+
+    void *ptr = malloc_pooled(total);
+    if (ptr) {
+        memset(ptr, 0, total);
+    }
+    return ptr;
+}
+
+void *realloc_pooled(void *ptr, size_t size) {
+    uint8_t *p = (uint8_t *)ptr;
+    if (!p) {
+        return malloc_pooled(size);
+    }
+    if (p < arena || p >= arena_end) {
+        // newlib blocks stay with newlib
+        void *grown = realloc(ptr, size);
+        if (!grown && size > 0 && mem_governor_reclaim(MEM_KIND_HEAP, size)) {
+            grown = realloc(ptr, size);
+        }
+        return grown;
+    }
+    if (size == 0) {
+        free_pooled(ptr);
+        return NULL;
+    }
+
+    size_t old_size = class_sizes[slab_classes[(p - arena) / POOL_SLAB_SIZE]];
+    if (size <= old_size && size > old_size / 2) {
+        return ptr;
+    }
+
+    void *new_ptr = malloc_pooled(size);
+    if (!new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, size < old_size ? size : old_size);
+    free_pooled(ptr);
+    return new_ptr;
+}
+
+int mem_pool_get_class_stats(int index, mem_pool_class_stats_t *stats) {
+    if (index < 0 || index >= MEM_POOL_CLASSES || !stats) {
+        return -1;
+    }
+
+    stats->block_size = class_sizes[index];
+    stats->slabs = classes[index].slabs;
+    stats->in_use = classes[index].in_use;
+    stats->peak_in_use = classes[index].peak_in_use;
+    return 0;
+}
+
+void mem_pool_get_usage(size_t *used, size_t *capacity) {
+    if (used) *used = pool_ready ? (size_t)(arena_next - arena) : 0;
+    if (capacity) *capacity = pool_ready ? MEM_POOL_ARENA_SIZE : 0;
+}
+
+int mem_pool_fallbacks(void) {
+    return fallbacks;
+}
+
+// ===== INTERNALS =====
+
+// The calling thread's cache, claimed on first use; NULL once all are taken
+static pool_cache_t *thread_cache(void) {
+    SceUID self = sceKernelGetThreadId();
+    uint32_t hash = (uint32_t)self * 2654435761u;
+
+    for (int probe = 0; probe < POOL_CACHE_SLOTS; probe++) {
+        pool_cache_t *cache = &caches[(hash + probe) & (POOL_CACHE_SLOTS - 1)];
+        SceUID owner = cache->owner;
+        if (owner == self) {
+            return cache;
+        }
+        if (owner == 0) {
+            SceUID expected = 0;
+            if (__atomic_compare_exchange_n(&cache->owner, &expected, self, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return cache;
+            }
+            if (expected == self) {
+                return cache;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Move up to max blocks onto *list, carving new slab space when the free
+// list runs dry; returns how many were moved
+static int refill(int index, pool_block_t **list, int max) {
+    pool_class_t *cls = &classes[index];
+    size_t block_size = class_sizes[index];
+    int moved = 0;
+
+    sceKernelLockLwMutex(&cls->lock, 1, NULL);
+    while (moved < max) {
+        pool_block_t *block = cls->free;
+        if (block) {
+            cls->free = block->next;
+        } else {
+            if (cls->carve + block_size > cls->carve_end && grab_slab(cls) < 0) {
+                break;
+            }
+            block = (pool_block_t *)cls->carve;
+            cls->carve += block_size;
+        }
+        block->next = *list;
+        *list = block;
+        moved++;
+    }
+    sceKernelUnlockLwMutex(&cls->lock, 1);
+
+    return moved;
+}
+
+static void spill(int index, pool_block_t *head, pool_block_t *tail) {
+    pool_class_t *cls = &classes[index];
+
+    sceKernelLockLwMutex(&cls->lock, 1, NULL);
+    tail->next = cls->free;
+    cls->free = head;
+    sceKernelUnlockLwMutex(&cls->lock, 1);
+}
+
+// Called with the class lock held
+static int grab_slab(pool_class_t *cls) {
+    sceKernelLockLwMutex(&arena_lock, 1, NULL);
+    uint8_t *slab = NULL;
+    if (arena_next + POOL_SLAB_SIZE <= arena_end) {
+        slab = arena_next;
+        arena_next += POOL_SLAB_SIZE;
+    }
+    sceKernelUnlockLwMutex(&arena_lock, 1);
+
+    if (!slab) {
+        return -1;
+    }
+
+    slab_classes[(slab - arena) / POOL_SLAB_SIZE] = (uint8_t)(cls - classes);
+    cls->carve = slab;
+    cls->carve_end = slab + POOL_SLAB_SIZE;
+    cls->slabs++;
+    return 0;
+}
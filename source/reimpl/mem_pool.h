@@ -0,0 +1,51 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Size-Class Pool Allocator
+ *
+ * Replaces the game's malloc/free/calloc/realloc imports when MEM_POOL is
+ * set. Requests up to MEM_POOL_MAX_SIZE bytes are served from fixed-size
+ * blocks carved out of one arena; anything larger, and anything the arena
+ * can't hold, goes to newlib. free_pooled() tells the two apart by address,
+ * so blocks from either side may be freed through it.
+ */
+
+#ifndef SOLOADER_MEM_POOL_H
+#define SOLOADER_MEM_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEM_POOL_CLASSES 12
+#define MEM_POOL_MAX_SIZE 1024
+
+typedef struct {
+    size_t block_size;
+    int slabs;              // Arena slabs assigned to the class
+    int in_use;             // Blocks handed out and not yet freed
+    int peak_in_use;
+} mem_pool_class_stats_t;
+
+int mem_pool_init(void);
+
+void *malloc_pooled(size_t size);
+void free_pooled(void *ptr);
+void *calloc_pooled(size_t num, size_t size);
+void *realloc_pooled(void *ptr, size_t size);
+
+// 0 and a filled *stats for class 0 .. MEM_POOL_CLASSES-1, -1 otherwise
+int mem_pool_get_class_stats(int index, mem_pool_class_stats_t *stats);
+
+// Arena bytes assigned to slabs and total arena size
+void mem_pool_get_usage(size_t *used, size_t *capacity);
+
+// Requests that fell back to newlib because the arena was full
+int mem_pool_fallbacks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOLOADER_MEM_POOL_H
@@ -10,17 +10,18 @@
 
 #include "reimpl/pthr.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include <psp2/kernel/clib.h>
 #include <psp2/kernel/threadmgr.h>
 #include <stdatomic.h>
 
+#include "config.h"
 #include "utils/utils.h"
 #include "utils/logger.h"
 
-#define PTHR_MAX_OBJECTS 1024
-
 #define BIONIC_PTHREAD_COND_INITIALIZER              0
 #define BIONIC_PTHREAD_MUTEX_INITIALIZER             0
 #define BIONIC_PTHREAD_RECURSIVE_MUTEX_INITIALIZER   0x4000
@@ -37,64 +38,82 @@ enum {
     BIONIC_PTHREAD_MUTEX_DEFAULT = BIONIC_PTHREAD_MUTEX_NORMAL
 };
 
+#ifndef SCE_KERNEL_LW_MUTEX_ATTR_RECURSIVE
+#define SCE_KERNEL_LW_MUTEX_ATTR_RECURSIVE 0x0200
+#endif
+
 #define PTHR_INLINE static inline __attribute__((always_inline))
 
-void * initializedObjects[PTHR_MAX_OBJECTS] = {0};
-static SceKernelLwMutexWork pthr_mutex;
-static volatile short int pthr_mutex_inited = 0;
-
-#define PTHR_LOCK \
-    if (!pthr_mutex_inited) { \
-        int ret = sceKernelCreateLwMutex(&pthr_mutex, "log_lock", 0, 0, NULL); \
-        if (ret < 0) { \
-            sceClibPrintf("Error: failed to create pthr mutex: 0x%x\n", ret); \
-            return 0; \
-        } \
-        pthr_mutex_inited = 1; \
-    } \
-    sceKernelLockLwMutex(&pthr_mutex, 1, NULL);
-
-#define PTHR_UNLOCK \
-    if (pthr_mutex_inited) { \
-        sceKernelUnlockLwMutex(&pthr_mutex, 1); \
-    }
+/*
+ * Thread policy. Android threads are named after they start, usually with
+ * pthread_setname_np() from the creator, so names can't steer creation.
+ * Every game thread gets a slot when it's created and starts through a
+ * trampoline that records its SceUID there and moves it off the render
+ * core; a later setname looks the slot up and applies the matching entry.
+ * The slot is freed when the thread returns or calls pthread_exit(), so
+ * only live game threads hold one. Stack size is only
+ * known at creation, so for game threads it follows the requested attr and
+ * table stack sizes apply to threads the port creates itself.
+ */
+#define PTHR_CORES_WORKERS (SCE_KERNEL_CPU_MASK_USER_1 | SCE_KERNEL_CPU_MASK_USER_2)
+#define PTHR_MIN_STACK_SIZE (16 * 1024)
+#define PTHR_MAX_THREADS 64
+
+static const pthr_thread_policy_t thread_policies[] = {
+    // name              priority  affinity                     stack
+    { "main",            0,        SCE_KERNEL_CPU_MASK_USER_0,  0 },    // Render thread
+    { "audio_thread",    72,       SCE_KERNEL_CPU_MASK_USER_1,  64 * 1024 },
+    { "audio_mixer",     64,       SCE_KERNEL_CPU_MASK_USER_1,  16 * 1024 },  // AUDIO_MIXER output
+};
 
-int isObjectInitialized(const void * mut) {
-    PTHR_LOCK
-    for (int i = 0; i < PTHR_MAX_OBJECTS; ++i) {
-        if (initializedObjects[i] == mut) {
-            PTHR_UNLOCK
-            return 1;
-        }
-    }
-    PTHR_UNLOCK
-    return 0;
-}
+// Anything else the game starts
+static const pthr_thread_policy_t default_policy = {
+    NULL, 0, PTHR_CORES_WORKERS, THREAD_DEFAULT_STACK_SIZE
+};
 
-int rememberObject(void * mut) {
-    PTHR_LOCK
-    for (int i = 0; i < PTHR_MAX_OBJECTS; ++i) {
-        if (initializedObjects[i] == 0) {
-            initializedObjects[i] = mut;
-            PTHR_UNLOCK
-            return 1;
-        }
-    }
-    PTHR_UNLOCK
-    return 0;
-}
+typedef struct {
+    pthread_t thread;                   // 0 until pthread_create has returned or the thread started
+    SceUID uid;                         // 0 until the thread has started
+    char name[16];                      // Set by pthread_setname_np before the start
+    uint32_t seq;                       // Tells a reused slot from the one a creator reserved
+    int in_use;
+} pthr_thread_t;
+
+typedef struct {
+    void *(*start)(void *);
+    void *param;
+    pthr_thread_t *slot;                // NULL if the table was full
+} pthr_start_t;
+
+static pthr_thread_t threads[PTHR_MAX_THREADS];
+static uint32_t thread_seq = 0;
+static SceKernelLwMutexWork threads_lock;
+static volatile int threads_lock_ready = 0;
 
-int forgetObject(const void * mut) {
-    PTHR_LOCK
-    for (int i = 0; i < PTHR_MAX_OBJECTS; ++i) {
-        if (initializedObjects[i] == mut) {
-            initializedObjects[i] = 0;
-            PTHR_UNLOCK
-            return 1;
-        }
-    }
-    PTHR_UNLOCK
-    return 0;
+/*
+ * Bionic mutexes and conds are a single word, too small for a magic stamp
+ * like the one attrs get. The word itself tells the two states apart: it
+ * holds one of the static initializer values until first use, and the
+ * pointer to the real object afterwards. Heap pointers can never equal an
+ * initializer, so the fast path is one load with no global lock; the first
+ * use publishes its object with a CAS and a losing racer frees its own copy.
+ *
+ * The real objects are SceKernelLwMutexWork and SceKernelLwCondWork rather
+ * than newlib's pthread types, whose mutexes sit on kernel objects: an
+ * uncontended LwMutex lock or unlock is an atomic in user memory and only
+ * enters the kernel to block. LwMutex already reports recursive locks and
+ * unlocks by a non-owner, which covers ERRORCHECK.
+ */
+struct pthr_cond {
+    SceKernelLwCondWork work;
+    SceKernelLwMutexWork *mutex;        // LwConds bind to one mutex; set on first wait
+    volatile int waiters;
+};
+
+PTHR_INLINE int _word_is_initializer(uintptr_t word) {
+    return word == BIONIC_PTHREAD_MUTEX_INITIALIZER ||
+           word == BIONIC_PTHREAD_RECURSIVE_MUTEX_INITIALIZER ||
+           word == BIONIC_PTHREAD_ERRORCHECK_MUTEX_INITIALIZER;
 }
 
 // null check for `attr` must be performed before this
@@ -102,6 +121,7 @@ PTHR_INLINE int _attr_t_static_init(pthread_attr_t_bionic * attr) {
     if (attr->magic != 0x42424242) {
         attr->magic = 0x42424242;
         attr->real_ptr = malloc(sizeof(pthread_attr_t));
+        attr->stack_size = 0; // Unset; pthread_create_soloader picks the default
         return pthread_attr_init(attr->real_ptr);
     }
     return 0;
@@ -109,82 +129,223 @@ PTHR_INLINE int _attr_t_static_init(pthread_attr_t_bionic * attr) {
 
 // null check for `mutex` param must be performed before this, `attr` is fine as null
 PTHR_INLINE int _mutex_t_static_init(pthread_mutex_t_bionic * mutex, const pthread_mutexattr_t * attr) {
-    int ret = 0, kind = PTHREAD_MUTEX_NORMAL;
+    int kind = PTHREAD_MUTEX_NORMAL;
 
-    if (isObjectInitialized(mutex)) {
-        //logv_debug("mutex already initialized: %p", mutex);
-        return ret;
+    uintptr_t word = __atomic_load_n((uintptr_t *) &mutex->real_ptr, __ATOMIC_ACQUIRE);
+    if (!_word_is_initializer(word)) {
+        return 0;
     }
 
     if (attr) {
         pthread_mutexattr_gettype((pthread_mutexattr_t *) attr, &kind);
-    } else {
-        if (* (int *) mutex == BIONIC_PTHREAD_MUTEX_INITIALIZER) kind = PTHREAD_MUTEX_NORMAL;
-        else if (* (int *) mutex == BIONIC_PTHREAD_RECURSIVE_MUTEX_INITIALIZER) kind = PTHREAD_MUTEX_RECURSIVE;
-        else if (* (int *) mutex == BIONIC_PTHREAD_ERRORCHECK_MUTEX_INITIALIZER) kind = PTHREAD_MUTEX_ERRORCHECK;
+    } else if (word == BIONIC_PTHREAD_RECURSIVE_MUTEX_INITIALIZER) {
+        kind = PTHREAD_MUTEX_RECURSIVE;
     }
 
-    pthread_mutex_t mut;
-    mutex->real_ptr = malloc(sizeof(pthread_mutex_t));
-    sceClibMemcpy(mutex->real_ptr, &mut, sizeof(pthread_mutex_t));
+    SceKernelLwMutexWork * work = memalign(8, sizeof(SceKernelLwMutexWork));
+    if (!work) {
+        l_error("mutex initialization for %p has failed", mutex);
+        return ENOMEM;
+    }
 
-    pthread_mutexattr_t mutattr;
-    pthread_mutexattr_init(&mutattr);
-    pthread_mutexattr_settype(&mutattr, kind);
-    ret = pthread_mutex_init(mutex->real_ptr, &mutattr);
-    pthread_mutexattr_destroy(&mutattr);
+    int lw_attr = kind == PTHREAD_MUTEX_RECURSIVE ? SCE_KERNEL_LW_MUTEX_ATTR_RECURSIVE : 0;
+    int ret = sceKernelCreateLwMutex(work, "pthr_mutex", lw_attr, 0, NULL);
+    if (ret < 0) {
+        l_error("mutex initialization for %p has failed: 0x%08X", mutex, ret);
+        free(work);
+        return EAGAIN;
+    }
 
-    if (ret == 0) {
-        rememberObject(mutex);
-    } else {
-        l_error("mutex initialization for %p has failed", mutex);
+    if (!__atomic_compare_exchange_n((uintptr_t *) &mutex->real_ptr, &word, (uintptr_t) work, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Another thread got there first; use its mutex
+        sceKernelDeleteLwMutex(work);
+        free(work);
     }
 
-    return ret;
+    return 0;
 }
 
-// null check for `cond` param must be performed before this, `attr` is fine as null
-PTHR_INLINE int _cond_t_static_init(pthread_cond_t_bionic * cond, const pthread_condattr_t * attr) {
-    int ret = 0;
+// null check for `cond` param must be performed before this
+PTHR_INLINE int _cond_t_static_init(pthread_cond_t_bionic * cond) {
+    uintptr_t word = __atomic_load_n((uintptr_t *) &cond->real_ptr, __ATOMIC_ACQUIRE);
+    if (word != BIONIC_PTHREAD_COND_INITIALIZER) {
+        return 0;
+    }
+
+    struct pthr_cond * c = memalign(8, sizeof(struct pthr_cond));
+    if (!c) {
+        l_error("cond initialization for %p has failed", cond);
+        return ENOMEM;
+    }
+    memset(c, 0, sizeof(struct pthr_cond));
 
-    if (isObjectInitialized(cond)) {
-        //logv_debug("cond already initialized: %p", cond);
-        return ret;
+    if (!__atomic_compare_exchange_n((uintptr_t *) &cond->real_ptr, &word, (uintptr_t) c, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(c);
     }
 
-    pthread_cond_t c;
-    cond->real_ptr = malloc(sizeof(pthread_cond_t));
-    sceClibMemcpy(cond->real_ptr, &c, sizeof(pthread_cond_t));
+    return 0;
+}
 
-    ret = pthread_cond_init(cond->real_ptr, attr);
+// Called with `mutex` held, so waiters on one cond are serialised here
+PTHR_INLINE int _cond_t_bind(struct pthr_cond * c, SceKernelLwMutexWork * mutex) {
+    if (c->mutex == mutex) {
+        return 0;
+    }
 
-    if (ret == 0) {
-        rememberObject(cond);
-    } else {
-        l_error("cond initialization for %p has failed", cond);
+    if (c->mutex) {
+        if (c->waiters > 0) {
+            l_error("cond %p waited on with a second mutex", c);
+            return EINVAL;
+        }
+        sceKernelDeleteLwCond(&c->work);
+        __atomic_store_n(&c->mutex, NULL, __ATOMIC_RELEASE);
+    }
+
+    int ret = sceKernelCreateLwCond(&c->work, "pthr_cond", 0, mutex, NULL);
+    if (ret < 0) {
+        l_error("cond creation for %p has failed: 0x%08X", c, ret);
+        return EAGAIN;
+    }
+    __atomic_store_n(&c->mutex, mutex, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// timeout_us is NULL to wait forever
+PTHR_INLINE int _cond_t_wait(pthread_cond_t_bionic * cond, pthread_mutex_t_bionic * mutex, SceUInt32 * timeout_us) {
+    int ret = _cond_t_static_init(cond);
+    if (ret == 0) ret = _mutex_t_static_init(mutex, NULL);
+    if (ret != 0) return ret;
+
+    struct pthr_cond * c = cond->real_ptr;
+    ret = _cond_t_bind(c, mutex->real_ptr);
+    if (ret != 0) return ret;
+
+    __atomic_add_fetch(&c->waiters, 1, __ATOMIC_RELAXED);
+    ret = sceKernelWaitLwCond(&c->work, timeout_us);
+    __atomic_sub_fetch(&c->waiters, 1, __ATOMIC_RELAXED);
+
+    if (ret < 0) {
+        return timeout_us ? ETIMEDOUT : EINVAL;
+    }
+    return 0;
+}
+
+static void _threads_lock(void) {
+    if (!__atomic_load_n(&threads_lock_ready, __ATOMIC_ACQUIRE)) {
+        // First created from the main thread, before the game starts any
+        sceKernelCreateLwMutex(&threads_lock, "pthr_threads", 0, 0, NULL);
+        __atomic_store_n(&threads_lock_ready, 1, __ATOMIC_RELEASE);
+    }
+    sceKernelLockLwMutex(&threads_lock, 1, NULL);
+}
+
+// Called with threads_lock held; only threads created through the shim have one
+static pthr_thread_t * _thread_slot(pthread_t thread) {
+    for (int i = 0; i < PTHR_MAX_THREADS; i++) {
+        if (threads[i].in_use && threads[i].thread && pthread_equal(threads[i].thread, thread)) {
+            return &threads[i];
+        }
+    }
+    return NULL;
+}
+
+// Called with threads_lock held
+static pthr_thread_t * _thread_reserve(void) {
+    for (int i = 0; i < PTHR_MAX_THREADS; i++) {
+        if (!threads[i].in_use) {
+            memset(&threads[i], 0, sizeof(pthr_thread_t));
+            threads[i].seq = ++thread_seq;
+            threads[i].in_use = 1;
+            return &threads[i];
+        }
+    }
+    return NULL;
+}
+
+// The calling thread's slot, when it ends by returning or by pthread_exit()
+static void _thread_release_self(void) {
+    _threads_lock();
+    pthr_thread_t * slot = _thread_slot(pthread_self());
+    if (slot) memset(slot, 0, sizeof(pthr_thread_t));
+    sceKernelUnlockLwMutex(&threads_lock, 1);
+}
+
+static void * _thread_trampoline(void * arg) {
+    pthr_start_t start = *(pthr_start_t *) arg;
+    free(arg);
+
+    SceUID self = sceKernelGetThreadId();
+    char name[16] = "";
+
+    // The slot is this thread's until it ends, so nothing else frees it first
+    if (start.slot) {
+        _threads_lock();
+        start.slot->thread = pthread_self();
+        start.slot->uid = self;
+        strncpy(name, start.slot->name, sizeof(name) - 1);
+        sceKernelUnlockLwMutex(&threads_lock, 1);
     }
 
+    pthr_apply_thread_policy(self, name[0] ? name : NULL);
+
+    void * ret = start.start(start.param);
+
+    _thread_release_self();
     return ret;
 }
 
 int pthread_create_soloader(pthread_t *thread, const pthread_attr_t_bionic *attr, void *(*start)(void *), void *param) {
     int ret;
 
+    pthr_start_t * trampoline = malloc(sizeof(pthr_start_t));
+    if (!trampoline) return EAGAIN;
+
+    // Reserved before the start so a setname right after create finds it
+    _threads_lock();
+    pthr_thread_t * slot = _thread_reserve();
+    uint32_t seq = slot ? slot->seq : 0;
+    sceKernelUnlockLwMutex(&threads_lock, 1);
+
+    trampoline->start = start;
+    trampoline->param = param;
+    trampoline->slot = slot;
+
     if (!attr) {
         pthread_attr_t a;
         pthread_attr_init(&a);
-        pthread_attr_setstacksize(&a, 512 * 1024);
-        ret = pthread_create(thread, &a, start, param);
+        pthread_attr_setstacksize(&a, default_policy.stack_size);
+        ret = pthread_create(thread, &a, _thread_trampoline, trampoline);
         pthread_attr_destroy(&a);
     } else{
         _attr_t_static_init((pthread_attr_t_bionic *) attr);
-        pthread_attr_setstacksize(attr->real_ptr, 512 * 1024);
-        ret = pthread_create(thread, attr->real_ptr, start, param);
+        size_t stack_size = attr->stack_size ? attr->stack_size : default_policy.stack_size;
+        if (stack_size < PTHR_MIN_STACK_SIZE) stack_size = PTHR_MIN_STACK_SIZE;
+        pthread_attr_setstacksize(attr->real_ptr, stack_size);
+        ret = pthread_create(thread, attr->real_ptr, _thread_trampoline, trampoline);
     }
 
+    if (slot) {
+        _threads_lock();
+        if (ret != 0) {
+            memset(slot, 0, sizeof(pthr_thread_t));
+        } else if (slot->in_use && slot->seq == seq) {
+            // Unless the thread already ran to the end and gave the slot up
+            slot->thread = *thread;
+        }
+        sceKernelUnlockLwMutex(&threads_lock, 1);
+    }
+
+    if (ret != 0) free(trampoline);
     return ret;
 }
 
+void pthread_exit_soloader(void *value_ptr) {
+    _thread_release_self();
+    pthread_exit(value_ptr);
+}
+
 int pthread_mutexattr_init_soloader(pthread_mutexattr_t *attr)
 {
     return pthread_mutexattr_init(attr);
@@ -208,38 +369,46 @@ int pthread_kill_soloader(pthread_t thread, int sig)
 int pthread_mutex_init_soloader(pthread_mutex_t_bionic *uid, const pthread_mutexattr_t *attr)
 {
     if (!uid) return EINVAL;
+    // Whatever the word held before, init starts a fresh mutex
+    uid->real_ptr = (SceKernelLwMutexWork *) BIONIC_PTHREAD_MUTEX_INITIALIZER;
     return _mutex_t_static_init(uid, attr);
 }
 
 int pthread_mutex_destroy_soloader(pthread_mutex_t_bionic *mutex)
 {
     if (!mutex) return 0;
-    forgetObject(mutex);
-    int ret = pthread_mutex_destroy(mutex->real_ptr);
-    if (mutex->real_ptr) free(mutex->real_ptr);
+    if (_word_is_initializer((uintptr_t) mutex->real_ptr)) {
+        mutex->real_ptr = 0x0;
+        return 0;
+    }
+    int ret = sceKernelDeleteLwMutex(mutex->real_ptr);
+    if (ret < 0) return EBUSY;
+    free(mutex->real_ptr);
     mutex->real_ptr = 0x0;
-    return ret;
+    return 0;
 }
 
 int pthread_mutex_lock_soloader(pthread_mutex_t_bionic *mutex)
 {
     if (!mutex) return EINVAL;
-    _mutex_t_static_init(mutex, NULL);
-    return pthread_mutex_lock(mutex->real_ptr);
+    int ret = _mutex_t_static_init(mutex, NULL);
+    if (ret != 0) return ret;
+    return sceKernelLockLwMutex(mutex->real_ptr, 1, NULL) < 0 ? EDEADLK : 0;
 }
 
 int pthread_mutex_trylock_soloader(pthread_mutex_t_bionic *mutex)
 {
     if (!mutex) return EINVAL;
-    _mutex_t_static_init(mutex, NULL);
-    return pthread_mutex_trylock(mutex->real_ptr);
+    int ret = _mutex_t_static_init(mutex, NULL);
+    if (ret != 0) return ret;
+    return sceKernelTryLockLwMutex(mutex->real_ptr, 1) < 0 ? EBUSY : 0;
 }
 
 int pthread_mutex_unlock_soloader(pthread_mutex_t_bionic *mutex)
 {
     if (!mutex) return EINVAL;
-    if (!mutex->real_ptr) return EINVAL;
-    return pthread_mutex_unlock(mutex->real_ptr);
+    if (_word_is_initializer((uintptr_t) mutex->real_ptr)) return EPERM;
+    return sceKernelUnlockLwMutex(mutex->real_ptr, 1) < 0 ? EPERM : 0;
 }
 
 int pthread_join_soloader(pthread_t thread, void **value_ptr)
@@ -264,36 +433,45 @@ int pthread_cond_init_soloader(pthread_cond_t_bionic *cond,
 {
     if (!cond) return EINVAL;
 
-    return _cond_t_static_init(cond, attr);
+    // Only the default, process-private clock-realtime cond exists here
+    cond->real_ptr = (struct pthr_cond *) BIONIC_PTHREAD_COND_INITIALIZER;
+    return _cond_t_static_init(cond);
 }
 
 int pthread_cond_destroy_soloader(pthread_cond_t_bionic *cond)
 {
     if (!cond) return 0;
-    forgetObject(cond);
-    int ret = pthread_cond_destroy(cond->real_ptr);
-    if (cond->real_ptr) free(cond->real_ptr);
+    if (!cond->real_ptr) return 0;
+    if (cond->real_ptr->waiters > 0) return EBUSY;
+    if (cond->real_ptr->mutex) sceKernelDeleteLwCond(&cond->real_ptr->work);
+    free(cond->real_ptr);
     cond->real_ptr = 0x0;
-    return ret;
+    return 0;
 }
 
 int pthread_cond_signal_soloader(pthread_cond_t_bionic *cond)
 {
     if (!cond) return EINVAL;
 
-    _cond_t_static_init(cond, NULL);
+    // No bound LwCond means nobody has ever waited, so nobody to wake
+    struct pthr_cond * c = cond->real_ptr;
+    if (!c || __atomic_load_n(&c->mutex, __ATOMIC_ACQUIRE) == NULL) return 0;
 
-    return pthread_cond_signal(cond->real_ptr);
+    sceKernelSignalLwCond(&c->work);
+    return 0;
 }
 
 int pthread_cond_timedwait_soloader(pthread_cond_t_bionic *cond, pthread_mutex_t_bionic *mutex, struct timespec *abstime)
 {
     if (!cond || !mutex) return EINVAL;
+    if (!abstime) return pthread_cond_wait_soloader(cond, mutex);
 
-    _cond_t_static_init(cond, NULL);
-    _mutex_t_static_init(mutex, NULL);
+    long long now = (long long) current_timestamp_ms() * 1000; // us
+    long long deadline = (long long) abstime->tv_sec * 1000 * 1000 + abstime->tv_nsec / 1000; // us
+    if (deadline <= now) return ETIMEDOUT;
 
-    return pthread_cond_timedwait(cond->real_ptr, mutex->real_ptr, abstime);
+    SceUInt32 timeout = (SceUInt32) (deadline - now);
+    return _cond_t_wait(cond, mutex, &timeout);
 }
 
 
@@ -301,19 +479,18 @@ int pthread_cond_wait_soloader(pthread_cond_t_bionic *cond, pthread_mutex_t_bion
 {
     if (!cond || !mutex) return EINVAL;
 
-    _cond_t_static_init(cond, NULL);
-    _mutex_t_static_init(mutex, NULL);
-
-    return pthread_cond_wait(cond->real_ptr, mutex->real_ptr);
+    return _cond_t_wait(cond, mutex, NULL);
 }
 
 int pthread_cond_broadcast_soloader(pthread_cond_t_bionic *cond)
 {
     if (!cond) return EINVAL;
 
-    _cond_t_static_init(cond, NULL);
+    struct pthr_cond * c = cond->real_ptr;
+    if (!c || __atomic_load_n(&c->mutex, __ATOMIC_ACQUIRE) == NULL) return 0;
 
-    return pthread_cond_broadcast(cond->real_ptr);
+    sceKernelSignalAllLwCond(&c->work);
+    return 0;
 }
 
 int pthread_attr_init_soloader(pthread_attr_t_bionic *attr)
@@ -345,6 +522,7 @@ int pthread_attr_setdetachstate_soloader(pthread_attr_t_bionic *attr, int state)
 int pthread_attr_setstacksize_soloader(pthread_attr_t_bionic *attr, size_t stacksize) {
     if (!attr) return -1;
     _attr_t_static_init(attr);
+    attr->stack_size = stacksize;
     return pthread_attr_setstacksize(attr->real_ptr, stacksize);
 }
 
@@ -400,11 +578,60 @@ int pthread_setname_np_soloader(pthread_t thread, const char* thread_name) {
         return ERANGE;
     }
 
-    sceClibPrintf("PTHREAD: pthread_setname_np with name %s for thread:0x%x\n", thread_name, pthread_self());
+    l_debug("pthread_setname_np(0x%x, %s)", thread, thread_name);
+
+    // Started threads get the policy now; others pick it up in the trampoline
+    SceUID uid = 0;
+    _threads_lock();
+    pthr_thread_t * slot = _thread_slot(thread);
+    if (slot) {
+        strncpy(slot->name, thread_name, sizeof(slot->name) - 1);
+        uid = slot->uid;
+    }
+    sceKernelUnlockLwMutex(&threads_lock, 1);
+
+    if (!slot && pthread_equal(thread, pthread_self())) {
+        uid = sceKernelGetThreadId();
+    }
+    if (uid > 0) {
+        pthr_apply_thread_policy(uid, thread_name);
+    }
 
     return 0;
 }
 
+const pthr_thread_policy_t * pthr_thread_policy(const char * name) {
+    if (name) {
+        for (size_t i = 0; i < sizeof(thread_policies) / sizeof(thread_policies[0]); i++) {
+            const pthr_thread_policy_t * policy = &thread_policies[i];
+            if (strncmp(name, policy->name, strlen(policy->name)) == 0) {
+                return policy;
+            }
+        }
+    }
+    return &default_policy;
+}
+
+int pthr_apply_thread_policy(SceUID thid, const char * name) {
+#if THREAD_POLICY
+    const pthr_thread_policy_t * policy = pthr_thread_policy(name);
+    int ret = 0;
+
+    if (policy->priority > 0 && sceKernelChangeThreadPriority(thid, policy->priority) < 0) {
+        ret = -1;
+    }
+    if (policy->affinity != 0 && sceKernelChangeThreadCpuAffinityMask(thid, policy->affinity) < 0) {
+        ret = -1;
+    }
+    if (ret < 0) {
+        l_warn("Could not apply thread policy to %s (0x%08X)", name ? name : "<unnamed>", thid);
+    }
+    return ret;
+#else
+    return 0;
+#endif
+}
+
 int sem_destroy_soloader(int * uid) {
     if (sceKernelDeleteSema(*uid) < 0)
         return -1;
@@ -23,6 +23,7 @@ extern "C" {
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <psp2/kernel/threadmgr.h>
 
 typedef struct {
     pthread_attr_t *real_ptr; // replaces `uint32_t flags;`
@@ -34,15 +35,33 @@ typedef struct {
 } pthread_attr_t_bionic;
 
 typedef struct {
-    pthread_mutex_t *real_ptr; // replaces `int volatile value;`
+    SceKernelLwMutexWork *real_ptr; // replaces `int volatile value;`
 } pthread_mutex_t_bionic;
 
 typedef struct {
-    pthread_cond_t *real_ptr; // replaces `int volatile value;`
+    struct pthr_cond *real_ptr; // replaces `int volatile value;`
 } pthread_cond_t_bionic;
 
+/**
+ * Scheduling policy for a named thread. Zero fields keep the kernel default;
+ * affinity is a SCE_KERNEL_CPU_MASK_USER_* mask.
+ */
+typedef struct {
+    const char *name;       // Prefix of the thread name this entry matches
+    int priority;
+    int affinity;
+    size_t stack_size;
+} pthr_thread_policy_t;
+
+// The first table entry whose name prefixes `name`, or the game default; never NULL
+const pthr_thread_policy_t *pthr_thread_policy(const char *name);
+
+// Applies the priority and affinity for `name` to a running thread
+int pthr_apply_thread_policy(SceUID thid, const char *name);
+
 // pthread_t is same size on bionic and newlib
 int pthread_create_soloader(pthread_t *thread, const pthread_attr_t_bionic *attr, void *(*start)(void *), void *param);
+void pthread_exit_soloader(void *value_ptr);
 int pthread_kill_soloader(pthread_t thread, int sig);
 int pthread_join_soloader(pthread_t thread, void **value_ptr);
 int pthread_detach_soloader(pthread_t thread);
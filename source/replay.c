@@ -0,0 +1,502 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Input Record/Replay
+ *
+ * A recording is a small header followed by fixed-size replay_event_t
+ * records. Events collect in memory and are appended every few seconds,
+ * with the header's counts rewritten after each append, so a session that
+ * crashes still leaves a playable file. A replay loads the whole file,
+ * hands each frame its events, and keeps one frame and one work time per
+ * frame; percentiles are taken once, when the report is written.
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vitaGL.h>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
+#include <psp2/rtc.h>
+
+#include "config.h"
+#include "asset_handler.h"
+#include "frame_pacer.h"
+#include "perf_profile.h"
+#include "replay.h"
+#include "utils/logger.h"
+
+#if REPLAY_MODE
+
+#define REPLAY_DIR DATA_PATH "replay"
+#define REPLAY_INPUT_PATH REPLAY_DIR "/input.rec"
+#define REPLAY_RESULTS_PATH REPLAY_DIR "/results.csv"
+#define REPLAY_MAGIC "FDRP"
+#define REPLAY_VERSION 1
+#define REPLAY_PENDING_EVENTS 4096
+#define REPLAY_FLUSH_FRAMES 600         // Append the recording every ~10 s
+#define REPLAY_MAX_FRAMES 216000        // Frame times kept: one hour at 60 Hz
+#define REPLAY_MAX_SPANS 256
+#define REPLAY_SPAN_GAP 2               // Quiet frames a load span may bridge
+#define REPLAY_MEM_INTERVAL 15          // Frames between memory samples
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t delta_ms;
+    uint32_t event_count;
+    uint32_t frame_count;
+} replay_header_t;
+
+// Consecutive frames that pulled assets in from storage
+typedef struct {
+    uint32_t start_frame;
+    uint32_t frames;
+    uint32_t misses;
+    uint64_t us;
+} replay_span_t;
+
+static int replay_mode = 0;             // 0 when off or init failed
+static uint32_t frame_index = 0;
+static replay_header_t header;
+
+// Recording
+static SceUID record_fd = -1;
+static replay_event_t *pending = NULL;
+static uint32_t pending_count = 0;
+static uint32_t pending_dropped = 0;
+
+// Playback
+static replay_event_t *events = NULL;
+static uint32_t next_event = 0;
+static uint32_t *frame_times = NULL;    // us
+static uint32_t *work_times = NULL;
+static uint32_t stat_capacity = 0;
+static uint32_t stat_count = 0;
+static uint32_t slow_frames = 0;
+static int finished = 0;
+
+static replay_span_t spans[REPLAY_MAX_SPANS];
+static int span_count = 0;
+static int span_open = 0;
+static replay_span_t span;
+static uint32_t span_last_frame = 0;
+static uint64_t span_pending_us = 0;    // Quiet frames after the last loading one
+static uint32_t last_misses = 0;
+
+static size_t heap_peak = 0;
+static size_t vram_min_free = (size_t)-1;
+static size_t ram_min_free = (size_t)-1;
+
+// Function prototypes
+static int open_recording(void);
+static int flush_recording(void);
+static int load_recording(void);
+static void queue_event(const replay_event_t *event);
+static void track_frame(uint64_t frame_us, uint64_t work_us);
+static void close_span(void);
+static int compare_u32(const void *a, const void *b);
+static float percentile_ms(const uint32_t *sorted, uint32_t count, int percent);
+static int write_report(void);
+
+#endif // REPLAY_MODE
+
+int replay_init(int mode) {
+#if REPLAY_MODE
+    int result = -1;
+    if (mode == 1) {
+        result = open_recording();
+    } else if (mode == 2) {
+        result = load_recording();
+    }
+    if (result < 0) {
+        l_warn("Replay: mode %d unavailable, running on live input", mode);
+        return -1;
+    }
+
+    replay_mode = mode;
+    frame_index = 0;
+    asset_get_cache_stats(NULL, &last_misses);
+    return 0;
+#else
+    (void)mode;
+    return -1;
+#endif
+}
+
+void replay_shutdown(void) {
+#if REPLAY_MODE
+    if (replay_mode == 1) {
+        flush_recording();
+        sceIoClose(record_fd);
+        record_fd = -1;
+        free(pending);
+        pending = NULL;
+        l_success("Replay: recorded %u events over %u frames", header.event_count, header.frame_count);
+        if (pending_dropped > 0) {
+            l_warn("Replay: %u events dropped, pending buffer full", pending_dropped);
+        }
+    } else if (replay_mode == 2) {
+        if (!finished && stat_count > 0) {
+            write_report();
+        }
+        free(events);
+        free(frame_times);
+        free(work_times);
+        events = NULL;
+        frame_times = work_times = NULL;
+    }
+    replay_mode = 0;
+#endif
+}
+
+int replay_is_recording(void) {
+#if REPLAY_MODE
+    return replay_mode == 1;
+#else
+    return 0;
+#endif
+}
+
+int replay_is_playing(void) {
+#if REPLAY_MODE
+    return replay_mode == 2;
+#else
+    return 0;
+#endif
+}
+
+int replay_is_active(void) {
+#if REPLAY_MODE
+    return replay_mode != 0;
+#else
+    return 0;
+#endif
+}
+
+void replay_record_touch(int action, float x, float y) {
+#if REPLAY_MODE
+    if (replay_mode != 1) {
+        return;
+    }
+    replay_event_t event = { frame_index, REPLAY_EVENT_TOUCH, (uint8_t)action, 0, x, y, 0 };
+    queue_event(&event);
+#else
+    (void)action;
+    (void)x;
+    (void)y;
+#endif
+}
+
+void replay_record_buttons(uint32_t buttons) {
+#if REPLAY_MODE
+    if (replay_mode != 1) {
+        return;
+    }
+    replay_event_t event = { frame_index, REPLAY_EVENT_BUTTONS, 0, 0, 0.0f, 0.0f, buttons };
+    queue_event(&event);
+#else
+    (void)buttons;
+#endif
+}
+
+int replay_poll(replay_event_t *event) {
+#if REPLAY_MODE
+    if (replay_mode != 2 || next_event >= header.event_count ||
+        events[next_event].frame > frame_index) {
+        return 0;
+    }
+    *event = events[next_event++];
+    return 1;
+#else
+    (void)event;
+    return 0;
+#endif
+}
+
+void replay_end_frame(uint64_t frame_us, uint64_t work_us) {
+#if REPLAY_MODE
+    if (replay_mode == 1) {
+        frame_index++;
+        if (frame_index % REPLAY_FLUSH_FRAMES == 0) {
+            flush_recording();
+        }
+    } else if (replay_mode == 2 && !finished) {
+        track_frame(frame_us, work_us);
+        frame_index++;
+        if (frame_index >= header.frame_count) {
+            write_report();
+            finished = 1;
+        }
+    }
+#else
+    (void)frame_us;
+    (void)work_us;
+#endif
+}
+
+int replay_done(void) {
+#if REPLAY_MODE
+    return replay_mode == 2 && finished;
+#else
+    return 0;
+#endif
+}
+
+#if REPLAY_MODE
+
+// ===== RECORDING =====
+
+static int open_recording(void) {
+    sceIoMkdir(REPLAY_DIR, 0777);
+    record_fd = sceIoOpen(REPLAY_INPUT_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+    if (record_fd < 0) {
+        l_error("Replay: could not create %s: 0x%08X", REPLAY_INPUT_PATH, record_fd);
+        return -1;
+    }
+
+    pending = malloc(REPLAY_PENDING_EVENTS * sizeof(replay_event_t));
+    if (!pending) {
+        l_error("Replay: out of memory for the event buffer");
+        sceIoClose(record_fd);
+        record_fd = -1;
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_VERSION;
+    header.delta_ms = REPLAY_DELTA_MS;
+    sceIoWrite(record_fd, &header, sizeof(header));
+
+    l_info("Replay: recording input to %s", REPLAY_INPUT_PATH);
+    return 0;
+}
+
+static void queue_event(const replay_event_t *event) {
+    if (pending_count >= REPLAY_PENDING_EVENTS) {
+        pending_dropped++;
+        return;
+    }
+    pending[pending_count++] = *event;
+    if (pending_count >= REPLAY_PENDING_EVENTS * 3 / 4) {
+        flush_recording();
+    }
+}
+
+static int flush_recording(void) {
+    int result = 0;
+
+    if (pending_count > 0) {
+        int size = (int)(pending_count * sizeof(replay_event_t));
+        sceIoLseek(record_fd, 0, SCE_SEEK_END);
+        if (sceIoWrite(record_fd, pending, size) != size) {
+            l_warn("Replay: short write to %s", REPLAY_INPUT_PATH);
+            result = -1;
+        } else {
+            header.event_count += pending_count;
+        }
+        pending_count = 0;
+    }
+
+    // Counts go in last so the header never claims events not on disk
+    header.frame_count = frame_index;
+    sceIoLseek(record_fd, 0, SCE_SEEK_SET);
+    sceIoWrite(record_fd, &header, sizeof(header));
+    return result;
+}
+
+// ===== PLAYBACK =====
+
+static int load_recording(void) {
+    SceUID fd = sceIoOpen(REPLAY_INPUT_PATH, SCE_O_RDONLY, 0);
+    if (fd < 0) {
+        l_error("Replay: no recording at %s", REPLAY_INPUT_PATH);
+        return -1;
+    }
+
+    if (sceIoRead(fd, &header, sizeof(header)) != (int)sizeof(header) ||
+        memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != REPLAY_VERSION || header.frame_count == 0) {
+        l_error("Replay: %s is not a usable recording", REPLAY_INPUT_PATH);
+        sceIoClose(fd);
+        return -1;
+    }
+
+    int size = (int)(header.event_count * sizeof(replay_event_t));
+    events = malloc(size > 0 ? size : 1);
+    if (!events || sceIoRead(fd, events, size) != size) {
+        l_error("Replay: could not read %u events from %s", header.event_count, REPLAY_INPUT_PATH);
+        sceIoClose(fd);
+        free(events);
+        events = NULL;
+        return -1;
+    }
+    sceIoClose(fd);
+
+    if (header.delta_ms != REPLAY_DELTA_MS) {
+        l_warn("Replay: recorded at %u ms steps, replaying at %d", header.delta_ms, REPLAY_DELTA_MS);
+    }
+
+    stat_capacity = MIN(header.frame_count, REPLAY_MAX_FRAMES);
+    frame_times = malloc(stat_capacity * sizeof(uint32_t));
+    work_times = malloc(stat_capacity * sizeof(uint32_t));
+    if (!frame_times || !work_times) {
+        l_error("Replay: out of memory for %u frame times", stat_capacity);
+        free(events);
+        free(frame_times);
+        free(work_times);
+        events = NULL;
+        frame_times = work_times = NULL;
+        return -1;
+    }
+
+    l_info("Replay: playing %u events over %u frames", header.event_count, header.frame_count);
+    return 0;
+}
+
+static void track_frame(uint64_t frame_us, uint64_t work_us) {
+    if (stat_count < stat_capacity) {
+        frame_times[stat_count] = (uint32_t)frame_us;
+        work_times[stat_count] = (uint32_t)work_us;
+        stat_count++;
+    }
+
+    // A frame more than a quarter over its vblank budget was visibly late
+    uint64_t budget_us = (uint64_t)frame_pacer_interval() * 1000000 / 60;
+    if (frame_us > budget_us + budget_us / 4) {
+        slow_frames++;
+    }
+
+    uint32_t misses;
+    asset_get_cache_stats(NULL, &misses);
+    uint32_t loaded = misses - last_misses;
+    last_misses = misses;
+
+    if (loaded > 0) {
+        if (!span_open) {
+            span_open = 1;
+            memset(&span, 0, sizeof(span));
+            span.start_frame = frame_index;
+        }
+        span.us += span_pending_us + frame_us;
+        span.misses += loaded;
+        span_pending_us = 0;
+        span_last_frame = frame_index;
+    } else if (span_open) {
+        span_pending_us += frame_us;
+        if (frame_index - span_last_frame > REPLAY_SPAN_GAP) {
+            close_span();
+        }
+    }
+
+    if (frame_index % REPLAY_MEM_INTERVAL == 0) {
+        struct mallinfo heap = mallinfo();
+        size_t vram = vglMemFree(VGL_MEM_VRAM);
+        size_t ram = vglMemFree(VGL_MEM_RAM);
+        heap_peak = MAX(heap_peak, (size_t)heap.uordblks);
+        vram_min_free = MIN(vram_min_free, vram);
+        ram_min_free = MIN(ram_min_free, ram);
+    }
+}
+
+static void close_span(void) {
+    span.frames = span_last_frame - span.start_frame + 1;
+    if (span_count < REPLAY_MAX_SPANS) {
+        spans[span_count++] = span;
+    }
+    span_open = 0;
+    span_pending_us = 0;
+}
+
+// ===== REPORT =====
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static float percentile_ms(const uint32_t *sorted, uint32_t count, int percent) {
+    if (count == 0) {
+        return 0.0f;
+    }
+    return sorted[(uint64_t)(count - 1) * percent / 100] / 1000.0f;
+}
+
+static int write_report(void) {
+    if (span_open) {
+        close_span();
+    }
+
+    SceDateTime now;
+    sceRtcGetCurrentClockLocalTime(&now);
+    char run[32];
+    snprintf(run, sizeof(run), "%04u%02u%02u_%02u%02u%02u",
+             now.year, now.month, now.day, now.hour, now.minute, now.second);
+
+    // The run is over, so the samples can be sorted in place
+    qsort(frame_times, stat_count, sizeof(uint32_t), compare_u32);
+    qsort(work_times, stat_count, sizeof(uint32_t), compare_u32);
+
+    uint64_t load_total_us = 0, load_max_us = 0;
+    for (int i = 0; i < span_count; i++) {
+        load_total_us += spans[i].us;
+        load_max_us = MAX(load_max_us, spans[i].us);
+    }
+
+    if (vram_min_free == (size_t)-1) {
+        vram_min_free = ram_min_free = 0;
+    }
+
+    char line[512];
+    sceIoMkdir(REPLAY_DIR, 0777);
+
+    SceIoStat stat;
+    int is_new = sceIoGetstat(REPLAY_RESULTS_PATH, &stat) < 0;
+    SceUID fd = sceIoOpen(REPLAY_RESULTS_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_APPEND, 0777);
+    if (fd < 0) {
+        l_warn("Replay: could not open %s: 0x%08X", REPLAY_RESULTS_PATH, fd);
+        return -1;
+    }
+    if (is_new) {
+        int n = snprintf(line, sizeof(line),
+                         "run,frames,frame_p50_ms,frame_p90_ms,frame_p99_ms,frame_max_ms,"
+                         "work_p50_ms,work_p99_ms,slow_frames,load_spans,load_total_ms,load_max_ms,"
+                         "heap_peak_kb,vram_min_free_kb,ram_min_free_kb,"
+                         "mem_pool,sprite_batch,profile,pace_mode,delta_ms\n");
+        sceIoWrite(fd, line, n);
+    }
+    int n = snprintf(line, sizeof(line),
+                     "%s,%u,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u,%d,%.1f,%.1f,%u,%u,%u,%d,%d,%s,%d,%d\n",
+                     run, stat_count,
+                     percentile_ms(frame_times, stat_count, 50), percentile_ms(frame_times, stat_count, 90),
+                     percentile_ms(frame_times, stat_count, 99), percentile_ms(frame_times, stat_count, 100),
+                     percentile_ms(work_times, stat_count, 50), percentile_ms(work_times, stat_count, 99),
+                     slow_frames, span_count, load_total_us / 1000.0f, load_max_us / 1000.0f,
+                     (unsigned)(heap_peak >> 10), (unsigned)(vram_min_free >> 10), (unsigned)(ram_min_free >> 10),
+                     MEM_POOL, GL_SPRITE_BATCH, perf_profile_get()->name, (int)frame_pacer_get_mode(), REPLAY_DELTA_MS);
+    sceIoWrite(fd, line, n);
+    sceIoClose(fd);
+
+    char path[128];
+    snprintf(path, sizeof(path), REPLAY_DIR "/spans_%s.csv", run);
+    fd = sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+    if (fd >= 0) {
+        n = snprintf(line, sizeof(line), "start_frame,frames,misses,ms\n");
+        sceIoWrite(fd, line, n);
+        for (int i = 0; i < span_count; i++) {
+            n = snprintf(line, sizeof(line), "%u,%u,%u,%.1f\n",
+                         spans[i].start_frame, spans[i].frames, spans[i].misses, spans[i].us / 1000.0f);
+            sceIoWrite(fd, line, n);
+        }
+        sceIoClose(fd);
+    }
+
+    l_success("Replay: %u frames, p50 %.2f ms, p99 %.2f ms, %u slow, %d load spans; written to %s",
+              stat_count, percentile_ms(frame_times, stat_count, 50), percentile_ms(frame_times, stat_count, 99),
+              slow_frames, span_count, REPLAY_RESULTS_PATH);
+    return 0;
+}
+
+#endif // REPLAY_MODE
@@ -0,0 +1,482 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Write-Behind Save Writer
+ *
+ * An open save is a growable buffer behind fopencookie(), so the game's
+ * newlib stdio calls work on it unchanged. fclose queues the buffer in a
+ * per-path slot; a newer image for a path still waiting replaces the old
+ * one. The writer thread writes <save>.tmp, syncs it and renames it to
+ * <save>.done, then removes the old save and renames the .done over it.
+ * Only a complete, synced image is ever named .done, so at boot a .done
+ * is promoted over whatever save is there and a .tmp, finished or not,
+ * is dropped along with the write it belonged to.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <psp2/io/dirent.h>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
+#include <psp2/kernel/threadmgr.h>
+
+#include "config.h"
+#include "save_writer.h"
+#include "utils/logger.h"
+
+#define SAVE_PREFIX SAVE_PATH "/"
+#define SAVE_WRITER_SLOTS 16
+#define SAVE_WRITER_PRIORITY 160            // Below the game and audio threads
+#define SAVE_WRITER_AFFINITY 0x40000        // Core 2, the one the game leaves idle
+#define SAVE_WRITER_STACK_SIZE (16 * 1024)
+#define SAVE_IMAGE_MIN_CAPACITY (16 * 1024)
+#define SAVE_TEMP_SUFFIX ".tmp"             // Being written
+#define SAVE_DONE_SUFFIX ".done"            // Written and synced, not yet in place
+
+typedef struct {
+    char path[256];
+    char *data;                             // Newest queued image, NULL once taken
+    size_t size;
+    char *writing;                          // Image the thread is writing
+    size_t writing_size;
+    int in_use;
+} pending_save_t;
+
+typedef struct {
+    char path[256];
+    char *data;
+    size_t size;
+    size_t capacity;
+    size_t pos;
+    int writable;
+    int append;
+} save_image_t;
+
+#if SAVE_WRITE_BEHIND
+static pending_save_t pending[SAVE_WRITER_SLOTS];
+static SceKernelLwMutexWork pending_lock;
+static SceUID work_sema = -1;
+static SceUID writer_thread = -1;
+static volatile int writer_running = 0;
+static int saves_written = 0;
+static int saves_collapsed = 0;
+
+// Function prototypes
+static int writer_thread_func(SceSize args, void *argp);
+static void queue_save(const char *path, char *data, size_t size);
+static pending_save_t *find_pending(const char *path);
+static int copy_current(const char *path, save_image_t *image);
+static int write_atomic(const char *path, const char *data, size_t size);
+static int has_suffix(const char *name, const char *suffix);
+static void recover_interrupted(void);
+static int reserve(save_image_t *image, size_t size);
+static ssize_t image_read(void *cookie, char *buf, size_t size);
+static ssize_t image_write(void *cookie, const char *buf, size_t size);
+static int image_seek(void *cookie, off_t *offset, int whence);
+static int image_close(void *cookie);
+#endif
+
+int save_writer_init(void) {
+#if SAVE_WRITE_BEHIND
+    if (writer_running) {
+        return 0;
+    }
+
+    recover_interrupted();
+
+    sceKernelCreateLwMutex(&pending_lock, "save_pending", 0, 0, NULL);
+    work_sema = sceKernelCreateSema("save_work", 0, 0, 0x7FFFFFFF, NULL);
+    if (work_sema < 0) {
+        l_error("Save writer: semaphore failed: 0x%08X", work_sema);
+        return -1;
+    }
+
+    writer_running = 1;
+    writer_thread = sceKernelCreateThread("save_writer", writer_thread_func, SAVE_WRITER_PRIORITY,
+                                          SAVE_WRITER_STACK_SIZE, 0, SAVE_WRITER_AFFINITY, NULL);
+    if (writer_thread < 0) {
+        l_error("Save writer: thread failed: 0x%08X", writer_thread);
+        writer_running = 0;
+        sceKernelDeleteSema(work_sema);
+        work_sema = -1;
+        return -1;
+    }
+    sceKernelStartThread(writer_thread, 0, NULL);
+
+    l_success("Save writer started for %s", SAVE_PREFIX);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int save_writer_owns(const char *path) {
+#if SAVE_WRITE_BEHIND
+    return writer_running && path && strncmp(path, SAVE_PREFIX, sizeof(SAVE_PREFIX) - 1) == 0;
+#else
+    return 0;
+#endif
+}
+
+FILE *save_writer_fopen(const char *path, const char *mode) {
+#if SAVE_WRITE_BEHIND
+    int writable = strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+');
+    save_image_t *image = calloc(1, sizeof(*image));
+    if (!image || strlen(path) >= sizeof(image->path)) {
+        free(image);
+        return NULL;
+    }
+    strcpy(image->path, path);
+    image->writable = writable;
+    image->append = strchr(mode, 'a') != NULL;
+
+    // "w" starts empty; everything else sees what is there now
+    int found = mode[0] != 'w' && copy_current(path, image);
+    if (!writable && !found) {
+        // Nothing queued: the card has the newest copy
+        free(image);
+        return fopen(path, mode);
+    }
+    if (mode[0] == 'r' && !found) {
+        // "r+" on a missing file fails as it would on disk
+        free(image);
+        return NULL;
+    }
+    if (reserve(image, 1) < 0) {
+        free(image->data);
+        free(image);
+        return NULL;
+    }
+
+    cookie_io_functions_t io = { image_read, image_write, image_seek, image_close };
+    FILE *file = fopencookie(image, mode, io);
+    if (!file) {
+        free(image->data);
+        free(image);
+    }
+    return file;
+#else
+    return fopen(path, mode);
+#endif
+}
+
+void save_writer_flush(void) {
+#if SAVE_WRITE_BEHIND
+    if (!writer_running) {
+        return;
+    }
+
+    for (;;) {
+        int busy = 0;
+        sceKernelLockLwMutex(&pending_lock, 1, NULL);
+        for (int i = 0; i < SAVE_WRITER_SLOTS; i++) {
+            busy |= pending[i].in_use;
+        }
+        sceKernelUnlockLwMutex(&pending_lock, 1);
+
+        if (!busy) {
+            break;
+        }
+        sceKernelDelayThread(1000);
+    }
+#endif
+}
+
+void save_writer_shutdown(void) {
+#if SAVE_WRITE_BEHIND
+    if (!writer_running) {
+        return;
+    }
+
+    save_writer_flush();
+    writer_running = 0;
+    sceKernelSignalSema(work_sema, 1);
+    sceKernelWaitThreadEnd(writer_thread, NULL, NULL);
+    sceKernelDeleteSema(work_sema);
+    work_sema = -1;
+    writer_thread = -1;
+
+    l_info("Save writer: %d saves written, %d collapsed into a later one", saves_written, saves_collapsed);
+#endif
+}
+
+#if SAVE_WRITE_BEHIND
+
+// ===== WRITER THREAD =====
+
+static int writer_thread_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    for (;;) {
+        sceKernelWaitSema(work_sema, 1, NULL);
+
+        sceKernelLockLwMutex(&pending_lock, 1, NULL);
+        pending_save_t *slot = NULL;
+        for (int i = 0; i < SAVE_WRITER_SLOTS; i++) {
+            if (pending[i].in_use && pending[i].data && !pending[i].writing) {
+                slot = &pending[i];
+                break;
+            }
+        }
+        if (!slot) {
+            sceKernelUnlockLwMutex(&pending_lock, 1);
+            if (!writer_running) {
+                break;
+            }
+            // A save that collapsed into another left its wakeup behind
+            continue;
+        }
+
+        char path[256];
+        strcpy(path, slot->path);
+        slot->writing = slot->data;
+        slot->writing_size = slot->size;
+        slot->data = NULL;
+        sceKernelUnlockLwMutex(&pending_lock, 1);
+
+        if (write_atomic(path, slot->writing, slot->writing_size) == 0) {
+            saves_written++;
+        }
+
+        sceKernelLockLwMutex(&pending_lock, 1, NULL);
+        free(slot->writing);
+        slot->writing = NULL;
+        if (!slot->data) {
+            slot->in_use = 0;
+        }
+        sceKernelUnlockLwMutex(&pending_lock, 1);
+    }
+
+    return sceKernelExitDeleteThread(0);
+}
+
+// Takes ownership of data
+static void queue_save(const char *path, char *data, size_t size) {
+    sceKernelLockLwMutex(&pending_lock, 1, NULL);
+    pending_save_t *slot = find_pending(path);
+    if (!slot) {
+        for (int i = 0; i < SAVE_WRITER_SLOTS && !slot; i++) {
+            if (!pending[i].in_use) {
+                slot = &pending[i];
+                strcpy(slot->path, path);
+                slot->in_use = 1;
+            }
+        }
+    }
+
+    if (!slot) {
+        // Every slot busy: write on the caller's thread rather than drop it
+        sceKernelUnlockLwMutex(&pending_lock, 1);
+        l_warn("Save writer: queue full, writing %s synchronously", path);
+        if (write_atomic(path, data, size) == 0) {
+            saves_written++;
+        }
+        free(data);
+        return;
+    }
+
+    if (slot->data) {
+        free(slot->data);
+        saves_collapsed++;
+    }
+    slot->data = data;
+    slot->size = size;
+    sceKernelUnlockLwMutex(&pending_lock, 1);
+
+    sceKernelSignalSema(work_sema, 1);
+}
+
+// Caller holds pending_lock
+static pending_save_t *find_pending(const char *path) {
+    for (int i = 0; i < SAVE_WRITER_SLOTS; i++) {
+        if (pending[i].in_use && strcmp(pending[i].path, path) == 0) {
+            return &pending[i];
+        }
+    }
+    return NULL;
+}
+
+// Newest contents of path, queued or on the card, into image; 1 if the file exists
+static int copy_current(const char *path, save_image_t *image) {
+    sceKernelLockLwMutex(&pending_lock, 1, NULL);
+    pending_save_t *slot = find_pending(path);
+    if (slot) {
+        const char *src = slot->data ? slot->data : slot->writing;
+        size_t size = slot->data ? slot->size : slot->writing_size;
+        int ok = reserve(image, size) == 0;
+        if (ok) {
+            memcpy(image->data, src, size);
+            image->size = size;
+        }
+        sceKernelUnlockLwMutex(&pending_lock, 1);
+        return ok;
+    }
+    sceKernelUnlockLwMutex(&pending_lock, 1);
+
+    SceUID fd = sceIoOpen(path, SCE_O_RDONLY, 0);
+    if (fd < 0) {
+        return 0;
+    }
+
+    SceOff size = sceIoLseek(fd, 0, SCE_SEEK_END);
+    sceIoLseek(fd, 0, SCE_SEEK_SET);
+    int ok = size >= 0 && reserve(image, (size_t)size) == 0 &&
+             sceIoRead(fd, image->data, (SceSize)size) == (int)size;
+    sceIoClose(fd);
+
+    image->size = ok ? (size_t)size : 0;
+    return ok;
+}
+
+static int write_atomic(const char *path, const char *data, size_t size) {
+    char temp_path[264];
+    char done_path[264];
+    snprintf(temp_path, sizeof(temp_path), "%s" SAVE_TEMP_SUFFIX, path);
+    snprintf(done_path, sizeof(done_path), "%s" SAVE_DONE_SUFFIX, path);
+
+    SceUID fd = sceIoOpen(temp_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+    if (fd < 0) {
+        l_error("Save writer: cannot create %s: 0x%08X", temp_path, fd);
+        return -1;
+    }
+
+    int ok = sceIoWrite(fd, data, size) == (int)size;
+    ok = ok && sceIoSyncByFd(fd, 0) >= 0;
+    sceIoClose(fd);
+
+    if (!ok) {
+        l_error("Save writer: short write to %s, previous save kept", temp_path);
+        sceIoRemove(temp_path);
+        return -1;
+    }
+
+    // The rename is what marks the image whole; boot recovery finishes from here
+    sceIoRemove(done_path);
+    int res = sceIoRename(temp_path, done_path);
+    if (res < 0) {
+        l_error("Save writer: rename to %s failed: 0x%08X, previous save kept", done_path, res);
+        sceIoRemove(temp_path);
+        return -1;
+    }
+
+    sceIoRemove(path);
+    res = sceIoRename(done_path, path);
+    if (res < 0) {
+        l_error("Save writer: rename to %s failed: 0x%08X", path, res);
+        return -1;
+    }
+
+    l_debug("Save writer: wrote %s (%zu bytes)", path, size);
+    return 0;
+}
+
+static int has_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name);
+    size_t suffix_len = strlen(suffix);
+    return len > suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static void recover_interrupted(void) {
+    SceUID dir = sceIoDopen(SAVE_PATH);
+    if (dir < 0) {
+        return;
+    }
+
+    SceIoDirent entry;
+    while (sceIoDread(dir, &entry) > 0) {
+        char file_path[264];
+        snprintf(file_path, sizeof(file_path), "%s%s", SAVE_PREFIX, entry.d_name);
+
+        if (has_suffix(entry.d_name, SAVE_TEMP_SUFFIX)) {
+            // Never known to be complete, whatever its size
+            l_warn("Save writer: dropping torn %s", file_path);
+            sceIoRemove(file_path);
+        } else if (has_suffix(entry.d_name, SAVE_DONE_SUFFIX)) {
+            char save_path[264];
+            snprintf(save_path, sizeof(save_path), "%s%.*s", SAVE_PREFIX,
+                     (int)(strlen(entry.d_name) - (sizeof(SAVE_DONE_SUFFIX) - 1)), entry.d_name);
+            l_warn("Save writer: finishing interrupted save %s", save_path);
+            sceIoRemove(save_path);
+            sceIoRename(file_path, save_path);
+        }
+    }
+    sceIoDclose(dir);
+}
+
+// ===== MEMORY IMAGES =====
+
+static int reserve(save_image_t *image, size_t size) {
+    if (size <= image->capacity) {
+        return 0;
+    }
+
+    size_t capacity = image->capacity ? image->capacity : SAVE_IMAGE_MIN_CAPACITY;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    char *data = realloc(image->data, capacity);
+    if (!data) {
+        return -1;
+    }
+    image->data = data;
+    image->capacity = capacity;
+    return 0;
+}
+
+static ssize_t image_read(void *cookie, char *buf, size_t size) {
+    save_image_t *image = cookie;
+    if (image->pos >= image->size) {
+        return 0;
+    }
+    size_t count = MIN(size, image->size - image->pos);
+    memcpy(buf, image->data + image->pos, count);
+    image->pos += count;
+    return (ssize_t)count;
+}
+
+static ssize_t image_write(void *cookie, const char *buf, size_t size) {
+    save_image_t *image = cookie;
+    if (!image->writable) {
+        return -1;
+    }
+    if (image->append) {
+        image->pos = image->size;
+    }
+    if (reserve(image, image->pos + size) < 0) {
+        return -1;
+    }
+
+    // Seeking past the end and writing leaves a zeroed gap, as on disk
+    if (image->pos > image->size) {
+        memset(image->data + image->size, 0, image->pos - image->size);
+    }
+    memcpy(image->data + image->pos, buf, size);
+    image->pos += size;
+    image->size = MAX(image->size, image->pos);
+    return (ssize_t)size;
+}
+
+static int image_seek(void *cookie, off_t *offset, int whence) {
+    save_image_t *image = cookie;
+    off_t base = whence == SEEK_SET ? 0 : whence == SEEK_CUR ? (off_t)image->pos : (off_t)image->size;
+    if (base + *offset < 0) {
+        return -1;
+    }
+    image->pos = (size_t)(base + *offset);
+    *offset = (off_t)image->pos;
+    return 0;
+}
+
+static int image_close(void *cookie) {
+    save_image_t *image = cookie;
+    if (image->writable) {
+        queue_save(image->path, image->data, image->size);
+    } else {
+        free(image->data);
+    }
+    free(image);
+    return 0;
+}
+
+#endif
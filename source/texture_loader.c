@@ -0,0 +1,984 @@
+/*
+ * Fluffy Diver PS Vita Port
+ * Texture Loader
+ *
+ * Decode jobs run on one thread on core 2 next to the asset workers. Each
+ * finished decode becomes a texture_upload_t on the completion list; the GL
+ * thread drains that list once per frame. Compressed siblings are uploaded
+ * straight from the pinned cache entry, decoded images from their own
+ * buffer holding every mip level back to back.
+ *
+ * Decoded textures are also written to TEXTURE_CACHE_PATH under the SHA-1
+ * of their source bytes, so a later load of the same file reads the
+ * transcoded levels back with one pread instead of decoding again.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <vitaGL.h>
+#include <psp2/kernel/threadmgr.h>
+#include <psp2/io/fcntl.h>
+#include <psp2/io/stat.h>
+
+#include "config.h"
+#include "texture_loader.h"
+#include "asset_handler.h"
+#include "asset_dir.h"
+#include "mem_budget.h"
+#include "mem_governor.h"
+#include "reimpl/gl_upload.h"
+#include "utils/logger.h"
+#include "utils/utils.h"
+
+#define TEXTURE_DECODER_PRIORITY 160
+#define TEXTURE_DECODER_AFFINITY 0x40000  // Core 2, next to the asset workers
+#define TEXTURE_DECODER_STACK_SIZE (64 * 1024)
+#define MAX_TEXTURE_JOBS 128
+#define MAX_TEXTURE_LEVELS 13             // 4096x4096 down to 1x1
+#define MAX_TEXTURE_SIZE 4096
+
+// Transcode cache, one file per distinct source image
+#define TEXTURE_CACHE_PATH "ux0:data/fluffydiver/textures"
+#define TEXTURE_CACHE_MAGIC 0x58544446    // "FDTX"
+#define TEXTURE_CACHE_VERSION 1
+#define TEXTURE_CACHE_SETTINGS ((TEXTURE_TRANSCODE << 0) | (TEXTURE_MIPMAPS << 1))
+
+#ifndef GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG
+#define GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG  0x8C00
+#define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG  0x8C01
+#define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG 0x8C02
+#define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG 0x8C03
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT    0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT    0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#endif
+
+typedef struct {
+    GLuint texture;
+    char path[256];
+} texture_job_t;
+
+// Followed by every level back to back, largest first
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t settings;                // TEXTURE_CACHE_SETTINGS at write time
+    uint32_t format;                  // TEXTURE_FORMAT_*
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t data_size;
+} texture_cache_header_t;
+
+typedef struct texture_upload {
+    struct texture_upload *next;
+    GLuint texture;
+    int format;                       // TEXTURE_FORMAT_*, 0 when compressed
+    GLenum compressed_format;
+    int width;
+    int height;
+    int levels;
+    const uint8_t *level_data[MAX_TEXTURE_LEVELS];
+    size_t level_size[MAX_TEXTURE_LEVELS];
+    void *pixels;                     // Owned decode buffer, or NULL
+    asset_handle_t source;            // Pinned compressed file, or invalid
+} texture_upload_t;
+
+static texture_job_t jobs[MAX_TEXTURE_JOBS];
+static int job_head = 0;
+static int job_count = 0;
+static SceKernelLwMutexWork job_lock;
+static SceUID job_sema = -1;
+static SceUID decoder_thread = -1;
+static volatile int decoder_running = 0;
+
+static texture_upload_t *upload_head = NULL;
+static texture_upload_t *upload_tail = NULL;
+static int upload_count = 0;
+static int decodes_in_flight = 0;
+static SceKernelLwMutexWork upload_lock;
+
+static size_t texture_bytes = 0;
+static int budget_warned = 0;
+static int loader_initialized = 0;
+static uint32_t disk_cache_hits = 0;
+static uint32_t disk_cache_writes = 0;
+
+// Function prototypes
+static int texture_decoder_func(SceSize args, void *argp);
+static texture_upload_t *decode_texture(GLuint texture, const char *path);
+static int find_sibling(const char *path, char *out, size_t out_size);
+static int parse_pvr(texture_upload_t *upload, const uint8_t *data, size_t size);
+static int parse_dds(texture_upload_t *upload, const uint8_t *data, size_t size);
+static uint8_t *decode_png(const uint8_t *data, size_t size, int *width, int *height);
+static int build_levels(texture_upload_t *upload, uint8_t *rgba, int width, int height);
+static void upload_texture(texture_upload_t *upload);
+static void free_upload(texture_upload_t *upload);
+static void push_upload(texture_upload_t *upload);
+static size_t layout_levels(texture_upload_t *upload);
+static int load_cached_texture(texture_upload_t *upload, const char *cache_path);
+static void save_cached_texture(const texture_upload_t *upload, const char *cache_path);
+
+int texture_loader_init(void) {
+    if (loader_initialized) {
+        return 0;
+    }
+
+    sceKernelCreateLwMutex(&job_lock, "tex_job_lock", 0, 0, NULL);
+    sceKernelCreateLwMutex(&upload_lock, "tex_upload_lock", 0, 0, NULL);
+    job_sema = sceKernelCreateSema("tex_jobs", 0, 0, MAX_TEXTURE_JOBS, NULL);
+    loader_initialized = 1;
+
+    decoder_running = 1;
+    decoder_thread = sceKernelCreateThread("texture_decoder", texture_decoder_func, TEXTURE_DECODER_PRIORITY,
+                                           TEXTURE_DECODER_STACK_SIZE, 0, TEXTURE_DECODER_AFFINITY, NULL);
+    if (decoder_thread < 0) {
+        // texture_loader_load() falls back to decoding on the caller
+        l_warn("Failed to create texture decoder thread: 0x%08X", decoder_thread);
+        decoder_running = 0;
+        return -1;
+    }
+
+    sceKernelStartThread(decoder_thread, 0, NULL);
+    l_success("Texture decoder thread started");
+    return 0;
+}
+
+void texture_loader_shutdown(void) {
+    if (!loader_initialized) {
+        return;
+    }
+
+    if (decoder_running) {
+        decoder_running = 0;
+        sceKernelSignalSema(job_sema, 1);
+        sceKernelWaitThreadEnd(decoder_thread, NULL, NULL);
+        decoder_thread = -1;
+    }
+
+    // Finished decodes that never reached the GPU
+    while (upload_head) {
+        texture_upload_t *upload = upload_head;
+        upload_head = upload->next;
+        free_upload(upload);
+    }
+    upload_tail = NULL;
+    upload_count = 0;
+    job_head = job_count = 0;
+    decodes_in_flight = 0;
+
+    sceKernelDeleteSema(job_sema);
+    sceKernelDeleteLwMutex(&job_lock);
+    sceKernelDeleteLwMutex(&upload_lock);
+    job_sema = -1;
+    loader_initialized = 0;
+
+    l_info("Texture loader stopped, %zu KB of textures uploaded", texture_bytes / 1024);
+    l_info("  Transcode cache: %u hits, %u written", disk_cache_hits, disk_cache_writes);
+}
+
+GLuint texture_loader_load(const char *path) {
+    if (!path) {
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    if (texture == 0) {
+        l_error("Failed to create texture for %s", path);
+        return 0;
+    }
+
+    // Placeholder until the decode lands, so the name is usable right away
+    static const uint8_t white[4] = { 255, 255, 255, 255 };
+#if GL_UPLOAD_FILTER
+    // What the game uploaded to this name before is gone
+    gl_upload_forget(upload->texture);
+#endif
+
+    GLint bound = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glBindTexture(GL_TEXTURE_2D, bound);
+
+    int queued = 0;
+    if (decoder_running) {
+        sceKernelLockLwMutex(&job_lock, 1, NULL);
+        if (job_count < MAX_TEXTURE_JOBS) {
+            texture_job_t *job = &jobs[(job_head + job_count) % MAX_TEXTURE_JOBS];
+            job->texture = texture;
+            strncpy(job->path, path, sizeof(job->path) - 1);
+            job->path[sizeof(job->path) - 1] = '\0';
+            job_count++;
+            queued = 1;
+        }
+        sceKernelUnlockLwMutex(&job_lock, 1);
+    }
+
+    if (queued) {
+        sceKernelLockLwMutex(&upload_lock, 1, NULL);
+        decodes_in_flight++;
+        sceKernelUnlockLwMutex(&upload_lock, 1);
+        sceKernelSignalSema(job_sema, 1);
+        return texture;
+    }
+
+    // No decoder thread or a full queue: decode here and upload now
+    texture_upload_t *upload = decode_texture(texture, path);
+    if (upload) {
+        upload_texture(upload);
+        free_upload(upload);
+    }
+    return texture;
+}
+
+int texture_loader_process_uploads(int max_uploads) {
+    if (!loader_initialized) {
+        return 0;
+    }
+
+    int uploaded = 0;
+    while (max_uploads <= 0 || uploaded < max_uploads) {
+        sceKernelLockLwMutex(&upload_lock, 1, NULL);
+        texture_upload_t *upload = upload_head;
+        if (upload) {
+            upload_head = upload->next;
+            if (!upload_head) upload_tail = NULL;
+            upload_count--;
+        }
+        sceKernelUnlockLwMutex(&upload_lock, 1);
+
+        if (!upload) {
+            break;
+        }
+
+        upload_texture(upload);
+        free_upload(upload);
+        uploaded++;
+    }
+
+    return uploaded;
+}
+
+int texture_loader_pending(void) {
+    if (!loader_initialized) {
+        return 0;
+    }
+
+    sceKernelLockLwMutex(&upload_lock, 1, NULL);
+    int pending = decodes_in_flight + upload_count;
+    sceKernelUnlockLwMutex(&upload_lock, 1);
+    return pending;
+}
+
+size_t texture_loader_get_usage(void) {
+    return texture_bytes;
+}
+
+// ===== DECODER THREAD =====
+
+static int texture_decoder_func(SceSize args __attribute__((unused)), void *argp __attribute__((unused))) {
+    while (1) {
+        sceKernelWaitSema(job_sema, 1, NULL);
+        if (!decoder_running) {
+            break;
+        }
+
+        sceKernelLockLwMutex(&job_lock, 1, NULL);
+        if (job_count == 0) {
+            sceKernelUnlockLwMutex(&job_lock, 1);
+            continue;
+        }
+        texture_job_t job = jobs[job_head];
+        job_head = (job_head + 1) % MAX_TEXTURE_JOBS;
+        job_count--;
+        sceKernelUnlockLwMutex(&job_lock, 1);
+
+        texture_upload_t *upload = decode_texture(job.texture, job.path);
+
+        sceKernelLockLwMutex(&upload_lock, 1, NULL);
+        decodes_in_flight--;
+        sceKernelUnlockLwMutex(&upload_lock, 1);
+
+        if (upload) {
+            push_upload(upload);
+        }
+    }
+
+    return sceKernelExitDeleteThread(0);
+}
+
+static void push_upload(texture_upload_t *upload) {
+    upload->next = NULL;
+    sceKernelLockLwMutex(&upload_lock, 1, NULL);
+    if (upload_tail) {
+        upload_tail->next = upload;
+    } else {
+        upload_head = upload;
+    }
+    upload_tail = upload;
+    upload_count++;
+    sceKernelUnlockLwMutex(&upload_lock, 1);
+}
+
+static texture_upload_t *decode_texture(GLuint texture, const char *path) {
+    texture_upload_t *upload = calloc(1, sizeof(texture_upload_t));
+    if (!upload) {
+        return NULL;
+    }
+    upload->texture = texture;
+    upload->source = ASSET_HANDLE_INVALID;
+
+    // Offline-converted sibling: keep the cache entry pinned until upload
+    char sibling[256];
+    if (find_sibling(path, sibling, sizeof(sibling)) == 0) {
+        asset_handle_t handle = asset_acquire(sibling);
+        size_t size = 0;
+        const uint8_t *data = handle != ASSET_HANDLE_INVALID ? asset_handle_data(handle, &size) : NULL;
+        int parsed = -1;
+        if (data) {
+            parsed = strcmp(strrchr(sibling, '.'), ".pvr") == 0 ? parse_pvr(upload, data, size)
+                                                               : parse_dds(upload, data, size);
+        }
+        if (parsed == 0) {
+            upload->source = handle;
+            l_debug("Texture %s: %dx%d compressed (%s), %d levels",
+                    path, upload->width, upload->height, sibling, upload->levels);
+            return upload;
+        }
+
+        if (handle != ASSET_HANDLE_INVALID) {
+            asset_release(handle);
+        }
+        l_warn("Unusable compressed texture %s, decoding %s", sibling, path);
+        memset(upload, 0, sizeof(*upload));
+        upload->texture = texture;
+        upload->source = ASSET_HANDLE_INVALID;
+    }
+
+    asset_handle_t handle = asset_acquire(path);
+    if (handle == ASSET_HANDLE_INVALID) {
+        l_error("Failed to load texture: %s", path);
+        free(upload);
+        return NULL;
+    }
+
+    size_t size = 0;
+    const uint8_t *data = asset_handle_data(handle, &size);
+
+#if TEXTURE_DISK_CACHE
+    // Keyed by content, so edited or replaced assets never hit a stale entry
+    char cache_path[256] = "";
+    char *sha = (data && size > 0) ? str_sha1sum((const char *)data, size) : NULL;
+    if (sha) {
+        snprintf(cache_path, sizeof(cache_path), TEXTURE_CACHE_PATH "/%s.tex", sha);
+        free(sha);
+        if (load_cached_texture(upload, cache_path) == 0) {
+            asset_release(handle);
+            disk_cache_hits++;
+            l_debug("Texture %s: %dx%d from transcode cache", path, upload->width, upload->height);
+            return upload;
+        }
+    }
+#endif
+
+    int width = 0, height = 0;
+    uint8_t *rgba = data ? decode_png(data, size, &width, &height) : NULL;
+    asset_release(handle);
+
+    if (!rgba) {
+        l_warn("Unsupported texture format, keeping placeholder: %s", path);
+        free(upload);
+        return NULL;
+    }
+
+    if (build_levels(upload, rgba, width, height) < 0) {
+        l_error("Out of memory building texture: %s", path);
+        free(rgba);
+        free(upload);
+        return NULL;
+    }
+
+#if TEXTURE_DISK_CACHE
+    if (cache_path[0]) {
+        save_cached_texture(upload, cache_path);
+    }
+#endif
+
+    l_debug("Texture %s: %dx%d, format %d, %d levels", path, width, height, upload->format, upload->levels);
+    return upload;
+}
+
+// <base>.pvr first (PVRTC is native to the SGX543), then <base>.dds
+static int find_sibling(const char *path, char *out, size_t out_size) {
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    size_t base_len = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+
+    static const char *extensions[] = { ".pvr", ".dds" };
+    for (size_t i = 0; i < ARRAY_SIZE(extensions); i++) {
+        if (base_len + strlen(extensions[i]) >= out_size) {
+            return -1;
+        }
+        memcpy(out, path, base_len);
+        strcpy(out + base_len, extensions[i]);
+        if (strcmp(out, path) != 0 && asset_dir_exists(out)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// ===== COMPRESSED CONTAINERS =====
+
+static uint32_t read_u32le(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t compressed_level_size(GLenum format, int width, int height) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG:
+        case GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG:
+            return (size_t)MAX(width, 8) * MAX(height, 8) / 2;
+        case GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG:
+        case GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG:
+            return (size_t)MAX(width, 16) * MAX(height, 8) / 4;
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+        default:
+            return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+    }
+}
+
+// Slices `levels` mips out of data, stopping early if the file is short
+static int slice_levels(texture_upload_t *upload, const uint8_t *data, size_t size, int levels) {
+    int width = upload->width;
+    int height = upload->height;
+    size_t offset = 0;
+
+    if (levels < 1) levels = 1;
+    if (levels > MAX_TEXTURE_LEVELS) levels = MAX_TEXTURE_LEVELS;
+
+    upload->levels = 0;
+    for (int i = 0; i < levels; i++) {
+        size_t level_size = compressed_level_size(upload->compressed_format, width, height);
+        if (level_size > size - offset) {
+            break;
+        }
+        upload->level_data[i] = data + offset;
+        upload->level_size[i] = level_size;
+        upload->levels++;
+        offset += level_size;
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+    return upload->levels > 0 ? 0 : -1;
+}
+
+// PVR v3: 52-byte header, metadata, then the surface with mips largest first
+static int parse_pvr(texture_upload_t *upload, const uint8_t *data, size_t size) {
+    if (size < 52 || read_u32le(data) != 0x03525650) {
+        return -1;
+    }
+
+    uint32_t format = read_u32le(data + 8);
+    uint32_t format_high = read_u32le(data + 12);
+    if (format_high != 0) {
+        return -1; // Uncompressed channel layout, not worth a second path
+    }
+
+    switch (format) {
+        case 0: upload->compressed_format = GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG; break;
+        case 1: upload->compressed_format = GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG; break;
+        case 2: upload->compressed_format = GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG; break;
+        case 3: upload->compressed_format = GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG; break;
+        case 7: upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+        case 9: upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
+        case 11: upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        default: return -1;
+    }
+
+    upload->height = read_u32le(data + 24);
+    upload->width = read_u32le(data + 28);
+    uint32_t levels = read_u32le(data + 44);
+    uint32_t metadata = read_u32le(data + 48);
+    if (upload->width <= 0 || upload->height <= 0 || metadata > size - 52) {
+        return -1;
+    }
+
+    return slice_levels(upload, data + 52 + metadata, size - 52 - metadata, (int)levels);
+}
+
+// DDS: "DDS " magic, 124-byte header, FourCC DXT1/DXT3/DXT5 only
+static int parse_dds(texture_upload_t *upload, const uint8_t *data, size_t size) {
+    if (size < 128 || memcmp(data, "DDS ", 4) != 0) {
+        return -1;
+    }
+
+    const uint8_t *fourcc = data + 84;
+    if (memcmp(fourcc, "DXT1", 4) == 0) {
+        upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    } else if (memcmp(fourcc, "DXT3", 4) == 0) {
+        upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    } else if (memcmp(fourcc, "DXT5", 4) == 0) {
+        upload->compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    } else {
+        return -1;
+    }
+
+    upload->height = read_u32le(data + 12);
+    upload->width = read_u32le(data + 16);
+    uint32_t levels = read_u32le(data + 28);
+    if (upload->width <= 0 || upload->height <= 0) {
+        return -1;
+    }
+
+    return slice_levels(upload, data + 128, size - 128, (int)levels);
+}
+
+// ===== PNG =====
+
+static uint32_t read_u32be(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a);
+    int pb = abs(p - b);
+    int pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Reverses the per-scanline filters in place; bpp is bytes per pixel
+static int unfilter(uint8_t *raw, int height, size_t stride, int bpp) {
+    uint8_t *prev = NULL;
+    for (int y = 0; y < height; y++) {
+        uint8_t *line = raw + y * (stride + 1);
+        int filter = line[0];
+        uint8_t *cur = line + 1;
+
+        for (size_t x = 0; x < stride; x++) {
+            int a = x >= (size_t)bpp ? cur[x - bpp] : 0;
+            int b = prev ? prev[x] : 0;
+            int c = (prev && x >= (size_t)bpp) ? prev[x - bpp] : 0;
+            switch (filter) {
+                case 0: break;
+                case 1: cur[x] += a; break;
+                case 2: cur[x] += b; break;
+                case 3: cur[x] += (a + b) / 2; break;
+                case 4: cur[x] += paeth(a, b, c); break;
+                default: return -1;
+            }
+        }
+        prev = cur;
+    }
+    return 0;
+}
+
+// Non-interlaced 8/16-bit gray, RGB, palette, gray+alpha and RGBA to RGBA8
+static uint8_t *decode_png(const uint8_t *data, size_t size, int *width, int *height) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (size < 8 || memcmp(data, signature, 8) != 0) {
+        return NULL;
+    }
+
+    uint32_t w = 0, h = 0;
+    int depth = 0, color = -1, interlace = 0;
+    uint8_t palette[256][4];
+    int palette_size = 0;
+    uint8_t *idat = NULL;
+    size_t idat_size = 0;
+    size_t offset = 8;
+
+    memset(palette, 255, sizeof(palette));
+
+    while (offset + 12 <= size) {
+        uint32_t length = read_u32be(data + offset);
+        const uint8_t *type = data + offset + 4;
+        const uint8_t *chunk = data + offset + 8;
+        if (length > size - offset - 12) {
+            break;
+        }
+
+        if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            w = read_u32be(chunk);
+            h = read_u32be(chunk + 4);
+            depth = chunk[8];
+            color = chunk[9];
+            interlace = chunk[12];
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            palette_size = MIN((int)(length / 3), 256);
+            for (int i = 0; i < palette_size; i++) {
+                palette[i][0] = chunk[i * 3];
+                palette[i][1] = chunk[i * 3 + 1];
+                palette[i][2] = chunk[i * 3 + 2];
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0 && color == 3) {
+            for (uint32_t i = 0; i < length && i < 256; i++) {
+                palette[i][3] = chunk[i];
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            uint8_t *grown = realloc(idat, idat_size + length);
+            if (!grown) {
+                free(idat);
+                return NULL;
+            }
+            idat = grown;
+            memcpy(idat + idat_size, chunk, length);
+            idat_size += length;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+
+        offset += length + 12;
+    }
+
+    int channels;
+    switch (color) {
+        case 0: channels = 1; break;
+        case 2: channels = 3; break;
+        case 3: channels = 1; break;
+        case 4: channels = 2; break;
+        case 6: channels = 4; break;
+        default: channels = 0; break;
+    }
+
+    if (!idat || channels == 0 || w == 0 || h == 0 || w > MAX_TEXTURE_SIZE || h > MAX_TEXTURE_SIZE || interlace != 0 ||
+        !(depth == 8 || (depth == 16 && color != 3))) {
+        free(idat);
+        return NULL;
+    }
+
+    int bpp = channels * depth / 8;
+    size_t stride = (size_t)w * bpp;
+    uLongf raw_size = (stride + 1) * h;
+    uint8_t *raw = malloc(raw_size);
+    uint8_t *rgba = malloc((size_t)w * h * 4);
+    if (!raw || !rgba || uncompress(raw, &raw_size, idat, idat_size) != Z_OK ||
+        raw_size != (stride + 1) * h || unfilter(raw, h, stride, bpp) < 0) {
+        free(idat);
+        free(raw);
+        free(rgba);
+        return NULL;
+    }
+    free(idat);
+
+    // 16-bit samples keep their high byte
+    int step = depth / 8;
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *src = raw + y * (stride + 1) + 1;
+        uint8_t *dst = rgba + (size_t)y * w * 4;
+        for (uint32_t x = 0; x < w; x++, src += bpp, dst += 4) {
+            switch (color) {
+                case 0:
+                    dst[0] = dst[1] = dst[2] = src[0];
+                    dst[3] = 255;
+                    break;
+                case 2:
+                    dst[0] = src[0];
+                    dst[1] = src[step];
+                    dst[2] = src[step * 2];
+                    dst[3] = 255;
+                    break;
+                case 3:
+                    memcpy(dst, palette[src[0]], 4);
+                    break;
+                case 4:
+                    dst[0] = dst[1] = dst[2] = src[0];
+                    dst[3] = src[step];
+                    break;
+                case 6:
+                    dst[0] = src[0];
+                    dst[1] = src[step];
+                    dst[2] = src[step * 2];
+                    dst[3] = src[step * 3];
+                    break;
+            }
+        }
+    }
+    free(raw);
+
+    *width = (int)w;
+    *height = (int)h;
+    return rgba;
+}
+
+// ===== TRANSCODE AND MIPS =====
+
+// 2x2 box filter; a 1-pixel side is sampled twice
+static void downsample(const uint8_t *src, int src_w, int src_h, uint8_t *dst, int dst_w, int dst_h) {
+    for (int y = 0; y < dst_h; y++) {
+        int y0 = MIN(y * 2, src_h - 1);
+        int y1 = MIN(y * 2 + 1, src_h - 1);
+        for (int x = 0; x < dst_w; x++) {
+            int x0 = MIN(x * 2, src_w - 1);
+            int x1 = MIN(x * 2 + 1, src_w - 1);
+            const uint8_t *a = src + ((size_t)y0 * src_w + x0) * 4;
+            const uint8_t *b = src + ((size_t)y0 * src_w + x1) * 4;
+            const uint8_t *c = src + ((size_t)y1 * src_w + x0) * 4;
+            const uint8_t *d = src + ((size_t)y1 * src_w + x1) * 4;
+            uint8_t *out = dst + ((size_t)y * dst_w + x) * 4;
+            for (int i = 0; i < 4; i++) {
+                out[i] = (a[i] + b[i] + c[i] + d[i] + 2) >> 2;
+            }
+        }
+    }
+}
+
+// Packs RGBA8 to 16 bits per pixel in place; dst never passes src
+static void pack_16bit(uint8_t *dst, const uint8_t *src, size_t pixels, int format) {
+    uint16_t *out = (uint16_t *)dst;
+    for (size_t i = 0; i < pixels; i++, src += 4) {
+        uint8_t r = src[0], g = src[1], b = src[2], a = src[3];
+        if (format == TEXTURE_FORMAT_RGB565) {
+            out[i] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        } else {
+            out[i] = ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | (a >> 4);
+        }
+    }
+}
+
+#if TEXTURE_MIPMAPS
+static int is_power_of_two(int value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+#endif
+
+// Takes ownership of rgba; levels end up back to back in upload->pixels
+static int build_levels(texture_upload_t *upload, uint8_t *rgba, int width, int height) {
+    int levels = 1;
+#if TEXTURE_MIPMAPS
+    if (is_power_of_two(width) && is_power_of_two(height)) {
+        for (int w = width, h = height; (w > 1 || h > 1) && levels < MAX_TEXTURE_LEVELS; levels++) {
+            w = MAX(w / 2, 1);
+            h = MAX(h / 2, 1);
+        }
+    }
+#endif
+
+    size_t total = 0;
+    for (int i = 0, w = width, h = height; i < levels; i++) {
+        total += (size_t)w * h * 4;
+        w = MAX(w / 2, 1);
+        h = MAX(h / 2, 1);
+    }
+
+    uint8_t *pixels = rgba;
+    if (levels > 1) {
+        pixels = realloc(rgba, total);
+        if (!pixels) {
+            return -1;
+        }
+    }
+
+    upload->format = TEXTURE_FORMAT_RGBA8888;
+#if TEXTURE_TRANSCODE
+    upload->format = TEXTURE_FORMAT_RGB565;
+    for (size_t i = 3; i < (size_t)width * height * 4; i += 4) {
+        if (pixels[i] != 255) {
+            upload->format = TEXTURE_FORMAT_RGBA4444;
+            break;
+        }
+    }
+#endif
+    int bytes_per_pixel = upload->format == TEXTURE_FORMAT_RGBA8888 ? 4 : 2;
+
+    // Mips from the full-precision chain, then each level packed down
+    size_t src_offset = 0;
+    size_t dst_offset = 0;
+    for (int i = 0, w = width, h = height; i < levels; i++) {
+        int next_w = MAX(w / 2, 1);
+        int next_h = MAX(h / 2, 1);
+        if (i + 1 < levels) {
+            downsample(pixels + src_offset, w, h, pixels + src_offset + (size_t)w * h * 4, next_w, next_h);
+        }
+
+        size_t count = (size_t)w * h;
+        if (bytes_per_pixel == 2) {
+            pack_16bit(pixels + dst_offset, pixels + src_offset, count, upload->format);
+        }
+        src_offset += count * 4;
+        dst_offset += count * bytes_per_pixel;
+        w = next_w;
+        h = next_h;
+    }
+
+    upload->pixels = pixels;
+    upload->width = width;
+    upload->height = height;
+    upload->levels = levels;
+    layout_levels(upload);
+    return 0;
+}
+
+// Points level_data into upload->pixels; returns the total size
+static size_t layout_levels(texture_upload_t *upload) {
+    int bytes_per_pixel = upload->format == TEXTURE_FORMAT_RGBA8888 ? 4 : 2;
+    size_t offset = 0;
+    for (int i = 0, w = upload->width, h = upload->height; i < upload->levels; i++) {
+        upload->level_data[i] = (const uint8_t *)upload->pixels + offset;
+        upload->level_size[i] = (size_t)w * h * bytes_per_pixel;
+        offset += upload->level_size[i];
+        w = MAX(w / 2, 1);
+        h = MAX(h / 2, 1);
+    }
+    return offset;
+}
+
+// ===== DISK CACHE =====
+
+static int load_cached_texture(texture_upload_t *upload, const char *cache_path) {
+    SceUID fd = sceIoOpen(cache_path, SCE_O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    texture_cache_header_t header;
+    if (sceIoPread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != TEXTURE_CACHE_MAGIC || header.version != TEXTURE_CACHE_VERSION ||
+        header.settings != TEXTURE_CACHE_SETTINGS ||
+        header.format < TEXTURE_FORMAT_RGBA8888 || header.format > TEXTURE_FORMAT_RGBA4444 ||
+        header.width == 0 || header.width > MAX_TEXTURE_SIZE ||
+        header.height == 0 || header.height > MAX_TEXTURE_SIZE ||
+        header.levels == 0 || header.levels > MAX_TEXTURE_LEVELS) {
+        sceIoClose(fd);
+        return -1;
+    }
+
+    upload->format = header.format;
+    upload->width = header.width;
+    upload->height = header.height;
+    upload->levels = header.levels;
+    upload->pixels = NULL;
+    size_t expected = layout_levels(upload);
+
+    // Straight into the upload buffer; nothing left to do on this thread
+    void *pixels = expected == header.data_size ? malloc(expected) : NULL;
+    int ok = pixels && sceIoPread(fd, pixels, expected, sizeof(header)) == (int)expected;
+    sceIoClose(fd);
+
+    if (!ok) {
+        l_warn("Discarding bad transcode cache entry: %s", cache_path);
+        free(pixels);
+        sceIoRemove(cache_path);
+        upload->format = 0;
+        upload->levels = 0;
+        return -1;
+    }
+
+    upload->pixels = pixels;
+    layout_levels(upload);
+    return 0;
+}
+
+static void save_cached_texture(const texture_upload_t *upload, const char *cache_path) {
+    size_t data_size = 0;
+    for (int i = 0; i < upload->levels; i++) {
+        data_size += upload->level_size[i];
+    }
+
+    texture_cache_header_t header = {
+        TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, TEXTURE_CACHE_SETTINGS, (uint32_t)upload->format,
+        (uint32_t)upload->width, (uint32_t)upload->height, (uint32_t)upload->levels, (uint32_t)data_size
+    };
+
+    // Written aside and renamed, so a crash never leaves a torn entry
+    char temp_path[260];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path);
+    SceUID fd = sceIoOpen(temp_path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_TRUNC, 0777);
+    if (fd < 0) {
+        l_warn("Cannot write transcode cache entry: %s", temp_path);
+        return;
+    }
+
+    int ok = sceIoWrite(fd, &header, sizeof(header)) == sizeof(header) &&
+             sceIoWrite(fd, upload->pixels, data_size) == (int)data_size;
+    sceIoClose(fd);
+
+    if (!ok) {
+        l_warn("Short write to transcode cache, dropping: %s", temp_path);
+        sceIoRemove(temp_path);
+        return;
+    }
+
+    sceIoRemove(cache_path);
+    if (sceIoRename(temp_path, cache_path) < 0) {
+        sceIoRemove(temp_path);
+        return;
+    }
+    disk_cache_writes++;
+}
+
+// ===== GL UPLOAD =====
+
+static void upload_texture(texture_upload_t *upload) {
+#if MEM_GOVERNOR
+    // vitaGL allocates the storage inside glTexImage2D, where a failure can't
+    // be retried; make room before the first level instead
+    size_t total = 0;
+    for (int i = 0; i < upload->levels; i++) {
+        total += upload->level_size[i];
+    }
+    mem_governor_reserve(MEM_KIND_VRAM, total);
+#endif
+
+    GLint bound = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+    glBindTexture(GL_TEXTURE_2D, upload->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    size_t bytes = 0;
+    int width = upload->width;
+    int height = upload->height;
+    for (int i = 0; i < upload->levels; i++) {
+        if (upload->format == 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, upload->compressed_format, width, height, 0,
+                                   upload->level_size[i], upload->level_data[i]);
+        } else if (upload->format == TEXTURE_FORMAT_RGB565) {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, width, height, 0, GL_RGB,
+                         GL_UNSIGNED_SHORT_5_6_5, upload->level_data[i]);
+        } else if (upload->format == TEXTURE_FORMAT_RGBA4444) {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, width, height, 0, GL_RGBA,
+                         GL_UNSIGNED_SHORT_4_4_4_4, upload->level_data[i]);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, width, height, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, upload->level_data[i]);
+        }
+        bytes += upload->level_size[i];
+        width = MAX(width / 2, 1);
+        height = MAX(height / 2, 1);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    upload->levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, bound);
+
+    texture_bytes += bytes;
+    int budget = mem_budget_plan()->texture_budget;
+    if (texture_bytes > (size_t)budget && !budget_warned) {
+        l_warn("Texture memory over budget: %zu MB of %d MB",
+               texture_bytes / (1024 * 1024), budget / (1024 * 1024));
+        budget_warned = 1;
+    }
+}
+
+static void free_upload(texture_upload_t *upload) {
+    if (upload->source != ASSET_HANDLE_INVALID) {
+        asset_release(upload->source);
+    }
+    free(upload->pixels);
+    free(upload);
+}
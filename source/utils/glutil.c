@@ -12,11 +12,15 @@
 #include "utils/utils.h"
 #include "utils/dialog.h"
 #include "utils/logger.h"
+#include "mem_budget.h"
+#include "perf_profile.h"
+#include "profiler.h"
 
 #include <stdio.h>
 #include <malloc.h>
 #include <string.h>
 #include <psp2/kernel/sysmem.h>
+#include <psp2/io/fcntl.h>
 #include <psp2/io/stat.h>
 
 // Helpers for our handling of shaders
@@ -24,6 +28,193 @@ GLboolean skip_next_compile = GL_FALSE;
 char next_shader_fname[256];
 void load_shader(GLuint shader, const char * string, size_t length);
 
+#if defined(USE_GLSL_SHADERS) && defined(DUMP_COMPILED_SHADERS)
+// Every shader the game requests, in first-request order, one line each
+// ("<sha1> v|f"). New hashes are appended as each session meets them.
+#define SHADER_MANIFEST_PATH DATA_PATH"gxp/manifest.txt"
+#define SHADER_MANIFEST_MAX 512
+#define SHADER_BINARY_MAX (32 * 1024)
+
+typedef struct {
+    char sha[41];
+    GLenum type;
+    uint8_t *gxp;       // Binary loaded by gl_prefetch_shaders(), or NULL
+    size_t gxp_size;
+} manifest_entry_t;
+
+static manifest_entry_t manifest[SHADER_MANIFEST_MAX];
+static int manifest_count = 0;
+static int manifest_loaded = 0;
+
+static manifest_entry_t *manifest_find(const char * sha) {
+    for (int i = 0; i < manifest_count; i++) {
+        if (strcmp(manifest[i].sha, sha) == 0) {
+            return &manifest[i];
+        }
+    }
+    return NULL;
+}
+
+static void manifest_load() {
+    if (manifest_loaded) {
+        return;
+    }
+    manifest_loaded = 1;
+
+    uint8_t *buffer;
+    size_t size;
+    if (!file_exists(SHADER_MANIFEST_PATH) || !file_load(SHADER_MANIFEST_PATH, &buffer, &size)) {
+        return;
+    }
+
+    char *text = malloc(size + 1);
+    memcpy(text, buffer, size);
+    text[size] = '\0';
+    free(buffer);
+
+    for (char *line = strtok(text, "\n"); line && manifest_count < SHADER_MANIFEST_MAX;
+         line = strtok(NULL, "\n")) {
+        char sha[41];
+        char type;
+        if (sscanf(line, "%40s %c", sha, &type) != 2 || strlen(sha) != 40 || manifest_find(sha)) {
+            continue;
+        }
+        manifest_entry_t *entry = &manifest[manifest_count++];
+        strcpy(entry->sha, sha);
+        entry->type = (type == 'f') ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER;
+        entry->gxp = NULL;
+        entry->gxp_size = 0;
+    }
+
+    free(text);
+}
+
+static manifest_entry_t *manifest_record(const char * sha, GLenum type) {
+    manifest_load();
+
+    manifest_entry_t *entry = manifest_find(sha);
+    if (entry || manifest_count >= SHADER_MANIFEST_MAX) {
+        return entry;
+    }
+
+    entry = &manifest[manifest_count++];
+    strcpy(entry->sha, sha);
+    entry->type = type;
+    entry->gxp = NULL;
+    entry->gxp_size = 0;
+
+    char line[48];
+    int len = snprintf(line, sizeof(line), "%s %c\n", sha, type == GL_FRAGMENT_SHADER ? 'f' : 'v');
+    file_mkpath(SHADER_MANIFEST_PATH, 0777);
+    SceUID fd = sceIoOpen(SHADER_MANIFEST_PATH, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_APPEND, 0777);
+    if (fd >= 0) {
+        sceIoWrite(fd, line, len);
+        sceIoClose(fd);
+    }
+
+    l_debug("Shader manifest: recorded %s", sha);
+    return entry;
+}
+
+static int manifest_prefetched = 0;
+
+void gl_prefetch_shaders() {
+    if (manifest_prefetched) {
+        return;
+    }
+    manifest_prefetched = 1;
+    manifest_load();
+
+    uint64_t start = current_timestamp_ms();
+    int preloaded = 0;
+
+    for (int i = 0; i < manifest_count; i++) {
+        manifest_entry_t *entry = &manifest[i];
+        if (entry->gxp) {
+            continue;
+        }
+
+        char gxp_path[256];
+        snprintf(gxp_path, sizeof(gxp_path), DATA_PATH"gxp/%s.gxp", entry->sha);
+        if (file_exists(gxp_path) && file_load(gxp_path, &entry->gxp, &entry->gxp_size)) {
+            preloaded++;
+        }
+    }
+
+    if (manifest_count > 0) {
+        l_info("Shader prefetch: %d of %d binaries read in %llu ms",
+               preloaded, manifest_count, current_timestamp_ms() - start);
+    }
+}
+
+void gl_warmup_shaders() {
+    gl_prefetch_shaders();
+    if (manifest_count == 0) {
+        return;
+    }
+
+    uint64_t start = current_timestamp_ms();
+    int compiled = 0, missing = 0;
+
+    for (int i = 0; i < manifest_count; i++) {
+        manifest_entry_t *entry = &manifest[i];
+        if (entry->gxp) {
+            continue;
+        }
+
+        char gxp_path[256];
+        snprintf(gxp_path, sizeof(gxp_path), DATA_PATH"gxp/%s.gxp", entry->sha);
+
+        // No dump yet (the game quit before compiling it, or it failed): compile now
+        char glsl_path[256];
+        snprintf(glsl_path, sizeof(glsl_path), DATA_PATH"glsl/%s.glsl", entry->sha);
+        uint8_t *source;
+        size_t size;
+        if (!file_exists(glsl_path) || !file_load(glsl_path, &source, &size)) {
+            missing++;
+            continue;
+        }
+
+        GLuint shader = glCreateShader(entry->type);
+        const GLchar *string = (const GLchar *) source;
+        GLint length = (GLint) size;
+        glShaderSource(shader, 1, &string, &length);
+        PROF_BEGIN(compile_zone, "shader_warmup_compile");
+        glCompileShader(shader);
+        PROF_END(compile_zone);
+
+        GLint ok = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (ok) {
+            void *bin = vglMalloc(SHADER_BINARY_MAX);
+            GLsizei len = 0;
+            vglGetShaderBinary(shader, SHADER_BINARY_MAX, &len, bin);
+            if (len > 0 && (entry->gxp = malloc(len))) {
+                memcpy(entry->gxp, bin, len);
+                entry->gxp_size = len;
+                file_save(gxp_path, entry->gxp, len);
+                compiled++;
+            }
+            vglFree(bin);
+        } else {
+            l_warn("Shader warm-up: %s failed to compile", entry->sha);
+        }
+
+        glDeleteShader(shader);
+        free(source);
+    }
+
+    l_info("Shader warm-up: %d compiled, %d missing in %llu ms",
+           compiled, missing, current_timestamp_ms() - start);
+}
+#else
+void gl_prefetch_shaders() {
+}
+
+void gl_warmup_shaders() {
+}
+#endif
+
 void gl_preload() {
     if (!file_exists("ur0:/data/libshacccg.suprx")
         && !file_exists("ur0:/data/external/libshacccg.suprx")) {
@@ -37,7 +228,7 @@ void gl_preload() {
 }
 
 void gl_init() {
-    vglInitExtended(0, 960, 544, 6 * 1024 * 1024, SCE_GXM_MULTISAMPLE_4X);
+    mem_budget_init_gl(960, 544, perf_profile_msaa());
 }
 
 void gl_swap() {
@@ -97,6 +288,7 @@ void glCompileShader_soloader(GLuint shader) {
 
 #ifndef USE_GXP_SHADERS
     if (!skip_next_compile) {
+        PROF_SCOPE("glCompileShader");
         glCompileShader(shader);
 #ifdef DUMP_COMPILED_SHADERS
         void *bin = vglMalloc(32 * 1024);
@@ -114,6 +306,18 @@ void glCompileShader_soloader(GLuint shader) {
 void load_shader(GLuint shader, const char * string, size_t length) {
     char* sha_name = str_sha1sum(string, length);
 
+    GLint type = GL_VERTEX_SHADER;
+    glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+    manifest_entry_t *warm = manifest_record(sha_name, type);
+
+    // Warmed up at boot: bind the binary straight from memory
+    if (warm && warm->gxp) {
+        glShaderBinary(1, &shader, 0, warm->gxp, (int32_t) warm->gxp_size);
+        skip_next_compile = GL_TRUE;
+        free(sha_name);
+        return;
+    }
+
     char gxp_path[256];
     snprintf(gxp_path, sizeof(gxp_path), DATA_PATH"gxp/%s.gxp", sha_name);
 
@@ -128,6 +332,15 @@ void load_shader(GLuint shader, const char * string, size_t length) {
         free(buffer);
         skip_next_compile = GL_TRUE;
     } else {
+        // Keep the source so a later boot can compile it during warm-up
+        char glsl_path[256];
+        snprintf(glsl_path, sizeof(glsl_path), DATA_PATH"glsl/%s.glsl", sha_name);
+        if (!file_exists(glsl_path)) {
+            file_mkpath(glsl_path, 0777);
+            file_save(glsl_path, (const uint8_t *) string, length);
+        }
+
+        file_mkpath(gxp_path, 0777);
         glShaderSource(shader, 1, &string, &length);
         strcpy(next_shader_fname, gxp_path);
     }
@@ -27,6 +27,20 @@ void gl_preload();
 
 void gl_swap();
 
+/**
+ * Reads the GXP of every shader in the manifest recorded by earlier
+ * sessions. Only file I/O, so it may run on any thread before the context
+ * exists; gl_warmup_shaders() calls it if nobody has.
+ */
+void gl_prefetch_shaders();
+
+/**
+ * Compiles and dumps the manifest shaders that had no GXP yet, so the
+ * game's own requests for any of them bind a binary instead of compiling.
+ * Call with a live context, before the game starts creating shaders.
+ */
+void gl_warmup_shaders();
+
 void glCompileShader_soloader(GLuint shader);
 
 void glShaderSource_soloader(GLuint shader, GLsizei count,
@@ -14,6 +14,9 @@
 #include "utils/logger.h"
 #include "utils/utils.h"
 #include "utils/settings.h"
+#include "jni_cache.h"
+#include "perf_profile.h"
+#include "prelink.h"
 
 #include <string.h>
 
@@ -44,11 +47,8 @@ void soloader_init_all() {
             sceAppMgrLoadExec("app0:/configurator.bin", NULL, NULL);
     }
 
-    // Set default overclock values
-    scePowerSetArmClockFrequency(444);
-    scePowerSetBusClockFrequency(222);
-    scePowerSetGpuClockFrequency(222);
-    scePowerSetGpuXbarClockFrequency(166);
+    // Full clocks while loading; the profile's take over with the game loop
+    perf_profile_boot_clocks();
 
 #ifdef USE_SCELIBC_IO
     if (fios_init(DATA_PATH) == 0)
@@ -72,14 +72,21 @@ void soloader_init_all() {
         fatal_error("Error: could not load %s.", SO_PATH);
     }
 
-    settings_load();
-    l_success("Settings loaded.");
+    dynlib_init();
 
-    so_relocate(&so_mod);
-    l_success("SO relocated.");
+    // Same .so and import table as last boot: restore the relocated image
+    uint32_t imports = dynlib_hash();
+    if (prelink_apply(&so_mod, SO_PATH, imports) == 0) {
+        l_success("SO relocated and resolved from prelink cache.");
+    } else {
+        so_relocate(&so_mod);
+        l_success("SO relocated.");
 
-    resolve_imports(&so_mod);
-    l_success("SO imports resolved.");
+        resolve_imports(&so_mod);
+        l_success("SO imports resolved.");
+
+        prelink_store(&so_mod, SO_PATH, imports);
+    }
 
     so_patch();
     l_success("SO patched.");
@@ -90,9 +97,7 @@ void soloader_init_all() {
     so_initialize(&so_mod);
     l_success("SO initialized.");
 
-    gl_preload();
-    l_success("OpenGL preloaded.");
-
     jni_init();
+    jni_cache_init();
     l_success("FalsoJNI initialized.");
 }
@@ -13,16 +13,24 @@
 #ifndef SOLOADER_INIT_H
 #define SOLOADER_INIT_H
 
+#include <stdint.h>
 #include <so_util/so_util.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Port-side setup the import table relies on; run before the game's code
+void dynlib_init(void);
+
 void resolve_imports(so_module *mod);
 
+// Changes whenever a table entry's name or address does
+uint32_t dynlib_hash(void);
+
 void so_patch();
 
+// Safe off the main thread: settings and gl_preload() are the caller's, before graphics
 void soloader_init_all();
 
 #ifdef __cplusplus
@@ -7,11 +7,15 @@
 
 #include "utils/logger.h"
 
+#include <psp2/io/fcntl.h>
 #include <psp2/kernel/clib.h>
 #include <psp2/kernel/threadmgr.h>
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
 
 #define COLOR_RED    "\x1B[38;5;196m"
 #define COLOR_PINK   "\x1B[38;5;212m"
@@ -22,61 +26,222 @@
 
 #define COLOR_END    "\033[0m"
 
+// Bounded MPSC ring: a producer claims a slot by bumping `head`, formats
+// into it and publishes it by storing its sequence number; the writer
+// thread consumes slots in order. Records longer than LOG_RECORD_SIZE are
+// truncated.
+#define LOG_RING_SIZE     256        // Power of two
+#define LOG_RECORD_SIZE   512
+#define LOG_THREAD_PRIORITY 180      // Below the game; it only has to keep up
+#define LOG_THREAD_AFFINITY 0x40000 // Core 2
+#define LOG_THREAD_STACK  (16 * 1024)
+#define LOG_IDLE_DELAY_US 2000
+
+typedef struct {
+    atomic_uint seq;
+    int type;
+    char text[LOG_RECORD_SIZE];
+} log_record_t;
+
+enum {
+    WRITER_OFF = 0,
+    WRITER_STARTING,
+    WRITER_RUNNING,
+    WRITER_FAILED
+};
+
+static log_record_t ring[LOG_RING_SIZE];
+static atomic_uint ring_head = ATOMIC_VAR_INIT(0);
+static atomic_uint ring_tail = ATOMIC_VAR_INIT(0);
+static atomic_int ring_dropped = ATOMIC_VAR_INIT(0);
+static atomic_int writer_state = ATOMIC_VAR_INIT(WRITER_OFF);
+
+// Used only while the writer thread isn't running
 static SceKernelLwMutexWork _log_mutex;
 static atomic_bool _log_mutex_ready = ATOMIC_VAR_INIT(false);
+static char sync_buffer[LOG_RECORD_SIZE];
 
-// Buffer A is used to adjust the format string.
-static char buffer_a[2048];
-// Buffer B is used to compile the final log using the updated format string.
-static char buffer_b[2048];
+static SceUID log_fd = -1;
 
-void _log_print(int t, const char* fmt, ...) {
-    if (!atomic_load_explicit(&_log_mutex_ready, memory_order_relaxed)) {
+static const char * prefix(int t) {
+    switch (t) {
+        case LT_DEBUG:   return " " COLOR_PINK   "• debug"   COLOR_END "    ";
+        case LT_INFO:    return " " COLOR_BLUE   "ℹ info"    COLOR_END "     ";
+        case LT_WARN:    return " " COLOR_ORANGE "⚠ warning" COLOR_END "  ";
+        case LT_ERROR:   return " " COLOR_RED    "⨯ error"   COLOR_END "    ";
+        case LT_FATAL:   return " " COLOR_RED    "! fatal"   COLOR_END "    ";
+        case LT_SUCCESS: return " " COLOR_GREEN  "! success" COLOR_END "  ";
+        case LT_WAIT:    return " " COLOR_CYAN   "… waiting" COLOR_END "  ";
+        default:         return NULL;
+    }
+}
+
+static const char * plain_prefix(int t) {
+    switch (t) {
+        case LT_DEBUG:   return "[debug]   ";
+        case LT_INFO:    return "[info]    ";
+        case LT_WARN:    return "[warning] ";
+        case LT_ERROR:   return "[error]   ";
+        case LT_FATAL:   return "[fatal]   ";
+        case LT_SUCCESS: return "[success] ";
+        default:         return "[waiting] ";
+    }
+}
+
+static void write_record(int t, const char * text) {
+    sceClibPrintf("%s%s\n", prefix(t), text);
+
+    SceUID fd = log_fd;
+    if (fd >= 0) {
+        const char * p = plain_prefix(t);
+        sceIoWrite(fd, p, strlen(p));
+        sceIoWrite(fd, text, strlen(text));
+        sceIoWrite(fd, "\n", 1);
+    }
+}
+
+// Pop every published record; returns how many were written
+static int drain(void) {
+    int written = 0;
+    unsigned int tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    for (;;) {
+        log_record_t * record = &ring[tail & (LOG_RING_SIZE - 1)];
+        if (atomic_load_explicit(&record->seq, memory_order_acquire) != tail + 1) {
+            break;
+        }
+
+        write_record(record->type, record->text);
+        // Free the slot for the producer one lap ahead
+        atomic_store_explicit(&record->seq, tail + LOG_RING_SIZE, memory_order_release);
+        tail++;
+        atomic_store_explicit(&ring_tail, tail, memory_order_release);
+        written++;
+    }
+    return written;
+}
+
+static int log_thread(SceSize args __attribute__((unused)), void * argp __attribute__((unused))) {
+    int reported = 0;
+    for (;;) {
+        if (drain() == 0) {
+            sceKernelDelayThread(LOG_IDLE_DELAY_US);
+        }
+
+        int dropped = atomic_load_explicit(&ring_dropped, memory_order_relaxed);
+        if (dropped != reported) {
+            sceClibPrintf("%slog ring full, %d records dropped\n", prefix(LT_WARN), dropped - reported);
+            reported = dropped;
+        }
+    }
+    return 0;
+}
+
+static void start_writer(void) {
+    int expected = WRITER_OFF;
+    if (!atomic_compare_exchange_strong(&writer_state, &expected, WRITER_STARTING)) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < LOG_RING_SIZE; i++) {
+        atomic_store_explicit(&ring[i].seq, i, memory_order_relaxed);
+    }
+
+    SceUID thid = sceKernelCreateThread("log_writer", log_thread, LOG_THREAD_PRIORITY,
+                                        LOG_THREAD_STACK, 0, LOG_THREAD_AFFINITY, NULL);
+    if (thid < 0 || sceKernelStartThread(thid, 0, NULL) < 0) {
+        sceClibPrintf("Error: failed to start log thread: 0x%x\n", thid);
+        atomic_store_explicit(&writer_state, WRITER_FAILED, memory_order_release);
+        return;
+    }
+    atomic_store_explicit(&writer_state, WRITER_RUNNING, memory_order_release);
+}
+
+// The original locked path, for the first record and if the thread can't run
+static void print_sync(int t, const char * fmt, va_list list) {
+    if (!atomic_load_explicit(&_log_mutex_ready, memory_order_acquire)) {
         int ret = sceKernelCreateLwMutex(&_log_mutex, "log_lock", 0, 0, NULL);
         if (ret < 0) {
             sceClibPrintf("Error: failed to create log mutex: 0x%x\n", ret);
             return;
         }
-        atomic_store_explicit(&_log_mutex_ready, true, memory_order_relaxed);
+        atomic_store_explicit(&_log_mutex_ready, true, memory_order_release);
     }
+
     sceKernelLockLwMutex(&_log_mutex, 1, NULL);
+    sceClibVsnprintf(sync_buffer, sizeof(sync_buffer), fmt, list);
+    write_record(t, sync_buffer);
+    sceKernelUnlockLwMutex(&_log_mutex, 1);
+}
 
-    switch (t) {
-        case LT_DEBUG:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s• debug%s    %s\n",
-                            COLOR_PINK, COLOR_END, fmt); break;
-        case LT_INFO:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %sℹ info%s     %s\n",
-                            COLOR_BLUE, COLOR_END, fmt); break;
-        case LT_WARN:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s⚠ warning%s  %s\n",
-                            COLOR_ORANGE, COLOR_END, fmt); break;
-        case LT_ERROR:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s⨯ error%s    %s\n",
-                            COLOR_RED, COLOR_END, fmt); break;
-        case LT_FATAL:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s! fatal%s    %s\n",
-                            COLOR_RED, COLOR_END, fmt); break;
-        case LT_SUCCESS:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s! success%s  %s\n",
-                            COLOR_GREEN, COLOR_END, fmt); break;
-        case LT_WAIT:
-            sceClibSnprintf(buffer_a, sizeof(buffer_a), " %s… waiting%s  %s\n",
-                            COLOR_CYAN, COLOR_END, fmt); break;
-        default:
-            if (atomic_load_explicit(&_log_mutex_ready, memory_order_relaxed)) {
-                sceKernelUnlockLwMutex(&_log_mutex, 1);
-            }
-            return;
+void _log_print(int t, const char* fmt, ...) {
+    if (!prefix(t)) {
+        return;
+    }
+
+    int state = atomic_load_explicit(&writer_state, memory_order_acquire);
+    if (state == WRITER_OFF) {
+        start_writer();
+        state = atomic_load_explicit(&writer_state, memory_order_acquire);
     }
 
     va_list list;
     va_start(list, fmt);
-    sceClibVsnprintf(buffer_b, sizeof(buffer_b), buffer_a, list);
+
+    if (state != WRITER_RUNNING) {
+        print_sync(t, fmt, list);
+        va_end(list);
+        return;
+    }
+
+    unsigned int pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    log_record_t * record;
+    for (;;) {
+        record = &ring[pos & (LOG_RING_SIZE - 1)];
+        unsigned int seq = atomic_load_explicit(&record->seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak(&ring_head, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the writer is a whole lap behind
+            atomic_fetch_add_explicit(&ring_dropped, 1, memory_order_relaxed);
+            va_end(list);
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring_head, memory_order_relaxed);
+        }
+    }
+
+    record->type = t;
+    sceClibVsnprintf(record->text, sizeof(record->text), fmt, list);
     va_end(list);
-    sceClibPrintf(buffer_b);
+    atomic_store_explicit(&record->seq, pos + 1, memory_order_release);
+
+    if (t == LT_FATAL) {
+        log_flush();
+    }
+}
 
-    if (atomic_load_explicit(&_log_mutex_ready, memory_order_relaxed)) {
-        sceKernelUnlockLwMutex(&_log_mutex, 1);
+void log_set_file(const char* path) {
+    SceUID old = log_fd;
+    log_fd = path ? sceIoOpen(path, SCE_O_WRONLY | SCE_O_CREAT | SCE_O_APPEND, 0777) : -1;
+    if (old >= 0) {
+        sceIoClose(old);
     }
 }
+
+void log_flush(void) {
+    if (atomic_load_explicit(&writer_state, memory_order_acquire) != WRITER_RUNNING) {
+        return;
+    }
+
+    unsigned int target = atomic_load_explicit(&ring_head, memory_order_acquire);
+    while ((int)(atomic_load_explicit(&ring_tail, memory_order_acquire) - target) < 0) {
+        sceKernelDelayThread(1000);
+    }
+}
+
+int log_dropped(void) {
+    return atomic_load_explicit(&ring_dropped, memory_order_relaxed);
+}
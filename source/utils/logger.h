@@ -25,26 +25,65 @@ extern "C" {
 #define LT_SUCCESS 5
 #define LT_WAIT    6
 
+/*
+ * Levels below SOLOADER_LOG_LEVEL compile to nothing, arguments included.
+ * LT_SUCCESS and LT_WAIT count as LT_INFO. Without DEBUG_SOLOADER only
+ * errors are kept, as before.
+ */
+#ifndef SOLOADER_LOG_LEVEL
 #ifdef DEBUG_SOLOADER
+#define SOLOADER_LOG_LEVEL LT_DEBUG
+#else
+#define SOLOADER_LOG_LEVEL LT_ERROR
+#endif
+#endif
+
+#if SOLOADER_LOG_LEVEL <= LT_DEBUG
 #define l_debug(...)   _log_print(LT_DEBUG,   __VA_ARGS__)
+#else
+#define l_debug(...)
+#endif
+
+#if SOLOADER_LOG_LEVEL <= LT_INFO
 #define l_info(...)    _log_print(LT_INFO,    __VA_ARGS__)
-#define l_warn(...)    _log_print(LT_WARN,    __VA_ARGS__)
 #define l_success(...) _log_print(LT_SUCCESS, __VA_ARGS__)
 #define l_wait(...)    _log_print(LT_WAIT,    __VA_ARGS__)
 #else
-#define l_debug(...)
 #define l_info(...)
-#define l_warn(...)
 #define l_success(...)
 #define l_wait(...)
 #endif
 
+#if SOLOADER_LOG_LEVEL <= LT_WARN
+#define l_warn(...)    _log_print(LT_WARN,    __VA_ARGS__)
+#else
+#define l_warn(...)
+#endif
+
 #define l_error(...)   _log_print(LT_ERROR,   __VA_ARGS__)
 #define l_fatal(...)   _log_print(LT_FATAL,   __VA_ARGS__)
 
+/**
+ * Formats into a slot of a lock-free ring and returns; a low-priority
+ * thread prints the ring to the console. Never blocks: when the ring is
+ * full the record is dropped and counted. Fatal records are flushed
+ * before returning, since the caller is about to go down.
+ */
 void _log_print(int t, const char* fmt, ...)
                 __attribute__ ((format (printf, 2, 3)));
 
+/**
+ * Also append every record to `path` (NULL to stop). Plain text, no
+ * colour codes.
+ */
+void log_set_file(const char* path);
+
+// Wait until everything logged so far has been written out
+void log_flush(void);
+
+// Records lost to a full ring since boot
+int log_dropped(void);
+
 #ifdef __cplusplus
 };
 #endif
@@ -7,31 +7,53 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "settings.h"
+#include "config.h"
+#include "perf_profile.h"
+#include "reimpl/fast_libc.h"
 
-#define CONFIG_FILE_PATH DATA_PATH"config.txt"
+#define CONFIG_FILE_PATH SETTINGS_PATH
 
 int  setting_sampleSetting;
 bool setting_sampleSetting2;
+int  setting_perfProfile;
+bool setting_perfGovernor;
+int  setting_vglVramMb;
+int  setting_vglRamMb;
+int  setting_vglPhycontMb;
+int  setting_fastImports;
 
 void settings_reset() {
     setting_sampleSetting  = 1;
     setting_sampleSetting2 = true;
+    setting_perfProfile    = PERF_PROFILE_DEFAULT;
+    setting_perfGovernor   = PERF_GOVERNOR;
+    setting_vglVramMb      = 0;
+    setting_vglRamMb       = 0;
+    setting_vglPhycontMb   = 0;
+    setting_fastImports    = FAST_IMPORTS_EXACT;
 }
 
 void settings_load() {
     settings_reset();
 
     char buffer[30];
-    int value;
+    char value[16];
 
     FILE *config = fopen(CONFIG_FILE_PATH, "r");
 
     if (config) {
-        while (EOF != fscanf(config, "%[^ ] %d\n", buffer, &value)) {
-            if 		(strcmp("setting_sampleSetting", buffer) == 0) 	setting_sampleSetting  = (int)value;
-            else if (strcmp("setting_sampleSetting2", buffer) == 0) setting_sampleSetting2 = (bool)value;
+        while (2 == fscanf(config, "%29s %15s\n", buffer, value)) {
+            if 		(strcmp("setting_sampleSetting", buffer) == 0) 	setting_sampleSetting  = atoi(value);
+            else if (strcmp("setting_sampleSetting2", buffer) == 0) setting_sampleSetting2 = (bool)atoi(value);
+            else if (strcmp("perf_profile", buffer) == 0) 			setting_perfProfile    = perf_profile_find(value);
+            else if (strcmp("perf_governor", buffer) == 0) 			setting_perfGovernor   = (bool)atoi(value);
+            else if (strcmp("vgl_vram_mb", buffer) == 0) 			setting_vglVramMb      = atoi(value);
+            else if (strcmp("vgl_ram_mb", buffer) == 0) 			setting_vglRamMb       = atoi(value);
+            else if (strcmp("vgl_phycont_mb", buffer) == 0) 		setting_vglPhycontMb   = atoi(value);
+            else if (strcmp("fast_imports", buffer) == 0) 			setting_fastImports    = (int)strtoul(value, NULL, 0);
         }
         fclose(config);
     }
@@ -43,6 +65,12 @@ void settings_save() {
     if (config) {
         fprintf(config, "%s %d\n", "setting_sampleSetting", (int)(setting_sampleSetting));
         fprintf(config, "%s %d\n", "setting_sampleSetting2", (int)(setting_sampleSetting2));
+        fprintf(config, "%s %s\n", "perf_profile", perf_profile_name(setting_perfProfile));
+        fprintf(config, "%s %d\n", "perf_governor", (int)(setting_perfGovernor));
+        fprintf(config, "%s %d\n", "vgl_vram_mb", setting_vglVramMb);
+        fprintf(config, "%s %d\n", "vgl_ram_mb", setting_vglRamMb);
+        fprintf(config, "%s %d\n", "vgl_phycont_mb", setting_vglPhycontMb);
+        fprintf(config, "%s 0x%03X\n", "fast_imports", (unsigned)setting_fastImports);
         fclose(config);
     }
 }
@@ -21,6 +21,12 @@ extern "C" {
 
 extern int  setting_sampleSetting;
 extern bool setting_sampleSetting2;
+extern int  setting_perfProfile;    // perf_profile_id_t; stored by name
+extern bool setting_perfGovernor;
+extern int  setting_vglVramMb;      // vitaGL pool sizes; 0 = sized at boot
+extern int  setting_vglRamMb;
+extern int  setting_vglPhycontMb;
+extern int  setting_fastImports;    // FAST_IMPORT_* mask; stored in hex
 
 void settings_load();
 void settings_save();